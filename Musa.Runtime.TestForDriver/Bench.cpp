@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Bench.h"
+
+// The registration sections sort between these markers and are merged into
+// .rdata, so the driver does not gain a section of its own.
+#pragma section("KBENCH$A", long, read)
+#pragma section("KBENCH$Z", long, read)
+#pragma comment(linker, "/merge:KBENCH=.rdata")
+
+#define BenchLOG(fmt, ...) DbgPrintEx(DPFLTR_DEFAULT_ID, DPFLTR_ERROR_LEVEL, \
+    "[Musa.Runtime][BENCH] " fmt "\n", ## __VA_ARGS__)
+
+
+namespace Bench
+{
+    void const* volatile Sink = nullptr;
+
+    __declspec(allocate("KBENCH$A")) static Entry const* const FirstEntry = nullptr;
+    __declspec(allocate("KBENCH$Z")) static Entry const* const LastEntry  = nullptr;
+
+    // Picoseconds per timestamp tick, in 48.16 fixed point.
+    static ULONG64 PsPerTickQ16 = 0;
+
+    static ULONG64 TicksToPs(ULONG64 const Ticks, ULONG64 const Iterations)
+    {
+        return ((Ticks * PsPerTickQ16) >> 16) / Iterations;
+    }
+
+    // Measures the timestamp counter against the performance counter for about
+    // 10 ms.  The counter is invariant on every processor this runs on, so one
+    // measurement serves all of them.
+    static void CalibrateTimer()
+    {
+        LARGE_INTEGER Frequency;
+        LARGE_INTEGER const QpcStart = KeQueryPerformanceCounter(&Frequency);
+        ULONG64 const       TscStart = ReadTimeStampCounter();
+
+        LARGE_INTEGER QpcEnd;
+        do {
+            YieldProcessor();
+            QpcEnd = KeQueryPerformanceCounter(nullptr);
+        } while (QpcEnd.QuadPart - QpcStart.QuadPart < Frequency.QuadPart / 100);
+        ULONG64 const TscEnd = ReadTimeStampCounter();
+
+        ULONG64 const Ns    = static_cast<ULONG64>(QpcEnd.QuadPart - QpcStart.QuadPart) * 1000000000ull /
+            static_cast<ULONG64>(Frequency.QuadPart);
+        ULONG64 const Ticks = std::max<ULONG64>(TscEnd - TscStart, 1);
+        PsPerTickQ16 = std::max<ULONG64>((Ns * 1000ull << 16) / Ticks, 1);
+    }
+
+    static ULONG64 TimeSample(Entry const& Entry, Context& Context)
+    {
+        _ReadWriteBarrier();
+        ULONG64 const Start = ReadTimeStampCounter();
+        Entry.Run(Context);
+        ULONG64 const End   = ReadTimeStampCounter();
+        _ReadWriteBarrier();
+        return End - Start;
+    }
+
+    // Doubles the iteration count until a sample takes at least half the target,
+    // then scales it to the target.
+    static ULONG64 CalibrateIterations(Entry const& Entry, Context& Context, ULONG const SampleUs)
+    {
+        ULONG64 const TargetPs = static_cast<ULONG64>(SampleUs) * 1000000ull;
+        constexpr ULONG64 MaxIterations = 1ull << 30;
+
+        Context.Iterations = 1;
+        for (;;) {
+            ULONG64 const Ps = TicksToPs(TimeSample(Entry, Context), 1);
+            if (Ps >= TargetPs / 2 || Context.Iterations >= MaxIterations) {
+                if (Ps != 0) {
+                    Context.Iterations = std::clamp<ULONG64>(Context.Iterations * TargetPs / Ps, 1, MaxIterations);
+                }
+                return Context.Iterations;
+            }
+            Context.Iterations *= 2;
+        }
+    }
+
+    static void FormatNs(char (&Buffer)[32], ULONG64 const Ps)
+    {
+        sprintf_s(Buffer, "%llu.%03llu", Ps / 1000, Ps % 1000);
+    }
+
+    static void Report(Entry const& Entry, Context const& Context, std::vector<ULONG64>& Ticks)
+    {
+        std::sort(Ticks.begin(), Ticks.end());
+
+        // Nearest rank.
+        size_t const Count = Ticks.size();
+        auto const Percentile = [&](size_t const P) {
+            size_t const Rank = (P * Count + 99) / 100;
+            return Ticks[Rank == 0 ? 0 : Rank - 1];
+        };
+
+        ULONG64 Total = 0;
+        for (ULONG64 const Sample : Ticks) {
+            Total += Sample;
+        }
+
+        char Min[32], P50[32], P90[32], P99[32], Max[32], Mean[32], Cycles[32];
+        FormatNs(Min,  TicksToPs(Ticks.front(),   Context.Iterations));
+        FormatNs(P50,  TicksToPs(Percentile(50),  Context.Iterations));
+        FormatNs(P90,  TicksToPs(Percentile(90),  Context.Iterations));
+        FormatNs(P99,  TicksToPs(Percentile(99),  Context.Iterations));
+        FormatNs(Max,  TicksToPs(Ticks.back(),    Context.Iterations));
+        FormatNs(Mean, TicksToPs(Total / Count,   Context.Iterations));
+        FormatNs(Cycles, Percentile(50) * 1000 / Context.Iterations); // same formatting: thousandths
+
+        BenchLOG("{\"suite\":\"%s\",\"name\":\"%s\",\"cpu\":%lu,\"iterations\":%llu,\"samples\":%zu,"
+            "\"ns\":{\"min\":%s,\"p50\":%s,\"p90\":%s,\"p99\":%s,\"max\":%s,\"mean\":%s},\"cycles_p50\":%s}",
+            Entry.Suite, Entry.Name, Context.Processor, Context.Iterations, Count,
+            Min, P50, P90, P99, Max, Mean, Cycles);
+    }
+
+    static bool RunPinned(Entry const& Entry, ULONG const Processor, Options const& Options, std::vector<ULONG64>& Ticks)
+    {
+        PROCESSOR_NUMBER Number{};
+        if (!NT_SUCCESS(KeGetProcessorNumberFromIndex(Processor, &Number))) {
+            return false;
+        }
+
+        GROUP_AFFINITY Affinity{};
+        GROUP_AFFINITY Previous{};
+        Affinity.Group = Number.Group;
+        Affinity.Mask  = KAFFINITY{ 1 } << Number.Number;
+        KeSetSystemGroupAffinityThread(&Affinity, &Previous);
+
+        Context State{ 0, Processor, Entry.Setup ? Entry.Setup() : nullptr, 0 };
+
+        Ticks.clear();
+        if (Entry.Flags & KBENCH_MEASURED) {
+            State.Iterations = 1;
+            Entry.Run(State);
+            Ticks.push_back(State.Ticks);
+        }
+        else {
+            CalibrateIterations(Entry, State, Options.SampleUs);
+            for (ULONG i = 0; i < Options.Warmup; ++i) {
+                (void)TimeSample(Entry, State);
+            }
+
+            for (ULONG i = 0; i < Options.Samples; ++i) {
+                Ticks.push_back(TimeSample(Entry, State));
+            }
+        }
+
+        if (Entry.Teardown) {
+            Entry.Teardown(State.Fixture);
+        }
+        KeRevertToUserGroupAffinityThread(&Previous);
+
+        Report(Entry, State, Ticks);
+        return true;
+    }
+
+    ULONG RunBenchmarks(Options const& Options)
+    {
+        NT_ASSERT(KeGetCurrentIrql() == PASSIVE_LEVEL);
+        if (Options.Samples == 0) {
+            return 0;
+        }
+
+        ULONG const Cpus = std::min(KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS), Options.MaxCpus);
+
+        // Reserved up front so that no run allocates on the harness's behalf.
+        std::vector<ULONG64> Ticks;
+        Ticks.reserve(Options.Samples);
+
+        KPRIORITY const Priority = KeSetPriorityThread(KeGetCurrentThread(), LOW_REALTIME_PRIORITY);
+        CalibrateTimer();
+
+        BenchLOG("{\"harness\":1,\"compiler\":%lu,\"build\":\"%s %s\",\"arch\":\"%s\",\"cpus\":%lu,\"ps_per_tick_q16\":%llu}",
+            static_cast<ULONG>(_MSC_FULL_VER), __DATE__, __TIME__,
+#if defined _M_ARM64
+            "arm64",
+#else
+            "x64",
+#endif
+            Cpus, PsPerTickQ16);
+
+        ULONG Runs = 0;
+        for (Entry const* const* Slot = &FirstEntry + 1; Slot < &LastEntry; ++Slot) {
+            Entry const* const Current = *Slot;
+            if (Current == nullptr) {
+                continue; // padding between contributions
+            }
+
+            if (Options.Filter) {
+                char Name[128];
+                sprintf_s(Name, "%s/%s", Current->Suite, Current->Name);
+                if (strstr(Name, Options.Filter) == nullptr) {
+                    continue;
+                }
+            }
+
+            ULONG const Last = (Current->Flags & KBENCH_ALL_CPUS) ? Cpus : 1;
+            for (ULONG Processor = 0; Processor < Last; ++Processor) {
+                Runs += RunPinned(*Current, Processor, Options, Ticks) ? 1 : 0;
+            }
+        }
+
+        KeSetPriorityThread(KeGetCurrentThread(), Priority);
+        BenchLOG("{\"runs\":%lu}", Runs);
+        return Runs;
+    }
+}
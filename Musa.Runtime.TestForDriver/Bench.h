@@ -0,0 +1,110 @@
+#pragma once
+
+
+// Microbenchmarks
+//
+// A benchmark is a routine that runs its body Context.Iterations times.  The
+// harness calibrates the iteration count so that one sample takes roughly
+// SampleUs microseconds, runs Warmup unrecorded samples and then Samples
+// recorded ones, each timed with ReadTimeStampCounter(), and reports the
+// per-iteration time as percentiles.  Every run is pinned to one processor at
+// LOW_REALTIME_PRIORITY; KBENCH_ALL_CPUS runs the benchmark once on each
+// active processor.
+//
+//     KBENCH(Alloc, KmallocFree64)
+//     {
+//         for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+//             void* p = kmalloc(64, NonPagedPoolNx, 'BsrT');
+//             Bench::DoNotOptimize(p);
+//             kfree(p, 'BsrT');
+//         }
+//     }
+//
+// Setup and teardown that must not be timed go in a fixture, built once per
+// run (per processor) and passed to the routine in Context.Fixture:
+//
+//     static void* MakeMap() { ... }
+//     static void  FreeMap(void* Fixture) { ... }
+//     KBENCH_FIXTURE(Containers, MapFind, 0, MakeMap, FreeMap) { ... }
+//
+// A cost that cannot be repeated, such as startup, is measured where it happens
+// and reported by a KBENCH_MEASURED routine, which stores the timestamp ticks it
+// took in Context.Ticks; the harness calls it once and reports one sample of
+// one iteration:
+//
+//     KBENCH_F(Startup, EntryToMain, KBENCH_MEASURED) { Context.Ticks = ...; }
+//
+// Results are printed with DbgPrintEx, in Release builds as well, as one JSON
+// object per line prefixed with "[Musa.Runtime][BENCH] ", so that a debugger
+// log can be filtered and diffed across runtime releases:
+//
+//     {"suite":"Alloc","name":"KmallocFree64","cpu":0,"iterations":4096,"samples":31,
+//      "ns":{"min":..,"p50":..,"p90":..,"p99":..,"max":..,"mean":..},"cycles_p50":..}
+//
+// Times are per iteration.  Use at namespace scope.
+
+#define KBENCH_ALL_CPUS 0x1ul    // run on every active processor, not only the first
+#define KBENCH_MEASURED 0x2ul    // report Context.Ticks, set by the routine, instead of timing it
+
+namespace Bench
+{
+    struct Context
+    {
+        ULONG64 Iterations;
+        ULONG   Processor;      // processor index the run is pinned to
+        void*   Fixture;        // from the entry's Setup, or nullptr
+        ULONG64 Ticks;          // KBENCH_MEASURED: the ticks measured elsewhere
+    };
+
+    using Routine = void (*)(Context&);
+
+    struct Entry
+    {
+        char const* Suite;
+        char const* Name;
+        Routine     Run;
+        ULONG       Flags;
+        void*     (*Setup)();                   // optional; outside the timed region
+        void      (*Teardown)(void* Fixture);   // optional
+    };
+
+    struct Options
+    {
+        char const* Filter     = nullptr;   // substring of "Suite/Name"; nullptr for all
+        ULONG       Warmup     = 3;         // unrecorded samples per run
+        ULONG       Samples    = 31;        // recorded samples per run
+        ULONG       SampleUs   = 200;       // target duration of one sample when calibrating
+        ULONG       MaxCpus    = 64;        // KBENCH_ALL_CPUS runs on at most this many processors
+    };
+
+    // Runs every registered benchmark that matches the filter.  Must be called
+    // at PASSIVE_LEVEL.  Returns the number of runs reported.
+    ULONG RunBenchmarks(Options const& Options = {});
+
+    // Keeps the compiler from discarding a value or the computation behind it.
+    extern void const* volatile Sink;
+
+    template <typename T>
+    __forceinline void DoNotOptimize(T const& Value)
+    {
+        _ReadWriteBarrier();
+        Sink = &Value;
+        _ReadWriteBarrier();
+    }
+}
+
+// Registration is a pointer in "KBENCH$M", between the harness's "KBENCH$A"
+// and "KBENCH$Z" markers.  Entries are constant-initialized, so registration
+// does not depend on the order of global constructors.
+#pragma section("KBENCH$M", long, read)
+
+#define KBENCH_FIXTURE(suite, name, flags, setup, teardown)                                 \
+    static void suite##_##name##_Bench(::Bench::Context& Context);                          \
+    static constexpr ::Bench::Entry suite##_##name##_BenchEntry{                            \
+        #suite, #name, &suite##_##name##_Bench, flags, setup, teardown };                   \
+    extern "C" __declspec(allocate("KBENCH$M"))                                             \
+        ::Bench::Entry const* const suite##_##name##_kbench = &suite##_##name##_BenchEntry; \
+    static void suite##_##name##_Bench([[maybe_unused]] ::Bench::Context& Context)
+
+#define KBENCH_F(suite, name, flags) KBENCH_FIXTURE(suite, name, flags, nullptr, nullptr)
+#define KBENCH(suite, name)          KBENCH_FIXTURE(suite, name, 0, nullptr, nullptr)
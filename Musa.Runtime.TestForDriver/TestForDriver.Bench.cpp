@@ -0,0 +1,1813 @@
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+#include <algorithm>
+#include <format>
+#include <print>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <numeric>
+#include <typeindex>
+#include <system_error>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <kmalloc.h>
+#include <kallocator.h>
+#include <kclock.h>
+#include <ktzdb.h>
+#include <klog.h>
+#include <kmath.h>
+#include <krand.h>
+#include <ksearch.h>
+#include <ksort.h>
+#include <kstdio.h>
+#include <kunwind.h>
+#include <krtti.h>
+#include <kundname.h>
+#include <kstartup.h>
+#include <kinit.h>
+#include <kerror.h>
+#include <kmemprof.h>
+
+#include "Bench.h"
+
+// The heap-backed undecorator, as a reference for kundname.
+extern "C" char* __cdecl __unDName(char*, const char*, int, void* (__cdecl*)(size_t), void (__cdecl*)(void*), unsigned short);
+
+
+namespace Main
+{
+    constexpr unsigned long BenchTag = 'BsrT';
+
+    // CRT: Allocator
+    KBENCH_F(Alloc, KmallocFree64, KBENCH_ALL_CPUS)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            void* const p = kmalloc(64, NonPagedPoolNx, BenchTag);
+            Bench::DoNotOptimize(p);
+            kfree(p, BenchTag);
+        }
+    }
+
+    KBENCH(Alloc, KmallocFree4096)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            void* const p = kmalloc(4096, NonPagedPoolNx, BenchTag);
+            Bench::DoNotOptimize(p);
+            kfree(p, BenchTag);
+        }
+    }
+
+    KBENCH_F(Alloc, MallocFree64, KBENCH_ALL_CPUS)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            void* const p = malloc(64);
+            Bench::DoNotOptimize(p);
+            free(p);
+        }
+    }
+
+    KBENCH(Alloc, NewDeleteInt)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            int* const p = new int(static_cast<int>(i));
+            Bench::DoNotOptimize(p);
+            delete p;
+        }
+    }
+
+    KBENCH(Alloc, ReallocGrow)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            void* p = nullptr;
+            for (size_t size = 16; size <= 1024; size *= 2) {
+                p = realloc(p, size);
+            }
+            Bench::DoNotOptimize(p);
+            free(p);
+        }
+    }
+
+    // STL: Containers on kallocator
+    using BenchVector = std::vector<int, std::kallocator<int, NonPagedPool, BenchTag>>;
+    using BenchMap    = std::map<int, int, std::less<int>, std::kallocator<std::pair<const int, int>, NonPagedPool, BenchTag>>;
+    using BenchHash   = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+        std::kallocator<std::pair<const int, int>, NonPagedPool, BenchTag>>;
+
+    constexpr int BenchKeys = 1024;
+
+    KBENCH(Containers, VectorPushBack1024)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            BenchVector v;
+            for (int k = 0; k < BenchKeys; ++k) {
+                v.push_back(k);
+            }
+            Bench::DoNotOptimize(v.back());
+        }
+    }
+
+    KBENCH(Containers, MapInsert1024)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            BenchMap m;
+            for (int k = 0; k < BenchKeys; ++k) {
+                m.emplace(k * 7919 % BenchKeys, k);
+            }
+            Bench::DoNotOptimize(m.size());
+        }
+    }
+
+    static void* MakeBenchMap()
+    {
+        auto const m = new BenchMap;
+        for (int k = 0; k < BenchKeys; ++k) {
+            m->emplace(k, k);
+        }
+        return m;
+    }
+
+    static void FreeBenchMap(void* const Fixture)
+    {
+        delete static_cast<BenchMap*>(Fixture);
+    }
+
+    KBENCH_FIXTURE(Containers, MapFind, 0, MakeBenchMap, FreeBenchMap)
+    {
+        auto const& m = *static_cast<BenchMap const*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const it = m.find(static_cast<int>(i * 7919 % BenchKeys));
+            Bench::DoNotOptimize(it->second);
+        }
+    }
+
+    static void* MakeBenchHash()
+    {
+        auto const m = new BenchHash;
+        for (int k = 0; k < BenchKeys; ++k) {
+            m->emplace(k, k);
+        }
+        return m;
+    }
+
+    static void FreeBenchHash(void* const Fixture)
+    {
+        delete static_cast<BenchHash*>(Fixture);
+    }
+
+    KBENCH_FIXTURE(Containers, UnorderedMapFind, 0, MakeBenchHash, FreeBenchHash)
+    {
+        auto const& m = *static_cast<BenchHash const*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const it = m.find(static_cast<int>(i * 7919 % BenchKeys));
+            Bench::DoNotOptimize(it->second);
+        }
+    }
+
+    // CRT: String conversion
+    KBENCH(Convert, Strtol)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            long const v = strtol("-1234567", nullptr, 10);
+            Bench::DoNotOptimize(v);
+        }
+    }
+
+    KBENCH(Convert, Strtod)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            double const v = strtod("3.14159265358979", nullptr);
+            Bench::DoNotOptimize(v);
+        }
+    }
+
+    KBENCH(Convert, StrtodShort)
+    {
+        static const char* const Inputs[] = { "0.5", "12.25", "-3.1", "100", "7e-3", "0.001", "42.42", "1e10" };
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            double const v = strtod(Inputs[i % std::size(Inputs)], nullptr);
+            Bench::DoNotOptimize(v);
+        }
+    }
+
+    // Inputs that the fast path hands to the big integer algorithm: halfway
+    // cases, subnormals and long mantissas near a rounding boundary.
+    KBENCH(Convert, StrtodPathological)
+    {
+        static const char* const Inputs[] = {
+            "9007199254740993",
+            "2.2250738585072011e-308",
+            "4.9e-324",
+            "0.1000000000000000055511151231257827021181583404541015625",
+        };
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            double const v = strtod(Inputs[i % std::size(Inputs)], nullptr);
+            Bench::DoNotOptimize(v);
+        }
+    }
+
+    constexpr size_t BenchDoubles = 1024;
+    using BenchDoubleText = char[BenchDoubles][32];
+
+    static void* MakeRandomDoubles()
+    {
+        auto const text = new BenchDoubleText[1];
+        uint64_t state = 0x4D757361;
+        for (size_t i = 0; i < BenchDoubles; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            uint64_t bits = state;
+            if ((bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull) {
+                bits &= ~0x4000000000000000ull;
+            }
+            double v;
+            memcpy(&v, &bits, sizeof(v));
+            sprintf_s((*text)[i], "%.17g", v);
+        }
+        return text;
+    }
+
+    static void FreeRandomDoubles(void* const Fixture)
+    {
+        delete[] static_cast<BenchDoubleText*>(Fixture);
+    }
+
+    KBENCH_FIXTURE(Convert, StrtodRandom, 0, MakeRandomDoubles, FreeRandomDoubles)
+    {
+        auto const& text = *static_cast<BenchDoubleText const*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            double const v = strtod(text[i % BenchDoubles], nullptr);
+            Bench::DoNotOptimize(v);
+        }
+    }
+
+    KBENCH(Convert, SprintfInt)
+    {
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            sprintf_s(buffer, "%d", static_cast<int>(i));
+            Bench::DoNotOptimize(buffer);
+        }
+    }
+
+    KBENCH(Convert, SprintfDouble)
+    {
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            sprintf_s(buffer, "%.6f", static_cast<double>(i) / 7.0);
+            Bench::DoNotOptimize(buffer);
+        }
+    }
+
+    // A driver log line, with and without width and precision; the Simple
+    // entries take the snprintf fast path.  Truncated ones still count the
+    // full length.
+    template <size_t Size>
+    static void BenchSnprintfSimple(Bench::Context& Context)
+    {
+        char buffer[256];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            int const n = snprintf(buffer, Size, "[musa] %s: irp=%p status=%x count=%d/%u",
+                "IRP_MJ_READ", &buffer, 0xC0000001u, static_cast<int>(i), 100000u);
+            Bench::DoNotOptimize(n);
+        }
+    }
+
+    template <size_t Size>
+    static void BenchSnprintfWidth(Bench::Context& Context)
+    {
+        char buffer[256];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            int const n = snprintf(buffer, Size, "[musa] %-12s: irp=%p status=%08x count=%6d/%u",
+                "IRP_MJ_READ", &buffer, 0xC0000001u, static_cast<int>(i), 100000u);
+            Bench::DoNotOptimize(n);
+        }
+    }
+
+    KBENCH(Convert, SnprintfSimpleFits)
+    {
+        BenchSnprintfSimple<256>(Context);
+    }
+
+    KBENCH(Convert, SnprintfSimpleTruncated)
+    {
+        BenchSnprintfSimple<32>(Context);
+    }
+
+    KBENCH(Convert, SnprintfWidthFits)
+    {
+        BenchSnprintfWidth<256>(Context);
+    }
+
+    KBENCH(Convert, SnprintfWidthTruncated)
+    {
+        BenchSnprintfWidth<32>(Context);
+    }
+
+    // Digit generation for the whole exponent range; %f of 1e300 and of a
+    // subnormal produce hundreds of digits.
+    static void* MakeRandomDoubleValues()
+    {
+        auto const values = new double[BenchDoubles];
+        uint64_t state = 0x4D757361;
+        for (size_t i = 0; i < BenchDoubles; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            uint64_t bits = state;
+            if ((bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull) {
+                bits &= ~0x4000000000000000ull;
+            }
+            memcpy(&values[i], &bits, sizeof(double));
+        }
+        return values;
+    }
+
+    static void FreeRandomDoubleValues(void* const Fixture)
+    {
+        delete[] static_cast<double*>(Fixture);
+    }
+
+    KBENCH_FIXTURE(Convert, Sprintf17gRandom, 0, MakeRandomDoubleValues, FreeRandomDoubleValues)
+    {
+        auto const values = static_cast<double const*>(Context.Fixture);
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            sprintf_s(buffer, "%.17g", values[i % BenchDoubles]);
+            Bench::DoNotOptimize(buffer);
+        }
+    }
+
+    KBENCH_FIXTURE(Convert, SprintfExpRandom, 0, MakeRandomDoubleValues, FreeRandomDoubleValues)
+    {
+        auto const values = static_cast<double const*>(Context.Fixture);
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            sprintf_s(buffer, "%e", values[i % BenchDoubles]);
+            Bench::DoNotOptimize(buffer);
+        }
+    }
+
+    KBENCH(Convert, SprintfFixedLarge)
+    {
+        char buffer[320];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            sprintf_s(buffer, "%.0f", 1e300 + static_cast<double>(i & 0xFF) * 1e284);
+            Bench::DoNotOptimize(buffer);
+        }
+    }
+
+    KBENCH(Convert, SprintfFixedSubnormal)
+    {
+        char buffer[1100];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            sprintf_s(buffer, "%.1074f", 4.9406564584124654e-324 * static_cast<double>((i & 0xFF) + 1));
+            Bench::DoNotOptimize(buffer);
+        }
+    }
+
+    KBENCH(Convert, Ecvt)
+    {
+        int decimal_point;
+        int sign;
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            char const* const digits = _ecvt(static_cast<double>(i) / 7.0, 17, &decimal_point, &sign);
+            Bench::DoNotOptimize(digits);
+        }
+    }
+
+    KBENCH(Convert, Gcvt)
+    {
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            char const* const text = _gcvt(static_cast<double>(i) / 7.0, 17, buffer);
+            Bench::DoNotOptimize(text);
+        }
+    }
+
+    KBENCH(Convert, ToCharsInt)
+    {
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<int>(i));
+            Bench::DoNotOptimize(result.ptr);
+        }
+    }
+
+    KBENCH(Convert, ToCharsDouble)
+    {
+        char buffer[32];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(i) / 7.0);
+            Bench::DoNotOptimize(result.ptr);
+        }
+    }
+
+    KBENCH(Convert, FromCharsDouble)
+    {
+        constexpr char Text[] = "3.14159265358979";
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            double v = 0;
+            (void)std::from_chars(Text, Text + sizeof(Text) - 1, v);
+            Bench::DoNotOptimize(v);
+        }
+    }
+
+    // STL: std::format
+    KBENCH(Format, FormatInt)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::string const s = std::format("{}", static_cast<int>(i));
+            Bench::DoNotOptimize(s);
+        }
+    }
+
+    KBENCH(Format, FormatMixed)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::string const s = std::format("{}:{:>8}:{:.3f}", "key", static_cast<int>(i), static_cast<double>(i) / 7.0);
+            Bench::DoNotOptimize(s);
+        }
+    }
+
+    KBENCH(Format, FormatToBuffer)
+    {
+        char buffer[64];
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const result = std::format_to_n(buffer, sizeof(buffer), "{:08x}", static_cast<unsigned>(i));
+            Bench::DoNotOptimize(result.out);
+        }
+    }
+
+    // CRT: Batch math against the scalar functions; one iteration is one
+    // element, evaluated in batches of BenchMathBatch.
+    constexpr size_t BenchMathBatch = 1024;
+
+    struct BenchMathValues
+    {
+        double Input[BenchMathBatch];
+        double Output[BenchMathBatch];
+    };
+
+    static void* MakeBenchMathValues()
+    {
+        auto const values = new BenchMathValues;
+        for (size_t i = 0; i < BenchMathBatch; ++i) {
+            values->Input[i] = 0.01 + static_cast<double>(i) * (40.0 / BenchMathBatch);
+        }
+        return values;
+    }
+
+    static void FreeBenchMathValues(void* const Fixture)
+    {
+        delete static_cast<BenchMathValues*>(Fixture);
+    }
+
+    template <class Function>
+    static void BenchMathBatches(Bench::Context& Context, Function const& Batch)
+    {
+        auto const values = static_cast<BenchMathValues*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; i += BenchMathBatch) {
+            auto const count = static_cast<size_t>((std::min)(Context.Iterations - i, static_cast<ULONG64>(BenchMathBatch)));
+            Batch(values->Input, values->Output, count);
+            Bench::DoNotOptimize(values->Output);
+        }
+    }
+
+    template <class Function>
+    static void BenchMathScalar(Bench::Context& Context, Function const& Scalar)
+    {
+        auto const values = static_cast<BenchMathValues*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            values->Output[i % BenchMathBatch] = Scalar(values->Input[i % BenchMathBatch]);
+        }
+        Bench::DoNotOptimize(values->Output);
+    }
+
+    KBENCH_FIXTURE(Math, Exp, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathScalar(Context, [](double x) { return exp(x); });
+    }
+
+    KBENCH_FIXTURE(Math, KvExp, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathBatches(Context, kvexp);
+    }
+
+    KBENCH_FIXTURE(Math, Log, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathScalar(Context, [](double x) { return log(x); });
+    }
+
+    KBENCH_FIXTURE(Math, KvLog, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathBatches(Context, kvlog);
+    }
+
+    KBENCH_FIXTURE(Math, Tanh, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathScalar(Context, [](double x) { return tanh(x); });
+    }
+
+    KBENCH_FIXTURE(Math, KvTanh, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathBatches(Context, kvtanh);
+    }
+
+    KBENCH_FIXTURE(Math, Sin, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathScalar(Context, [](double x) { return sin(x); });
+    }
+
+    KBENCH_FIXTURE(Math, KvSin, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathBatches(Context, kvsin);
+    }
+
+    KBENCH_FIXTURE(Math, Sqrt, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathScalar(Context, [](double x) { return sqrt(x); });
+    }
+
+    KBENCH_FIXTURE(Math, KvSqrt, 0, MakeBenchMathValues, FreeBenchMathValues)
+    {
+        BenchMathBatches(Context, kvsqrt);
+    }
+
+    // CRT: Random numbers.  RandSBytes and SystemRandomBytes take one byte per
+    // iteration, in requests of BenchRandomRequest bytes, so bytes per second
+    // is 10^9 / ns.
+    constexpr size_t BenchRandomRequest = 4096;
+
+    KBENCH(Random, RandS)
+    {
+        unsigned int value;
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            (void)rand_s(&value);
+            Bench::DoNotOptimize(value);
+        }
+    }
+
+    KBENCH(Random, RandomDevice)
+    {
+        std::random_device device;
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            Bench::DoNotOptimize(device());
+        }
+    }
+
+    static void* MakeRandomRequest()
+    {
+        return new unsigned char[BenchRandomRequest];
+    }
+
+    static void FreeRandomRequest(void* const Fixture)
+    {
+        delete[] static_cast<unsigned char*>(Fixture);
+    }
+
+    static void BenchRandomBytes(Bench::Context& Context)
+    {
+        auto const buffer = static_cast<unsigned char*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; i += BenchRandomRequest) {
+            auto const count = static_cast<size_t>((std::min)(Context.Iterations - i, static_cast<ULONG64>(BenchRandomRequest)));
+            (void)rand_s_bytes(buffer, count);
+            Bench::DoNotOptimize(buffer[0]);
+        }
+    }
+
+    KBENCH_FIXTURE(Random, RandSBytes, 0, MakeRandomRequest, FreeRandomRequest)
+    {
+        BenchRandomBytes(Context);
+    }
+
+    // The system RNG on its own: an interval of 0 bypasses the generators.
+    KBENCH_FIXTURE(Random, SystemRandomBytes, 0, MakeRandomRequest, FreeRandomRequest)
+    {
+        size_t const interval = krand_set_reseed_interval(0);
+        BenchRandomBytes(Context);
+        krand_set_reseed_interval(interval);
+    }
+
+    // CRT: qsort and qsort_u32.  One iteration copies BenchSortCount keys from
+    // the fixture and sorts them.
+    constexpr size_t BenchSortCount = 4096;
+
+    struct BenchSortKeys
+    {
+        unsigned int Source[BenchSortCount];
+        unsigned int Keys[BenchSortCount];
+    };
+
+    template <int Pattern>
+    static void* MakeBenchSortKeys()
+    {
+        auto const keys = new BenchSortKeys;
+        uint64_t state = 0x4D757361;
+        for (size_t i = 0; i < BenchSortCount; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            unsigned int const random = static_cast<unsigned int>(state >> 32);
+            switch (Pattern) {
+            case 0:  keys->Source[i] = random;                                         break;
+            case 1:  keys->Source[i] = static_cast<unsigned int>(i);                   break;
+            case 2:  keys->Source[i] = static_cast<unsigned int>(BenchSortCount - i); break;
+            default: keys->Source[i] = random % 16;                                    break;
+            }
+        }
+        return keys;
+    }
+
+    static void FreeBenchSortKeys(void* const Fixture)
+    {
+        delete static_cast<BenchSortKeys*>(Fixture);
+    }
+
+    static int __cdecl BenchCompareKeys(void const* const a, void const* const b)
+    {
+        unsigned int const x = *static_cast<unsigned int const*>(a);
+        unsigned int const y = *static_cast<unsigned int const*>(b);
+        return (x > y) - (x < y);
+    }
+
+    static void BenchQsort(Bench::Context& Context)
+    {
+        auto const keys = static_cast<BenchSortKeys*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            memcpy(keys->Keys, keys->Source, sizeof(keys->Keys));
+            qsort(keys->Keys, BenchSortCount, sizeof(unsigned int), BenchCompareKeys);
+            Bench::DoNotOptimize(keys->Keys);
+        }
+    }
+
+    static void BenchQsortU32(Bench::Context& Context)
+    {
+        auto const keys = static_cast<BenchSortKeys*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            memcpy(keys->Keys, keys->Source, sizeof(keys->Keys));
+            qsort_u32(keys->Keys, BenchSortCount);
+            Bench::DoNotOptimize(keys->Keys);
+        }
+    }
+
+    KBENCH_FIXTURE(Sort, QsortRandom, 0, MakeBenchSortKeys<0>, FreeBenchSortKeys)
+    {
+        BenchQsort(Context);
+    }
+
+    KBENCH_FIXTURE(Sort, QsortSorted, 0, MakeBenchSortKeys<1>, FreeBenchSortKeys)
+    {
+        BenchQsort(Context);
+    }
+
+    KBENCH_FIXTURE(Sort, QsortReversed, 0, MakeBenchSortKeys<2>, FreeBenchSortKeys)
+    {
+        BenchQsort(Context);
+    }
+
+    KBENCH_FIXTURE(Sort, QsortDuplicates, 0, MakeBenchSortKeys<3>, FreeBenchSortKeys)
+    {
+        BenchQsort(Context);
+    }
+
+    KBENCH_FIXTURE(Sort, QsortU32Random, 0, MakeBenchSortKeys<0>, FreeBenchSortKeys)
+    {
+        BenchQsortU32(Context);
+    }
+
+    KBENCH_FIXTURE(Sort, QsortU32Duplicates, 0, MakeBenchSortKeys<3>, FreeBenchSortKeys)
+    {
+        BenchQsortU32(Context);
+    }
+
+    // CRT: bsearch against the ksearch tables over sorted unsigned ints.  One
+    // iteration is one lookup of a pseudo-random key, a third of which are
+    // present.  The key arrays fit in L1 (4096 keys), in L2 (65536) or in
+    // neither (4M).
+    constexpr size_t BenchSearchProbes = 4096;
+
+    struct BenchSearchTable
+    {
+        size_t         Count;
+        unsigned int*  Keys;
+        ksearch_u32*   Tree;
+        ksearch_table* Table;
+        unsigned int   Probes[BenchSearchProbes];
+    };
+
+    static void FreeBenchSearchTable(void* const Fixture)
+    {
+        auto const search = static_cast<BenchSearchTable*>(Fixture);
+        if (search != nullptr) {
+            ksearch_u32_free(search->Tree);
+            ksearch_table_free(search->Table);
+            delete[] search->Keys;
+            delete search;
+        }
+    }
+
+    template <size_t Count>
+    static void* MakeBenchSearchTable()
+    {
+        auto const search = new BenchSearchTable{};
+        search->Count = Count;
+        search->Keys = new unsigned int[Count];
+        for (size_t i = 0; i < Count; ++i) {
+            search->Keys[i] = static_cast<unsigned int>(i * 3);
+        }
+
+        uint64_t state = 0x4D757361;
+        for (size_t i = 0; i < BenchSearchProbes; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            search->Probes[i] = static_cast<unsigned int>((state >> 32) % (Count * 3));
+        }
+
+        search->Tree = ksearch_u32_build(search->Keys, Count);
+        search->Table = ksearch_table_build(search->Keys, Count, sizeof(unsigned int));
+        if (search->Tree == nullptr || search->Table == nullptr) {
+            FreeBenchSearchTable(search);
+            return nullptr;
+        }
+        return search;
+    }
+
+    static void BenchBsearch(Bench::Context& Context)
+    {
+        auto const search = static_cast<BenchSearchTable*>(Context.Fixture);
+        if (search == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            unsigned int const key = search->Probes[i % BenchSearchProbes];
+            void const* const found = bsearch(&key, search->Keys, search->Count, sizeof(unsigned int), BenchCompareKeys);
+            Bench::DoNotOptimize(found);
+        }
+    }
+
+    static void BenchKsearchU32(Bench::Context& Context)
+    {
+        auto const search = static_cast<BenchSearchTable*>(Context.Fixture);
+        if (search == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            size_t const index = ksearch_u32_lower_bound(search->Tree, search->Probes[i % BenchSearchProbes]);
+            Bench::DoNotOptimize(index);
+        }
+    }
+
+    static void BenchKsearchTable(Bench::Context& Context)
+    {
+        auto const search = static_cast<BenchSearchTable*>(Context.Fixture);
+        if (search == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            unsigned int const key = search->Probes[i % BenchSearchProbes];
+            void const* const found = ksearch_table_find(search->Table, &key, BenchCompareKeys);
+            Bench::DoNotOptimize(found);
+        }
+    }
+
+    KBENCH_FIXTURE(Search, BsearchL1, 0, MakeBenchSearchTable<4096>, FreeBenchSearchTable)
+    {
+        BenchBsearch(Context);
+    }
+
+    KBENCH_FIXTURE(Search, KsearchU32L1, 0, MakeBenchSearchTable<4096>, FreeBenchSearchTable)
+    {
+        BenchKsearchU32(Context);
+    }
+
+    KBENCH_FIXTURE(Search, KsearchTableL1, 0, MakeBenchSearchTable<4096>, FreeBenchSearchTable)
+    {
+        BenchKsearchTable(Context);
+    }
+
+    KBENCH_FIXTURE(Search, BsearchL2, 0, MakeBenchSearchTable<65536>, FreeBenchSearchTable)
+    {
+        BenchBsearch(Context);
+    }
+
+    KBENCH_FIXTURE(Search, KsearchU32L2, 0, MakeBenchSearchTable<65536>, FreeBenchSearchTable)
+    {
+        BenchKsearchU32(Context);
+    }
+
+    KBENCH_FIXTURE(Search, KsearchTableL2, 0, MakeBenchSearchTable<65536>, FreeBenchSearchTable)
+    {
+        BenchKsearchTable(Context);
+    }
+
+    KBENCH_FIXTURE(Search, BsearchDram, 0, MakeBenchSearchTable<4 * 1024 * 1024>, FreeBenchSearchTable)
+    {
+        BenchBsearch(Context);
+    }
+
+    KBENCH_FIXTURE(Search, KsearchU32Dram, 0, MakeBenchSearchTable<4 * 1024 * 1024>, FreeBenchSearchTable)
+    {
+        BenchKsearchU32(Context);
+    }
+
+    KBENCH_FIXTURE(Search, KsearchTableDram, 0, MakeBenchSearchTable<4 * 1024 * 1024>, FreeBenchSearchTable)
+    {
+        BenchKsearchTable(Context);
+    }
+
+    // CRT: Clock sources.  The *Read entries time one reading; the *Tick
+    // entries spin until the reading changes, so that one iteration is the
+    // clock's effective resolution.
+    template <long long (__cdecl* Read)()>
+    static void BenchClockRead(Bench::Context& Context)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            long long const now = Read();
+            Bench::DoNotOptimize(now);
+        }
+    }
+
+    template <long long (__cdecl* Read)()>
+    static void BenchClockTick(Bench::Context& Context)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            long long const start = Read();
+            long long now;
+            do {
+                now = Read();
+            } while (now == start);
+            Bench::DoNotOptimize(now);
+        }
+    }
+
+    static long long __cdecl BenchPerformanceCounter()
+    {
+        return KeQueryPerformanceCounter(nullptr).QuadPart;
+    }
+
+    KBENCH(Clock, RealtimePreciseRead)
+    {
+        BenchClockRead<kclock_realtime_precise>(Context);
+    }
+
+    KBENCH(Clock, RealtimeCoarseRead)
+    {
+        BenchClockRead<kclock_realtime_coarse>(Context);
+    }
+
+    KBENCH(Clock, MonotonicRead)
+    {
+        BenchClockRead<kclock_monotonic>(Context);
+    }
+
+    KBENCH(Clock, MonotonicCoarseRead)
+    {
+        BenchClockRead<kclock_monotonic_coarse>(Context);
+    }
+
+    KBENCH(Clock, PerformanceCounterRead)
+    {
+        BenchClockRead<BenchPerformanceCounter>(Context);
+    }
+
+    KBENCH(Clock, SteadyClockNow)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const now = std::chrono::steady_clock::now();
+            Bench::DoNotOptimize(now);
+        }
+    }
+
+    KBENCH(Clock, SystemClockNow)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const now = std::chrono::system_clock::now();
+            Bench::DoNotOptimize(now);
+        }
+    }
+
+    KBENCH(Clock, TimespecGet)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            timespec ts;
+            timespec_get(&ts, TIME_UTC);
+            Bench::DoNotOptimize(ts);
+        }
+    }
+
+    KBENCH(Clock, RealtimePreciseTick)
+    {
+        BenchClockTick<kclock_realtime_precise>(Context);
+    }
+
+    KBENCH(Clock, RealtimeCoarseTick)
+    {
+        BenchClockTick<kclock_realtime_coarse>(Context);
+    }
+
+    KBENCH(Clock, MonotonicTick)
+    {
+        BenchClockTick<kclock_monotonic>(Context);
+    }
+
+    KBENCH(Clock, MonotonicCoarseTick)
+    {
+        BenchClockTick<kclock_monotonic_coarse>(Context);
+    }
+
+    // CRT: Time conversion and formatting.  Each iteration is one event one
+    // second after the last, so AuditEvent (localtime_s and an RFC 3339
+    // timestamp) is the cost of stamping one audit record.
+    constexpr __time64_t BenchTimeBase = 1700000000;
+
+    KBENCH(Time, GmtimeS)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            __time64_t const t = BenchTimeBase + static_cast<__time64_t>(i);
+            tm value;
+            _gmtime64_s(&value, &t);
+            Bench::DoNotOptimize(value);
+        }
+    }
+
+    KBENCH(Time, LocaltimeS)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            __time64_t const t = BenchTimeBase + static_cast<__time64_t>(i);
+            tm value;
+            _localtime64_s(&value, &t);
+            Bench::DoNotOptimize(value);
+        }
+    }
+
+    KBENCH(Time, StrftimeIso)
+    {
+        __time64_t const t = BenchTimeBase;
+        tm value;
+        _gmtime64_s(&value, &t);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            char buffer[32];
+            size_t const length = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &value);
+            Bench::DoNotOptimize(length);
+        }
+    }
+
+    KBENCH(Time, StrftimeLocale)
+    {
+        __time64_t const t = BenchTimeBase;
+        tm value;
+        _gmtime64_s(&value, &t);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            char buffer[64];
+            size_t const length = strftime(buffer, sizeof(buffer), "%a %b %d %H:%M:%S %Y", &value);
+            Bench::DoNotOptimize(length);
+        }
+    }
+
+    KBENCH(Time, AuditEvent)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            __time64_t const t = BenchTimeBase + static_cast<__time64_t>(i);
+            tm value;
+            _localtime64_s(&value, &t);
+            char buffer[32];
+            size_t const length = strftime(buffer, sizeof(buffer), "%FT%T%z", &value);
+            Bench::DoNotOptimize(length);
+        }
+    }
+
+    // STL: <chrono> time zones on a ktzdb database of the sample zones and
+    // BenchTzdbCopies copies of New York, about the size of the IANA one.
+    // Validate is the check ktzdb_load makes, without publishing the
+    // database:  every loaded database is kept until unload, so FirstUse,
+    // which loads it and looks up every copy (parsing each), is measured once
+    // rather than sampled.  The lookups are of times spread over 1970 to
+    // 2100, a half in the transitions and a half in the rule.
+    constexpr unsigned  BenchTzdbCopies = 400;
+    constexpr long long BenchTzdbSpan   = 130ll * 365 * 86400;
+
+    std::vector<unsigned char> MakeSampleTzdb(unsigned copies);    // TestForDriver.Main.cpp
+
+    static std::vector<unsigned char> const& BenchTzdb()
+    {
+        static std::vector<unsigned char> const database = MakeSampleTzdb(BenchTzdbCopies);
+        return database;
+    }
+
+    static void* MakeBenchTzdbNames()
+    {
+        auto const names = new std::vector<std::string>();
+        for (unsigned i = 0; i < BenchTzdbCopies; ++i) {
+            names->push_back(std::format("Etc/Sample{:04}", i));
+        }
+        return names;
+    }
+
+    static void* LoadBenchTzdbNames()
+    {
+        auto const& database = BenchTzdb();
+        ktzdb_load(database.data(), database.size());
+        return MakeBenchTzdbNames();
+    }
+
+    static void FreeBenchTzdbNames(void* const Fixture)
+    {
+        delete static_cast<std::vector<std::string>*>(Fixture);
+    }
+
+    static std::chrono::sys_seconds BenchTzdbTime(ULONG64 const i)
+    {
+        return std::chrono::sys_seconds{ std::chrono::seconds{ static_cast<long long>(i * 2654435761ull % BenchTzdbSpan) } };
+    }
+
+    KBENCH(Tzdb, Validate)
+    {
+        auto const& database = BenchTzdb();
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            errno_t const result = ktzdb_validate(database.data(), database.size());
+            Bench::DoNotOptimize(result);
+        }
+    }
+
+    KBENCH_FIXTURE(Tzdb, FirstUse, KBENCH_MEASURED, MakeBenchTzdbNames, FreeBenchTzdbNames)
+    {
+        auto const& database = BenchTzdb();
+        auto const& names = *static_cast<std::vector<std::string>*>(Context.Fixture);
+        ULONG64 const start = ReadTimeStampCounter();
+        ktzdb_load(database.data(), database.size());
+        for (auto const& name : names) {
+            __std_tzdb_sys_info* const info = __std_tzdb_get_sys_info(name.c_str(), name.size(), 1.7e12);
+            Bench::DoNotOptimize(info->_Offset);
+            __std_tzdb_delete_sys_info(info);
+        }
+        Context.Ticks = ReadTimeStampCounter() - start;
+    }
+
+    KBENCH_FIXTURE(Tzdb, GetSysInfo, 0, LoadBenchTzdbNames, FreeBenchTzdbNames)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            double const time = static_cast<double>(BenchTzdbTime(i).time_since_epoch().count()) * 1000;
+            __std_tzdb_sys_info* const info = __std_tzdb_get_sys_info("America/New_York", 16, time);
+            Bench::DoNotOptimize(info->_Offset);
+            __std_tzdb_delete_sys_info(info);
+        }
+    }
+
+    KBENCH_FIXTURE(Tzdb, GetInfo, 0, LoadBenchTzdbNames, FreeBenchTzdbNames)
+    {
+        std::chrono::time_zone const* const zone = std::chrono::locate_zone("America/New_York");
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::chrono::sys_info const info = zone->get_info(BenchTzdbTime(i));
+            Bench::DoNotOptimize(info);
+        }
+    }
+
+    KBENCH_FIXTURE(Tzdb, LocateZoneGetInfo, 0, LoadBenchTzdbNames, FreeBenchTzdbNames)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::chrono::sys_info const info = std::chrono::locate_zone("US/Eastern")->get_info(BenchTzdbTime(i));
+            Bench::DoNotOptimize(info);
+        }
+    }
+
+    KBENCH_FIXTURE(Tzdb, ZonedTimeFormat, 0, LoadBenchTzdbNames, FreeBenchTzdbNames)
+    {
+        std::chrono::time_zone const* const zone = std::chrono::locate_zone("America/New_York");
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            char buffer[64];
+            std::chrono::zoned_time const zoned{ zone, BenchTzdbTime(i) };
+            auto const result = std::format_to_n(buffer, sizeof(buffer), "{:%F %T %Z}", zoned);
+            Bench::DoNotOptimize(result);
+        }
+    }
+
+    // STL: Logging.  One iteration is one line, so lines per second is
+    // 10^9 / ns.  DbgPrintEx is the synchronous baseline, what MusaLOG costs.
+    // The others go through the kernel log to a file sink and drain it every
+    // BenchLogBatch lines on the benchmark's own processor, so their time
+    // includes writing the file as well as the format_to and the append.
+    constexpr ULONG64 BenchLogBatch = 256;
+
+    static void* MakeBenchLogSink()
+    {
+        int const fd = _open("C:\\musa_klog_bench.tmp",
+            _O_CREAT | _O_TRUNC | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd < 0 || klog_set_file_sink(fd) != 0) {
+            return nullptr;
+        }
+        return new int(fd);
+    }
+
+    static void FreeBenchLogSink(void* const Fixture)
+    {
+        klog_flush();
+        klog_set_debugger_sink(DPFLTR_DEFAULT_ID);
+        if (auto const fd = static_cast<int*>(Fixture)) {
+            _close(*fd);
+            delete fd;
+        }
+        _unlink("C:\\musa_klog_bench.tmp");
+    }
+
+    KBENCH(Log, DbgPrintEx)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            ULONG const status = DbgPrintEx(DPFLTR_DEFAULT_ID, DPFLTR_ERROR_LEVEL,
+                "[Musa.Runtime] bench line %llu of %s\n", i, "Log");
+            Bench::DoNotOptimize(status);
+        }
+    }
+
+    KBENCH_FIXTURE(Log, Println, 0, MakeBenchLogSink, FreeBenchLogSink)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::println(stdout, "[Musa.Runtime] bench line {} of {}", i, "Log");
+            if (i % BenchLogBatch == BenchLogBatch - 1) {
+                klog_flush();
+            }
+        }
+        klog_flush();
+    }
+
+    KBENCH_FIXTURE(Log, KlogPrint, 0, MakeBenchLogSink, FreeBenchLogSink)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            errno_t const result = klog_print(KLOG_INFO, "[Musa.Runtime] bench line {} of {}", i, "Log");
+            Bench::DoNotOptimize(result);
+            if (i % BenchLogBatch == BenchLogBatch - 1) {
+                klog_flush();
+            }
+        }
+        klog_flush();
+    }
+
+    // Locks, uncontended
+    KBENCH_F(Locks, SpinLock, KBENCH_ALL_CPUS)
+    {
+        KSPIN_LOCK lock;
+        KeInitializeSpinLock(&lock);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            KIRQL irql;
+            KeAcquireSpinLock(&lock, &irql);
+            KeReleaseSpinLock(&lock, irql);
+        }
+    }
+
+    KBENCH(Locks, QueuedSpinLock)
+    {
+        KSPIN_LOCK lock;
+        KeInitializeSpinLock(&lock);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            KLOCK_QUEUE_HANDLE handle;
+            KeAcquireInStackQueuedSpinLock(&lock, &handle);
+            KeReleaseInStackQueuedSpinLock(&handle);
+        }
+    }
+
+    KBENCH(Locks, PushLockExclusive)
+    {
+        EX_PUSH_LOCK lock;
+        ExInitializePushLock(&lock);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            KeEnterCriticalRegion();
+            ExAcquirePushLockExclusive(&lock);
+            ExReleasePushLockExclusive(&lock);
+            KeLeaveCriticalRegion();
+        }
+    }
+
+    KBENCH(Locks, FastMutex)
+    {
+        FAST_MUTEX mutex;
+        ExInitializeFastMutex(&mutex);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            ExAcquireFastMutex(&mutex);
+            ExReleaseFastMutex(&mutex);
+        }
+    }
+
+    KBENCH(Locks, AtomicFetchAdd)
+    {
+        std::atomic<ULONG64> counter{ 0 };
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            counter.fetch_add(1);
+        }
+        Bench::DoNotOptimize(counter);
+    }
+
+    // CRT: Exceptions
+    __declspec(noinline) static int BenchThrow(int const Depth)
+    {
+        if (Depth <= 1) {
+            throw std::runtime_error("bench");
+        }
+        return BenchThrow(Depth - 1) + 1;
+    }
+
+    KBENCH(Exceptions, ThrowCatchDepth1)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            try { Bench::DoNotOptimize(BenchThrow(1)); }
+            catch (const std::runtime_error& e) { Bench::DoNotOptimize(e); }
+        }
+    }
+
+    KBENCH(Exceptions, ThrowCatchDepth10)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            try { Bench::DoNotOptimize(BenchThrow(10)); }
+            catch (const std::runtime_error& e) { Bench::DoNotOptimize(e); }
+        }
+    }
+
+    KBENCH(Exceptions, ThrowCatchDepth50)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            try { Bench::DoNotOptimize(BenchThrow(50)); }
+            catch (const std::runtime_error& e) { Bench::DoNotOptimize(e); }
+        }
+    }
+
+    // The exception_ptr blocks come from the per-processor pool.
+    template <int Depth>
+    static void BenchCurrentException(Bench::Context& Context)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::exception_ptr captured;
+            try { Bench::DoNotOptimize(BenchThrow(Depth)); }
+            catch (...) { captured = std::current_exception(); }
+            Bench::DoNotOptimize(captured);
+        }
+    }
+
+    KBENCH(Exceptions, CurrentExceptionDepth1)
+    {
+        BenchCurrentException<1>(Context);
+    }
+
+    KBENCH(Exceptions, CurrentExceptionDepth10)
+    {
+        BenchCurrentException<10>(Context);
+    }
+
+    KBENCH(Exceptions, CurrentExceptionDepth50)
+    {
+        BenchCurrentException<50>(Context);
+    }
+
+#if defined _M_AMD64 || defined _M_ARM64
+    // CRT: Function table lookup, the kernel's against the image's .pdata
+    // index with its last-hit cache.  Lookups alternate between two functions.
+    template <class Lookup>
+    static void BenchFunctionLookup(Bench::Context& Context, Lookup const& Find)
+    {
+        ULONG64 const pcs[] = {
+            reinterpret_cast<ULONG64>(&BenchThrow) + 4,
+            reinterpret_cast<ULONG64>(&Bench::RunBenchmarks) + 16,
+        };
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            ULONG64 base = 0;
+            Bench::DoNotOptimize(Find(pcs[i & 1], &base, nullptr));
+        }
+    }
+
+    KBENCH(Unwind, RtlLookupFunctionEntry)
+    {
+        BenchFunctionLookup(Context, RtlLookupFunctionEntry);
+    }
+
+    KBENCH(Unwind, IndexLookup)
+    {
+        BenchFunctionLookup(Context, kunwind_lookup_function_entry);
+    }
+#endif
+
+    // CRT: RTTI.  dynamic_cast down single, multiple and virtual inheritance,
+    // without and with the cast cache.
+    struct BenchSiBase  { virtual ~BenchSiBase() = default; int base = 0; };
+    struct BenchSiMid   : BenchSiBase { int mid = 1; };
+    struct BenchSiLeaf  : BenchSiMid  { int leaf = 2; };
+
+    struct BenchMiLeft  { virtual ~BenchMiLeft() = default;  int left = 0; };
+    struct BenchMiRight { virtual ~BenchMiRight() = default; int right = 1; };
+    struct BenchMiJoin  : BenchMiLeft, BenchMiRight { int join = 2; };
+
+    struct BenchViBase  { virtual ~BenchViBase() = default; int base = 0; };
+    struct BenchViLeft  : virtual BenchViBase { int left = 1; };
+    struct BenchViRight : virtual BenchViBase { int right = 2; };
+    struct BenchViJoin  : BenchViLeft, BenchViRight { int join = 3; };
+
+    static void* EnableBenchCastCache()
+    {
+        krtti_set_cast_cache(true);
+        return nullptr;
+    }
+
+    static void DisableBenchCastCache(void*)
+    {
+        krtti_set_cast_cache(false);
+    }
+
+    template <class Target, class Base, class Object>
+    static void BenchDynamicCast(Bench::Context& Context)
+    {
+        Object object;
+        Base* volatile const source = &object;
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            Bench::DoNotOptimize(dynamic_cast<Target*>(source));
+        }
+    }
+
+    KBENCH(Rtti, DynamicCastSI)
+    {
+        BenchDynamicCast<BenchSiLeaf, BenchSiBase, BenchSiLeaf>(Context);
+    }
+
+    KBENCH(Rtti, DynamicCastMI)
+    {
+        BenchDynamicCast<BenchMiRight, BenchMiLeft, BenchMiJoin>(Context);
+    }
+
+    KBENCH(Rtti, DynamicCastVI)
+    {
+        BenchDynamicCast<BenchViRight, BenchViBase, BenchViJoin>(Context);
+    }
+
+    KBENCH_FIXTURE(Rtti, DynamicCastSICached, 0, EnableBenchCastCache, DisableBenchCastCache)
+    {
+        BenchDynamicCast<BenchSiLeaf, BenchSiBase, BenchSiLeaf>(Context);
+    }
+
+    KBENCH_FIXTURE(Rtti, DynamicCastMICached, 0, EnableBenchCastCache, DisableBenchCastCache)
+    {
+        BenchDynamicCast<BenchMiRight, BenchMiLeft, BenchMiJoin>(Context);
+    }
+
+    KBENCH_FIXTURE(Rtti, DynamicCastVICached, 0, EnableBenchCastCache, DisableBenchCastCache)
+    {
+        BenchDynamicCast<BenchViRight, BenchViBase, BenchViJoin>(Context);
+    }
+
+    // A type_index-keyed dispatch table, as std::any and std::function
+    // users build them; the hashes of type_info are memoized.
+    using BenchLongType = std::map<std::wstring, std::vector<std::pair<std::wstring, std::unordered_map<int, std::string>>>>;
+    using BenchTypeMap  = std::unordered_map<std::type_index, int>;
+
+    static std::type_index const BenchTypeKeys[] = {
+        typeid(int), typeid(BenchSiLeaf), typeid(BenchMiJoin), typeid(BenchViJoin), typeid(BenchLongType),
+        typeid(std::unordered_map<std::wstring, std::vector<std::string>>),
+    };
+
+    static void* MakeBenchTypeMap()
+    {
+        auto const map = new BenchTypeMap;
+        for (size_t i = 0; i < std::size(BenchTypeKeys); ++i) {
+            map->emplace(BenchTypeKeys[i], static_cast<int>(i));
+        }
+        return map;
+    }
+
+    static void FreeBenchTypeMap(void* const Fixture)
+    {
+        delete static_cast<BenchTypeMap*>(Fixture);
+    }
+
+    KBENCH_FIXTURE(Rtti, TypeIndexMapFind, 0, MakeBenchTypeMap, FreeBenchTypeMap)
+    {
+        auto const& map = *static_cast<BenchTypeMap const*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            Bench::DoNotOptimize(map.find(BenchTypeKeys[i % std::size(BenchTypeKeys)])->second);
+        }
+    }
+
+    // Undecoration of a corpus of names from short to long; one iteration
+    // undecorates all of them, on the heap or into an arena in one batch.
+    static char const* const BenchDecoratedNames[] = {
+        "?Foo@@YAHH@Z",
+        "?x@@3HA",
+        "??0Bar@@QEAA@XZ",
+        "??2@YAPEAX_K@Z",
+        "??_7type_info@@6B@",
+        "?what@exception@std@@UEBAPEBDXZ",
+        "?DriverEntry@@YAJPEAU_DRIVER_OBJECT@@PEAU_UNICODE_STRING@@@Z",
+        "?push_back@?$vector@HV?$allocator@H@std@@@std@@QEAAXAEBH@Z",
+        "??1?$basic_string@DU?$char_traits@D@std@@V?$allocator@D@2@@std@@QEAA@XZ",
+        "??$make_shared@VFoo@@$$V@std@@YA?AV?$shared_ptr@VFoo@@@0@XZ",
+        "?find@?$_Hash@V?$_Umap_traits@HHV?$_Uhash_compare@HU?$hash@H@std@@U?$equal_to@H@2@@std@@V?$allocator@U?$pair@$$CBHH@std@@@2@$0A@@std@@@std@@QEAA?AV?$_List_iterator@V?$_List_val@U?$_List_simple_types@U?$pair@$$CBHH@std@@@std@@@std@@@2@AEBH@Z",
+        "_not_decorated",
+    };
+
+    struct BenchUndnameBuffers
+    {
+        char        Arena[64 * 1024];
+        char        Packed[16 * 1024];
+        char const* Results[std::size(BenchDecoratedNames)];
+    };
+
+    static void* MakeBenchUndnameBuffers()
+    {
+        return new BenchUndnameBuffers;
+    }
+
+    static void FreeBenchUndnameBuffers(void* const Fixture)
+    {
+        delete static_cast<BenchUndnameBuffers*>(Fixture);
+    }
+
+    KBENCH(Rtti, UndnameHeap)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            for (char const* const name : BenchDecoratedNames) {
+                char* const text = __unDName(nullptr, name, 0, malloc, free, 0);
+                Bench::DoNotOptimize(text);
+                free(text);
+            }
+        }
+    }
+
+    KBENCH_FIXTURE(Rtti, UndnameArenaBatch, 0, MakeBenchUndnameBuffers, FreeBenchUndnameBuffers)
+    {
+        auto const buffers = static_cast<BenchUndnameBuffers*>(Context.Fixture);
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            size_t const count = kundname_batch(BenchDecoratedNames, buffers->Results, std::size(BenchDecoratedNames),
+                buffers->Packed, sizeof(buffers->Packed), buffers->Arena, sizeof(buffers->Arena), 0);
+            Bench::DoNotOptimize(count);
+        }
+    }
+
+    // CRT: Startup.  Measured once, from DriverEntry to DriverMain, by the
+    // startup trace.
+    KBENCH_F(Startup, EntryToMain, KBENCH_MEASURED)
+    {
+        kstartup_summary summary{};
+        (void)kstartup_trace_query(nullptr, 0, &summary);
+        Context.Ticks = summary.entry_to_main_cycles;
+    }
+
+    // The build of the test's parallel and deferred objects, measured once by
+    // the runtime.  KinitSum is built on first access, here if not already.
+    extern kinit_object<std::vector<unsigned long long>> KinitSquares;    // TestForDriver.Main.cpp
+    extern kinit_object<unsigned long long>              KinitSum;        // TestForDriver.Main.cpp
+
+    KBENCH_F(Kinit, BuildParallelSquares, KBENCH_MEASURED)
+    {
+        Context.Ticks = KinitSquares.entry.cycles;
+    }
+
+    KBENCH_F(Kinit, BuildDeferredSum, KBENCH_MEASURED)
+    {
+        Bench::DoNotOptimize(*KinitSum);
+        Context.Ticks = KinitSum.entry.cycles;
+    }
+
+    // CRT: Allocation telemetry.  The loop of Alloc/KmallocFree64 (telemetry
+    // disabled) with every allocation counted, and with 1 in 1000 sampled.
+    template <unsigned long SampleEvery>
+    static void* EnableBenchMemprof()
+    {
+        kmemprof_options options{};
+        options.buckets      = 256;
+        options.live_blocks  = 4096;
+        options.sample_every = SampleEvery;
+        (void)kmemprof_enable(&options);
+        return nullptr;
+    }
+
+    static void DisableBenchMemprof(void*)
+    {
+        kmemprof_disable();
+    }
+
+    KBENCH_FIXTURE(KMemProf, KmallocFree64Counting, 0, EnableBenchMemprof<0>, DisableBenchMemprof)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            void* const p = kmalloc(64, NonPagedPoolNx, BenchTag);
+            Bench::DoNotOptimize(p);
+            kfree(p, BenchTag);
+        }
+    }
+
+    KBENCH_FIXTURE(KMemProf, KmallocFree64Sampling1000, 0, EnableBenchMemprof<1000>, DisableBenchMemprof)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            void* const p = kmalloc(64, NonPagedPoolNx, BenchTag);
+            Bench::DoNotOptimize(p);
+            kfree(p, BenchTag);
+        }
+    }
+
+    // CRT: NTSTATUS to errno, directly and by way of the Win32 error and
+    // system_category, and nt_category's condition and message.
+    static NTSTATUS const BenchStatuses[] = {
+        STATUS_ACCESS_DENIED, STATUS_OBJECT_NAME_NOT_FOUND, STATUS_INSUFFICIENT_RESOURCES,
+        STATUS_INVALID_PARAMETER, STATUS_SHARING_VIOLATION, STATUS_OBJECT_NAME_COLLISION,
+        STATUS_DISK_FULL, STATUS_NOT_SUPPORTED,
+    };
+
+    KBENCH(Errno, NtStatusDirect)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            Bench::DoNotOptimize(kerrno_from_ntstatus(BenchStatuses[i & 7]));
+        }
+    }
+
+    KBENCH(Errno, NtStatusViaWin32SystemCategory)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            std::error_code const code(static_cast<int>(RtlNtStatusToDosError(BenchStatuses[i & 7])), std::system_category());
+            Bench::DoNotOptimize(code.default_error_condition().value());
+        }
+    }
+
+    KBENCH(Errno, NtCategoryCondition)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            Bench::DoNotOptimize(std::make_nt_error_code(BenchStatuses[i & 7]).default_error_condition().value());
+        }
+    }
+
+    KBENCH(Errno, NtStatusMessage)
+    {
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            Bench::DoNotOptimize(kntstatus_message(BenchStatuses[i & 7]));
+        }
+    }
+
+    // CRT: Descriptor allocation.  BenchChurnLive descriptors are open (the
+    // CRT caps them at 8192); one iteration closes one and dups another into
+    // the lowest free slot.
+    constexpr size_t BenchChurnLive = 8000;
+
+    struct BenchChurn
+    {
+        int              File;
+        std::vector<int> Live;
+    };
+
+    static void* MakeBenchChurn()
+    {
+        auto const churn = new BenchChurn;
+        churn->File = _open("C:\\musa_bench_churn.tmp", _O_CREAT | _O_RDWR | _O_BINARY, _S_IREAD | _S_IWRITE);
+        churn->Live.reserve(BenchChurnLive);
+        while (churn->File >= 0 && churn->Live.size() < BenchChurnLive) {
+            int const fd = _dup(churn->File);
+            if (fd < 0) {
+                break;
+            }
+            churn->Live.push_back(fd);
+        }
+        return churn;
+    }
+
+    static void FreeBenchChurn(void* const Fixture)
+    {
+        auto const churn = static_cast<BenchChurn*>(Fixture);
+        for (int const fd : churn->Live) {
+            if (fd >= 0) {
+                _close(fd);
+            }
+        }
+        if (churn->File >= 0) {
+            _close(churn->File);
+        }
+        _unlink("C:\\musa_bench_churn.tmp");
+        delete churn;
+    }
+
+    KBENCH_FIXTURE(LowIO, Churn, 0, MakeBenchChurn, FreeBenchChurn)
+    {
+        auto const churn = static_cast<BenchChurn*>(Context.Fixture);
+        if (churn->Live.empty()) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            size_t const k = static_cast<size_t>(i * 2654435761u % churn->Live.size());
+            _close(churn->Live[k]);
+            churn->Live[k] = _dup(churn->File);
+        }
+    }
+
+    // CRT: File throughput.  One iteration writes or reads the whole text:
+    // BenchLogLines log lines and, for the writes, a 64 KiB span without a
+    // newline.  Text mode translates every LF to or from CRLF.
+    constexpr size_t BenchLogLines = 4096;
+
+    static std::string MakeBenchLogText(bool const Span)
+    {
+        std::string text;
+        text.reserve(BenchLogLines * 44 + (Span ? 64 * 1024 : 0));
+        for (size_t i = 0; i < BenchLogLines; ++i) {
+            text += "[musa] kernel log line with some payload ";
+            text += static_cast<char>('0' + i % 10);
+            text += '\n';
+        }
+        if (Span) {
+            text.append(64 * 1024, 'x');
+        }
+        return text;
+    }
+
+    struct BenchFile
+    {
+        char const*                Path;
+        int                        Fd;
+        FILE*                      Stream;
+        std::string                Text;
+        std::vector<unsigned char> Buffer;
+    };
+
+    static void FreeBenchFile(void* const Fixture)
+    {
+        auto const file = static_cast<BenchFile*>(Fixture);
+        if (file->Stream != nullptr) {
+            fclose(file->Stream);
+        }
+        else if (file->Fd >= 0) {
+            _close(file->Fd);
+        }
+        _unlink(file->Path);
+        delete file;
+    }
+
+    template <int Mode, bool Stdio>
+    static void* MakeBenchWriteFile()
+    {
+        auto const file = new BenchFile{ "C:\\musa_bench_write.tmp", -1, nullptr, MakeBenchLogText(true), {} };
+        file->Fd = _open(file->Path, _O_CREAT | _O_TRUNC | _O_RDWR | Mode, _S_IREAD | _S_IWRITE);
+        if (Stdio && file->Fd >= 0) {
+            file->Stream = _fdopen(file->Fd, Mode == _O_TEXT ? "wt" : "wb");
+        }
+        return file;
+    }
+
+    static void BenchWrite(Bench::Context& Context)
+    {
+        auto const file = static_cast<BenchFile*>(Context.Fixture);
+        if (file->Fd < 0) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            _lseek(file->Fd, 0, SEEK_SET);
+            int const written = _write(file->Fd, file->Text.data(), static_cast<unsigned>(file->Text.size()));
+            Bench::DoNotOptimize(written);
+        }
+    }
+
+    static void BenchFWrite(Bench::Context& Context)
+    {
+        auto const file = static_cast<BenchFile*>(Context.Fixture);
+        if (file->Stream == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            fseek(file->Stream, 0, SEEK_SET);
+            size_t const written = fwrite(file->Text.data(), 1, file->Text.size(), file->Stream);
+            fflush(file->Stream);
+            Bench::DoNotOptimize(written);
+        }
+    }
+
+    KBENCH_FIXTURE(LowIO, WriteText, 0, (MakeBenchWriteFile<_O_TEXT, false>), FreeBenchFile)
+    {
+        BenchWrite(Context);
+    }
+
+    KBENCH_FIXTURE(LowIO, WriteBinary, 0, (MakeBenchWriteFile<_O_BINARY, false>), FreeBenchFile)
+    {
+        BenchWrite(Context);
+    }
+
+    KBENCH_FIXTURE(StdIO, FWriteText, 0, (MakeBenchWriteFile<_O_TEXT, true>), FreeBenchFile)
+    {
+        BenchFWrite(Context);
+    }
+
+    KBENCH_FIXTURE(StdIO, FWriteBinary, 0, (MakeBenchWriteFile<_O_BINARY, true>), FreeBenchFile)
+    {
+        BenchFWrite(Context);
+    }
+
+    // The log text, written in text mode and read back the same way.
+    template <bool Stdio>
+    static void* MakeBenchReadFile()
+    {
+        auto const file = new BenchFile{ "C:\\musa_bench_read.tmp", -1, nullptr, MakeBenchLogText(false), {} };
+        int const fd = _open(file->Path, _O_CREAT | _O_TRUNC | _O_WRONLY | _O_TEXT, _S_IREAD | _S_IWRITE);
+        if (fd >= 0) {
+            _write(fd, file->Text.data(), static_cast<unsigned>(file->Text.size()));
+            _close(fd);
+        }
+        file->Buffer.resize(file->Text.size() + 64);
+        if (Stdio) {
+            file->Stream = fopen(file->Path, "rt");
+        }
+        else {
+            file->Fd = _open(file->Path, _O_RDONLY | _O_TEXT);
+        }
+        return file;
+    }
+
+    KBENCH_FIXTURE(LowIO, ReadText, 0, MakeBenchReadFile<false>, FreeBenchFile)
+    {
+        auto const file = static_cast<BenchFile*>(Context.Fixture);
+        if (file->Fd < 0) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            _lseek(file->Fd, 0, SEEK_SET);
+            size_t total = 0;
+            int    n;
+            while ((n = _read(file->Fd, file->Buffer.data() + total, static_cast<unsigned>(file->Buffer.size() - total))) > 0) {
+                total += static_cast<size_t>(n);
+            }
+            Bench::DoNotOptimize(total);
+        }
+    }
+
+    KBENCH_FIXTURE(StdIO, FGetsText, 0, MakeBenchReadFile<true>, FreeBenchFile)
+    {
+        auto const file = static_cast<BenchFile*>(Context.Fixture);
+        if (file->Stream == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            fseek(file->Stream, 0, SEEK_SET);
+            char   line[128];
+            size_t lines = 0;
+            while (fgets(line, sizeof(line), file->Stream)) {
+                ++lines;
+            }
+            Bench::DoNotOptimize(lines);
+        }
+    }
+
+    // CRT: Memory-mapped streams.  One iteration sums a BenchMappedSize file
+    // through fread in 64 KiB chunks from a buffered ("rb") or mapped ("rm")
+    // stream, or straight from the mapped view.
+    constexpr size_t BenchMappedSize = 4 * 1024 * 1024;
+
+    template <char Mode>
+    static void* MakeBenchMappedFile()
+    {
+        auto const file = new BenchFile{ "C:\\musa_bench_map.tmp", -1, nullptr, {}, {} };
+        file->Buffer.resize(BenchMappedSize);
+        for (size_t i = 0; i < BenchMappedSize; ++i) {
+            file->Buffer[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+        }
+        if (FILE* const w = fopen(file->Path, "wb")) {
+            fwrite(file->Buffer.data(), 1, file->Buffer.size(), w);
+            fclose(w);
+        }
+        char const mode[] = { 'r', Mode, '\0' };
+        file->Buffer.resize(64 * 1024);
+        file->Stream = fopen(file->Path, mode);
+        return file;
+    }
+
+    static void BenchFRead(Bench::Context& Context)
+    {
+        auto const file = static_cast<BenchFile*>(Context.Fixture);
+        if (file->Stream == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            fseek(file->Stream, 0, SEEK_SET);
+            uint64_t sum = 0;
+            size_t   n;
+            while ((n = fread(file->Buffer.data(), 1, file->Buffer.size(), file->Stream)) != 0) {
+                sum = std::accumulate(file->Buffer.begin(), file->Buffer.begin() + n, sum);
+            }
+            Bench::DoNotOptimize(sum);
+        }
+    }
+
+    KBENCH_FIXTURE(StdIO, FReadBuffered, 0, MakeBenchMappedFile<'b'>, FreeBenchFile)
+    {
+        BenchFRead(Context);
+    }
+
+    KBENCH_FIXTURE(StdIO, FReadMapped, 0, MakeBenchMappedFile<'m'>, FreeBenchFile)
+    {
+        BenchFRead(Context);
+    }
+
+    KBENCH_FIXTURE(StdIO, MapViewSum, 0, MakeBenchMappedFile<'m'>, FreeBenchFile)
+    {
+        auto const file = static_cast<BenchFile*>(Context.Fixture);
+        if (file->Stream == nullptr) {
+            return;
+        }
+        for (ULONG64 i = 0; i < Context.Iterations; ++i) {
+            auto const view = kfmapview(file->Stream);
+            auto const first = reinterpret_cast<unsigned char const*>(view.data());
+            Bench::DoNotOptimize(std::accumulate(first, first + view.size(), uint64_t{ 0 }));
+        }
+    }
+}
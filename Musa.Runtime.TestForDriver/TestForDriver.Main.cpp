@@ -2,6 +2,9 @@
 #include <new>
 #include <cstdlib>
 #include <exception>
+#include <typeinfo>
+#include <typeindex>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <map>
@@ -27,9 +30,11 @@
 #include <utility>
 #include <bit>
 #include <format>
+#include <print>
 #include <regex>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
 #include <ctime>
 #include <filesystem>
 #include <cctype>
@@ -41,12 +46,206 @@
 #include <fcntl.h>
 #include <kmalloc.h>
 #include <kallocator.h>
-
+#include <kstdio.h>
+#include <krtti.h>
+#include <kundname.h>
+#include <kexception.h>
+#include <kunwind.h>
+#include <kstartup.h>
+#include <kinit.h>
+#include <kerror.h>
+#include <kmemprof.h>
+#include <kclock.h>
+#include <ktzdb.h>
+#include <klog.h>
+#include <kmath.h>
+#include <krand.h>
+#include <ksearch.h>
+#include <ksort.h>
+
+#include "Bench.h"
 #include "Test.h"
 
+// The heap-backed undecorator, as a reference for kundname.
+extern "C" char* __cdecl __unDName(char*, const char*, int, void* (__cdecl*)(size_t), void (__cdecl*)(void*), unsigned short);
+
 
 namespace Main
 {
+    // dynamic_cast hierarchies: single, multiple and virtual inheritance.
+    struct SiBase  { virtual ~SiBase() = default; int base = 0; };
+    struct SiMid   : SiBase { int mid = 1; };
+    struct SiLeaf  : SiMid  { int leaf = 2; };
+
+    struct MiLeft  { virtual ~MiLeft() = default;  int left = 0; };
+    struct MiRight { virtual ~MiRight() = default; int right = 1; };
+    struct MiJoin  : MiLeft, MiRight { int join = 2; };
+
+    struct ViBase  { virtual ~ViBase() = default; int base = 0; };
+    struct ViLeft  : virtual ViBase { int left = 1; };
+    struct ViRight : virtual ViBase { int right = 2; };
+    struct ViJoin  : ViLeft, ViRight { int join = 3; };
+
+    // Deferred and parallel static initialization.
+    static long KinitSumBuilds = 0;
+
+    static void BuildKinitSquares(void* storage)
+    {
+        auto const squares = ::new (storage) std::vector<unsigned long long>(65536);
+        for (size_t i = 0; i < squares->size(); ++i) {
+            (*squares)[i] = static_cast<unsigned long long>(i) * i;
+        }
+    }
+    KINIT_OBJECT(std::vector<unsigned long long>, KinitSquares, KINIT_PARALLEL, BuildKinitSquares, nullptr);
+
+    static kinit_entry* const KinitSumDependencies[] = { &KinitSquares.entry, nullptr };
+    static void BuildKinitSum(void* storage)
+    {
+        InterlockedIncrement(&KinitSumBuilds);
+        ::new (storage) unsigned long long(std::accumulate(KinitSquares->begin(), KinitSquares->end(), 0ull));
+    }
+    KINIT_OBJECT(unsigned long long, KinitSum, KINIT_DEFERRED, BuildKinitSum, KinitSumDependencies);
+
+    // Throws from 'depth' frames down; noinline keeps every frame on the stack.
+    __declspec(noinline) static int ThrowThrough(int depth)
+    {
+        if (depth <= 1) {
+            throw std::runtime_error("deep");
+        }
+        return ThrowThrough(depth - 1) + 1;
+    }
+
+    // Time zone databases in the ktzdb format, with made-up TZif data.
+    struct SampleTzifType { int offset; bool dst; char const* abbrev; };
+
+    static void AppendBe32(std::vector<unsigned char>& out, unsigned const value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<unsigned char>(value >> shift));
+        }
+    }
+
+    static void AppendLe32(std::vector<unsigned char>& out, unsigned const value)
+    {
+        for (int shift = 0; shift < 32; shift += 8) {
+            out.push_back(static_cast<unsigned char>(value >> shift));
+        }
+    }
+
+    static std::vector<unsigned char> MakeSampleTzif(std::vector<SampleTzifType> const& types,
+        std::vector<std::pair<long long, unsigned char>> const& transitions, char const* const footer)
+    {
+        std::string abbrevs;
+        std::vector<unsigned char> tzif;
+        auto const header = [&](size_t const times, size_t const type_count, size_t const chars) {
+            tzif.insert(tzif.end(), { 'T', 'Z', 'i', 'f', '2' });
+            tzif.resize(tzif.size() + 15);
+            for (size_t const count : { size_t{ 0 }, size_t{ 0 }, size_t{ 0 }, times, type_count, chars }) {
+                AppendBe32(tzif, static_cast<unsigned>(count));
+            }
+        };
+
+        // An empty version 1 block: one type, one empty abbreviation.
+        header(0, 1, 1);
+        tzif.resize(tzif.size() + 7);
+
+        for (auto const& type : types) {
+            abbrevs.append(type.abbrev).push_back('\0');
+        }
+        header(transitions.size(), types.size(), abbrevs.size());
+        for (auto const& transition : transitions) {
+            AppendBe32(tzif, static_cast<unsigned>(static_cast<unsigned long long>(transition.first) >> 32));
+            AppendBe32(tzif, static_cast<unsigned>(transition.first));
+        }
+        for (auto const& transition : transitions) {
+            tzif.push_back(transition.second);
+        }
+        size_t abbrev = 0;
+        for (auto const& type : types) {
+            AppendBe32(tzif, static_cast<unsigned>(type.offset));
+            tzif.push_back(type.dst);
+            tzif.push_back(static_cast<unsigned char>(abbrev));
+            abbrev += strlen(type.abbrev) + 1;
+        }
+        tzif.insert(tzif.end(), abbrevs.begin(), abbrevs.end());
+        tzif.push_back('\n');
+        tzif.insert(tzif.end(), footer, footer + strlen(footer));
+        tzif.push_back('\n');
+        return tzif;
+    }
+
+    // America/New_York with the current US rules as transitions from 1970 to
+    // 2037 and as its rule after, Asia/Kolkata with no transitions,
+    // Australia/Sydney with a southern rule, UTC, and the link US/Eastern;
+    // 'copies' adds that many copies of New York, Etc/Sample0000 on.
+    std::vector<unsigned char> MakeSampleTzdb(unsigned const copies)
+    {
+        auto const sunday = [](int const year, int const month, int const nth) {
+            // Days since 1970-01-01 of the nth Sunday of the month.
+            int const y = month <= 2 ? year - 1 : year;
+            int const era = y / 400;
+            int const yoe = y - era * 400;
+            int const doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5;
+            long long const first = era * 146097ll + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+            return first + (7 - (first + 4) % 7) % 7 + 7 * (nth - 1);
+        };
+
+        std::vector<std::pair<long long, unsigned char>> us;
+        for (int year = 1970; year <= 2037; ++year) {
+            us.emplace_back(sunday(year, 3, 2) * 86400 + 7 * 3600, 1);     // 02:00 EST
+            us.emplace_back(sunday(year, 11, 1) * 86400 + 6 * 3600, 0);    // 02:00 EDT
+        }
+        auto const new_york = MakeSampleTzif({ { -18000, false, "EST" }, { -14400, true, "EDT" } }, us, "EST5EDT,M3.2.0,M11.1.0");
+
+        std::map<std::string, std::pair<std::string, std::vector<unsigned char>>> entries;    // name -> link target, TZif
+        entries["America/New_York"].second = new_york;
+        entries["Asia/Kolkata"].second = MakeSampleTzif({ { 19800, false, "IST" } }, {}, "IST-5:30");
+        entries["Australia/Sydney"].second = MakeSampleTzif({ { 36000, false, "AEST" } }, {}, "AEST-10AEDT,M10.1.0,M4.1.0/3");
+        entries["UTC"].second = MakeSampleTzif({ { 0, false, "UTC" } }, {}, "UTC0");
+        entries["US/Eastern"].first = "America/New_York";
+        for (unsigned i = 0; i < copies; ++i) {
+            char name[32];
+            sprintf_s(name, "Etc/Sample%04u", i);
+            entries[name].second = new_york;
+        }
+
+        std::map<std::string, unsigned> index;
+        for (auto const& entry : entries) {
+            index.emplace(entry.first, static_cast<unsigned>(index.size()));
+        }
+
+        size_t const names_offset = 32 + 16 * entries.size();
+        size_t data_offset = names_offset;
+        for (auto const& entry : entries) {
+            data_offset += entry.first.size() + 1;
+        }
+
+        std::vector<unsigned char> database{ 'T', 'Z', 'D', 'B' };
+        AppendLe32(database, 1);
+        AppendLe32(database, static_cast<unsigned>(entries.size()));
+        AppendLe32(database, 0xFFFFFFFFu);
+        database.insert(database.end(), { 's', 'a', 'm', 'p', 'l', 'e' });
+        database.resize(32);
+
+        size_t name_offset = names_offset;
+        for (auto const& entry : entries) {
+            bool const link = !entry.second.first.empty();
+            AppendLe32(database, static_cast<unsigned>(name_offset));
+            AppendLe32(database, link ? index[entry.second.first] : 0xFFFFFFFFu);
+            AppendLe32(database, link ? 0 : static_cast<unsigned>(data_offset));
+            AppendLe32(database, static_cast<unsigned>(entry.second.second.size()));
+            name_offset += entry.first.size() + 1;
+            data_offset += entry.second.second.size();
+        }
+        for (auto const& entry : entries) {
+            database.insert(database.end(), entry.first.c_str(), entry.first.c_str() + entry.first.size() + 1);
+        }
+        for (auto const& entry : entries) {
+            database.insert(database.end(), entry.second.second.begin(), entry.second.second.end());
+        }
+        return database;
+    }
+
     static void RunSehTests(ULONG& TestsRun, ULONG& TestsFailed)
     {
         // CRT: SEH (Structured Exception Handling)
@@ -139,6 +338,42 @@ namespace Main
 
         MusaLOG("=== Musa.Runtime Kernel Test Suite ===");
 
+        // CRT: Startup trace
+        {
+            kstartup_summary summary{};
+            (void)kstartup_trace_query(nullptr, 0, &summary);
+            size_t const available = summary.records;
+            KTEST_EXPECT(available != 0 && summary.entry_to_main_cycles != 0, "Startup_TracePublished");
+
+            auto const records = static_cast<kstartup_record*>(malloc(available * sizeof(kstartup_record)));
+            if (records) {
+                size_t const copied = kstartup_trace_query(records, available, nullptr);
+
+                bool core = false, acrt = false;
+                for (size_t i = 0; i < copied; ++i) {
+                    core = core || (records[i].phase == kstartup_phase_core && records[i].name &&
+                        strcmp(records[i].name, "MusaCoreStartup") == 0);
+                    acrt = acrt || records[i].phase == kstartup_phase_acrt;
+                    MusaLOG("[STARTUP] phase %lu %s %p: %llu cycles, %lu allocations, %llu bytes",
+                        records[i].phase, records[i].name ? records[i].name : "-", records[i].routine,
+                        records[i].cycles, records[i].allocations, records[i].bytes);
+                }
+                KTEST_EXPECT(copied == available && core && acrt, "Startup_TraceRecords");
+                free(records);
+            }
+
+            // The environment is not built during startup; the first access builds it.
+            KTEST_EXPECT(*__p__environ() != nullptr, "Startup_EnvironmentOnFirstUse");
+        }
+
+        // CRT: Deferred and parallel static initialization
+        {
+            KTEST_EXPECT(ReadNoFence(&KinitSumBuilds) == 0, "Kinit_DeferredNotBuiltAtStartup");
+            KTEST_EXPECT(*KinitSum == 93822844764160ull, "Kinit_DeferredWithParallelDependency");
+            KTEST_EXPECT(*KinitSum == 93822844764160ull && ReadNoFence(&KinitSumBuilds) == 1, "Kinit_BuiltOnce");
+            KTEST_EXPECT(KinitSquares->size() == 65536 && (*KinitSquares)[65535] == 65535ull * 65535ull, "Kinit_Parallel");
+        }
+
         // CRT: new / delete
         {
             int* p = new int(42);
@@ -196,6 +431,118 @@ namespace Main
             }
         }
 
+        // CRT: kmalloc — allocation telemetry
+        {
+            kmemprof_options options{};
+            options.buckets      = 256;
+            options.live_blocks  = 4096;
+            options.sample_every = 1;
+            options.samples      = 64;
+            KTEST_EXPECT(NT_SUCCESS(kmemprof_enable(&options)), "KMemProf_Enable");
+
+            // Buckets are per call site:  the volatile bound keeps the loop
+            // from being unrolled into several.
+            constexpr int Blocks = 100;
+            volatile int block_count = Blocks;
+            void** blocks = static_cast<void**>(malloc(Blocks * sizeof(void*)));
+            KTEST_EXPECT(blocks != nullptr, "KMemProf_Blocks");
+            if (blocks) {
+                for (int i = 0; i < block_count; ++i) {
+                    blocks[i] = kmalloc(48, NonPagedPoolNx, 'PmkT');
+                }
+                for (int i = 0; i < 40; ++i) {
+                    kfree(blocks[i], 'PmkT');
+                }
+
+                void* heap_blocks[10];
+                for (auto& block : heap_blocks) {
+                    block = malloc(200);
+                }
+
+                kmemprof_bucket buckets[64];
+                kmemprof_summary summary{};
+                size_t count = kmemprof_query(buckets, _countof(buckets), &summary);
+                KTEST_EXPECT(count > 0 && summary.buckets >= count, "KMemProf_Query");
+
+                const kmemprof_bucket* pool = nullptr;
+                unsigned long long heap_allocations = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    if (buckets[i].tag == 'PmkT') pool = &buckets[i];
+                    if (buckets[i].tag == KMEMPROF_TAG_CRT_HEAP && buckets[i].size_class == 256)
+                        heap_allocations += buckets[i].allocations;
+                    if (i != 0) KTEST_EXPECT(buckets[i - 1].live_bytes >= buckets[i].live_bytes, "KMemProf_Sorted");
+                }
+                KTEST_EXPECT(pool != nullptr, "KMemProf_PoolBucket");
+                if (pool) {
+                    KTEST_EXPECT(pool->size_class == 64, "KMemProf_SizeClass");
+                    KTEST_EXPECT(pool->allocations == Blocks && pool->frees == 40, "KMemProf_Counts");
+                    KTEST_EXPECT(pool->live_bytes == 60 * 48 && pool->peak_live_bytes == 60 * 48, "KMemProf_LiveBytes");
+                    KTEST_EXPECT(pool->call_site != nullptr, "KMemProf_CallSite");
+                }
+                KTEST_EXPECT(heap_allocations >= 10, "KMemProf_CrtHeap");
+
+                // Each call site gets its own bucket, whether it calls malloc
+                // or operator new.  The counts are volatile so that no loop is
+                // unrolled into several call sites.
+                volatile int site_counts[3] = { 3, 5, 7 };
+                void* site_blocks[3 + 5 + 7];
+                for (int i = 0; i < site_counts[0]; ++i) {
+                    site_blocks[i] = malloc(1000);
+                }
+                for (int i = 0; i < site_counts[1]; ++i) {
+                    site_blocks[3 + i] = malloc(1000);
+                }
+                for (int i = 0; i < site_counts[2]; ++i) {
+                    site_blocks[8 + i] = ::operator new(1000);
+                }
+                count = kmemprof_query(buckets, _countof(buckets), nullptr);
+                const void* site_calls[3]{};
+                for (size_t i = 0; i < count; ++i) {
+                    if (buckets[i].tag != KMEMPROF_TAG_CRT_HEAP || buckets[i].size_class != 1024) continue;
+                    if (buckets[i].allocations == 3) site_calls[0] = buckets[i].call_site;
+                    if (buckets[i].allocations == 5) site_calls[1] = buckets[i].call_site;
+                    if (buckets[i].allocations == 7) site_calls[2] = buckets[i].call_site;
+                }
+                KTEST_EXPECT(site_calls[0] && site_calls[1] && site_calls[0] != site_calls[1], "KMemProf_CallSitesSplit");
+                KTEST_EXPECT(site_calls[2] && site_calls[2] != site_calls[0] && site_calls[2] != site_calls[1], "KMemProf_OperatorNewCallSite");
+                for (int i = 0; i < 8; ++i) {
+                    free(site_blocks[i]);
+                }
+                for (int i = 8; i < 15; ++i) {
+                    ::operator delete(site_blocks[i]);
+                }
+
+                kmemprof_sample* samples = static_cast<kmemprof_sample*>(malloc(64 * sizeof(kmemprof_sample)));
+                if (samples) {
+                    size_t sampled = kmemprof_query_samples(samples, 64);
+                    bool live_pool_sample = false;
+                    for (size_t i = 0; i < sampled; ++i) {
+                        if (samples[i].tag == 'PmkT' && samples[i].live && samples[i].frames != 0)
+                            live_pool_sample = true;
+                    }
+                    KTEST_EXPECT(sampled > 0 && live_pool_sample, "KMemProf_Samples");
+                    free(samples);
+                }
+
+                for (auto block : heap_blocks) {
+                    free(block);
+                }
+                for (int i = 40; i < Blocks; ++i) {
+                    kfree(blocks[i], 'PmkT');
+                }
+
+                count = kmemprof_query(buckets, _countof(buckets), nullptr);
+                for (size_t i = 0; i < count; ++i) {
+                    if (buckets[i].tag == 'PmkT') {
+                        KTEST_EXPECT(buckets[i].live_bytes == 0 && buckets[i].peak_live_bytes == 60 * 48, "KMemProf_AllFreed");
+                    }
+                }
+                free(blocks);
+            }
+
+            kmemprof_disable();
+        }
+
         // CRT: Exceptions
         {
             bool caught = false;
@@ -216,6 +563,221 @@ namespace Main
             KTEST_EXPECT(level == 3, "Exception_NestedCatchAll");
         }
 
+        // CRT: Exceptions — throw latency and exception_ptr pool
+        {
+            kexception_pool_stats before{};
+            kexception_pool_query(&before);
+
+            std::exception_ptr captured;
+            try { ThrowThrough(1); }
+            catch (...) { captured = std::current_exception(); }
+
+            bool rethrown = false;
+            try { std::rethrow_exception(captured); }
+            catch (const std::runtime_error& e) { rethrown = strcmp(e.what(), "deep") == 0; }
+            KTEST_EXPECT(rethrown, "ExceptionPtr_CaptureRethrow");
+
+            std::exception_ptr made = std::make_exception_ptr(std::logic_error("made"));
+            KTEST_EXPECT(made != nullptr && made != captured, "ExceptionPtr_Make");
+
+            kexception_pool_stats after{};
+            kexception_pool_query(&after);
+            KTEST_EXPECT(after.capacity == 0 || after.pooled - before.pooled == 2, "ExceptionPtr_FromPool");
+            KTEST_EXPECT(after.failed == before.failed, "ExceptionPtr_NoFailures");
+            captured = nullptr;
+            made     = nullptr;
+
+            for (const int depth : { 1, 10, 50 }) {
+                constexpr int Iterations = 100;
+                kexception_pool_query(&before);
+
+                int caught = 0;
+                for (int i = 0; i < Iterations; ++i) {
+                    try { ThrowThrough(depth); }
+                    catch (const std::runtime_error&) { ++caught; }
+                    try { ThrowThrough(depth); }
+                    catch (...) { captured = std::current_exception(); }
+                }
+                captured = nullptr;
+
+                kexception_pool_query(&after);
+                KTEST_EXPECT(caught == Iterations, "Exception_ThrowDepth");
+                KTEST_EXPECT(after.failed == before.failed, "Exception_CaptureDepth");
+            }
+        }
+
+#if defined _M_AMD64 || defined _M_ARM64
+        // CRT: Exceptions — function table index
+        {
+            const ULONG64 pcs[] = {
+                reinterpret_cast<ULONG64>(&ThrowThrough) + 4,
+                reinterpret_cast<ULONG64>(&RunSehTests) + 16,
+                reinterpret_cast<ULONG64>(&RunTests) + 32,
+                reinterpret_cast<ULONG64>(&KeQueryPerformanceCounter), // outside this image
+            };
+
+            bool same = true;
+            for (const ULONG64 pc : pcs) {
+                for (int pass = 0; pass < 2; ++pass) { // cold, then from the last-hit cache
+                    ULONG64 expected_base = 0, actual_base = 0;
+                    const auto expected = RtlLookupFunctionEntry(pc, &expected_base, nullptr);
+                    const auto actual   = kunwind_lookup_function_entry(pc, &actual_base, nullptr);
+                    same = same && expected == actual && (!expected || expected_base == actual_base);
+                }
+            }
+            KTEST_EXPECT(same, "Unwind_LookupMatchesKernel");
+
+            constexpr int Iterations = 1000;
+            ULONG64 base = 0;
+            size_t found = 0;
+            for (int i = 0; i < Iterations; ++i) {
+                found += RtlLookupFunctionEntry(pcs[i & 1], &base, nullptr) != nullptr;
+                found += kunwind_lookup_function_entry(pcs[i & 1], &base, nullptr) != nullptr;
+            }
+            KTEST_EXPECT(found == 2 * static_cast<size_t>(Iterations), "Unwind_LookupFound");
+        }
+#endif
+
+        // CRT: RTTI — dynamic_cast, with and without the cast cache
+        {
+            SiLeaf si;
+            MiJoin mi;
+            ViJoin vi;
+            SiBase* volatile si_base  = &si;
+            MiLeft* volatile mi_left  = &mi;
+            ViBase* volatile vi_base  = &vi;
+            SiBase  si_plain;
+            SiBase* volatile si_miss  = &si_plain;
+
+            const auto check = [&](const char* name) {
+                KTEST_EXPECT(dynamic_cast<SiLeaf*>(si_base) == &si &&
+                    dynamic_cast<SiLeaf*>(si_miss) == nullptr, name);
+                KTEST_EXPECT(dynamic_cast<MiRight*>(mi_left) == static_cast<MiRight*>(&mi), name);
+                KTEST_EXPECT(dynamic_cast<ViRight*>(vi_base) == static_cast<ViRight*>(&vi) &&
+                    dynamic_cast<ViLeft*>(vi_base) == static_cast<ViLeft*>(&vi), name);
+            };
+
+            bool cast_failed = false;
+            try { (void)dynamic_cast<SiLeaf&>(*si_miss); }
+            catch (const std::bad_cast&) { cast_failed = true; }
+            KTEST_EXPECT(cast_failed, "DynamicCast_BadCastReference");
+
+            check("DynamicCast_Uncached");
+            KTEST_EXPECT(!krtti_set_cast_cache(true), "DynamicCast_EnableCache");
+            check("DynamicCast_Cached_Cold");
+            check("DynamicCast_Cached_Warm");
+
+            cast_failed = false;
+            try { (void)dynamic_cast<SiLeaf&>(*si_miss); }
+            catch (const std::bad_cast&) { cast_failed = true; }
+            KTEST_EXPECT(cast_failed, "DynamicCast_Cached_BadCastReference");
+
+            constexpr int Iterations = 1000;
+            for (const bool cached : { false, true }) {
+                krtti_set_cast_cache(cached);
+                struct CastCase { const char* name; void* (*cast)(void*); void* object; };
+                const CastCase cases[] = {
+                    { cached ? "DynamicCast_SI_Cached" : "DynamicCast_SI", [](void* p) -> void* { return dynamic_cast<SiLeaf*>(static_cast<SiBase*>(p)); }, si_base },
+                    { cached ? "DynamicCast_MI_Cached" : "DynamicCast_MI", [](void* p) -> void* { return dynamic_cast<MiRight*>(static_cast<MiLeft*>(p)); }, mi_left },
+                    { cached ? "DynamicCast_VI_Cached" : "DynamicCast_VI", [](void* p) -> void* { return dynamic_cast<ViRight*>(static_cast<ViBase*>(p)); }, vi_base },
+                };
+                for (const auto& c : cases) {
+                    size_t hits = 0;
+                    for (int i = 0; i < Iterations; ++i) {
+                        hits += c.cast(c.object) != nullptr;
+                    }
+                    KTEST_EXPECT(hits == Iterations, c.name);
+                }
+            }
+            krtti_set_cast_cache(false);
+        }
+
+        // CRT: RTTI — type_info hash and name
+        {
+            using LongType = std::map<std::basic_string<wchar_t>, std::vector<std::pair<std::wstring, std::unordered_map<int, std::string>>>>;
+
+            KTEST_EXPECT(typeid(int).hash_code() == typeid(int).hash_code(), "TypeInfo_HashStable");
+            KTEST_EXPECT(typeid(LongType).hash_code() == typeid(LongType).hash_code(), "TypeInfo_HashStable_Long");
+            KTEST_EXPECT(typeid(int).hash_code() != typeid(long).hash_code(), "TypeInfo_HashDistinct");
+            KTEST_EXPECT(strcmp(typeid(int).name(), "int") == 0, "TypeInfo_Name");
+            KTEST_EXPECT(strcmp(typeid(SiLeaf).name(), "struct Main::SiLeaf") == 0, "TypeInfo_Name_Struct");
+            KTEST_EXPECT(typeid(SiLeaf).name() == typeid(SiLeaf).name(), "TypeInfo_NameCached");
+            KTEST_EXPECT(strncmp(typeid(LongType).name(), "class std::map<", 15) == 0, "TypeInfo_Name_Long");
+
+            std::unordered_map<std::type_index, int> dispatch;
+            dispatch[typeid(int)]      = 1;
+            dispatch[typeid(SiLeaf)]   = 2;
+            dispatch[typeid(MiJoin)]   = 3;
+            dispatch[typeid(ViJoin)]   = 4;
+            dispatch[typeid(LongType)] = 5;
+            dispatch[typeid(std::unordered_map<std::wstring, std::vector<std::string>>)] = 6;
+
+            const std::type_index keys[] = {
+                typeid(int), typeid(SiLeaf), typeid(MiJoin), typeid(ViJoin), typeid(LongType),
+                typeid(std::unordered_map<std::wstring, std::vector<std::string>>),
+            };
+
+            constexpr int Iterations = 6000;
+            long long sum = 0;
+            for (int i = 0; i < Iterations; ++i) {
+                sum += dispatch.find(keys[i % std::size(keys)])->second;
+            }
+            KTEST_EXPECT(sum == 21000, "TypeIndex_MapLookup");
+        }
+
+        // CRT: RTTI — arena-backed undecoration
+        {
+            static constexpr const char* Corpus[] = {
+                "?Foo@@YAHH@Z",
+                "?x@@3HA",
+                "??0Bar@@QEAA@XZ",
+                "??2@YAPEAX_K@Z",
+                "??_7type_info@@6B@",
+                "?what@exception@std@@UEBAPEBDXZ",
+                "?DriverEntry@@YAJPEAU_DRIVER_OBJECT@@PEAU_UNICODE_STRING@@@Z",
+                "?push_back@?$vector@HV?$allocator@H@std@@@std@@QEAAXAEBH@Z",
+                "??1?$basic_string@DU?$char_traits@D@std@@V?$allocator@D@2@@std@@QEAA@XZ",
+                "??$make_shared@VFoo@@$$V@std@@YA?AV?$shared_ptr@VFoo@@@0@XZ",
+                "?find@?$_Hash@V?$_Umap_traits@HHV?$_Uhash_compare@HU?$hash@H@std@@U?$equal_to@H@2@@std@@V?$allocator@U?$pair@$$CBHH@std@@@2@$0A@@std@@@std@@QEAA?AV?$_List_iterator@V?$_List_val@U?$_List_simple_types@U?$pair@$$CBHH@std@@@std@@@std@@@2@AEBH@Z",
+                "_not_decorated",
+            };
+
+            const auto reference = [](const char* name) {
+                return __unDName(nullptr, name, 0, malloc, free, 0);
+            };
+
+            auto arena  = std::make_unique<char[]>(64 * 1024);
+            auto packed = std::make_unique<char[]>(16 * 1024);
+            char output[1024];
+
+            KTEST_EXPECT(kundname(output, "?Foo@@YAHH@Z", sizeof(output), arena.get(), 64 * 1024, 0) &&
+                strcmp(output, "int __cdecl Foo(int)") == 0, "Undname_Arena_Simple");
+            KTEST_EXPECT(kundname(output, "_not_decorated", sizeof(output), arena.get(), 64 * 1024, 0) &&
+                strcmp(output, "_not_decorated") == 0, "Undname_Arena_Undecorated");
+            KTEST_EXPECT(kundname(output, Corpus[10], sizeof(output), arena.get(), 64, 0) == nullptr,
+                "Undname_Arena_Exhausted");
+
+            bool same = true;
+            for (const char* name : Corpus) {
+                char* expected = reference(name);
+                const char* actual = kundname(output, name, sizeof(output), arena.get(), 64 * 1024, 0);
+                same = same && expected && actual && strcmp(expected, actual) == 0;
+                free(expected);
+            }
+            KTEST_EXPECT(same, "Undname_Arena_MatchesHeap");
+
+            const char* results[std::size(Corpus)];
+            const size_t undecorated = kundname_batch(Corpus, results, std::size(Corpus),
+                packed.get(), 16 * 1024, arena.get(), 64 * 1024, 0);
+            same = undecorated == std::size(Corpus);
+            for (size_t i = 0; same && i < std::size(Corpus); ++i) {
+                char* expected = reference(Corpus[i]);
+                same = expected && results[i] && strcmp(expected, results[i]) == 0;
+                free(expected);
+            }
+            KTEST_EXPECT(same, "Undname_Batch");
+        }
+
         RunSehTests(TestsRun, TestsFailed);
 
         // Vector
@@ -1368,6 +1930,282 @@ namespace Main
             KTEST_EXPECT(strlen(buf) == 10 && buf[4] == '-', "StrFTime");
         }
 
+        // CRT: gmtime computes dates arithmetically, localtime answers DST
+        // from the transition table that _tzset builds, and numeric strftime
+        // formats are written directly into the caller's buffer.
+        {
+            struct DateCase { __time64_t time; int year, mon, mday, yday, wday, hour, min, sec; };
+            const DateCase cases[] = {
+                {           0,   70,  0,  1,   0, 4,  0,  0,  0 },   // 1970-01-01T00:00:00
+                {       -3600,   69, 11, 31, 364, 3, 23,  0,  0 },   // 1969-12-31T23:00:00
+                {   951782400,  100,  1, 29,  59, 2,  0,  0,  0 },   // 2000-02-29T00:00:00
+                {  1709211909,  124,  1, 29,  59, 4, 13,  5,  9 },   // 2024-02-29T13:05:09
+                {  4107542399,  200,  1, 28,  58, 0, 23, 59, 59 },   // 2100-02-28T23:59:59
+                { 32503680000, 1100,  0,  1,   0, 3,  0,  0,  0 },   // 3000-01-01T00:00:00
+            };
+            bool dates = true;
+            for (const auto& c : cases) {
+                tm g = {};
+                dates = dates && _gmtime64_s(&g, &c.time) == 0 &&
+                    g.tm_year == c.year && g.tm_mon == c.mon && g.tm_mday == c.mday && g.tm_yday == c.yday &&
+                    g.tm_wday == c.wday && g.tm_hour == c.hour && g.tm_min == c.min && g.tm_sec == c.sec;
+            }
+            KTEST_EXPECT(dates, "GmTime_Civil");
+
+            // A minute either side of the US transitions in PST8PDT, inside the
+            // table (2024) and past it (2150), where the locked path answers.
+            char saved_tz[64] = {};
+            size_t saved_tz_length = 0;
+            const bool had_tz = getenv_s(&saved_tz_length, saved_tz, sizeof(saved_tz), "TZ") == 0 && saved_tz_length != 0;
+            _putenv_s("TZ", "PST8PDT");
+            _tzset();
+
+            struct TransitionCase { __time64_t time; int isdst_before, hour_before, isdst_after, hour_after; };
+            const TransitionCase transitions[] = {
+                { 1710064800, 0, 1, 1, 3 },   // 2024-03-10T10:00:00Z
+                { 1730624400, 1, 1, 0, 1 },   // 2024-11-03T09:00:00Z
+                { 5686020000, 0, 1, 1, 3 },   // 2150-03-08T10:00:00Z
+                { 5706579600, 1, 1, 0, 1 },   // 2150-11-01T09:00:00Z
+            };
+            bool in_table = true, past_table = true;
+            for (const auto& c : transitions) {
+                __time64_t const before = c.time - 60, after = c.time + 60;
+                tm b = {}, a = {};
+                const bool match = _localtime64_s(&b, &before) == 0 && _localtime64_s(&a, &after) == 0 &&
+                    b.tm_isdst == c.isdst_before && b.tm_hour == c.hour_before && b.tm_min == 59 &&
+                    a.tm_isdst == c.isdst_after  && a.tm_hour == c.hour_after  && a.tm_min == 1;
+                if (c.time < 4102444800) { // 2100-01-01
+                    in_table = in_table && match;
+                }
+                else {
+                    past_table = past_table && match;
+                }
+            }
+            KTEST_EXPECT(in_table, "LocalTime_Transitions");
+            KTEST_EXPECT(past_table, "LocalTime_TransitionsPastTable");
+
+            _putenv_s("TZ", had_tz ? saved_tz : "");
+            _tzset();
+
+            char buf[32] = {};
+            __time64_t const t = 1709211909;
+            tm g = {};
+            _gmtime64_s(&g, &t);
+            KTEST_EXPECT(strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &g) == 20 &&
+                strcmp(buf, "2024-02-29T13:05:09Z") == 0, "StrFTime_Iso8601");
+            KTEST_EXPECT(strftime(buf, sizeof(buf), "%F %T", &g) == 19 &&
+                strcmp(buf, "2024-02-29 13:05:09") == 0, "StrFTime_FT");
+            KTEST_EXPECT(strftime(buf, sizeof(buf), "%FT%T%z", &g) == 24 &&
+                (buf[19] == '+' || buf[19] == '-'), "StrFTime_Rfc3339Offset");
+            errno = 0;
+            KTEST_EXPECT(strftime(buf, 19, "%FT%T", &g) == 0 && buf[0] == '\0' && errno == ERANGE, "StrFTime_TooSmall");
+            KTEST_EXPECT(strftime(buf, sizeof(buf), "%a %Y", &g) == 8 && strcmp(buf, "Thu 2024") == 0, "StrFTime_General");
+        }
+
+        // CRT: kclock — the monotonic clock never goes back and resolves well
+        // below a clock tick; the precise clocks are at or ahead of the coarse
+        // ones; timespec_get, system_clock and steady_clock follow kclock.
+        {
+            constexpr long long Ms = 1000 * 1000;   // in ns
+            constexpr long long UnixEpoch = 116444736000000000ll;
+
+            bool forward = true;
+            long long previous = kclock_monotonic();
+            long long step = 0;
+            for (int i = 0; i < 100000; ++i) {
+                long long const now = kclock_monotonic();
+                forward = forward && now >= previous;
+                if (step == 0 && now != previous) {
+                    step = now - previous;
+                }
+                previous = now;
+            }
+            KTEST_EXPECT(forward, "KClock_MonotonicForward");
+            KTEST_EXPECT(step > 0 && step < Ms, "KClock_MonotonicResolution");
+
+            long long const mono_coarse = kclock_monotonic_coarse();
+            long long const mono = kclock_monotonic();
+            KTEST_EXPECT(mono >= mono_coarse - Ms && mono - mono_coarse < 1000 * Ms, "KClock_MonotonicCoarse");
+
+            long long const real_coarse = kclock_realtime_coarse();
+            long long const real = kclock_realtime_precise();
+            KTEST_EXPECT(real >= real_coarse - Ms / 100 && real - real_coarse < 1000 * Ms / 100, "KClock_RealtimeCoarse");
+
+            timespec ts = {};
+            KTEST_EXPECT(timespec_get(&ts, TIME_UTC) == TIME_UTC &&
+                llabs(ts.tv_sec - (kclock_realtime() - UnixEpoch) / 10000000) <= 1, "KClock_TimespecGet");
+
+            auto const steady = std::chrono::steady_clock::now().time_since_epoch().count();
+            KTEST_EXPECT(llabs(kclock_monotonic() - steady) < Ms, "KClock_SteadyClock");
+
+            KTEST_EXPECT(kclock_set_realtime_mode(KCLOCK_COARSE) == KCLOCK_PRECISE, "KClock_SetCoarse");
+            long long const coarse_before = kclock_realtime_coarse() - UnixEpoch;
+            auto const system = std::chrono::system_clock::now().time_since_epoch().count(); // 100 ns units
+            KTEST_EXPECT(kclock_set_realtime_mode(KCLOCK_PRECISE) == KCLOCK_COARSE, "KClock_SetPrecise");
+            KTEST_EXPECT(system >= coarse_before && system - coarse_before < 1000 * Ms / 100, "KClock_SystemClockCoarse");
+        }
+
+        // CRT: kclock — steady_clock never goes back, on one thread or from
+        // one thread to another, while the calibration is taken and refined
+        // under the readers.  Each reader checks its reading against its own
+        // last one and against the latest that any reader published.
+        {
+            struct Readers {
+                std::atomic<long long> latest;
+                std::atomic<bool> stop;
+                std::atomic<long> backwards;
+                std::atomic<long long> reads;
+            };
+            static Readers readers;
+            readers.latest = 0;
+            readers.stop = false;
+            readers.backwards = 0;
+            readers.reads = 0;
+
+            HANDLE threads[4] = {};
+            ULONG const processors = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+            ULONG const count = processors > 1 ? std::min<ULONG>(processors - 1, _countof(threads)) : 1;
+            for (ULONG i = 0; i < count; ++i) {
+                PsCreateSystemThread(&threads[i], THREAD_ALL_ACCESS, nullptr, nullptr, nullptr, [](PVOID) {
+                    long long previous = 0;
+                    long long reads = 0;
+                    while (!readers.stop.load(std::memory_order_relaxed)) {
+                        long long seen = readers.latest.load(std::memory_order_acquire);
+                        long long const now = std::chrono::steady_clock::now().time_since_epoch().count();
+                        if (now < seen || now < previous) {
+                            ++readers.backwards;
+                        }
+                        previous = now;
+                        while (now > seen && !readers.latest.compare_exchange_weak(seen, now)) {
+                        }
+                        ++reads;
+                    }
+                    readers.reads += reads;
+                    PsTerminateSystemThread(STATUS_SUCCESS);
+                }, nullptr);
+            }
+
+            // Past the first calibration, refining every millisecond.
+            LARGE_INTEGER interval;
+            interval.QuadPart = -10 * 1000; // 1 ms
+            long long const until = kclock_monotonic_coarse() + (KCLOCK_CALIBRATION_MS + 200) * 1000 * 1000ll;
+            while (kclock_monotonic_coarse() < until) {
+                kclock_refine();
+                KeDelayExecutionThread(KernelMode, FALSE, &interval);
+            }
+
+            readers.stop = true;
+            for (HANDLE const thread : threads) {
+                if (thread) {
+                    ZwWaitForSingleObject(thread, FALSE, nullptr);
+                    ZwClose(thread);
+                }
+            }
+            KTEST_EXPECT(readers.reads > 0 && readers.backwards == 0, "KClock_SteadyClockNeverBack");
+        }
+
+        // STL: <chrono> time zones from a ktzdb database.  Offsets follow the
+        // transitions and then the zone's rule, links resolve to their zone,
+        // and current_zone is the one set with ktzdb_set_current_zone.
+        {
+            using namespace std::chrono;
+            static std::vector<unsigned char> const database = MakeSampleTzdb(0);
+            KTEST_EXPECT(ktzdb_validate(database.data(), database.size()) == 0 &&
+                ktzdb_validate(database.data(), database.size() - 1) == EINVAL, "Tzdb_Validate");
+            KTEST_EXPECT(ktzdb_load(database.data(), database.size() - 1) == EINVAL, "Tzdb_LoadTruncated");
+            KTEST_EXPECT(ktzdb_load(database.data(), database.size()) == 0, "Tzdb_Load");
+
+            try {
+                tzdb const& db = get_tzdb();
+                KTEST_EXPECT(db.zones.size() == 4 && db.links.size() == 1 && db.version.starts_with("sample."), "Tzdb_List");
+
+                time_zone const* const new_york = locate_zone("America/New_York");
+                KTEST_EXPECT(locate_zone("US/Eastern") == new_york, "Tzdb_Link");
+
+                sys_info const summer = new_york->get_info(sys_seconds{ 1719835200s });   // 2024-07-01T12:00:00Z
+                KTEST_EXPECT(summer.offset == -4h && summer.save == 60min && summer.abbrev == "EDT" &&
+                    summer.begin == sys_seconds{ 1710054000s } && summer.end == sys_seconds{ 1730613600s }, "Tzdb_Transitions");
+
+                sys_info const rule = new_york->get_info(sys_seconds{ 2540246400s });     // 2050-07-01T00:00:00Z
+                KTEST_EXPECT(rule.offset == -4h && rule.abbrev == "EDT" &&
+                    rule.begin == sys_seconds{ 2530767600s } && rule.end == sys_seconds{ 2551327200s }, "Tzdb_Rule");
+
+                time_zone const* const sydney = locate_zone("Australia/Sydney");
+                sys_info const aedt = sydney->get_info(sys_seconds{ 1735689600s });       // 2025-01-01T00:00:00Z
+                KTEST_EXPECT(aedt.offset == 11h && aedt.abbrev == "AEDT" &&
+                    aedt.begin == sys_seconds{ 1728144000s } && aedt.end == sys_seconds{ 1743868800s }, "Tzdb_SouthernRule");
+
+                sys_info const kolkata = locate_zone("Asia/Kolkata")->get_info(sys_seconds{ 0s });
+                KTEST_EXPECT(kolkata.offset == 5h + 30min && kolkata.save == 0min && kolkata.abbrev == "IST" &&
+                    kolkata.begin == sys_seconds::min() && kolkata.end == sys_seconds::max(), "Tzdb_FixedOffset");
+
+                zoned_time const zoned{ "America/New_York", sys_seconds{ 1709211909s } };
+                KTEST_EXPECT(std::format("{:%F %T %Z}", zoned) == "2024-02-29 08:05:09 EST", "Tzdb_ZonedTimeFormat");
+
+                local_info const gap = new_york->get_info(local_days{ 2024y / March / 10 } + 2h + 30min);
+                local_info const overlap = new_york->get_info(local_days{ 2024y / November / 3 } + 1h + 30min);
+                KTEST_EXPECT(gap.result == local_info::nonexistent && overlap.result == local_info::ambiguous, "Tzdb_LocalInfo");
+
+                KTEST_EXPECT(current_zone()->name() == "UTC", "Tzdb_CurrentZoneDefault");
+                KTEST_EXPECT(ktzdb_set_current_zone("Asia/Kolkata") == 0 && current_zone()->name() == "Asia/Kolkata", "Tzdb_CurrentZone");
+                KTEST_EXPECT(ktzdb_set_current_zone(nullptr) == 0 && current_zone()->name() == "UTC", "Tzdb_CurrentZoneReset");
+                KTEST_EXPECT(ktzdb_set_current_zone("Nowhere/Special") == EINVAL && current_zone()->name() == "UTC", "Tzdb_CurrentZoneUnknown");
+
+                bool unknown = false;
+                try { (void)locate_zone("Nowhere/Special"); } catch (std::runtime_error const&) { unknown = true; }
+                KTEST_EXPECT(unknown, "Tzdb_UnknownZone");
+            }
+            catch (std::exception const&) {
+                KTEST_EXPECT(false, "Tzdb_NoException");
+            }
+        }
+
+        // STL: std::print and std::println to stdout and stderr go to the
+        // kernel log.  Lines are split at KLOG_MAX_LINE, text without a newline
+        // waits for klog_flush, and the file sink gets every line in order.
+        {
+            int fd = _open("C:\\musa_klog.tmp", _O_CREAT | _O_TRUNC | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
+            KTEST_EXPECT(fd >= 0 && klog_set_file_sink(fd) == 0, "Klog_FileSink");
+            if (fd >= 0) {
+                klog_stats before{};
+                klog_query(&before);
+                try {
+                    std::println("print {} {}", 42, "lines");
+                    std::print(stderr, "no ");
+                    std::print(stderr, "newline");
+                    std::println(stdout);
+                    std::println(stdout, "{}", std::string(KLOG_MAX_LINE + 8, 'x'));
+                }
+                catch (std::exception const&) {
+                    KTEST_EXPECT(false, "Klog_PrintNoException");
+                }
+                KTEST_EXPECT(klog_print(KLOG_WARNING, "klog {:#x}", 0x2a) == 0, "Klog_Print");
+                KTEST_EXPECT(klog_write(static_cast<klog_level>(0), "", 0) == EINVAL, "Klog_WriteLevel");
+                klog_flush();
+
+                klog_stats after{};
+                klog_query(&after);
+                KTEST_EXPECT(after.lines - before.lines == 6 && after.written - before.written == 6 &&
+                    after.dropped == before.dropped, "Klog_Stats");
+                KTEST_EXPECT(klog_set_debugger_sink(DPFLTR_DEFAULT_ID) == 0, "Klog_DebuggerSink");
+                _close(fd);
+
+                std::string const expected = "print 42 lines\n\n" + std::string(KLOG_MAX_LINE, 'x') + "\nxxxxxxxx\n"
+                    "klog 0x2a\nno newline\n";
+                std::string contents;
+                if (FILE* f = fopen("C:\\musa_klog.tmp", "rb")) {
+                    char buffer[256];
+                    size_t n;
+                    while ((n = fread(buffer, 1, sizeof(buffer), f)) != 0) {
+                        contents.append(buffer, n);
+                    }
+                    fclose(f);
+                }
+                KTEST_EXPECT(contents == expected, "Klog_Lines");
+            }
+            _unlink("C:\\musa_klog.tmp");
+        }
+
         // ============================================================
         // UCRT Unlocked: Environment variables
         // ============================================================
@@ -1402,6 +2240,39 @@ namespace Main
             int n = snprintf(buf, 10, "%s-%d", "abcdefgh", 99);
             KTEST_EXPECT(n > 9 && strcmp(buf, "abcdefgh-") == 0, "Snprintf_Trunc");
         }
+        {
+            // Truncation reports the full length from a single pass, on both
+            // the simple-format fast path and the general engine.
+            char buf[16] = {};
+            int n = snprintf(buf, sizeof(buf), "[%s] pid=%u ptr=%p", "driver", 1234u, (void*)0x1000);
+            KTEST_EXPECT(n == 38 && strcmp(buf, "[driver] pid=12") == 0, "Snprintf_Fast_TruncCount");
+            n = snprintf(buf, sizeof(buf), "[%8s] pid=%05u", "driver", 1234u);
+            KTEST_EXPECT(n == 20 && strcmp(buf, "[  driver] pid=") == 0, "Snprintf_Engine_TruncCount");
+            n = snprintf(nullptr, 0, "%d %x %X %lld %zu %c%%", -42, 0xbeefu, 0xbeefu, -1ll, size_t{ 7 }, 'z');
+            KTEST_EXPECT(n == 21, "Snprintf_Fast_CountOnly");
+            n = snprintf(buf, sizeof(buf), "%d|%s", (std::numeric_limits<int>::min)(), static_cast<const char*>(nullptr));
+            KTEST_EXPECT(n == 18 && strcmp(buf, "-2147483648|(nu") == 0, "Snprintf_Fast_Edges");
+        }
+        {
+            struct FormatCase { const char* name; size_t size; bool simple; };
+            const FormatCase cases[] = {
+                { "Snprintf_Simple_Fits",      256, true  },
+                { "Snprintf_Simple_Truncated",  32, true  },
+                { "Snprintf_Width_Fits",       256, false },
+                { "Snprintf_Width_Truncated",   32, false },
+            };
+            constexpr int Iterations = 1000;
+            char buf[256];
+            for (const auto& c : cases) {
+                int total = 0;
+                for (int i = 0; i < Iterations; ++i) {
+                    total += c.simple
+                        ? snprintf(buf, c.size, "[musa] %s: irp=%p status=%x count=%d/%u", "IRP_MJ_READ", &buf, 0xC0000001u, i, 100000u)
+                        : snprintf(buf, c.size, "[musa] %-12s: irp=%p status=%08x count=%6d/%u", "IRP_MJ_READ", &buf, 0xC0000001u, i, 100000u);
+                }
+                KTEST_EXPECT(total > Iterations * 32, c.name);
+            }
+        }
         {
             int a = 0, b = 0;
             int n = sscanf("42 99", "%d %d", &a, &b);
@@ -1478,6 +2349,136 @@ namespace Main
             });
             KTEST_EXPECT(arr[0] == 1 && arr[5] == 9, "QSort_Ascending");
         }
+
+        // CRT: qsort / qsort_s — pattern-defeating quicksort, for the widths
+        // with their own swap (4, 8, 16) and one without (12), on the inputs
+        // that send a plain quicksort quadratic; qsort_u32 / qsort_u64 — radix.
+        {
+            struct Wide12 { int key; int index; int pad; };
+            struct Wide16 { long long key; long long index; };
+            struct Counter { long long compares; bool same_pointer; };
+
+            constexpr size_t count = 20000;
+            auto const keys = std::make_unique<int[]>(count);
+            auto make_keys = [&](int pattern) {
+                uint64_t state = 0x2545F4914F6CDD1Dull + pattern;
+                for (size_t i = 0; i < count; ++i) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    int const random = static_cast<int>(state >> 33);
+                    switch (pattern) {
+                    case 0:  keys[i] = random;                                         break; // random
+                    case 1:  keys[i] = static_cast<int>(i);                            break; // sorted
+                    case 2:  keys[i] = static_cast<int>(count - i);                    break; // reversed
+                    case 3:  keys[i] = random % 4;                                     break; // many duplicates
+                    case 4:  keys[i] = static_cast<int>(i < count / 2 ? i : count - i); break; // organ pipe
+                    default: keys[i] = i % 64 == 0 ? random : static_cast<int>(i);     break; // nearly sorted
+                    }
+                }
+            };
+
+            auto compare_int = [](void* context, void const* a, void const* b) {
+                auto const counter = static_cast<Counter*>(context);
+                ++counter->compares;
+                counter->same_pointer |= a == b;
+                int const x = *static_cast<int const*>(a);
+                int const y = *static_cast<int const*>(b);
+                return (x > y) - (x < y);
+            };
+
+            bool sorted = true;
+            bool bounded = true;
+            bool distinct = true;
+            auto const expected = std::make_unique<int[]>(count);
+            auto const wide12 = std::make_unique<Wide12[]>(count);
+            auto const wide16 = std::make_unique<Wide16[]>(count);
+            auto const u32 = std::make_unique<unsigned int[]>(count);
+            auto const u64 = std::make_unique<unsigned long long[]>(count);
+            for (int pattern = 0; pattern < 6; ++pattern) {
+                make_keys(pattern);
+                std::copy(keys.get(), keys.get() + count, expected.get());
+                std::sort(expected.get(), expected.get() + count);
+
+                Counter counter = {};
+                qsort_s(keys.get(), count, sizeof(int), compare_int, &counter);
+                sorted = sorted && std::equal(keys.get(), keys.get() + count, expected.get());
+                bounded = bounded && counter.compares < 2 * 15 * static_cast<long long>(count); // 2 n log2(n)
+                distinct = distinct && !counter.same_pointer;
+
+                make_keys(pattern);
+                for (size_t i = 0; i < count; ++i) {
+                    wide12[i] = { keys[i], static_cast<int>(i), 0 };
+                    wide16[i] = { keys[i], static_cast<long long>(i) };
+                    u32[i] = static_cast<unsigned int>(keys[i]) * 2654435761u;
+                    u64[i] = static_cast<unsigned long long>(keys[i]) << 31 | i;
+                }
+
+                qsort(wide12.get(), count, sizeof(Wide12), [](void const* a, void const* b) {
+                    int const x = static_cast<Wide12 const*>(a)->key;
+                    int const y = static_cast<Wide12 const*>(b)->key;
+                    return (x > y) - (x < y);
+                });
+                qsort(wide16.get(), count, sizeof(Wide16), [](void const* a, void const* b) {
+                    long long const x = static_cast<Wide16 const*>(a)->key;
+                    long long const y = static_cast<Wide16 const*>(b)->key;
+                    return (x > y) - (x < y);
+                });
+                for (size_t i = 0; i < count; ++i) {
+                    sorted = sorted && wide12[i].key == expected[i] && wide16[i].key == expected[i] &&
+                        keys[wide12[i].index] == expected[i] && keys[wide16[i].index] == expected[i];
+                }
+
+                qsort_u32(u32.get(), count);
+                qsort_u64(u64.get(), count);
+                sorted = sorted && std::is_sorted(u32.get(), u32.get() + count) && std::is_sorted(u64.get(), u64.get() + count);
+            }
+            KTEST_EXPECT(sorted, "QSort_Patterns");
+            KTEST_EXPECT(bounded, "QSort_CompareBound");
+            KTEST_EXPECT(distinct, "QSort_NoSelfCompare");
+
+            unsigned int few[] = { 3, 0xFFFFFFFF, 1, 0, 2 };
+            qsort_u32(few, _countof(few));
+            KTEST_EXPECT(few[0] == 0 && few[1] == 1 && few[4] == 0xFFFFFFFF, "QSortU32_Short");
+
+            // Spread over the high bytes only, so the low-byte passes are skipped.
+            for (size_t i = 0; i < count; ++i) {
+                u64[i] = static_cast<unsigned long long>(count - i) << 48;
+            }
+            qsort_u64(u64.get(), count);
+            KTEST_EXPECT(u64[0] == 1ull << 48 && std::is_sorted(u64.get(), u64.get() + count), "QSortU64_SkippedPasses");
+
+            // This comparator never returns 0, so with NaNs among the doubles
+            // (and with equal ones) it is not a strict weak ordering.  qsort may
+            // leave any order but must stay inside the array.  Rows of 1 and 3
+            // doubles take both partitions.
+            struct Bounds { char const* begin; char const* end; bool outside; };
+            auto compare_double = [](void* context, void const* a, void const* b) {
+                auto const bounds = static_cast<Bounds*>(context);
+                bounds->outside |= a < bounds->begin || a >= bounds->end || b < bounds->begin || b >= bounds->end;
+                if (bounds->outside)
+                    return 0;
+
+                double const x = *static_cast<double const*>(a);
+                double const y = *static_cast<double const*>(b);
+                return x > y ? 1 : -1;
+            };
+
+            bool inside = true;
+            auto const doubles = std::make_unique<double[]>(3 * count + 2);
+            for (size_t row = 1; row <= 3; row += 2) {
+                uint64_t state = 0x9E3779B97F4A7C15ull;
+                for (size_t i = 0; i < row * count + 2; ++i) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    doubles[i] = i % 5 == 0 ? std::numeric_limits<double>::quiet_NaN() : static_cast<double>(state >> 40);
+                }
+                doubles[0] = -1.0;
+                doubles[row * count + 1] = -1.0;
+
+                Bounds bounds = { reinterpret_cast<char const*>(&doubles[1]), reinterpret_cast<char const*>(&doubles[row * count + 1]), false };
+                qsort_s(&doubles[1], count, row * sizeof(double), compare_double, &bounds);
+                inside = inside && !bounds.outside && doubles[0] == -1.0 && doubles[row * count + 1] == -1.0;
+            }
+            KTEST_EXPECT(inside, "QSort_NaNStaysInBounds");
+        }
         {
             int arr[] = {1, 2, 3, 4, 5, 6};
             int key = 4;
@@ -1490,6 +2491,71 @@ namespace Main
             KTEST_EXPECT(found == nullptr, "BSearch_NotFound");
         }
 
+        // CRT: ksearch — S+ trees and the Eytzinger table against
+        // std::lower_bound, at sizes around the node and level boundaries, with
+        // duplicates and keys at both ends of the range.
+        {
+            auto compare_u64 = [](void const* a, void const* b) {
+                unsigned long long const x = *static_cast<unsigned long long const*>(a);
+                unsigned long long const y = *static_cast<unsigned long long const*>(b);
+                return (x > y) - (x < y);
+            };
+
+            bool u32_ok = true;
+            bool u64_ok = true;
+            bool table_ok = true;
+            bool built = true;
+            uint64_t state = 0x9E3779B97F4A7C15ull;
+            for (size_t num : { 0, 1, 7, 8, 9, 16, 17, 136, 137, 1000, 4096, 4097, 70000 }) {
+                std::vector<unsigned int> u32(num);
+                std::vector<unsigned long long> u64(num);
+                for (size_t i = 0; i < num; ++i) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    u32[i] = i % 5 == 0 ? 0xFFFFFFFF : static_cast<unsigned int>(state >> 40) % (num + 1);
+                    u64[i] = i % 7 == 0 ? 0 : state;
+                }
+                std::sort(u32.begin(), u32.end());
+                std::sort(u64.begin(), u64.end());
+
+                ksearch_u32* const t32 = ksearch_u32_build(u32.data(), num);
+                ksearch_u64* const t64 = ksearch_u64_build(u64.data(), num);
+                ksearch_table* const table = ksearch_table_build(u64.data(), num, sizeof(unsigned long long));
+                built = built && t32 != nullptr && t64 != nullptr && table != nullptr;
+                if (t32 == nullptr || t64 == nullptr || table == nullptr) {
+                    ksearch_u32_free(t32);
+                    ksearch_u64_free(t64);
+                    ksearch_table_free(table);
+                    continue;
+                }
+
+                for (size_t i = 0; i < num + 64; ++i) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    unsigned int const k32 = i < num ? u32[i] : i == num ? 0xFFFFFFFF : static_cast<unsigned int>(state >> 40) % (num + 2);
+                    unsigned long long const k64 = i < num ? u64[i] : i == num ? ~0ull : i == num + 1 ? 0 : state;
+
+                    size_t const r32 = std::lower_bound(u32.begin(), u32.end(), k32) - u32.begin();
+                    size_t const r64 = std::lower_bound(u64.begin(), u64.end(), k64) - u64.begin();
+                    u32_ok = u32_ok && ksearch_u32_lower_bound(t32, k32) == r32;
+                    u64_ok = u64_ok && ksearch_u64_lower_bound(t64, k64) == r64;
+
+                    auto const lower = static_cast<unsigned long long const*>(ksearch_table_lower_bound(table, &k64, compare_u64));
+                    auto const found = static_cast<unsigned long long const*>(ksearch_table_find(table, &k64, compare_u64));
+                    bool const present = r64 < num && u64[r64] == k64;
+                    table_ok = table_ok &&
+                        (r64 == num ? lower == nullptr : lower != nullptr && *lower == u64[r64]) &&
+                        (present ? found != nullptr && *found == k64 : found == nullptr);
+                }
+
+                ksearch_u32_free(t32);
+                ksearch_u64_free(t64);
+                ksearch_table_free(table);
+            }
+            KTEST_EXPECT(built, "KSearch_Build");
+            KTEST_EXPECT(u32_ok, "KSearchU32_LowerBound");
+            KTEST_EXPECT(u64_ok, "KSearchU64_LowerBound");
+            KTEST_EXPECT(table_ok, "KSearchTable_LowerBoundFind");
+        }
+
         // ============================================================
         // UCRT Unlocked: ctype edge cases
         // ============================================================
@@ -1557,6 +2623,63 @@ namespace Main
             KTEST_EXPECT(d > 789.011 && d < 789.013, "Wtof_Basic");
         }
 
+        // CRT: strtod — Eisel-Lemire fast path, cross-checked bit for bit
+        // against the hexadecimal parser, which does not use it.
+        {
+            struct { const char* decimal; const char* exact; } const cases[] = {
+                { "0.1",                                "0x1.999999999999ap-4"   },
+                { "1e23",                               "0x1.52d02c7e14af6p+76"  },
+                { "9007199254740993",                   "0x1p+53"                }, // halfway, to even
+                { "9007199254740995",                   "0x1.0000000000002p+53"  }, // halfway, to even
+                { "2.2250738585072011e-308",            "0x0.fffffffffffffp-1022"}, // subnormal
+                { "2.2250738585072014e-308",            "0x1p-1022"              },
+                { "4.9e-324",                           "0x0.0000000000001p-1022"},
+                { "1.7976931348623157e308",             "0x1.fffffffffffffp+1023"},
+                { "0.1000000000000000055511151231257827021181583404541015625", "0x1.999999999999ap-4" },
+                { "0.1000000000000000055511151231257827021181583404541015624", "0x1.999999999999ap-4" },
+                { "123456789012345678901234567890",     "0x1.8ee90ff6c373ep+96"  },
+                { "-2.5e-3",                            "-0x1.47ae147ae147bp-9"  },
+            };
+
+            bool exact = true;
+            for (const auto& c : cases) {
+                double const d = strtod(c.decimal, nullptr);
+                double const x = strtod(c.exact, nullptr);
+                exact = exact && memcmp(&d, &x, sizeof(d)) == 0;
+            }
+            KTEST_EXPECT(exact, "Strtod_FastPath_Exact");
+
+            float const f = strtof("16777217", nullptr); // halfway, to even
+            KTEST_EXPECT(f == 16777216.0f, "Strtof_FastPath_Halfway");
+
+            // Random doubles survive a round trip through %.17g and through %a.
+            std::mt19937_64 rng(0x4D757361);
+            bool roundtrip = true;
+            char text[64];
+            for (int i = 0; i < 20000 && roundtrip; ++i) {
+                uint64_t bits = rng();
+                if ((bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull) {
+                    bits &= ~0x4000000000000000ull; // no infinities or NaNs
+                }
+                double v;
+                memcpy(&v, &bits, sizeof(v));
+
+                sprintf_s(text, "%.17g", v);
+                double const decimal = strtod(text, nullptr);
+                sprintf_s(text, "%a", v);
+                double const hex = strtod(text, nullptr);
+                roundtrip = memcmp(&decimal, &v, sizeof(v)) == 0 && memcmp(&hex, &v, sizeof(v)) == 0;
+            }
+            KTEST_EXPECT(roundtrip, "Strtod_FastPath_RoundTrip");
+
+            errno = 0;
+            double const huge = strtod("1e400", nullptr);
+            KTEST_EXPECT(huge > 0.0 && !_finite(huge) && errno == ERANGE, "Strtod_FastPath_Overflow");
+            errno = 0;
+            double const tiny = strtod("1e-400", nullptr);
+            KTEST_EXPECT(tiny == 0.0 && errno == ERANGE, "Strtod_FastPath_Underflow");
+        }
+
         // ============================================================
         // UCRT Unlocked: locale — mbstowcs / wcstombs
         // ============================================================
@@ -1710,6 +2833,210 @@ namespace Main
             KTEST_EXPECT(buf[1] == '.', "Printf_GFormatDecimal");
         }
 
+        // CRT: printf %e/%f/%g, _ecvt, _fcvt, _gcvt — digits from the Ryu-printf
+        // tables, compared with the output of the big integer generator.
+        {
+            struct { const char* format; double value; const char* expected; } const cases[] = {
+                { "%.17g", 0.1,                     "0.10000000000000001"                        },
+                { "%.17g", 1e23,                    "9.9999999999999992e+22"                     },
+                { "%f",    1e22,                    "10000000000000000000000.000000"             },
+                { "%.20f", 0.1,                     "0.10000000000000000555"                     },
+                { "%e",    4.9406564584124654e-324, "4.940656e-324"                              },
+                { "%.25e", 4.9406564584124654e-324, "4.9406564584124654417656879e-324"           },
+                { "%.17g", 2.2250738585072014e-308, "2.2250738585072014e-308"                    },
+                { "%.16e", 1.7976931348623157e308,  "1.7976931348623157e+308"                    },
+                { "%.40f", 8.4703294725430034e-22,  "0.0000000000000000000008470329472543003391" }, // 2^-70
+                { "%g",    123456789.0,             "1.23457e+08"                                },
+                { "%g",    0.0001,                  "0.0001"                                     },
+                { "%g",    1e-5,                    "1e-05"                                      },
+                { "%.3f",  2.0005,                  "2.001"                                      }, // 2.000500000000000078
+                { "%.2f",  -1.005,                  "-1.00"                                      }, // 1.004999999999999893
+                { "%.0e",  9.5e-10,                 "1e-09"                                      },
+                { "%.1f",  999.96,                  "1000.0"                                     },
+                { "%.3e",  9.9995e99,               "1.000e+100"                                 },
+                { "%.10f", 1.0 / 3,                 "0.3333333333"                               },
+            };
+
+            bool exact = true;
+            char text[512];
+            for (const auto& c : cases) {
+                sprintf_s(text, c.format, c.value);
+                exact = exact && strcmp(text, c.expected) == 0;
+            }
+            KTEST_EXPECT(exact, "Printf_Float_Exact");
+
+            sprintf_s(text, "%.0f", 1.7976931348623157e308);
+            KTEST_EXPECT(strlen(text) == 309 &&
+                strncmp(text, "179769313486231570814527423731704356798070567525844996598917476803", 66) == 0 &&
+                strcmp(text + 300, "124858368") == 0, "Printf_Float_DblMaxFixed");
+
+            int decimal_point = 0;
+            int sign = 0;
+            char const* digits = _ecvt(3.14159265, 5, &decimal_point, &sign);
+            KTEST_EXPECT(digits && strcmp(digits, "31416") == 0 && decimal_point == 1 && sign == 0, "Ecvt_Basic");
+            digits = _ecvt(-0.000123456, 3, &decimal_point, &sign);
+            KTEST_EXPECT(digits && strcmp(digits, "123") == 0 && decimal_point == -3 && sign != 0, "Ecvt_Negative");
+            digits = _ecvt(1e23, 17, &decimal_point, &sign);
+            KTEST_EXPECT(digits && strcmp(digits, "99999999999999992") == 0 && decimal_point == 23, "Ecvt_Inexact");
+            digits = _fcvt(1234.5678, 2, &decimal_point, &sign);
+            KTEST_EXPECT(digits && strcmp(digits, "123457") == 0 && decimal_point == 4, "Fcvt_Basic");
+            digits = _fcvt(1.5e-5, 7, &decimal_point, &sign);
+            KTEST_EXPECT(digits && strcmp(digits, "150") == 0 && decimal_point == -4, "Fcvt_Small");
+
+            char g[32];
+            KTEST_EXPECT(strcmp(_gcvt(1234.5678, 6, g), "1234.57") == 0, "Gcvt_Fixed");
+            KTEST_EXPECT(strcmp(_gcvt(1e-10, 4, g), "1.e-010") == 0, "Gcvt_Exponent");
+            KTEST_EXPECT(strcmp(_gcvt(100.0, 5, g), "100.") == 0, "Gcvt_TrailingZeroes");
+        }
+
+        // CRT: kvexp / kvlog / kvtanh / kvsin / kvcos / kvsqrt — batch math,
+        // compared with the scalar functions within the documented bounds (plus
+        // one ulp for the scalar function's own error).
+        {
+            auto ulps = [](double a, double b) -> uint64_t {
+                if (std::isnan(a) || std::isnan(b)) {
+                    return std::isnan(a) && std::isnan(b) ? 0 : UINT64_MAX;
+                }
+                auto ordered = [](double v) {
+                    int64_t bits;
+                    memcpy(&bits, &v, sizeof(bits));
+                    return bits < 0 ? INT64_MIN - bits : bits;
+                };
+                int64_t const d = ordered(a) - ordered(b);
+                return static_cast<uint64_t>(d < 0 ? -d : d);
+            };
+
+            // 1003 elements: the AVX2 path, when taken, and an odd tail.
+            constexpr size_t count = 1003;
+            auto const x = std::make_unique<double[]>(count);
+            auto const y = std::make_unique<double[]>(count);
+
+            struct {
+                const char* accuracy;
+                const char* in_place;
+                void (__cdecl* batch)(double const*, double*, size_t);
+                double (__cdecl* scalar)(double);
+                double low, high;
+                uint64_t bound;
+            } const functions[] = {
+                { "Kvexp_Accuracy",  "Kvexp_InPlace",  kvexp,  ::exp,  -708.0, 708.0, 2 },
+                { "Kvlog_Accuracy",  "Kvlog_InPlace",  kvlog,  ::log,  1e-300, 1e300, 2 },
+                { "Kvtanh_Accuracy", "Kvtanh_InPlace", kvtanh, ::tanh, -25.0,  25.0,  4 },
+                { "Kvsin_Accuracy",  "Kvsin_InPlace",  kvsin,  ::sin,  -1e5,   1e5,   2 },
+                { "Kvcos_Accuracy",  "Kvcos_InPlace",  kvcos,  ::cos,  -1e5,   1e5,   2 },
+                { "Kvsqrt_Accuracy", "Kvsqrt_InPlace", kvsqrt, ::sqrt, 0.0,    1e300, 0 },
+            };
+
+            uint64_t state = 0x9E3779B97F4A7C15ull;
+            for (const auto& f : functions) {
+                bool const logarithmic = f.low > 0 && f.high / f.low > 1e6;
+                for (size_t i = 0; i < count; ++i) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    double const t = static_cast<double>(state >> 11) / 9007199254740992.0;
+                    x[i] = logarithmic
+                        ? ::exp(::log(f.low) + t * (::log(f.high) - ::log(f.low)))
+                        : f.low + t * (f.high - f.low);
+                }
+
+                f.batch(x.get(), y.get(), count);
+                uint64_t worst = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    worst = (std::max)(worst, ulps(y[i], f.scalar(x[i])));
+                }
+                KTEST_EXPECT(worst <= f.bound, f.accuracy);
+
+                // In place, and a count that leaves a one-element tail.
+                memcpy(y.get(), x.get(), 5 * sizeof(double));
+                f.batch(y.get(), y.get(), 5);
+                bool in_place = true;
+                for (size_t i = 0; i < 5; ++i) {
+                    in_place = in_place && ulps(y[i], f.scalar(x[i])) <= f.bound;
+                }
+                KTEST_EXPECT(in_place, f.in_place);
+            }
+
+            // Out-of-domain lanes take the scalar function, errno included.
+            double const special[] = { 800.0, -1.0, 0.0, std::numeric_limits<double>::quiet_NaN(), 1.0, -800.0 };
+            double result[_countof(special)];
+
+            errno = 0;
+            kvexp(special, result, _countof(special));
+            KTEST_EXPECT(result[0] == HUGE_VAL && errno == ERANGE && result[2] == 1.0 &&
+                std::isnan(result[3]) && result[5] == 0.0, "Kvexp_Fallback");
+
+            kvlog(special, result, _countof(special));
+            KTEST_EXPECT(std::isnan(result[1]) && result[2] == -HUGE_VAL && result[4] == 0.0, "Kvlog_Fallback");
+
+            double const negative[] = { 4.0, -1.0 };
+            errno = 0;
+            kvlog(negative, result, _countof(negative));
+            KTEST_EXPECT(std::isnan(result[1]) && errno == EDOM, "Kvlog_Fallback_Errno");
+
+            kvsin(special, result, _countof(special));
+            KTEST_EXPECT(std::isnan(result[3]) && result[2] == 0.0 && ulps(result[0], ::sin(800.0)) <= 2, "Kvsin_Fallback");
+
+            kvtanh(special, result, _countof(special));
+            KTEST_EXPECT(result[0] == 1.0 && result[5] == -1.0 && std::isnan(result[3]), "Kvtanh_Saturate");
+
+            kvsqrt(special, result, _countof(special));
+            KTEST_EXPECT(std::isnan(result[1]) && result[2] == 0.0 && result[4] == 1.0, "Kvsqrt_Special");
+
+            kvexp(special, result, 0);
+            KTEST_EXPECT(result[4] == 1.0, "Kvexp_Empty");
+        }
+
+        // CRT: rand_s / rand_s_bytes / std::random_device — per-processor
+        // ChaCha20 generators seeded from the system RNG.
+        {
+            unsigned int values[64] = {};
+            bool ok = true;
+            for (auto& value : values) {
+                ok = ok && rand_s(&value) == 0;
+            }
+            KTEST_EXPECT(ok && std::any_of(values + 1, values + 64, [&](unsigned v) { return v != values[0]; }), "RandS_Varies");
+
+            // 10000 bytes miss one of the 256 values with probability 2^-48.
+            constexpr size_t count = 10000;
+            auto const bytes = std::make_unique<unsigned char[]>(count + 2);
+            bytes[0] = bytes[count + 1] = 0xA5;
+            bool seen[256] = {};
+            KTEST_EXPECT(rand_s_bytes(bytes.get() + 1, count) == 0, "RandSBytes_Success");
+            for (size_t i = 1; i <= count; ++i) {
+                seen[bytes[i]] = true;
+            }
+            KTEST_EXPECT(std::all_of(std::begin(seen), std::end(seen), [](bool b) { return b; }), "RandSBytes_AllByteValues");
+            KTEST_EXPECT(bytes[0] == 0xA5 && bytes[count + 1] == 0xA5, "RandSBytes_Bounds");
+            KTEST_EXPECT(rand_s_bytes(nullptr, 0) == 0, "RandSBytes_Empty");
+
+            unsigned char first[32];
+            unsigned char second[32];
+            krand_reseed();
+            KTEST_EXPECT(rand_s_bytes(first, sizeof(first)) == 0 && rand_s_bytes(second, sizeof(second)) == 0 &&
+                memcmp(first, second, sizeof(first)) != 0, "RandSBytes_Reseed");
+
+            size_t const interval = krand_set_reseed_interval(0);
+            KTEST_EXPECT(rand_s_bytes(first, sizeof(first)) == 0 && memcmp(first, second, sizeof(first)) != 0, "RandSBytes_Bypass");
+            KTEST_EXPECT(krand_set_reseed_interval(64) == 0, "RandSBytes_SetInterval");
+            ok = true;
+            for (int i = 0; i < 16; ++i) {
+                ok = ok && rand_s_bytes(first, sizeof(first)) == 0;
+            }
+            KTEST_EXPECT(ok, "RandSBytes_ShortInterval");
+            krand_set_reseed_interval(interval);
+
+            KIRQL irql;
+            KeRaiseIrql(DISPATCH_LEVEL, &irql);
+            errno_t const dispatch_result = rand_s_bytes(first, sizeof(first));
+            KeLowerIrql(irql);
+            KTEST_EXPECT(dispatch_result == 0, "RandSBytes_Dispatch");
+
+            std::random_device device;
+            unsigned int const d0 = device();
+            unsigned int const d1 = device();
+            unsigned int const d2 = device();
+            KTEST_EXPECT(d0 != d1 || d1 != d2, "RandomDevice_Varies");
+        }
+
         // ============================================================
         // UCRT Unlocked: locale — wcsrtombs
         // ============================================================
@@ -1898,6 +3225,241 @@ namespace Main
             _unlink("C:\\musa_dup.tmp");
         }
 
+        // ============================================================
+        // UCRT Unlocked: lowio — descriptor allocation churn
+        // ============================================================
+        {
+            // The CRT caps descriptors at _NHANDLE_ (8192), so churn just
+            // below that instead of the 10k the allocator was sized for.
+            constexpr size_t LiveCount  = 8000;
+            constexpr int    ChurnCount = 10000;
+
+            int fd = _open("C:\\musa_churn.tmp", _O_CREAT | _O_RDWR | _O_BINARY, _S_IREAD | _S_IWRITE);
+            if (fd >= 0) {
+                std::vector<int> live;
+                live.reserve(LiveCount);
+                while (live.size() < LiveCount) {
+                    int d = _dup(fd);
+                    if (d < 0) break;
+                    live.push_back(d);
+                }
+                KTEST_EXPECT(live.size() == LiveCount, "LowIO_Churn_Fill");
+
+                if (!live.empty()) {
+                    bool reused = true;
+                    for (int i = 0; i < ChurnCount; ++i) {
+                        size_t k = (static_cast<size_t>(i) * 2654435761u) % live.size();
+                        int old = live[k];
+                        _close(old);
+                        live[k] = _dup(fd);
+                        reused &= (live[k] == old);
+                    }
+                    KTEST_EXPECT(reused, "LowIO_Churn_ReusesLowestFree");
+                }
+
+                for (int d : live) {
+                    if (d >= 0) _close(d);
+                }
+                _close(fd);
+            }
+            _unlink("C:\\musa_churn.tmp");
+        }
+
+        // ============================================================
+        // UCRT Unlocked: lowio — large text/binary write throughput
+        // ============================================================
+        {
+            constexpr size_t LineCount = 64 * 1024;
+            std::string text;
+            text.reserve(LineCount * 48);
+            for (size_t i = 0; i < LineCount; ++i) {
+                text += "[musa] kernel log line with some payload ";
+                text += static_cast<char>('0' + i % 10);
+                text += '\n';
+            }
+            text.append(64 * 1024, 'x'); // one long newline-free span
+
+            struct WriteCase { const char* name; int mode; bool stdio; };
+            const WriteCase cases[] = {
+                { "LowIO_Write_Text",   _O_TEXT,   false },
+                { "LowIO_Write_Binary", _O_BINARY, false },
+                { "StdIO_FWrite_Text",  _O_TEXT,   true  },
+                { "StdIO_FWrite_Binary", _O_BINARY, true },
+            };
+            for (const auto& c : cases) {
+                int fd = _open("C:\\musa_wr.tmp", _O_CREAT | _O_TRUNC | _O_RDWR | c.mode, _S_IREAD | _S_IWRITE);
+                if (fd < 0) continue;
+
+                size_t written = 0;
+                if (c.stdio) {
+                    FILE* f = _fdopen(fd, c.mode == _O_TEXT ? "wt" : "wb");
+                    if (f) {
+                        written = fwrite(text.data(), 1, text.size(), f);
+                        fflush(f);
+                    }
+                    KTEST_EXPECT(written == text.size(), c.name);
+                    if (f) fclose(f); else _close(fd);
+                }
+                else {
+                    written = static_cast<size_t>(_write(fd, text.data(), static_cast<unsigned>(text.size())));
+                    KTEST_EXPECT(written == text.size(), c.name);
+                    _close(fd);
+                }
+
+                // Text mode must expand every LF into CRLF on disk:
+                size_t expected = text.size() + (c.mode == _O_TEXT ? LineCount : 0);
+                struct _stat64i32 st = {};
+                KTEST_EXPECT(_stat64i32("C:\\musa_wr.tmp", &st) == 0 &&
+                    static_cast<size_t>(st.st_size) == expected, "LowIO_Write_TranslatedSize");
+            }
+            _unlink("C:\\musa_wr.tmp");
+        }
+
+        // ============================================================
+        // UCRT Unlocked: lowio/stdio — large text read throughput
+        // ============================================================
+        {
+            constexpr size_t LineCount = 64 * 1024;
+            std::string text;
+            text.reserve(LineCount * 48);
+            for (size_t i = 0; i < LineCount; ++i) {
+                text += "[musa] kernel log line with some payload ";
+                text += static_cast<char>('0' + i % 10);
+                text += '\n';
+            }
+
+            int fd = _open("C:\\musa_rd.tmp", _O_CREAT | _O_TRUNC | _O_WRONLY | _O_TEXT, _S_IREAD | _S_IWRITE);
+            if (fd >= 0) {
+                _write(fd, text.data(), static_cast<unsigned>(text.size()));
+                _close(fd);
+
+                // _read in text mode: CRLF on disk must come back as LF.
+                std::string back(text.size() + 64, '\0');
+                fd = _open("C:\\musa_rd.tmp", _O_RDONLY | _O_TEXT);
+                size_t total = 0;
+                if (fd >= 0) {
+                    int n;
+                    while ((n = _read(fd, &back[total], 64 * 1024)) > 0) {
+                        total += static_cast<size_t>(n);
+                    }
+                    _close(fd);
+                }
+                back.resize(total);
+                KTEST_EXPECT(back == text, "LowIO_Read_TextTranslated");
+
+                // fgets over the same file: the stream buffer grows as it is
+                // consumed sequentially; ftell must still see on-disk offsets.
+                FILE* f = fopen("C:\\musa_rd.tmp", "rt");
+                if (f) {
+                    char line[128];
+                    size_t lines = 0;
+                    bool   match = true;
+                    bool   tell_ok = true;
+                    while (fgets(line, sizeof(line), f)) {
+                        match = match && strlen(line) == 43 &&
+                            line[41] == static_cast<char>('0' + lines % 10);
+                        ++lines;
+                        if (lines == LineCount / 2) {
+                            tell_ok = ftell(f) == static_cast<long>(lines * 44);
+                        }
+                    }
+                    KTEST_EXPECT(lines == LineCount && match, "StdIO_FGets_Text");
+                    KTEST_EXPECT(tell_ok, "StdIO_FTell_AfterReadAhead");
+
+                    // After a seek the stream starts over with a small fill.
+                    KTEST_EXPECT(fseek(f, 44, SEEK_SET) == 0 && fgets(line, sizeof(line), f) &&
+                        line[41] == '1', "StdIO_FSeek_AfterReadAhead");
+                    fclose(f);
+                }
+
+                // A UTF-8 stream's buffer is not grown, so ftell can still
+                // re-read it well past 8 KB into the file.
+                f = fopen("C:\\musa_rd.tmp", "rt, ccs=UTF-8");
+                if (f) {
+                    wchar_t line[128];
+                    size_t lines = 0;
+                    bool   tell_ok = true;
+                    while (lines < 1000 && fgetws(line, static_cast<int>(std::size(line)), f)) {
+                        ++lines;
+                        if (lines % 250 == 0) {
+                            tell_ok = tell_ok && ftell(f) == static_cast<long>(lines * 44);
+                        }
+                    }
+                    KTEST_EXPECT(lines == 1000 && tell_ok, "StdIO_FTell_Utf8PastInternalBuffer");
+                    fclose(f);
+                }
+            }
+            _unlink("C:\\musa_rd.tmp");
+        }
+
+        // ============================================================
+        // UCRT Unlocked: stdio — memory-mapped streams ("rm")
+        // ============================================================
+        {
+            constexpr size_t FileSize = 16 * 1024 * 1024 + 123;
+            std::vector<unsigned char> data(FileSize);
+            for (size_t i = 0; i < FileSize; ++i) {
+                data[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+            }
+            const uint64_t expected_sum = std::accumulate(data.begin(), data.end(), uint64_t{ 0 });
+
+            FILE* w = fopen("C:\\musa_map.tmp", "wb");
+            if (w) {
+                fwrite(data.data(), 1, data.size(), w);
+                fclose(w);
+
+                std::vector<unsigned char> chunk(64 * 1024);
+                struct ReadCase { const char* name; const char* mode; };
+                const ReadCase cases[] = {
+                    { "StdIO_FRead_Buffered", "rb" },
+                    { "StdIO_FRead_Mapped",   "rm" },
+                };
+                for (const auto& c : cases) {
+                    FILE* f = fopen("C:\\musa_map.tmp", c.mode);
+                    KTEST_EXPECT(f != nullptr, c.name);
+                    if (!f) continue;
+
+                    uint64_t sum = 0;
+                    size_t   n;
+                    while ((n = fread(chunk.data(), 1, chunk.size(), f)) != 0) {
+                        sum = std::accumulate(chunk.begin(), chunk.begin() + n, sum);
+                    }
+                    KTEST_EXPECT(sum == expected_sum && feof(f), c.name);
+                    fclose(f);
+                }
+
+                FILE* f = fopen("C:\\musa_map.tmp", "rm");
+                if (f) {
+                    const auto view = kfmapview(f);
+                    const uint64_t sum = std::accumulate(
+                        reinterpret_cast<const unsigned char*>(view.data()),
+                        reinterpret_cast<const unsigned char*>(view.data()) + view.size(), uint64_t{ 0 });
+                    KTEST_EXPECT(view.size() == FileSize && sum == expected_sum, "StdIO_MapView_Span");
+
+                    // Positioning works as on any binary stream:
+                    KTEST_EXPECT(fseek(f, 1000, SEEK_SET) == 0 && ftell(f) == 1000 &&
+                        fgetc(f) == data[1000] && ftell(f) == 1001, "StdIO_Mapped_FSeek_FTell");
+                    KTEST_EXPECT(fseek(f, -2, SEEK_END) == 0 && fgetc(f) == data[FileSize - 2] &&
+                        fgetc(f) == data[FileSize - 1] && fgetc(f) == EOF && feof(f), "StdIO_Mapped_EOF");
+
+                    // The view is read-only, so only the character just read can be pushed back:
+                    fseek(f, 10, SEEK_SET);
+                    const int ch = fgetc(f);
+                    KTEST_EXPECT(ungetc(ch ^ 1, f) == EOF && ungetc(ch, f) == ch && fgetc(f) == ch,
+                        "StdIO_Mapped_UngetC");
+                    fclose(f);
+                }
+
+                // A non-mapped stream has no view.
+                f = fopen("C:\\musa_map.tmp", "rb");
+                if (f) {
+                    KTEST_EXPECT(kfmapview(f).empty(), "StdIO_MapView_NotMapped");
+                    fclose(f);
+                }
+            }
+            _unlink("C:\\musa_map.tmp");
+        }
+
         // ============================================================
         // UCRT Unlocked: wide char string
         // ============================================================
@@ -1972,6 +3534,50 @@ namespace Main
             KTEST_EXPECT(err == 0, "Strerror_s_SmallBuf_Success");
         }
 
+        // CRT: NTSTATUS errors and nt_category
+        {
+            KTEST_EXPECT(kerrno_from_ntstatus(STATUS_SUCCESS) == 0, "NtErrno_Success");
+            KTEST_EXPECT(kerrno_from_ntstatus(STATUS_PENDING) == 0, "NtErrno_Pending");
+            KTEST_EXPECT(kerrno_from_ntstatus(STATUS_ACCESS_DENIED) == EACCES, "NtErrno_AccessDenied");
+            KTEST_EXPECT(kerrno_from_ntstatus(STATUS_OBJECT_NAME_NOT_FOUND) == ENOENT, "NtErrno_NotFound");
+            KTEST_EXPECT(kerrno_from_ntstatus(STATUS_NO_UNICODE_TRANSLATION) == EILSEQ, "NtErrno_Ilseq");
+            KTEST_EXPECT(kerrno_from_ntstatus(STATUS_NO_MORE_FILES) == ENOENT, "NtErrno_Warning");
+            KTEST_EXPECT(kerrno_from_ntstatus(static_cast<NTSTATUS>(0xC0070000 | ERROR_FILE_EXISTS)) == EEXIST, "NtErrno_Win32");
+            KTEST_EXPECT(kerrno_from_ntstatus(static_cast<NTSTATUS>(0xC0FF0001)) == EINVAL, "NtErrno_Unknown");
+
+            const char* msg = kntstatus_message(STATUS_ACCESS_DENIED);
+            KTEST_EXPECT(msg != nullptr && strcmp(msg, "access denied") == 0, "NtMessage_AccessDenied");
+            KTEST_EXPECT(kntstatus_message(static_cast<NTSTATUS>(0xC0FF0001)) == nullptr, "NtMessage_Unknown");
+
+            std::error_code ec = std::make_nt_error_code(STATUS_ACCESS_DENIED);
+            KTEST_EXPECT(ec.category() == std::nt_category(), "NtCategory_Identity");
+            KTEST_EXPECT(strcmp(ec.category().name(), "ntstatus") == 0, "NtCategory_Name");
+            KTEST_EXPECT(ec == std::errc::permission_denied, "NtCategory_Condition");
+            KTEST_EXPECT(ec.message() == "access denied", "NtCategory_Message");
+            KTEST_EXPECT(!std::make_nt_error_code(STATUS_SUCCESS), "NtCategory_SuccessIsZero");
+            KTEST_EXPECT(std::make_nt_error_code(STATUS_SUCCESS).default_error_condition() == std::error_condition(), "NtCategory_SuccessCondition");
+            KTEST_EXPECT(std::make_nt_error_code(static_cast<NTSTATUS>(0xC0FF0001)).message() == "unknown NTSTATUS 0xC0FF0001", "NtCategory_UnknownMessage");
+
+            // NTSTATUS -> errno: the direct table, the Win32 route (RtlNtStatusToDosError,
+            // system_category) and nt_category; timed in the Errno bench suite.
+            static const NTSTATUS statuses[] = {
+                STATUS_ACCESS_DENIED, STATUS_OBJECT_NAME_NOT_FOUND, STATUS_INSUFFICIENT_RESOURCES,
+                STATUS_INVALID_PARAMETER, STATUS_SHARING_VIOLATION, STATUS_OBJECT_NAME_COLLISION,
+                STATUS_DISK_FULL, STATUS_NOT_SUPPORTED,
+            };
+            int  sink = 0;
+            bool agree = true;
+            for (const NTSTATUS status : statuses) {
+                const int direct = kerrno_from_ntstatus(status);
+                agree = agree && std::make_nt_error_code(status).default_error_condition().value() == direct;
+                sink += direct;
+                sink += std::error_code(static_cast<int>(RtlNtStatusToDosError(status)), std::system_category()).default_error_condition().value();
+                sink += kntstatus_message(status)[0];
+            }
+            KTEST_EXPECT(agree, "NtCategory_ConditionMatchesDirect");
+            KTEST_EXPECT(sink != 0, "NtErrno_BenchResult");
+        }
+
         // CRT: string functions (strspn/strcspn/strpbrk/memccpy/memicmp/strdup)
         {
             size_t spn = strspn("hello world", "helo");
@@ -2470,6 +4076,7 @@ namespace Main
         KeExpandKernelStackAndCalloutEx([](PVOID)
         {
             RunTests();
+            Bench::RunBenchmarks();
         }, nullptr, MAXIMUM_EXPANSION_SIZE, TRUE, nullptr);
 
         MusaLOG("Test thread completed.");
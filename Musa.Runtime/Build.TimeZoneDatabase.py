@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# Builds the time zone database read by ktzdb_load and ktzdb_load_file (see
+# kext/ktzdb.h) from a zoneinfo directory, as installed by tzdata or compiled
+# by zic:
+#
+#     python Build.TimeZoneDatabase.py /usr/share/zoneinfo tzdb.bin --default UTC
+#
+# Links are read from tzdata.zi when the directory has one, and otherwise from
+# symbolic links.  Zones are stored as their TZif files, unchanged.
+
+import argparse
+import os
+import struct
+import sys
+
+SKIPPED = {'localtime', 'posixrules'}
+SKIPPED_DIRECTORIES = {'posix', 'right'}
+NO_ENTRY = 0xFFFFFFFF
+
+
+def read_links(root):
+    links = {}
+    path = os.path.join(root, 'tzdata.zi')
+    if os.path.exists(path):
+        with open(path, encoding='utf-8') as zi:
+            for line in zi:
+                fields = line.split()
+                if len(fields) == 3 and fields[0] == 'L':
+                    links[fields[2]] = fields[1]
+    return links
+
+
+def read_version(root):
+    for name in ('tzdata.zi', '+VERSION', 'VERSION'):
+        path = os.path.join(root, name)
+        if os.path.exists(path):
+            with open(path, encoding='utf-8') as file:
+                line = file.readline().strip()
+            return line[len('# version '):] if line.startswith('# version ') else line
+    return ''
+
+
+def read_zones(root, links):
+    zones = {}
+    for directory, subdirectories, files in os.walk(root):
+        if directory == root:
+            subdirectories[:] = [d for d in subdirectories if d not in SKIPPED_DIRECTORIES]
+        for file in files:
+            path = os.path.join(directory, file)
+            name = os.path.relpath(path, root).replace(os.sep, '/')
+            if name in SKIPPED or name in links:
+                continue
+            if os.path.islink(path) and not os.path.exists(os.path.join(root, 'tzdata.zi')):
+                target = os.path.relpath(os.path.realpath(path), os.path.realpath(root)).replace(os.sep, '/')
+                links[name] = target
+                continue
+            with open(path, 'rb') as tzif:
+                data = tzif.read()
+            if data[:4] == b'TZif' and data[4:5] != b'\0':
+                zones[name] = data
+    return zones
+
+
+def build(root, default_zone, version):
+    links = read_links(root)
+    zones = read_zones(root, links)
+    if not version:
+        version = read_version(root)
+
+    # Resolve chains of links, and drop those to zones that are not present.
+    def resolve(name):
+        seen = set()
+        while name in links and name not in seen:
+            seen.add(name)
+            name = links[name]
+        return name
+
+    links = {link: resolve(target) for link, target in links.items()}
+    links = {link: target for link, target in links.items() if target in zones and link not in zones}
+
+    names = sorted(set(zones) | set(links), key=lambda name: name.encode('utf-8'))
+    index = {name: i for i, name in enumerate(names)}
+    if default_zone is not None and default_zone not in index:
+        sys.exit(f'{default_zone}: no such zone')
+
+    header_size = 32 + 16 * len(names)
+    strings = bytearray()
+    name_offsets = []
+    for name in names:
+        name_offsets.append(header_size + len(strings))
+        strings += name.encode('utf-8') + b'\0'
+
+    blobs = bytearray()
+    entries = bytearray()
+    for name, name_offset in zip(names, name_offsets):
+        if name in links:
+            entries += struct.pack('<IIII', name_offset, index[links[name]], 0, 0)
+        else:
+            data = zones[name]
+            entries += struct.pack('<IIII', name_offset, NO_ENTRY, header_size + len(strings) + len(blobs), len(data))
+            blobs += data
+
+    header = struct.pack('<4sIII16s', b'TZDB', 1, len(names),
+                         NO_ENTRY if default_zone is None else index[default_zone],
+                         version.encode('ascii')[:16])
+    return header + entries + strings + blobs, len(zones), len(links)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Builds a Musa.Runtime time zone database.')
+    parser.add_argument('zoneinfo', help='the zoneinfo directory')
+    parser.add_argument('output', help='the database to write')
+    parser.add_argument('--default', dest='default_zone', help='the zone current_zone returns by default')
+    parser.add_argument('--version', default='', help='the tzdata version, if the directory does not say')
+    args = parser.parse_args()
+
+    database, zone_count, link_count = build(args.zoneinfo, args.default_zone, args.version)
+    with open(args.output, 'wb') as output:
+        output.write(database)
+    print(f'{args.output}: {zone_count} zones, {link_count} links, {len(database)} bytes')
+
+
+if __name__ == '__main__':
+    main()
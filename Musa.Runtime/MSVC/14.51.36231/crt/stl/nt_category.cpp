@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Musa: error_category for NTSTATUS values. See kext/kerror.h.
+
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+#include <Windows.h>
+#include "kext/kerror.h"
+
+_STD_BEGIN
+
+namespace {
+    class _Nt_error_category final : public error_category { // categorize an NTSTATUS
+    public:
+        // Like the Standard categories, the object is identified by a symbolic address rather than by this, so the
+        // constant-initialized image from _Immortalize_memcpy_image is usable without running a constructor.
+        static constexpr uintptr_t _Nt_addr = 0x4D555253; // 'MURS', odd like the Standard symbolic addresses
+
+        constexpr _Nt_error_category() noexcept : error_category(_Nt_addr) {}
+
+        _NODISCARD const char* name() const noexcept override {
+            return "ntstatus";
+        }
+
+        _NODISCARD string message(int _Errval) const override {
+            const char* const _Msg = _CSTD kntstatus_message(static_cast<NTSTATUS>(_Errval));
+            if (_Msg) {
+                return string{_Msg};
+            }
+
+            char _Buf[sizeof("unknown NTSTATUS 0x00000000")];
+            const int _Len = _CSTD sprintf_s(_Buf, "unknown NTSTATUS 0x%08lX", static_cast<unsigned long>(_Errval));
+            return string{_Buf, static_cast<size_t>(_Len > 0 ? _Len : 0)};
+        }
+
+        _NODISCARD error_condition default_error_condition(int _Errval) const noexcept override {
+            // success and informational statuses map to 0, every error to a nonzero errno value
+            return error_condition(_CSTD kerrno_from_ntstatus(static_cast<NTSTATUS>(_Errval)), _STD generic_category());
+        }
+    };
+
+    static_assert((_Nt_error_category::_Nt_addr & 1) != 0, "symbolic addresses must not be valid object addresses");
+} // unnamed namespace
+
+_EXPORT_STD _NODISCARD const error_category& nt_category() noexcept {
+    return _Immortalize_memcpy_image<_Nt_error_category>();
+}
+
+_STD_END
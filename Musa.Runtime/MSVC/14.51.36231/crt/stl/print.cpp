@@ -0,0 +1,652 @@
+// Copyright (c) Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// print.cpp -- C++23 <print> implementation
+
+// Musa: There is no console. stdout and stderr are the kernel log: lines go to a per-processor buffer that a worker
+// thread drains to DbgPrintEx, a file descriptor or an ETW provider. See kext/klog.h.
+
+#include <__msvc_print.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <internal_shared.h>
+#include <io.h>
+
+#include <Windows.h>
+#include "kext/kclock.h"
+#include "kext/kerror.h"
+#include "kext/klog.h"
+
+namespace {
+    constexpr size_t _Ring_size           = KLOG_BUFFER_SIZE;
+    constexpr size_t _Record_align        = 16;
+    constexpr unsigned char _Wrap_level   = 0xFF; // the rest of the ring is unused; the next record is at offset 0
+    constexpr size_t _Batch_size          = 16 * 1024;
+    constexpr size_t _Debugger_batch_size = 511; // DbgPrintEx keeps 512 bytes, the terminating null included
+    constexpr KPRIORITY _Worker_priority  = 4; // below every normal thread
+    constexpr ULONG _Log_tag              = 'LsuM';
+
+    static_assert((_Ring_size & (_Ring_size - 1)) == 0, "the ring size must be a power of two");
+
+    struct _Record {
+        long long _Time; // kclock_monotonic, to merge the rings
+        unsigned short _Size;
+        unsigned char _Level;
+        unsigned char _Reserved[5];
+    };
+
+    static_assert(sizeof(_Record) == _Record_align);
+
+    [[nodiscard]] constexpr size_t _Record_size(const size_t _Text_size) noexcept {
+        return sizeof(_Record) + ((_Text_size + _Record_align - 1) & ~(_Record_align - 1));
+    }
+
+    // A ring has one producer, the processor it belongs to, which appends at DISPATCH_LEVEL and so cannot be
+    // preempted by another producer, and one consumer, the drain, which holds _Drain_lock. Positions only grow;
+    // the offset of a position is its remainder modulo _Ring_size.
+    struct _Ring {
+        LONG64 volatile _Head; // read position, published by the drain
+        LONG64 _Drain_head; // the drain's own copies
+        LONG64 _Drain_tail;
+
+        alignas(64) LONG64 volatile _Tail; // write position, published by the producer
+        LONG64 _Lines; // written only by the producer
+        LONG64 _Dropped;
+
+        alignas(64) unsigned char _Data[_Ring_size];
+    };
+
+    [[nodiscard]] _Ring* _Load_ring(_Ring* volatile* const _Rings, const ULONG _Cpu) noexcept {
+        return static_cast<_Ring*>(ReadPointerAcquire(reinterpret_cast<PVOID volatile*>(&_Rings[_Cpu])));
+    }
+
+    enum class _Sink_kind : unsigned char { _Debugger, _File, _Trace };
+
+    struct _Sink {
+        _Sink_kind _Kind;
+        ULONG _Component; // _Debugger
+        int _Fd; // _File
+        REGHANDLE _Trace; // _Trace
+    };
+
+    enum : LONG { _Worker_none, _Worker_starting, _Worker_running, _Worker_failed };
+
+    struct _Log_state {
+        _Ring* volatile* _Rings; // [_Processors], each allocated by its processor when it writes its first line
+        ULONG _Processors;
+        LONG volatile _Closed;
+
+        LONG volatile _Worker_state;
+        LONG volatile _Stopping;
+        LONG volatile _Idle; // the worker waits for a line without a timeout
+        PKTHREAD _Worker;
+        KEVENT _Wake;
+
+        SRWLOCK _Drain_lock = SRWLOCK_INIT; // one drain at a time; guards the sink and the batch
+        _Sink _Output{_Sink_kind::_Debugger, DPFLTR_DEFAULT_ID, -1, 0};
+        unsigned char _Batch_level;
+        size_t _Batch_used;
+        char _Batch[_Batch_size + 1];
+        wchar_t _Wide[KLOG_MAX_LINE + 1];
+
+        LONG64 volatile _Dropped; // lines dropped before reaching a ring
+        LONG64 volatile _Written;
+        LONG64 volatile _Batches;
+    };
+
+    _Log_state _Log{};
+
+    [[nodiscard]] ULONG _Debugger_level(const unsigned char _Level) noexcept {
+        switch (_Level) {
+        case KLOG_ERROR:
+            return DPFLTR_ERROR_LEVEL;
+        case KLOG_WARNING:
+            return DPFLTR_WARNING_LEVEL;
+        case KLOG_INFO:
+            return DPFLTR_TRACE_LEVEL;
+        default:
+            return DPFLTR_INFO_LEVEL;
+        }
+    }
+
+    void _Flush_batch() noexcept {
+        if (_Log._Batch_used == 0) {
+            return;
+        }
+
+        if (_Log._Output._Kind == _Sink_kind::_Debugger) {
+            _Log._Batch[_Log._Batch_used] = '\0';
+            DbgPrintEx(_Log._Output._Component, _Debugger_level(_Log._Batch_level), "%s", _Log._Batch);
+        } else {
+            (void) _write(_Log._Output._Fd, _Log._Batch, static_cast<unsigned int>(_Log._Batch_used));
+        }
+
+        _Log._Batch_used = 0;
+        InterlockedIncrement64(&_Log._Batches);
+    }
+
+    void _Put(const char* _Text, size_t _Size, const size_t _Capacity) noexcept {
+        while (_Size != 0) {
+            if (_Log._Batch_used == _Capacity) {
+                _Flush_batch();
+            }
+
+            const size_t _Room  = _Capacity - _Log._Batch_used;
+            const size_t _Count = _Size < _Room ? _Size : _Room;
+            _CSTD memcpy(_Log._Batch + _Log._Batch_used, _Text, _Count);
+            _Log._Batch_used += _Count;
+            _Text += _Count;
+            _Size -= _Count;
+        }
+    }
+
+    // Passes one line to the sink, or to the batch for it. _Drain_lock is held.
+    void _Emit(const unsigned char _Level, const char* const _Text, const size_t _Size) noexcept {
+        InterlockedIncrement64(&_Log._Written);
+
+        if (_Log._Output._Kind == _Sink_kind::_Trace) {
+            ULONG _Bytes = 0;
+            (void) RtlUTF8ToUnicodeN(_Log._Wide, static_cast<ULONG>(sizeof(_Log._Wide) - sizeof(wchar_t)), &_Bytes,
+                _Text, static_cast<ULONG>(_Size));
+            _Log._Wide[_Bytes / sizeof(wchar_t)] = L'\0';
+            (void) EtwWriteString(_Log._Output._Trace, _Level, 0, nullptr, _Log._Wide);
+            InterlockedIncrement64(&_Log._Batches);
+            return;
+        }
+
+        size_t _Capacity = _Batch_size;
+        if (_Log._Output._Kind == _Sink_kind::_Debugger) {
+            // A debugger batch has one level, and a line that fits in one is not split across two.
+            _Capacity = _Debugger_batch_size;
+            if (_Log._Batch_used != 0
+                && (_Log._Batch_level != _Level
+                    || (_Log._Batch_used + _Size + 1 > _Capacity && _Size + 1 <= _Capacity))) {
+                _Flush_batch();
+            }
+        }
+
+        _Log._Batch_level = _Level;
+        _Put(_Text, _Size, _Capacity);
+        _Put("\n", 1, _Capacity);
+    }
+
+    // Returns the record at _Drain_head, skipping the unused end of the ring, or nullptr if there is none before
+    // _Drain_tail.
+    [[nodiscard]] const _Record* _Peek(_Ring& _Rx) noexcept {
+        while (_Rx._Drain_head != _Rx._Drain_tail) {
+            const size_t _Offset = static_cast<size_t>(_Rx._Drain_head) & (_Ring_size - 1);
+            const auto _Rec      = reinterpret_cast<const _Record*>(_Rx._Data + _Offset);
+            if (_Rec->_Level != _Wrap_level) {
+                return _Rec;
+            }
+
+            _Rx._Drain_head += static_cast<LONG64>(_Ring_size - _Offset);
+        }
+
+        return nullptr;
+    }
+
+    // Writes out the lines buffered when the drain starts, oldest first across processors, and returns whether
+    // there were any. _Drain_lock is held.
+    bool _Drain_locked() noexcept {
+        const auto _Rings = _Log._Rings;
+        if (_Rings == nullptr) {
+            return false;
+        }
+
+        for (ULONG _Cpu = 0; _Cpu != _Log._Processors; ++_Cpu) {
+            const auto _Rx = _Load_ring(_Rings, _Cpu);
+            if (_Rx != nullptr) {
+                _Rx->_Drain_head = _Rx->_Head;
+                _Rx->_Drain_tail = ReadAcquire64(&_Rx->_Tail);
+            }
+        }
+
+        bool _Any = false;
+        for (;;) {
+            _Ring* _Oldest              = nullptr;
+            const _Record* _Oldest_rec = nullptr;
+            for (ULONG _Cpu = 0; _Cpu != _Log._Processors; ++_Cpu) {
+                // A ring that appears during the drain still has its drain positions at zero and waits for the next.
+                const auto _Rx = _Load_ring(_Rings, _Cpu);
+                if (_Rx == nullptr) {
+                    continue;
+                }
+
+                const _Record* const _Rec = _Peek(*_Rx);
+                if (_Rec != nullptr && (_Oldest_rec == nullptr || _Rec->_Time < _Oldest_rec->_Time)) {
+                    _Oldest     = _Rx;
+                    _Oldest_rec = _Rec;
+                }
+            }
+
+            if (_Oldest == nullptr) {
+                break;
+            }
+
+            _Emit(_Oldest_rec->_Level, reinterpret_cast<const char*>(_Oldest_rec + 1), _Oldest_rec->_Size);
+            _Oldest->_Drain_head += static_cast<LONG64>(_Record_size(_Oldest_rec->_Size));
+            WriteRelease64(&_Oldest->_Head, _Oldest->_Drain_head);
+            _Any = true;
+        }
+
+        for (ULONG _Cpu = 0; _Cpu != _Log._Processors; ++_Cpu) {
+            const auto _Rx = _Load_ring(_Rings, _Cpu);
+            if (_Rx != nullptr) {
+                WriteRelease64(&_Rx->_Head, _Rx->_Drain_head); // past a trailing wrap record
+            }
+        }
+
+        _Flush_batch();
+        return _Any;
+    }
+
+    [[nodiscard]] bool _Buffered() noexcept {
+        const auto _Rings = _Log._Rings;
+        for (ULONG _Cpu = 0; _Rings != nullptr && _Cpu != _Log._Processors; ++_Cpu) {
+            const auto _Rx = _Load_ring(_Rings, _Cpu);
+            if (_Rx != nullptr && ReadAcquire64(&_Rx->_Tail) != ReadAcquire64(&_Rx->_Head)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool _Drain() noexcept {
+        AcquireSRWLockExclusive(&_Log._Drain_lock);
+        const bool _Any = _Drain_locked();
+        ReleaseSRWLockExclusive(&_Log._Drain_lock);
+        return _Any;
+    }
+
+    void NTAPI _Log_worker(PVOID) noexcept {
+        KeSetPriorityThread(KeGetCurrentThread(), _Worker_priority);
+
+        LARGE_INTEGER _Interval;
+        _Interval.QuadPart = -10'000LL * KLOG_FLUSH_INTERVAL_MS;
+
+        bool _Idle = false;
+        for (;;) {
+            KeWaitForSingleObject(&_Log._Wake, Executive, KernelMode, FALSE, _Idle ? nullptr : &_Interval);
+
+            const bool _Stop = ReadAcquire(&_Log._Stopping) != 0;
+            const bool _Any  = _Drain();
+            if (_Stop) {
+                break;
+            }
+
+            // Wait for a line without a timeout once a drain finds nothing. A producer that buffers a line after
+            // the check below sees _Idle set and wakes the worker; one that buffered it before is seen by the
+            // check. Both sides order their store and load with a full barrier.
+            _Idle = false;
+            if (!_Any) {
+                InterlockedExchange(&_Log._Idle, 1);
+                _Idle = !_Buffered();
+                if (!_Idle) {
+                    InterlockedExchange(&_Log._Idle, 0);
+                }
+            }
+        }
+
+        PsTerminateSystemThread(STATUS_SUCCESS);
+    }
+
+    // Called at PASSIVE_LEVEL. Until the worker runs, lines are only written by klog_flush and at unload.
+    void _Start_worker() noexcept {
+        if (ReadNoFence(&_Log._Worker_state) != _Worker_none
+            || InterlockedCompareExchange(&_Log._Worker_state, _Worker_starting, _Worker_none) != _Worker_none) {
+            return;
+        }
+
+        // The caller may be in any process; the handle must not land in its handle table.
+        OBJECT_ATTRIBUTES _Attributes;
+        InitializeObjectAttributes(&_Attributes, nullptr, OBJ_KERNEL_HANDLE, nullptr, nullptr);
+
+        HANDLE _Thread_handle = nullptr;
+        NTSTATUS _Status = PsCreateSystemThread(
+            &_Thread_handle, THREAD_ALL_ACCESS, &_Attributes, nullptr, nullptr, _Log_worker, nullptr);
+        if (!NT_SUCCESS(_Status)) {
+            WriteRelease(&_Log._Worker_state, _Worker_failed);
+            return;
+        }
+
+        PKTHREAD _Thread = nullptr;
+        _Status = ObReferenceObjectByHandle(
+            _Thread_handle, SYNCHRONIZE, *PsThreadType, KernelMode, reinterpret_cast<PVOID*>(&_Thread), nullptr);
+        ZwClose(_Thread_handle);
+
+        if (!NT_SUCCESS(_Status)) {
+            // The thread cannot be waited for at unload, so let it exit now.
+            InterlockedExchange(&_Log._Stopping, 1);
+            KeSetEvent(&_Log._Wake, IO_NO_INCREMENT, FALSE);
+            WriteRelease(&_Log._Worker_state, _Worker_failed);
+            return;
+        }
+
+        _Log._Worker = _Thread;
+        WriteRelease(&_Log._Worker_state, _Worker_running);
+    }
+
+    [[nodiscard]] errno_t _Append(const unsigned char _Level, const char* const _Text, size_t _Size) noexcept {
+        if (_Size > KLOG_MAX_LINE) {
+            _Size = KLOG_MAX_LINE;
+        }
+
+        const KIRQL _Irql = KeGetCurrentIrql();
+        if (_Irql > DISPATCH_LEVEL || _Log._Rings == nullptr || ReadNoFence(&_Log._Closed) != 0) {
+            InterlockedIncrement64(&_Log._Dropped);
+            return ENOSPC;
+        }
+
+        if (_Irql == PASSIVE_LEVEL) {
+            _Start_worker();
+        }
+
+        KIRQL _Old_irql;
+        KeRaiseIrql(DISPATCH_LEVEL, &_Old_irql);
+
+        const ULONG _Cpu = KeGetCurrentProcessorNumberEx(nullptr) % _Log._Processors;
+        auto _Rx = static_cast<_Ring*>(ReadPointerNoFence(reinterpret_cast<PVOID volatile*>(&_Log._Rings[_Cpu])));
+        if (_Rx == nullptr) {
+            _Rx = static_cast<_Ring*>(ExAllocatePoolWithTag(NonPagedPoolNx, sizeof(_Ring), _Log_tag));
+            if (_Rx == nullptr) {
+                KeLowerIrql(_Old_irql);
+                InterlockedIncrement64(&_Log._Dropped);
+                return ENOSPC;
+            }
+
+            _CSTD memset(_Rx, 0, offsetof(_Ring, _Data));
+            WritePointerRelease(reinterpret_cast<PVOID volatile*>(&_Log._Rings[_Cpu]), _Rx);
+        }
+
+        const size_t _Need    = _Record_size(_Size);
+        const LONG64 _Head    = ReadAcquire64(&_Rx->_Head);
+        LONG64 _Tail          = _Rx->_Tail;
+        const size_t _Offset  = static_cast<size_t>(_Tail) & (_Ring_size - 1);
+        const size_t _Contig  = _Ring_size - _Offset;
+        const size_t _Used    = static_cast<size_t>(_Tail - _Head);
+        const size_t _Reserve = _Need + (_Contig < _Need ? _Contig : 0);
+
+        if (_Used + _Reserve > _Ring_size) {
+            ++_Rx->_Dropped;
+            KeLowerIrql(_Old_irql);
+            return ENOSPC;
+        }
+
+        if (_Contig < _Need) {
+            reinterpret_cast<_Record*>(_Rx->_Data + _Offset)->_Level = _Wrap_level;
+            _Tail += static_cast<LONG64>(_Contig);
+        }
+
+        const auto _Rec = reinterpret_cast<_Record*>(_Rx->_Data + (static_cast<size_t>(_Tail) & (_Ring_size - 1)));
+        _Rec->_Time     = kclock_monotonic();
+        _Rec->_Size     = static_cast<unsigned short>(_Size);
+        _Rec->_Level    = _Level;
+        _CSTD memcpy(_Rec + 1, _Text, _Size);
+
+        WriteRelease64(&_Rx->_Tail, _Tail + static_cast<LONG64>(_Need));
+        ++_Rx->_Lines;
+
+        // A worker that is about to wait without a timeout has set _Idle before looking at the rings.
+        MemoryBarrier();
+        bool _Wake = _Used < _Ring_size / 2 && _Used + _Reserve >= _Ring_size / 2;
+        if (ReadNoFence(&_Log._Idle) != 0 && InterlockedExchange(&_Log._Idle, 0) != 0) {
+            _Wake = true;
+        }
+
+        KeLowerIrql(_Old_irql);
+
+        if (_Wake) {
+            KeSetEvent(&_Log._Wake, IO_NO_INCREMENT, FALSE);
+        }
+
+        return 0;
+    }
+
+    // Text printed to stdout or stderr that does not end a line yet. <print> holds the stream lock while it writes,
+    // which guards the text; klog_flush and println(FILE*) take the lock themselves.
+    struct _Pending_line {
+        int _Fd;
+        unsigned char _Level;
+        size_t _Size;
+        char _Text[KLOG_MAX_LINE];
+    };
+
+    _Pending_line _Stdout_line{1, KLOG_INFO, 0, {}};
+    _Pending_line _Stderr_line{2, KLOG_ERROR, 0, {}};
+
+    [[nodiscard]] _Pending_line* _Pending_line_for(const __std_unicode_console_handle _Handle) noexcept {
+        switch (static_cast<intptr_t>(_Handle)) {
+        case 1:
+            return &_Stdout_line;
+        case 2:
+            return &_Stderr_line;
+        default:
+            return nullptr;
+        }
+    }
+
+    [[nodiscard]] FILE* _Stream_of(const _Pending_line& _Line) noexcept {
+        return _Line._Fd == 1 ? stdout : stderr;
+    }
+
+    void _End_line(_Pending_line& _Line) noexcept {
+        (void) _Append(_Line._Level, _Line._Text, _Line._Size);
+        _Line._Size = 0;
+    }
+
+    void _Print_to_line(_Pending_line& _Line, const char* _Str, size_t _Str_size) noexcept {
+        while (_Str_size != 0) {
+            const auto _Newline = static_cast<const char*>(_CSTD memchr(_Str, '\n', _Str_size));
+            const size_t _Count = _Newline != nullptr ? static_cast<size_t>(_Newline - _Str) : _Str_size;
+
+            if (_Line._Size == 0 && _Newline != nullptr && _Count <= KLOG_MAX_LINE) {
+                (void) _Append(_Line._Level, _Str, _Count); // a whole line, straight from the caller
+                _Str += _Count + 1;
+                _Str_size -= _Count + 1;
+                continue;
+            }
+
+            const size_t _Room = KLOG_MAX_LINE - _Line._Size;
+            const size_t _Take = _Count < _Room ? _Count : _Room;
+            _CSTD memcpy(_Line._Text + _Line._Size, _Str, _Take);
+            _Line._Size += _Take;
+            _Str += _Take;
+            _Str_size -= _Take;
+
+            const bool _Ends_line = _Newline != nullptr && _Take == _Count;
+            if (_Ends_line || _Line._Size == KLOG_MAX_LINE) {
+                _End_line(_Line);
+            }
+
+            if (_Ends_line) {
+                ++_Str;
+                --_Str_size;
+            }
+        }
+    }
+
+    void _Flush_pending_line(_Pending_line& _Line) noexcept {
+        FILE* const _Stream = _Stream_of(_Line);
+        _lock_file(_Stream);
+        if (_Line._Size != 0) {
+            _End_line(_Line);
+        }
+        _unlock_file(_Stream);
+    }
+
+    [[nodiscard]] errno_t _Set_sink(const _Sink& _New) noexcept {
+        AcquireSRWLockExclusive(&_Log._Drain_lock);
+        (void) _Drain_locked();
+        const _Sink _Old = _Log._Output;
+        _Log._Output     = _New;
+        ReleaseSRWLockExclusive(&_Log._Drain_lock);
+
+        if (_Old._Kind == _Sink_kind::_Trace) {
+            (void) EtwUnregister(_Old._Trace);
+        }
+
+        return 0;
+    }
+
+    void __cdecl _Close_log() noexcept {
+        if (_Log._Worker != nullptr) {
+            InterlockedExchange(&_Log._Stopping, 1);
+            KeSetEvent(&_Log._Wake, IO_NO_INCREMENT, FALSE);
+            KeWaitForSingleObject(_Log._Worker, Executive, KernelMode, FALSE, nullptr);
+            ObDereferenceObject(_Log._Worker);
+            _Log._Worker = nullptr;
+        }
+
+        WriteRelease(&_Log._Worker_state, _Worker_failed);
+        _Flush_pending_line(_Stdout_line);
+        _Flush_pending_line(_Stderr_line);
+        InterlockedExchange(&_Log._Closed, 1);
+        (void) _Set_sink(_Sink{_Sink_kind::_Debugger, DPFLTR_DEFAULT_ID, -1, 0});
+
+        const auto _Rings = _Log._Rings;
+        _Log._Rings       = nullptr;
+        for (ULONG _Cpu = 0; _Cpu != _Log._Processors; ++_Cpu) {
+            if (_Rings[_Cpu] != nullptr) {
+                ExFreePoolWithTag(_Rings[_Cpu], _Log_tag);
+            }
+        }
+
+        ExFreePoolWithTag(const_cast<_Ring**>(_Rings), _Log_tag);
+    }
+
+    bool _Initialize_log() noexcept {
+        const ULONG _Processors = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+        const auto _Rings =
+            static_cast<_Ring**>(ExAllocatePoolWithTag(NonPagedPoolNx, _Processors * sizeof(_Ring*), _Log_tag));
+        if (_Rings == nullptr) {
+            return false; // every line is dropped
+        }
+
+        _CSTD memset(_Rings, 0, _Processors * sizeof(_Ring*));
+        KeInitializeEvent(&_Log._Wake, SynchronizationEvent, FALSE);
+        _Log._Processors = _Processors;
+        _Log._Rings      = _Rings;
+        atexit(_Close_log);
+        return true;
+    }
+
+    // Set up while the CRT runs C++ initializers; the worker starts with the first line.
+    const bool _Log_ready = _Initialize_log();
+} // unnamed namespace
+
+extern "C" {
+
+[[nodiscard]] _Success_(return._Error == __std_win_error::_Success) __std_unicode_console_retrieval_result
+    __stdcall __std_get_unicode_console_handle_from_file_stream(_In_ FILE* const _Stream) noexcept {
+    if (_Stream == nullptr) {
+        return __std_unicode_console_retrieval_result{._Error = __std_win_error::_Invalid_parameter};
+    }
+
+    // Musa: stdout and stderr are "consoles" whose handle is their file descriptor; every other stream is written
+    // with fwrite.
+    if (_Stream == stdout || _Stream == stderr) {
+        return __std_unicode_console_retrieval_result{
+            ._Console_handle = static_cast<__std_unicode_console_handle>(_Stream == stdout ? 1 : 2),
+            ._Error          = __std_win_error::_Success};
+    }
+
+    if (_fileno(_Stream) < 0) {
+        return __std_unicode_console_retrieval_result{._Error = __std_win_error::_Invalid_parameter};
+    }
+
+    return __std_unicode_console_retrieval_result{._Error = __std_win_error::_File_not_found};
+}
+
+[[nodiscard]] _Success_(return == __std_win_error::_Success) __std_win_error
+    __stdcall __std_print_to_unicode_console(_In_ const __std_unicode_console_handle _Console_handle,
+        _In_reads_(_Str_size) const char* const _Str, _In_ const size_t _Str_size) noexcept {
+    _Pending_line* const _Line = _Pending_line_for(_Console_handle);
+    if (_Line == nullptr || _Str == nullptr) {
+        return __std_win_error::_Invalid_parameter;
+    }
+
+    // Musa: A line that does not fit in its processor's buffer is dropped, not reported.
+    _Print_to_line(*_Line, _Str, _Str_size);
+    return __std_win_error::_Success;
+}
+
+[[nodiscard]] _Success_(return == __std_win_error::_Success) __std_win_error
+    __stdcall __std_print_newline_only_to_unicode_console(
+        _In_ const __std_unicode_console_handle _Console_handle) noexcept {
+    _Pending_line* const _Line = _Pending_line_for(_Console_handle);
+    if (_Line == nullptr) {
+        return __std_win_error::_Invalid_parameter;
+    }
+
+    FILE* const _Stream = _Stream_of(*_Line);
+    _lock_file(_Stream);
+    _End_line(*_Line);
+    _unlock_file(_Stream);
+    return __std_win_error::_Success;
+}
+
+errno_t __cdecl klog_set_debugger_sink(const unsigned long component_id) {
+    return _Set_sink(_Sink{_Sink_kind::_Debugger, component_id, -1, 0});
+}
+
+errno_t __cdecl klog_set_file_sink(const int fd) {
+    if (fd < 0) {
+        return EINVAL;
+    }
+
+    return _Set_sink(_Sink{_Sink_kind::_File, 0, fd, 0});
+}
+
+errno_t __cdecl klog_set_trace_sink(const GUID* const provider) {
+    if (provider == nullptr) {
+        return EINVAL;
+    }
+
+    REGHANDLE _Handle      = 0;
+    const NTSTATUS _Status = EtwRegister(provider, nullptr, nullptr, &_Handle);
+    if (!NT_SUCCESS(_Status)) {
+        return kerrno_from_ntstatus(_Status);
+    }
+
+    return _Set_sink(_Sink{_Sink_kind::_Trace, 0, -1, _Handle});
+}
+
+errno_t __cdecl klog_write(const klog_level level, const char* const text, const size_t size) {
+    if (level < KLOG_ERROR || level > KLOG_VERBOSE || (text == nullptr && size != 0)) {
+        return EINVAL;
+    }
+
+    return _Append(static_cast<unsigned char>(level), text, size);
+}
+
+void __cdecl klog_flush() {
+    _Flush_pending_line(_Stdout_line);
+    _Flush_pending_line(_Stderr_line);
+    (void) _Drain();
+}
+
+void __cdecl klog_query(klog_stats* const stats) {
+    long long _Lines   = 0;
+    long long _Dropped = ReadNoFence64(&_Log._Dropped);
+
+    const auto _Rings = _Log._Rings;
+    for (ULONG _Cpu = 0; _Rings != nullptr && _Cpu != _Log._Processors; ++_Cpu) {
+        const auto _Rx = _Load_ring(_Rings, _Cpu);
+        if (_Rx != nullptr) {
+            _Lines += ReadNoFence64(&_Rx->_Lines);
+            _Dropped += ReadNoFence64(&_Rx->_Dropped);
+        }
+    }
+
+    stats->lines   = _Lines;
+    stats->dropped = _Dropped;
+    stats->written = ReadNoFence64(&_Log._Written);
+    stats->batches = ReadNoFence64(&_Log._Batches);
+}
+
+} // extern "C"
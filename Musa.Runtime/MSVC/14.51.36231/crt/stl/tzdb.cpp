@@ -0,0 +1,1063 @@
+// Copyright (c) Microsoft Corporation.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Musa: The time zone database is a compact TZif database loaded by the driver, not ICU. See kext/ktzdb.h.
+
+#include <__msvc_tzdb.hpp>
+#include <cerrno>
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <internal_shared.h>
+#include <new>
+
+#include <Windows.h>
+#include "kext/kstdio.h"
+#include "kext/ktzdb.h"
+
+namespace {
+    constexpr uint32_t _No_entry        = 0xFFFF'FFFFu;
+    constexpr size_t _Header_size       = 32;
+    constexpr size_t _Entry_size        = 16;
+    constexpr size_t _Tzif_header_size  = 44;
+    constexpr size_t _Max_abbrev        = 16;
+    constexpr size_t _Max_zone_name     = 64;
+    constexpr int64_t _Seconds_per_day  = 86400;
+    constexpr int32_t _Default_rule_time = 2 * 3600;
+    constexpr int32_t _Min_offset        = -89999; // RFC 8536: more than -25 hours
+    constexpr int32_t _Max_offset        = 93599; // and less than 26
+
+    [[nodiscard]] uint32_t _Read_le32(const unsigned char* const _Ptr) noexcept {
+        return static_cast<uint32_t>(_Ptr[0]) | (static_cast<uint32_t>(_Ptr[1]) << 8)
+             | (static_cast<uint32_t>(_Ptr[2]) << 16) | (static_cast<uint32_t>(_Ptr[3]) << 24);
+    }
+
+    [[nodiscard]] uint32_t _Read_be32(const unsigned char* const _Ptr) noexcept {
+        return (static_cast<uint32_t>(_Ptr[0]) << 24) | (static_cast<uint32_t>(_Ptr[1]) << 16)
+             | (static_cast<uint32_t>(_Ptr[2]) << 8) | static_cast<uint32_t>(_Ptr[3]);
+    }
+
+    [[nodiscard]] int64_t _Read_be64(const unsigned char* const _Ptr) noexcept {
+        return static_cast<int64_t>((static_cast<uint64_t>(_Read_be32(_Ptr)) << 32) | _Read_be32(_Ptr + 4));
+    }
+
+    // Civil dates, after H. Hinnant, "chrono-Compatible Low-Level Date Algorithms".
+    [[nodiscard]] bool _Is_leap(const int64_t _Year) noexcept {
+        return _Year % 4 == 0 && (_Year % 100 != 0 || _Year % 400 == 0);
+    }
+
+    [[nodiscard]] int64_t _Days_from_civil(int64_t _Year, const int _Month, const int _Day) noexcept {
+        _Year -= _Month <= 2;
+        const int64_t _Era  = (_Year >= 0 ? _Year : _Year - 399) / 400;
+        const int64_t _Yoe  = _Year - _Era * 400;
+        const int64_t _Doy  = (153 * (_Month > 2 ? _Month - 3 : _Month + 9) + 2) / 5 + _Day - 1;
+        const int64_t _Doe  = _Yoe * 365 + _Yoe / 4 - _Yoe / 100 + _Doy;
+        return _Era * 146097 + _Doe - 719468;
+    }
+
+    [[nodiscard]] int64_t _Year_from_days(int64_t _Days) noexcept {
+        _Days += 719468;
+        const int64_t _Era = (_Days >= 0 ? _Days : _Days - 146096) / 146097;
+        const int64_t _Doe = _Days - _Era * 146097;
+        const int64_t _Yoe = (_Doe - _Doe / 1460 + _Doe / 36524 - _Doe / 146096) / 365;
+        const int64_t _Doy = _Doe - (365 * _Yoe + _Yoe / 4 - _Yoe / 100);
+        return _Yoe + _Era * 400 + ((5 * _Doy + 2) / 153 >= 10);
+    }
+
+    [[nodiscard]] int64_t _Floor_div(const int64_t _Num, const int64_t _Den) noexcept {
+        return _Num / _Den - (_Num % _Den < 0);
+    }
+
+    // A date of a POSIX TZ rule: Jn (1 - 365, February 29 not counted), n (0 - 365) or Mm.w.d.
+    struct _Rule_date {
+        char _Kind;
+        int _Month;
+        int _Week;
+        int _Day;
+        int32_t _Time; // seconds after local midnight; may be negative or past 24 hours
+    };
+
+    // The POSIX TZ string that follows the TZif data, for times after the last transition.
+    struct _Posix_rule {
+        bool _Has_dst;
+        int32_t _Std_offset; // seconds east of UTC
+        int32_t _Dst_offset;
+        char _Std_abbrev[_Max_abbrev];
+        char _Dst_abbrev[_Max_abbrev];
+        _Rule_date _Start;
+        _Rule_date _End;
+    };
+
+    // A parsed zone.  The arrays point into the database.
+    struct _Zone {
+        const unsigned char* _Transitions; // big endian, _Time_size bytes each
+        const unsigned char* _Transition_types;
+        const unsigned char* _Types; // 6 bytes each: be32 offset, is_dst, abbreviation index
+        const char* _Abbrevs;
+        uint32_t _Transition_count;
+        uint32_t _Type_count;
+        uint32_t _Abbrev_size;
+        uint32_t _Time_size;
+        bool _Has_rule;
+        _Posix_rule _Rule;
+    };
+
+    struct _Database {
+        _Database* _Next; // every database loaded, newest first
+        const unsigned char* _Data;
+        size_t _Size;
+        FILE* _Stream; // the mapped file, if loaded from one
+        void* _Copy; // the file contents, if it could not be mapped
+        uint32_t _Count;
+        uint32_t _Default_zone;
+        char _Version[17];
+        _Zone* volatile* _Zones; // parsed on first use, one per entry
+    };
+
+    _Database* volatile _Current_database = nullptr;
+    _Database* _All_databases             = nullptr; // guarded by _Tzdb_lock
+    SRWLOCK _Tzdb_lock                    = SRWLOCK_INIT;
+    char _Current_zone_name[_Max_zone_name]; // guarded by _Tzdb_lock; empty for the default
+
+    [[nodiscard]] const unsigned char* _Entry_at(const _Database& _Db, const uint32_t _Idx) noexcept {
+        return _Db._Data + _Header_size + static_cast<size_t>(_Idx) * _Entry_size;
+    }
+
+    [[nodiscard]] const char* _Entry_name(const _Database& _Db, const uint32_t _Idx) noexcept {
+        return reinterpret_cast<const char*>(_Db._Data + _Read_le32(_Entry_at(_Db, _Idx)));
+    }
+
+    [[nodiscard]] bool _Validate_database(_Database& _Db) noexcept {
+        const unsigned char* const _Data = _Db._Data;
+        const size_t _Size               = _Db._Size;
+        if (_Size < _Header_size || _CSTD memcmp(_Data, "TZDB", 4) != 0 || _Read_le32(_Data + 4) != 1) {
+            return false;
+        }
+
+        _Db._Count        = _Read_le32(_Data + 8);
+        _Db._Default_zone = _Read_le32(_Data + 12);
+        if (_Db._Count > (_Size - _Header_size) / _Entry_size
+            || (_Db._Default_zone != _No_entry && _Db._Default_zone >= _Db._Count)) {
+            return false;
+        }
+
+        _CSTD memcpy(_Db._Version, _Data + 16, 16);
+        _Db._Version[16] = '\0';
+
+        const char* _Previous = nullptr;
+        for (uint32_t _Idx = 0; _Idx < _Db._Count; ++_Idx) {
+            const unsigned char* const _Entry = _Entry_at(_Db, _Idx);
+            const uint32_t _Name              = _Read_le32(_Entry);
+            const uint32_t _Target            = _Read_le32(_Entry + 4);
+            const uint32_t _Offset            = _Read_le32(_Entry + 8);
+            const uint32_t _Length            = _Read_le32(_Entry + 12);
+            if (_Name >= _Size || _CSTD memchr(_Data + _Name, '\0', _Size - _Name) == nullptr) {
+                return false;
+            }
+
+            const char* const _Current = reinterpret_cast<const char*>(_Data + _Name);
+            if (_Previous != nullptr && _CSTD strcmp(_Previous, _Current) >= 0) {
+                return false; // names must be sorted and unique
+            }
+
+            if (_Target == _No_entry) {
+                if (_Offset > _Size || _Length > _Size - _Offset || _Length < _Tzif_header_size) {
+                    return false;
+                }
+            } else if (_Target >= _Db._Count || _Read_le32(_Entry_at(_Db, _Target) + 4) != _No_entry) {
+                return false; // a link must name a zone
+            }
+
+            _Previous = _Current;
+        }
+
+        return true;
+    }
+
+    // Returns the entry index of the zone that _Name names (following a link), or _No_entry.
+    [[nodiscard]] uint32_t _Find_zone_entry(const _Database& _Db, const char* const _Name, const size_t _Len) noexcept {
+        uint32_t _First = 0;
+        uint32_t _Count = _Db._Count;
+        while (_Count > 0) {
+            const uint32_t _Half   = _Count / 2;
+            const uint32_t _Mid    = _First + _Half;
+            const char* const _Key = _Entry_name(_Db, _Mid);
+            int _Order             = _CSTD strncmp(_Key, _Name, _Len);
+            if (_Order == 0 && _Key[_Len] != '\0') {
+                _Order = 1;
+            }
+
+            if (_Order == 0) {
+                const uint32_t _Target = _Read_le32(_Entry_at(_Db, _Mid) + 4);
+                return _Target == _No_entry ? _Mid : _Target;
+            }
+
+            if (_Order < 0) {
+                _First = _Mid + 1;
+                _Count -= _Half + 1;
+            } else {
+                _Count = _Half;
+            }
+        }
+
+        return _No_entry;
+    }
+
+    [[nodiscard]] bool _Parse_abbrev(const char*& _It, const char* const _Last, char (&_Abbrev)[_Max_abbrev]) noexcept {
+        const char* _First = _It;
+        const char* _End;
+        if (_It != _Last && *_It == '<') {
+            _First = ++_It;
+            while (_It != _Last && *_It != '>') {
+                ++_It;
+            }
+
+            if (_It == _Last) {
+                return false;
+            }
+
+            _End = _It++;
+        } else {
+            while (_It != _Last && ((*_It >= 'A' && *_It <= 'Z') || (*_It >= 'a' && *_It <= 'z'))) {
+                ++_It;
+            }
+
+            _End = _It;
+        }
+
+        const size_t _Len = static_cast<size_t>(_End - _First);
+        if (_Len == 0 || _Len >= _Max_abbrev) {
+            return false;
+        }
+
+        _CSTD memcpy(_Abbrev, _First, _Len);
+        _Abbrev[_Len] = '\0';
+        return true;
+    }
+
+    [[nodiscard]] bool _Parse_number(const char*& _It, const char* const _Last, int& _Value, const int _Max) noexcept {
+        if (_It == _Last || *_It < '0' || *_It > '9') {
+            return false;
+        }
+
+        _Value = 0;
+        while (_It != _Last && *_It >= '0' && *_It <= '9') {
+            _Value = _Value * 10 + (*_It++ - '0');
+            if (_Value > _Max) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // [+|-]hh[:mm[:ss]], in seconds
+    [[nodiscard]] bool _Parse_time(
+        const char*& _It, const char* const _Last, int32_t& _Seconds, const int _Max_hours) noexcept {
+        bool _Negative = false;
+        if (_It != _Last && (*_It == '+' || *_It == '-')) {
+            _Negative = *_It++ == '-';
+        }
+
+        int _Hours   = 0;
+        int _Minutes = 0;
+        int _Secs    = 0;
+        if (!_Parse_number(_It, _Last, _Hours, _Max_hours)) {
+            return false;
+        }
+
+        if (_It != _Last && *_It == ':') {
+            ++_It;
+            if (!_Parse_number(_It, _Last, _Minutes, 59)) {
+                return false;
+            }
+
+            if (_It != _Last && *_It == ':') {
+                ++_It;
+                if (!_Parse_number(_It, _Last, _Secs, 59)) {
+                    return false;
+                }
+            }
+        }
+
+        _Seconds = (_Hours * 60 + _Minutes) * 60 + _Secs;
+        if (_Negative) {
+            _Seconds = -_Seconds;
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] bool _Parse_rule_date(const char*& _It, const char* const _Last, _Rule_date& _Date) noexcept {
+        _Date = {};
+        if (_It != _Last && *_It == 'J') {
+            ++_It;
+            _Date._Kind = 'J';
+            if (!_Parse_number(_It, _Last, _Date._Day, 365) || _Date._Day < 1) {
+                return false;
+            }
+        } else if (_It != _Last && *_It == 'M') {
+            ++_It;
+            _Date._Kind = 'M';
+            if (!_Parse_number(_It, _Last, _Date._Month, 12) || _Date._Month < 1 || _It == _Last || *_It++ != '.'
+                || !_Parse_number(_It, _Last, _Date._Week, 5) || _Date._Week < 1 || _It == _Last || *_It++ != '.'
+                || !_Parse_number(_It, _Last, _Date._Day, 6)) {
+                return false;
+            }
+        } else {
+            _Date._Kind = 'n';
+            if (!_Parse_number(_It, _Last, _Date._Day, 365)) {
+                return false;
+            }
+        }
+
+        _Date._Time = _Default_rule_time;
+        if (_It != _Last && *_It == '/') {
+            ++_It;
+            return _Parse_time(_It, _Last, _Date._Time, 167);
+        }
+
+        return true;
+    }
+
+    // std offset [dst [offset] [,start[/time],end[/time]]]
+    [[nodiscard]] bool _Parse_posix_rule(const char* _It, const char* const _Last, _Posix_rule& _Rule) noexcept {
+        _Rule = {};
+        int32_t _Offset;
+        if (!_Parse_abbrev(_It, _Last, _Rule._Std_abbrev) || !_Parse_time(_It, _Last, _Offset, 24)) {
+            return false;
+        }
+
+        _Rule._Std_offset = -_Offset; // POSIX offsets are positive west of Greenwich
+        if (_It == _Last) {
+            return true;
+        }
+
+        if (!_Parse_abbrev(_It, _Last, _Rule._Dst_abbrev)) {
+            return false;
+        }
+
+        _Rule._Has_dst    = true;
+        _Rule._Dst_offset = _Rule._Std_offset + 3600;
+        if (_It != _Last && *_It != ',') {
+            if (!_Parse_time(_It, _Last, _Offset, 24)) {
+                return false;
+            }
+
+            _Rule._Dst_offset = -_Offset;
+        }
+
+        if (_It == _Last) {
+            // No rule: the US rules, as in tzcode.
+            _Rule._Start = {'M', 3, 2, 0, _Default_rule_time};
+            _Rule._End   = {'M', 11, 1, 0, _Default_rule_time};
+            return true;
+        }
+
+        return *_It++ == ',' && _Parse_rule_date(_It, _Last, _Rule._Start) && _It != _Last && *_It++ == ','
+            && _Parse_rule_date(_It, _Last, _Rule._End) && _It == _Last;
+    }
+
+    [[nodiscard]] bool _Parse_tzif(const unsigned char* const _Data, const size_t _Size, _Zone& _Tzif) noexcept {
+        _Tzif = {};
+        if (_Size < _Tzif_header_size || _CSTD memcmp(_Data, "TZif", 4) != 0) {
+            return false;
+        }
+
+        const auto _Block_size = [](const unsigned char* const _Header, const size_t _Time_size) noexcept {
+            const size_t _Isut_count  = _Read_be32(_Header + 20);
+            const size_t _Isstd_count = _Read_be32(_Header + 24);
+            const size_t _Leap_count  = _Read_be32(_Header + 28);
+            const size_t _Time_count  = _Read_be32(_Header + 32);
+            const size_t _Type_count  = _Read_be32(_Header + 36);
+            const size_t _Char_count  = _Read_be32(_Header + 40);
+            return _Time_count * _Time_size + _Time_count + _Type_count * 6 + _Char_count
+                 + _Leap_count * (_Time_size + 4) + _Isstd_count + _Isut_count;
+        };
+
+        // Version 1 data has 32-bit times and no footer; later versions repeat the data with 64-bit times.
+        const unsigned char* _Header = _Data;
+        size_t _Time_size            = 4;
+        size_t _Block                = _Block_size(_Header, 4);
+        if (_Data[4] != '\0') {
+            if (_Block > _Size - _Tzif_header_size || _Size - _Tzif_header_size - _Block < _Tzif_header_size) {
+                return false;
+            }
+
+            _Header = _Data + _Tzif_header_size + _Block;
+            if (_CSTD memcmp(_Header, "TZif", 4) != 0) {
+                return false;
+            }
+
+            _Time_size = 8;
+            _Block     = _Block_size(_Header, 8);
+        }
+
+        const size_t _Available = _Size - static_cast<size_t>(_Header - _Data) - _Tzif_header_size;
+        if (_Block > _Available) {
+            return false;
+        }
+
+        _Tzif._Transition_count = _Read_be32(_Header + 32);
+        _Tzif._Type_count       = _Read_be32(_Header + 36);
+        _Tzif._Abbrev_size      = _Read_be32(_Header + 40);
+        _Tzif._Time_size        = static_cast<uint32_t>(_Time_size);
+        if (_Tzif._Type_count == 0 || _Tzif._Abbrev_size == 0) {
+            return false;
+        }
+
+        const unsigned char* _It = _Header + _Tzif_header_size;
+        _Tzif._Transitions       = _It;
+        _It += static_cast<size_t>(_Tzif._Transition_count) * _Time_size;
+        _Tzif._Transition_types = _It;
+        _It += _Tzif._Transition_count;
+        _Tzif._Types = _It;
+        _It += static_cast<size_t>(_Tzif._Type_count) * 6;
+        _Tzif._Abbrevs = reinterpret_cast<const char*>(_It);
+
+        if (_Tzif._Abbrevs[_Tzif._Abbrev_size - 1] != '\0') {
+            return false;
+        }
+
+        for (uint32_t _Idx = 0; _Idx < _Tzif._Transition_count; ++_Idx) {
+            if (_Tzif._Transition_types[_Idx] >= _Tzif._Type_count) {
+                return false;
+            }
+        }
+
+        for (uint32_t _Idx = 0; _Idx < _Tzif._Type_count; ++_Idx) {
+            const int32_t _Offset = static_cast<int32_t>(_Read_be32(_Tzif._Types + _Idx * 6));
+            if (_Offset < _Min_offset || _Offset > _Max_offset || _Tzif._Types[_Idx * 6 + 5] >= _Tzif._Abbrev_size) {
+                return false;
+            }
+        }
+
+        if (_Time_size == 4) {
+            return true;
+        }
+
+        // The footer: a newline, a POSIX TZ string (possibly empty), a newline.
+        const char* const _Footer = reinterpret_cast<const char*>(_Header + _Tzif_header_size + _Block);
+        const char* const _Last   = reinterpret_cast<const char*>(_Data + _Size);
+        if (_Footer == _Last || *_Footer != '\n') {
+            return true;
+        }
+
+        const char* const _Rule_end = static_cast<const char*>(
+            _CSTD memchr(_Footer + 1, '\n', static_cast<size_t>(_Last - _Footer - 1)));
+        if (_Rule_end == nullptr) {
+            return false;
+        }
+
+        if (_Rule_end != _Footer + 1) {
+            if (!_Parse_posix_rule(_Footer + 1, _Rule_end, _Tzif._Rule)) {
+                return false;
+            }
+
+            _Tzif._Has_rule = true;
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] int64_t _Transition_at(const _Zone& _Tzif, const uint32_t _Idx) noexcept {
+        const unsigned char* const _Ptr = _Tzif._Transitions + static_cast<size_t>(_Idx) * _Tzif._Time_size;
+        return _Tzif._Time_size == 8 ? _Read_be64(_Ptr) : static_cast<int32_t>(_Read_be32(_Ptr));
+    }
+
+    struct _Local_type {
+        int32_t _Offset;
+        bool _Is_dst;
+        const char* _Abbrev;
+    };
+
+    [[nodiscard]] _Local_type _Type_at(const _Zone& _Tzif, const uint32_t _Type) noexcept {
+        const unsigned char* const _Ptr = _Tzif._Types + static_cast<size_t>(_Type) * 6;
+        return {static_cast<int32_t>(_Read_be32(_Ptr)), _Ptr[4] != 0, _Tzif._Abbrevs + _Ptr[5]};
+    }
+
+    // The amount of daylight saving time of the type in effect from transition _Idx: the difference from the
+    // nearest standard time, before or after.
+    [[nodiscard]] int32_t _Save_at(const _Zone& _Tzif, const uint32_t _Idx, const int32_t _Offset) noexcept {
+        for (uint32_t _Prev = _Idx; _Prev-- > 0;) {
+            const _Local_type _Type = _Type_at(_Tzif, _Tzif._Transition_types[_Prev]);
+            if (!_Type._Is_dst && _Type._Offset != _Offset) {
+                return _Offset - _Type._Offset;
+            }
+        }
+
+        for (uint32_t _Next = _Idx + 1; _Next < _Tzif._Transition_count; ++_Next) {
+            const _Local_type _Type = _Type_at(_Tzif, _Tzif._Transition_types[_Next]);
+            if (!_Type._Is_dst && _Type._Offset != _Offset) {
+                return _Offset - _Type._Offset;
+            }
+        }
+
+        return 3600;
+    }
+
+    // The day, in days since 1970-01-01, on which a POSIX rule date falls in _Year.
+    [[nodiscard]] int64_t _Rule_day(const _Rule_date& _Date, const int64_t _Year) noexcept {
+        const int64_t _January_1 = _Days_from_civil(_Year, 1, 1);
+        switch (_Date._Kind) {
+        case 'J':
+            return _January_1 + _Date._Day - 1 + (_Is_leap(_Year) && _Date._Day >= 60);
+        case 'n':
+            return _January_1 + _Date._Day;
+        default:
+        {
+            static constexpr int _Month_days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+            const int64_t _First   = _Days_from_civil(_Year, _Date._Month, 1);
+            const int _Length      = _Month_days[_Date._Month - 1] + (_Date._Month == 2 && _Is_leap(_Year));
+            const int _First_wday  = static_cast<int>((_First % 7 + 11) % 7); // 1970-01-01 was a Thursday
+            int64_t _Day           = _First + (_Date._Day - _First_wday + 7) % 7 + (_Date._Week - 1) * 7;
+            while (_Day >= _First + _Length) {
+                _Day -= 7;
+            }
+
+            return _Day;
+        }
+        }
+    }
+
+    struct _Lookup_result {
+        int32_t _Offset;
+        int32_t _Save;
+        const char* _Abbrev;
+        bool _Is_dst;
+        bool _Has_begin;
+        bool _Has_end;
+        int64_t _Begin;
+        int64_t _End;
+    };
+
+    // Applies the POSIX rule at _Time, which is at or after _Floor (the last transition) if _Has_floor.
+    void _Lookup_rule(const _Posix_rule& _Rule, const int64_t _Time, const bool _Has_floor, const int64_t _Floor,
+        _Lookup_result& _Result) noexcept {
+        _Result._Offset    = _Rule._Std_offset;
+        _Result._Save      = 0;
+        _Result._Is_dst    = false;
+        _Result._Abbrev    = _Rule._Std_abbrev;
+        _Result._Begin     = _Floor;
+        _Result._Has_begin = _Has_floor;
+        _Result._Has_end   = false;
+        if (!_Rule._Has_dst) {
+            return;
+        }
+
+        // The transitions of the year around _Time and of the years either side, in order; at the same instant
+        // an end of DST sorts before a start, so that back-to-back periods of DST read as one.
+        struct _Event {
+            int64_t _When;
+            bool _To_dst;
+        };
+
+        _Event _Events[6];
+        const int64_t _Year = _Year_from_days(_Floor_div(_Time + _Rule._Std_offset, _Seconds_per_day));
+        for (int _Idx = 0; _Idx < 3; ++_Idx) {
+            const int64_t _Y      = _Year - 1 + _Idx;
+            const int64_t _Start  = _Rule_day(_Rule._Start, _Y) * _Seconds_per_day + _Rule._Start._Time;
+            const int64_t _End    = _Rule_day(_Rule._End, _Y) * _Seconds_per_day + _Rule._End._Time;
+            _Events[_Idx * 2]     = {_Start - _Rule._Std_offset, true}; // local standard time
+            _Events[_Idx * 2 + 1] = {_End - _Rule._Dst_offset, false}; // local daylight saving time
+        }
+
+        for (int _Idx = 1; _Idx < 6; ++_Idx) {
+            const _Event _Next = _Events[_Idx];
+            int _Pos             = _Idx;
+            for (; _Pos > 0
+                   && (_Events[_Pos - 1]._When > _Next._When
+                       || (_Events[_Pos - 1]._When == _Next._When && _Events[_Pos - 1]._To_dst && !_Next._To_dst));
+                 --_Pos) {
+                _Events[_Pos] = _Events[_Pos - 1];
+            }
+
+            _Events[_Pos] = _Next;
+        }
+
+        bool _State   = !_Events[0]._To_dst;
+        bool _At_time = _State;
+        for (int _Idx = 0; _Idx < 6;) {
+            const int64_t _When = _Events[_Idx]._When;
+            const bool _Before  = _State;
+            for (; _Idx < 6 && _Events[_Idx]._When == _When; ++_Idx) {
+                _State = _Events[_Idx]._To_dst;
+            }
+
+            if (_When <= _Time) {
+                _At_time = _State;
+                if (_State != _Before && (!_Result._Has_begin || _When > _Result._Begin)) {
+                    _Result._Begin     = _When;
+                    _Result._Has_begin = true;
+                }
+            } else if (_State != _At_time) {
+                _Result._End     = _When;
+                _Result._Has_end = true;
+                break;
+            }
+        }
+
+        if (_At_time) {
+            _Result._Is_dst = true;
+            _Result._Offset = _Rule._Dst_offset;
+            _Result._Save   = _Rule._Dst_offset - _Rule._Std_offset;
+            _Result._Abbrev = _Rule._Dst_abbrev;
+        }
+    }
+
+    [[nodiscard]] bool _Same_type(const _Local_type& _Left, const _Local_type& _Right) noexcept {
+        return _Left._Offset == _Right._Offset && _Left._Is_dst == _Right._Is_dst
+            && _CSTD strcmp(_Left._Abbrev, _Right._Abbrev) == 0;
+    }
+
+    // The type in effect after transition _Period - 1; before the first transition, the first type.
+    [[nodiscard]] _Local_type _Period_type(const _Zone& _Tzif, const uint32_t _Period) noexcept {
+        return _Type_at(_Tzif, _Period == 0 ? 0 : _Tzif._Transition_types[_Period - 1]);
+    }
+
+    // The first of the periods before and including _Period that have the same type.  Transitions that change
+    // nothing (zic -b fat writes some) are not the beginning of a period.
+    [[nodiscard]] uint32_t _Run_start(const _Zone& _Tzif, uint32_t _Period, const _Local_type& _Type) noexcept {
+        while (_Period > 0 && _Same_type(_Period_type(_Tzif, _Period - 1), _Type)) {
+            --_Period;
+        }
+
+        return _Period;
+    }
+
+    void _Lookup(const _Zone& _Tzif, const int64_t _Time, _Lookup_result& _Result) noexcept {
+        _Result = {};
+
+        // The number of transitions at or before _Time, by binary search.
+        const uint32_t _Transitions = _Tzif._Transition_count;
+        uint32_t _Period            = 0;
+        uint32_t _Count             = _Transitions;
+        while (_Count > 0) {
+            const uint32_t _Half = _Count / 2;
+            if (_Transition_at(_Tzif, _Period + _Half) <= _Time) {
+                _Period += _Half + 1;
+                _Count -= _Half + 1;
+            } else {
+                _Count = _Half;
+            }
+        }
+
+        if (_Period == _Transitions && _Tzif._Has_rule) {
+            const bool _Has_floor = _Transitions > 0;
+            const int64_t _Floor  = _Has_floor ? _Transition_at(_Tzif, _Transitions - 1) : 0;
+            _Lookup_rule(_Tzif._Rule, _Time, _Has_floor, _Floor, _Result);
+
+            const _Local_type _Type{_Result._Offset, _Result._Is_dst, _Result._Abbrev};
+            if (_Has_floor && _Result._Begin == _Floor && _Same_type(_Period_type(_Tzif, _Transitions), _Type)) {
+                const uint32_t _Start = _Run_start(_Tzif, _Transitions, _Type);
+                _Result._Has_begin    = _Start > 0;
+                _Result._Begin        = _Start > 0 ? _Transition_at(_Tzif, _Start - 1) : 0;
+            }
+
+            return;
+        }
+
+        const _Local_type _Type = _Period_type(_Tzif, _Period);
+        _Result._Offset         = _Type._Offset;
+        _Result._Save           = _Type._Is_dst ? _Save_at(_Tzif, _Period == 0 ? 0 : _Period - 1, _Type._Offset) : 0;
+        _Result._Abbrev         = _Type._Abbrev;
+        _Result._Is_dst         = _Type._Is_dst;
+
+        const uint32_t _Start = _Run_start(_Tzif, _Period, _Type);
+        _Result._Has_begin    = _Start > 0;
+        _Result._Begin        = _Start > 0 ? _Transition_at(_Tzif, _Start - 1) : 0;
+
+        uint32_t _Stop = _Period;
+        while (_Stop < _Transitions && _Same_type(_Period_type(_Tzif, _Stop + 1), _Type)) {
+            ++_Stop;
+        }
+
+        if (_Stop < _Transitions) {
+            _Result._Has_end = true;
+            _Result._End     = _Transition_at(_Tzif, _Stop);
+        } else if (_Tzif._Has_rule) {
+            // The period runs past the last transition, into the rule.
+            const int64_t _Floor = _Transition_at(_Tzif, _Transitions - 1);
+            _Lookup_result _After;
+            _Lookup_rule(_Tzif._Rule, _Floor, true, _Floor, _After);
+            if (_Same_type({_After._Offset, _After._Is_dst, _After._Abbrev}, _Type)) {
+                _Result._Has_end = _After._Has_end;
+                _Result._End     = _After._End;
+            } else {
+                _Result._Has_end = true;
+                _Result._End     = _Floor;
+            }
+        }
+    }
+
+    void _Free_database(_Database* const _Db) noexcept {
+        if (_Db->_Zones != nullptr) {
+            for (uint32_t _Idx = 0; _Idx < _Db->_Count; ++_Idx) {
+                _free_crt(_Db->_Zones[_Idx]);
+            }
+
+            _free_crt(const_cast<_Zone**>(_Db->_Zones));
+        }
+
+        if (_Db->_Stream != nullptr) {
+            _CSTD fclose(_Db->_Stream);
+        }
+
+        _free_crt(_Db->_Copy);
+        _free_crt(_Db);
+    }
+
+    struct _Database_cleanup {
+        ~_Database_cleanup() {
+            _Current_database = nullptr;
+            while (_All_databases != nullptr) {
+                _Database* const _Next = _All_databases->_Next;
+                _Free_database(_All_databases);
+                _All_databases = _Next;
+            }
+        }
+    };
+
+    _Database_cleanup _Cleanup;
+
+    // Validates the database at _Data and makes it the current one.  On failure, nothing is taken over.
+    [[nodiscard]] errno_t _Load(
+        const void* const _Data, const size_t _Size, FILE* const _Stream, void* const _Copy) noexcept {
+        auto _Db = static_cast<_Database*>(_calloc_crt(1, sizeof(_Database)));
+        if (_Db == nullptr) {
+            return ENOMEM;
+        }
+
+        _Db->_Data = static_cast<const unsigned char*>(_Data);
+        _Db->_Size = _Size;
+        if (!_Validate_database(*_Db)) {
+            _free_crt(_Db);
+            return EINVAL;
+        }
+
+        _Db->_Zones = static_cast<_Zone**>(_calloc_crt(_Db->_Count != 0 ? _Db->_Count : 1, sizeof(_Zone*)));
+        if (_Db->_Zones == nullptr) {
+            _free_crt(_Db);
+            return ENOMEM;
+        }
+
+        _Db->_Stream = _Stream;
+        _Db->_Copy   = _Copy;
+
+        AcquireSRWLockExclusive(&_Tzdb_lock);
+        _Db->_Next     = _All_databases;
+        _All_databases = _Db;
+        InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&_Current_database), _Db);
+        ReleaseSRWLockExclusive(&_Tzdb_lock);
+        return 0;
+    }
+
+    [[nodiscard]] _Database* _Acquire_database() noexcept {
+        return static_cast<_Database*>(ReadPointerAcquire(reinterpret_cast<PVOID volatile*>(&_Current_database)));
+    }
+
+    enum class _Zone_status { _Found, _Not_found, _No_memory };
+
+    // Finds the zone _Name names, parsing it on first use.
+    [[nodiscard]] _Zone_status _Get_zone(
+        _Database& _Db, const char* const _Name, const size_t _Len, const _Zone*& _Result) noexcept {
+        const uint32_t _Idx = _Find_zone_entry(_Db, _Name, _Len);
+        if (_Idx == _No_entry) {
+            return _Zone_status::_Not_found;
+        }
+
+        auto& _Slot    = reinterpret_cast<PVOID volatile&>(_Db._Zones[_Idx]);
+        auto _Existing = static_cast<const _Zone*>(ReadPointerAcquire(&_Slot));
+        if (_Existing == nullptr) {
+            auto _Parsed = static_cast<_Zone*>(_calloc_crt(1, sizeof(_Zone)));
+            if (_Parsed == nullptr) {
+                return _Zone_status::_No_memory;
+            }
+
+            const unsigned char* const _Entry = _Entry_at(_Db, _Idx);
+            if (!_Parse_tzif(_Db._Data + _Read_le32(_Entry + 8), _Read_le32(_Entry + 12), *_Parsed)) {
+                _free_crt(_Parsed);
+                return _Zone_status::_Not_found;
+            }
+
+            _Existing = static_cast<const _Zone*>(InterlockedCompareExchangePointer(&_Slot, _Parsed, nullptr));
+            if (_Existing == nullptr) {
+                _Existing = _Parsed;
+            } else {
+                _free_crt(_Parsed); // another thread parsed it first
+            }
+        }
+
+        _Result = _Existing;
+        return _Zone_status::_Found;
+    }
+
+    [[nodiscard]] char* _Copy_string(const char* const _Str) noexcept {
+        const size_t _Len = _CSTD strlen(_Str);
+        char* const _Copy = new (_STD nothrow) char[_Len + 1];
+        if (_Copy != nullptr) {
+            _CSTD memcpy(_Copy, _Str, _Len + 1);
+        }
+
+        return _Copy;
+    }
+
+    [[nodiscard]] __std_tzdb_epoch_milli _To_milli(
+        const bool _Has_value, const int64_t _Seconds, const double _Limit) noexcept {
+        return _Has_value ? static_cast<double>(_Seconds) * 1000 : _Limit;
+    }
+} // unnamed namespace
+
+extern "C" {
+
+[[nodiscard]] __std_tzdb_time_zones_info* __stdcall __std_tzdb_get_time_zones() noexcept {
+    // On exit---
+    //    _Info == nullptr          --> bad_alloc
+    //    _Info->_Err == _Icu_error --> no database has been loaded
+    // The names point into the database, which is never freed while the driver runs.
+    const auto _Info = new (_STD nothrow) __std_tzdb_time_zones_info{};
+    if (_Info == nullptr) {
+        return nullptr;
+    }
+
+    _Database* const _Db = _Acquire_database();
+    if (_Db == nullptr) {
+        _Info->_Err = __std_tzdb_error::_Icu_error;
+        return _Info;
+    }
+
+    _Info->_Version        = _Db->_Version;
+    _Info->_Num_time_zones = _Db->_Count;
+    _Info->_Names          = new (_STD nothrow) const char*[_Db->_Count + 1];
+    _Info->_Links          = new (_STD nothrow) const char*[_Db->_Count + 1];
+    if (_Info->_Names == nullptr || _Info->_Links == nullptr) {
+        __std_tzdb_delete_time_zones(_Info);
+        return nullptr;
+    }
+
+    for (uint32_t _Idx = 0; _Idx < _Db->_Count; ++_Idx) {
+        const uint32_t _Target = _Read_le32(_Entry_at(*_Db, _Idx) + 4);
+        _Info->_Names[_Idx]    = _Entry_name(*_Db, _Idx);
+        _Info->_Links[_Idx]    = _Target == _No_entry ? nullptr : _Entry_name(*_Db, _Target);
+    }
+
+    return _Info;
+}
+
+void __stdcall __std_tzdb_delete_time_zones(__std_tzdb_time_zones_info* const _Info) noexcept {
+    if (_Info != nullptr) {
+        delete[] _Info->_Names;
+        delete[] _Info->_Links;
+        delete _Info;
+    }
+}
+
+[[nodiscard]] __std_tzdb_current_zone_info* __stdcall __std_tzdb_get_current_zone() noexcept {
+    // On exit---
+    //    _Info == nullptr          --> bad_alloc
+    const auto _Info = new (_STD nothrow) __std_tzdb_current_zone_info{};
+    if (_Info == nullptr) {
+        return nullptr;
+    }
+
+    AcquireSRWLockShared(&_Tzdb_lock);
+    const char* _Name    = _Current_zone_name;
+    _Database* const _Db = _Acquire_database();
+    if (_Name[0] == '\0') {
+        _Name = _Db != nullptr && _Db->_Default_zone != _No_entry ? _Entry_name(*_Db, _Db->_Default_zone) : "UTC";
+    }
+
+    _Info->_Tz_name = _Copy_string(_Name);
+    ReleaseSRWLockShared(&_Tzdb_lock);
+
+    if (_Info->_Tz_name == nullptr) {
+        delete _Info;
+        return nullptr;
+    }
+
+    return _Info;
+}
+
+void __stdcall __std_tzdb_delete_current_zone(__std_tzdb_current_zone_info* const _Info) noexcept {
+    if (_Info) {
+        delete[] _Info->_Tz_name;
+
+        delete _Info;
+    }
+}
+
+[[nodiscard]] __std_tzdb_sys_info* __stdcall __std_tzdb_get_sys_info(
+    const char* _Tz, const size_t _Tz_len, __std_tzdb_epoch_milli _Sys) noexcept {
+    // On exit---
+    //    _Info == nullptr          --> bad_alloc
+    //    _Info->_Err == _Icu_error --> no database, or the zone is not in it or is malformed
+    const auto _Info = new (_STD nothrow) __std_tzdb_sys_info{};
+    if (_Info == nullptr) {
+        return nullptr;
+    }
+
+    // Get the option stored after the time zone name. If there's no option, _Tz[_Tz_len] is the null terminator in the
+    // std::string, and will be treated the same as __std_tzdb_sys_info_type::_Full.
+    const auto _Type = static_cast<__std_tzdb_sys_info_type>(_Tz[_Tz_len]);
+
+    _Database* const _Db = _Acquire_database();
+    const _Zone* _Tzif   = nullptr;
+    const auto _Status   = _Db != nullptr ? _Get_zone(*_Db, _Tz, _Tz_len, _Tzif) : _Zone_status::_Not_found;
+    if (_Status == _Zone_status::_No_memory) {
+        delete _Info;
+        return nullptr;
+    } else if (_Status != _Zone_status::_Found) {
+        _Info->_Err = __std_tzdb_error::_Icu_error;
+        return _Info;
+    }
+
+    // Milliseconds to seconds, rounding toward negative infinity.
+    constexpr double _Max_seconds = 1e15;
+    double _Seconds               = _Sys / 1000;
+    if (_Seconds < -_Max_seconds) {
+        _Seconds = -_Max_seconds;
+    } else if (_Seconds > _Max_seconds) {
+        _Seconds = _Max_seconds;
+    }
+
+    int64_t _Time = static_cast<int64_t>(_Seconds);
+    if (static_cast<double>(_Time) > _Seconds) {
+        --_Time;
+    }
+
+    _Lookup_result _Result;
+    _Lookup(*_Tzif, _Time, _Result);
+
+    _Info->_Offset = _Result._Offset * 1000;
+    _Info->_Save   = _Result._Save * 1000;
+    if (_Type == __std_tzdb_sys_info_type::_Offset_only) {
+        return _Info;
+    }
+
+    _Info->_Begin = _To_milli(_Result._Has_begin, _Result._Begin, -DBL_MAX);
+    _Info->_End   = _To_milli(_Result._Has_end, _Result._End, DBL_MAX);
+    if (_Type == __std_tzdb_sys_info_type::_Offset_and_range) {
+        return _Info;
+    }
+
+    _Info->_Abbrev = _Copy_string(_Result._Abbrev);
+    if (_Info->_Abbrev == nullptr) {
+        delete _Info;
+        return nullptr;
+    }
+
+    return _Info;
+}
+
+void __stdcall __std_tzdb_delete_sys_info(__std_tzdb_sys_info* const _Info) noexcept {
+    if (_Info) {
+        delete[] _Info->_Abbrev;
+
+        delete _Info;
+    }
+}
+
+[[nodiscard]] __std_tzdb_leap_info* __stdcall __std_tzdb_get_leap_seconds(
+    const size_t, size_t* const current_reg_ls_size) noexcept {
+    // Musa: There is no LeapSecondInformation to read; <chrono> uses the leap seconds it knows.
+    *current_reg_ls_size = 0;
+    return nullptr;
+}
+
+void __stdcall __std_tzdb_delete_leap_seconds(__std_tzdb_leap_info* _Info) noexcept {
+    delete[] _Info;
+}
+
+[[nodiscard]] void* __stdcall __std_calloc_crt(const size_t count, const size_t size) noexcept {
+    return _calloc_crt(count, size);
+}
+
+void __stdcall __std_free_crt(void* p) noexcept {
+    _free_crt(p);
+}
+
+errno_t __cdecl ktzdb_load(const void* const database, const size_t size) {
+    if (database == nullptr) {
+        return EINVAL;
+    }
+
+    return _Load(database, size, nullptr, nullptr);
+}
+
+errno_t __cdecl ktzdb_validate(const void* const database, const size_t size) {
+    if (database == nullptr) {
+        return EINVAL;
+    }
+
+    _Database _Db{};
+    _Db._Data = static_cast<const unsigned char*>(database);
+    _Db._Size = size;
+    return _Validate_database(_Db) ? 0 : EINVAL;
+}
+
+errno_t __cdecl ktzdb_load_file(const char* const path) {
+    if (path == nullptr) {
+        return EINVAL;
+    }
+
+    FILE* const _Stream = _CSTD fopen(path, "rbm");
+    if (_Stream == nullptr) {
+        return errno;
+    }
+
+    const void* _Data = nullptr;
+    size_t _Size      = 0;
+    if (_fmapview(_Stream, &_Data, &_Size) == 0) {
+        const errno_t _Err = _Load(_Data, _Size, _Stream, nullptr);
+        if (_Err != 0) {
+            _CSTD fclose(_Stream);
+        }
+
+        return _Err;
+    }
+
+    // Not mappable: read it.
+    errno_t _Err            = EINVAL;
+    const long long _Length = _CSTD _fseeki64(_Stream, 0, SEEK_END) == 0 ? _CSTD _ftelli64(_Stream) : -1;
+    void* _Copy             = nullptr;
+    if (_Length > 0 && static_cast<unsigned long long>(_Length) <= SIZE_MAX
+        && _CSTD _fseeki64(_Stream, 0, SEEK_SET) == 0) {
+        _Size = static_cast<size_t>(_Length);
+        _Copy = _malloc_crt(_Size);
+        if (_Copy == nullptr) {
+            _Err = ENOMEM;
+        } else if (_CSTD fread(_Copy, 1, _Size, _Stream) == _Size) {
+            _Err = _Load(_Copy, _Size, nullptr, _Copy);
+        }
+    }
+
+    _CSTD fclose(_Stream);
+    if (_Err != 0) {
+        _free_crt(_Copy);
+    }
+
+    return _Err;
+}
+
+errno_t __cdecl ktzdb_set_current_zone(const char* const name) {
+    if (name != nullptr) {
+        const size_t _Len    = _CSTD strlen(name);
+        _Database* const _Db = _Acquire_database();
+        if (_Len >= _Max_zone_name || _Db == nullptr || _Find_zone_entry(*_Db, name, _Len) == _No_entry) {
+            return EINVAL; // current_zone would throw
+        }
+    }
+
+    AcquireSRWLockExclusive(&_Tzdb_lock);
+    if (name != nullptr) {
+        _CSTD memcpy(_Current_zone_name, name, _CSTD strlen(name) + 1);
+    } else {
+        _Current_zone_name[0] = '\0';
+    }
+    ReleaseSRWLockExclusive(&_Tzdb_lock);
+    return 0;
+}
+
+} // extern "C"
@@ -0,0 +1,216 @@
+//
+// deferred_initializers.cpp
+//
+// Musa: Deferred and parallel static initialization.  See kext/kinit.h.
+//
+// Each entry moves through pending -> claimed -> running -> done.  Whoever
+// wins the pending -> claimed exchange builds the entry:  the DriverEntry
+// thread, a pool thread, or the first thread to access the object.  The
+// entry's completion event is only initialized by that thread, before the
+// entry is published as running, so entries need no setup pass and can be
+// accessed from ordinary global constructors.
+//
+// A built entry is destroyed the way an ordinary global is:  its completion
+// registers a function with atexit, which destroys the most recently completed
+// entry.  Completing and registering is one step under a lock, so entries and
+// globals are destroyed in exact reverse order of construction.
+//
+#include <vcstartup_internal.h>
+#include <vcruntime_internal.h>
+#include "kext/kinit.h"
+
+#pragma section(".CRT$XKA", long, read)
+#pragma section(".CRT$XKZ", long, read)
+
+extern "C" _CRTALLOC(".CRT$XKA") kinit_entry* const __xk_a[] = { nullptr }; // deferred and parallel initializers (first)
+extern "C" _CRTALLOC(".CRT$XKZ") kinit_entry* const __xk_z[] = { nullptr }; // deferred and parallel initializers (last)
+
+
+
+namespace
+{
+    enum : long
+    {
+        StatePending = 0,
+        StateClaimed,
+        StateRunning,
+        StateDone,
+    };
+
+    constexpr ULONG MaximumWorkers = 8;
+
+    struct ParallelPool
+    {
+        long volatile cursor;
+        ULONG         count;
+        PKTHREAD      workers[MaximumWorkers];
+    };
+}
+
+static ParallelPool parallel_pool;
+static SRWLOCK      completion_lock   = SRWLOCK_INIT;
+static kinit_entry* completed_entries = nullptr; // most recently completed first; guarded by completion_lock
+
+
+
+// Registered with atexit once for each completed entry.  Runs at unload, once
+// the parallel pool has stopped, so it needs no lock (atexit functions run
+// under the exit lock, which build_entry takes inside completion_lock).
+static void __cdecl destroy_completed_entry() noexcept
+{
+    kinit_entry* const entry = completed_entries;
+    if (entry == nullptr)
+        return;
+
+    completed_entries = entry->next_completed;
+    if (entry->destroy != nullptr)
+    {
+        entry->destroy(entry->object);
+    }
+}
+
+
+
+static void __cdecl build_entry(kinit_entry* const entry) noexcept
+{
+    KeInitializeEvent(&entry->completed, NotificationEvent, FALSE);
+    WritePointerNoFence(&entry->owner, KeGetCurrentThread());
+    WriteRelease(&entry->state, StateRunning);
+
+    if (entry->dependencies != nullptr)
+    {
+        for (kinit_entry* const* it = entry->dependencies; *it != nullptr; ++it)
+        {
+            kinit_ensure(*it);
+        }
+    }
+
+    unsigned __int64 const start = ReadTimeStampCounter();
+    entry->construct(entry->object);
+    entry->cycles = ReadTimeStampCounter() - start;
+
+    // If atexit fails, the entry is destroyed after the atexit functions have
+    // run instead; the functions registered still destroy one entry each, in
+    // the same order.
+    AcquireSRWLockExclusive(&completion_lock);
+    entry->next_completed = completed_entries;
+    completed_entries = entry;
+    atexit(destroy_completed_entry);
+    ReleaseSRWLockExclusive(&completion_lock);
+
+    WriteRelease(&entry->state, StateDone);
+    KeSetEvent(&entry->completed, IO_NO_INCREMENT, FALSE);
+}
+
+extern "C" void __cdecl kinit_ensure(kinit_entry* const entry)
+{
+    if (ReadAcquire(&entry->state) == StateDone)
+        return;
+
+    if (InterlockedCompareExchange(&entry->state, StateClaimed, StatePending) == StatePending)
+    {
+        build_entry(entry);
+        return;
+    }
+
+    // Another thread is building it.  The claimed state only lasts until the
+    // builder has initialized the completion event:
+    long state;
+    while ((state = ReadAcquire(&entry->state)) == StateClaimed)
+    {
+        YieldProcessor();
+    }
+
+    if (state == StateDone)
+        return;
+
+    // An entry that (indirectly) depends on itself would wait forever:
+    if (ReadPointerNoFence(&entry->owner) == KeGetCurrentThread())
+    {
+        __fastfail(FAST_FAIL_FATAL_APP_EXIT);
+    }
+
+    KeWaitForSingleObject(&entry->completed, Executive, KernelMode, FALSE, nullptr);
+}
+
+
+
+static void NTAPI parallel_worker(PVOID) noexcept
+{
+    for (;;)
+    {
+        long const index = InterlockedIncrement(&parallel_pool.cursor) - 1;
+        if (index >= __xk_z - __xk_a)
+            break;
+
+        kinit_entry* const entry = __xk_a[index];
+        if (entry != nullptr && (entry->flags & KINIT_PARALLEL) != 0)
+        {
+            kinit_ensure(entry);
+        }
+    }
+
+    PsTerminateSystemThread(STATUS_SUCCESS);
+}
+
+// Starts the parallel pool.  Called just before DriverMain.  If no thread can
+// be started, parallel entries are built on first access instead.
+extern "C" void __cdecl __scrt_start_parallel_initializers()
+{
+    ULONG pending = 0;
+    for (kinit_entry* const* it = __xk_a; it != __xk_z; ++it)
+    {
+        if (*it != nullptr && ((*it)->flags & KINIT_PARALLEL) != 0 && ReadAcquire(&(*it)->state) == StatePending)
+            ++pending;
+    }
+
+    if (pending == 0)
+        return;
+
+    ULONG workers = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+    workers = workers < MaximumWorkers ? workers : MaximumWorkers;
+    workers = workers < pending        ? workers : pending;
+
+    parallel_pool.cursor = 0;
+    for (ULONG i = 0; i != workers; ++i)
+    {
+        HANDLE thread_handle = nullptr;
+        NTSTATUS status = PsCreateSystemThread(&thread_handle, THREAD_ALL_ACCESS, nullptr, nullptr, nullptr,
+            parallel_worker, nullptr);
+        if (!NT_SUCCESS(status))
+            break;
+
+        PKTHREAD thread = nullptr;
+        status = ObReferenceObjectByHandle(thread_handle, SYNCHRONIZE, *PsThreadType, KernelMode,
+            reinterpret_cast<PVOID*>(&thread), nullptr);
+        ZwClose(thread_handle);
+
+        if (NT_SUCCESS(status))
+        {
+            parallel_pool.workers[parallel_pool.count++] = thread;
+        }
+    }
+}
+
+// Waits for the parallel pool, so that no entry completes while the atexit
+// functions run.  Called at unload before _cexit.
+extern "C" void __cdecl __scrt_stop_parallel_initializers()
+{
+    for (ULONG i = 0; i != parallel_pool.count; ++i)
+    {
+        KeWaitForSingleObject(parallel_pool.workers[i], Executive, KernelMode, FALSE, nullptr);
+        ObDereferenceObject(parallel_pool.workers[i]);
+        parallel_pool.workers[i] = nullptr;
+    }
+    parallel_pool.count = 0;
+}
+
+// Destroys the entries whose atexit registration failed, most recently
+// completed first.  Called at unload after _cexit.
+extern "C" void __cdecl __scrt_uninitialize_parallel_initializers()
+{
+    while (completed_entries != nullptr)
+    {
+        destroy_completed_entry();
+    }
+}
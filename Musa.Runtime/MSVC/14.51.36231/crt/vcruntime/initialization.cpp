@@ -10,6 +10,11 @@
 //
 #include <vcruntime_internal.h>
 
+#if defined _M_AMD64 || defined _M_ARM64
+#include "unwind_index.h"
+#define INIT_UNWIND_INDEX 1
+#endif
+
 extern "C" {
 
 #if !defined(_CRT_WINDOWS) && \
@@ -77,6 +82,11 @@ bool __cdecl __vcrt_initialize()
         return false;
     }
 
+    #ifdef INIT_UNWIND_INDEX
+    // Musa: optional; exception dispatch falls back to the kernel without it.
+    __vcrt_initialize_unwind_index();
+    #endif
+
     return true;
 }
 
@@ -84,6 +94,11 @@ bool __cdecl __vcrt_uninitialize(_In_ bool const terminating)
 {
     UNREFERENCED_PARAMETER(terminating);
 
+    #ifdef INIT_UNWIND_INDEX
+    // Musa: pool memory, which does not go away with the image; always freed.
+    __vcrt_uninitialize_unwind_index();
+    #endif
+
 #if !defined NTOS_KERNEL_RUNTIME
     // If the process is terminating, there's no point in cleaning up, except
     // in debug builds.
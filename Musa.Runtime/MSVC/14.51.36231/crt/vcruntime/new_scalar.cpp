@@ -0,0 +1,64 @@
+//
+// new_scalar.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Defines the scalar operator new.
+//
+#include <stdlib.h>
+#include <vcruntime_new.h>
+#include <vcstartup_internal.h>
+#if defined NTOS_KERNEL_RUNTIME
+#include <corecrt_internal_heap_profile.h>
+#endif
+
+// Enable the compiler to elide null checks during LTCG
+#pragma comment(linker, "/ThrowingNew")
+
+////////////////////////////////////
+// new() Fallback Ordering
+//
+// +----------+
+// |new_scalar<---------------+
+// +----^-----+               |
+//      |                     |
+// +----+-------------+  +----+----+
+// |new_scalar_nothrow|  |new_array|
+// +------------------+  +----^----+
+//                            |
+//               +------------+----+
+//               |new_array_nothrow|
+//               +-----------------+
+
+_NODISCARD _Ret_notnull_ _Post_writable_byte_size_(size) _VCRT_ALLOCATOR
+_CRT_SECURITYCRITICAL_ATTRIBUTE
+void* __CRTDECL operator new(size_t const size)
+{
+    for (;;)
+    {
+        #if defined NTOS_KERNEL_RUNTIME
+        // Musa: Charged to the caller of operator new in the allocation
+        // telemetry (kext/kmemprof.h):
+        if (void* const block = __acrt_malloc_from(size, _ReturnAddress()))
+        #else
+        if (void* const block = malloc(size))
+        #endif
+        {
+            return block;
+        }
+
+        if (_callnewh(size) == 0)
+        {
+            if (size == SIZE_MAX)
+            {
+                __scrt_throw_std_bad_array_new_length();
+            }
+            else
+            {
+                __scrt_throw_std_bad_alloc();
+            }
+        }
+
+        // The new handler was successful; try to allocate again...
+    }
+}
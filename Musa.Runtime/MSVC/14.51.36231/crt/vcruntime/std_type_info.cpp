@@ -0,0 +1,275 @@
+//
+// std_type_info.cpp
+//
+//       Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Definitions of the std::type_info implementation functions, used for
+// Run-Time Type Information (RTTI).
+//
+#include <vcruntime_internal.h>
+#include <vcruntime_string.h>
+#include <vcruntime_typeinfo.h>
+#include <undname.h>
+
+
+
+
+
+extern "C" int __cdecl __std_type_info_compare(
+    _In_ __std_type_info_data const* const lhs,
+    _In_ __std_type_info_data const* const rhs
+    )
+{
+    if (lhs == rhs)
+    {
+        return 0;
+    }
+
+    return strcmp(lhs->_DecoratedName + 1, rhs->_DecoratedName + 1);
+}
+
+// Musa: type_info hash and name caches
+//
+// The layout of __std_type_info_data is fixed by the compiler, so the hash
+// cannot live inside it.  Instead each hash is memoized in a small open-
+// addressed table keyed by the address of the type's data:  std::type_index
+// lookups then cost one pointer hash and a probe or two instead of an FNV-1a
+// pass over a decorated name that is often hundreds of characters long for
+// template types.  Slots are claimed once with a compare-exchange on the key
+// and never reused; a slot whose hash has not been published yet reads as a
+// miss.  When the table is full, hashes are simply recomputed.
+//
+// Undecorated names are carved out of arena blocks instead of one _malloc_crt
+// node per name.  The blocks are linked into the module's __type_info_node
+// list, so __std_type_info_destroy_list frees them exactly as it used to free
+// the per-name nodes.
+namespace
+{
+    constexpr size_t TypeHashSlots  = 512; // power of two
+    constexpr size_t TypeHashProbes = 8;
+
+    struct TypeHashSlot
+    {
+        void const* volatile data;
+        ULONG_PTR   volatile hash;
+    };
+
+    TypeHashSlot type_hash_slots[TypeHashSlots];
+
+    size_t TypeHashSlotIndex(__std_type_info_data const* const data) noexcept
+    {
+        return static_cast<size_t>(
+            (reinterpret_cast<uintptr_t>(data) >> 3) * 0x9E3779B97F4A7C15ull >> 32) & (TypeHashSlots - 1);
+    }
+}
+
+static size_t __cdecl ComputeTypeInfoHash(
+    _In_ __std_type_info_data const* const data
+    ) noexcept
+{
+    // FNV-1a hash function for the undecorated name
+
+    #ifdef _WIN64
+    static_assert(sizeof(size_t) == 8, "This code is for 64-bit size_t.");
+    size_t const fnv_offset_basis = 14695981039346656037ULL;
+    size_t const fnv_prime        = 1099511628211ULL;
+    #else
+    static_assert(sizeof(size_t) == 4, "This code is for 32-bit size_t.");
+    size_t const fnv_offset_basis = 2166136261U;
+    size_t const fnv_prime        = 16777619U;
+    #endif
+
+    size_t value = fnv_offset_basis;
+    for (char const* it = data->_DecoratedName + 1; *it != '\0'; ++it)
+    {
+        value ^= static_cast<size_t>(static_cast<unsigned char>(*it));
+        value *= fnv_prime;
+    }
+
+    #ifdef _WIN64
+    static_assert(sizeof(size_t) == 8, "This code is for 64-bit size_t.");
+    value ^= value >> 32;
+    #else
+    static_assert(sizeof(size_t) == 4, "This code is for 32-bit size_t.");
+    #endif
+
+    return value;
+}
+
+extern "C" size_t __cdecl __std_type_info_hash(
+    _In_ __std_type_info_data const* const data
+    )
+{
+    size_t index = TypeHashSlotIndex(data);
+    for (size_t probe = 0; probe != TypeHashProbes; ++probe, index = (index + 1) & (TypeHashSlots - 1))
+    {
+        TypeHashSlot& slot = type_hash_slots[index];
+
+        void const* const owner = ReadPointerAcquire(const_cast<PVOID volatile*>(&slot.data));
+        if (owner == data)
+        {
+            size_t const cached_hash = ReadULongPtrAcquire(&slot.hash);
+            return cached_hash != 0 ? cached_hash : ComputeTypeInfoHash(data);
+        }
+
+        if (owner != nullptr)
+        {
+            continue;
+        }
+
+        size_t const hash = ComputeTypeInfoHash(data);
+
+        void const* const claimed = InterlockedCompareExchangePointer(
+            const_cast<PVOID volatile*>(&slot.data),
+            const_cast<__std_type_info_data*>(data),
+            nullptr);
+        if (claimed == nullptr)
+        {
+            WriteULongPtrRelease(&slot.hash, hash);
+            return hash;
+        }
+
+        if (claimed == data)
+        {
+            return hash;
+        }
+    }
+
+    return ComputeTypeInfoHash(data);
+}
+
+namespace
+{
+    constexpr size_t TypeNameBlockSize = 4096;
+
+    struct TypeNameBlock
+    {
+        SLIST_ENTRY     header;
+        size_t volatile used;
+        size_t          capacity;
+        // char         names[capacity];
+
+        char* names() noexcept { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    TypeNameBlock* volatile type_name_block = nullptr;
+}
+
+// Returns storage for 'count' characters that lives until the root node is
+// destroyed, or nullptr if the allocation fails.
+static char* __cdecl AllocateTypeName(
+    _Inout_ __type_info_node* const root_node,
+    _In_    size_t            const count
+    ) noexcept
+{
+    TypeNameBlock* const block = static_cast<TypeNameBlock*>(
+        ReadPointerAcquire(reinterpret_cast<PVOID volatile*>(&type_name_block)));
+    if (block != nullptr)
+    {
+        size_t const offset = static_cast<size_t>(InterlockedExchangeAddSizeT(&block->used, count));
+        if (offset + count <= block->capacity)
+        {
+            return block->names() + offset;
+        }
+    }
+
+    // The current block is exhausted (or there is none yet).  Names that
+    // would not fit comfortably in a shared block get a block of their own:
+    size_t const capacity = count > TypeNameBlockSize / 4
+        ? count
+        : TypeNameBlockSize - sizeof(TypeNameBlock);
+
+    TypeNameBlock* const new_block = static_cast<TypeNameBlock*>(_malloc_crt(sizeof(TypeNameBlock) + capacity));
+    if (!new_block)
+    {
+        return nullptr;
+    }
+
+    new_block->header   = SLIST_ENTRY{};
+    new_block->used     = count;
+    new_block->capacity = capacity;
+    InterlockedPushEntrySList(&root_node->_Header, &new_block->header);
+
+    // If another thread installed a fresh block first, ours stays linked into
+    // the list (and is freed with it) but is not used for further names:
+    if (capacity != count)
+    {
+        InterlockedCompareExchangePointer(
+            reinterpret_cast<PVOID volatile*>(&type_name_block), new_block, block);
+    }
+
+    return new_block->names();
+}
+
+extern "C" char const* __cdecl __std_type_info_name(
+    _Inout_ __std_type_info_data* const data,
+    _Inout_ __type_info_node*     const root_node
+    )
+{
+    // First check to see if we've already cached the undecorated name; if we
+    // have, we can just return it:
+    {
+        char const* const cached_undecorated_name = __crt_interlocked_read_pointer(&data->_UndecoratedName);
+        if (cached_undecorated_name)
+        {
+            return cached_undecorated_name;
+        }
+    }
+
+    __crt_unique_heap_ptr<char> undecorated_name(__unDName(
+        nullptr,
+        data->_DecoratedName + 1,
+        0,
+        [](size_t const n) { return _malloc_crt(n); },
+        [](void*  const p) { return _free_crt(p);   },
+        UNDNAME_32_BIT_DECODE | UNDNAME_TYPE_ONLY));
+
+    if (!undecorated_name)
+    {
+        return nullptr; // CRT_REFACTOR TODO This is nonconforming
+    }
+
+    size_t undecorated_name_length = strlen(undecorated_name.get());
+    while (undecorated_name_length != 0 && undecorated_name.get()[undecorated_name_length - 1] == ' ')
+    {
+        undecorated_name.get()[undecorated_name_length - 1] = '\0';
+        --undecorated_name_length;
+    }
+
+    size_t const undecorated_name_count = undecorated_name_length + 1;
+
+    char* const name_string = AllocateTypeName(root_node, undecorated_name_count);
+    if (!name_string)
+    {
+        return nullptr; // CRT_REFACTOR TODO This is nonconforming
+    }
+
+    memcpy(name_string, undecorated_name.get(), undecorated_name_count);
+
+    // If the cache already contained an undecorated name pointer, another
+    // thread must have cached it while we were computing the undecorated
+    // name.  Our copy stays in the arena until the module is unloaded:
+    char const* const cached_undecorated_name = __crt_interlocked_compare_exchange_pointer(
+        &data->_UndecoratedName,
+        name_string,
+        nullptr);
+
+    return cached_undecorated_name ? cached_undecorated_name : name_string;
+}
+
+// This function is called during module unload to clean up all of the undecorated
+// name strings that were allocated by calls to name().
+extern "C" void __cdecl __std_type_info_destroy_list(
+    __type_info_node* const root_node
+    )
+{
+    type_name_block = nullptr;
+
+    PSLIST_ENTRY current_node = InterlockedFlushSList(&root_node->_Header);
+    while (current_node)
+    {
+        PSLIST_ENTRY const next_node = current_node->Next;
+        _free_crt(current_node);
+        current_node = next_node;
+    }
+}
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 
 #include <Musa.Core.h>
+#include <corecrt_internal_startup_trace.h>
 
 
 #define __scrt_module_type_sys ((__scrt_module_type)3)
@@ -36,6 +37,11 @@ _ACRTIMP int __cdecl _seh_filter_sys(
     _In_ PEXCEPTION_POINTERS ExceptionPtr
 );
 
+// Musa: Deferred and parallel static initialization (kext/kinit.h):
+EXTERN_C void __cdecl __scrt_start_parallel_initializers();
+EXTERN_C void __cdecl __scrt_stop_parallel_initializers();
+EXTERN_C void __cdecl __scrt_uninitialize_parallel_initializers();
+
 
 #ifdef _MUSA_SCRT_BUILD_PGO_INITIALIZER
 
@@ -102,7 +108,9 @@ static __declspec(noinline) VOID NTAPI __scrt_common_exit(_In_ PDRIVER_OBJECT dr
         __scrt_drv_unload(driver_object);
     }
 
+    __scrt_stop_parallel_initializers();
     _cexit();
+    __scrt_uninitialize_parallel_initializers();
     __scrt_uninitialize_crt(true, true);
 
     (void)MusaCoreShutdown();
@@ -116,6 +124,13 @@ static __declspec(noinline) int __cdecl __scrt_common_main_seh(
     _In_     PDRIVER_INITIALIZE driver_main
     )
 {
+    // Musa: Everything up to DriverMain is recorded in the startup trace; see
+    // kext/kstartup.h.
+    __acrt_startup_trace_begin();
+
+    __acrt_startup_trace_mark mark;
+    __acrt_startup_trace_enter(&mark);
+
     DWORD TLSWithThreadNotifyCallback = 1;
     if (!RtlIsNullOrEmptyUnicodeString(registry_path)) {
         auto parameters_size = registry_path->Length + sizeof(L"\\Parameters") + sizeof(UNICODE_NULL);
@@ -140,35 +155,46 @@ static __declspec(noinline) int __cdecl __scrt_common_main_seh(
         }
     }
 
+    __acrt_startup_trace_leave(&mark, kstartup_phase_core, "Parameters", nullptr);
+
+    __acrt_startup_trace_enter(&mark);
     long status = MusaCoreStartup(driver_object, registry_path, TLSWithThreadNotifyCallback != 0);
+    __acrt_startup_trace_leave(&mark, kstartup_phase_core, "MusaCoreStartup", nullptr);
     if (!NT_SUCCESS(status)) {
         return status;
     }
 
+    __acrt_startup_trace_enter(&mark);
     _tls_index = TlsAlloc();
+    __acrt_startup_trace_leave(&mark, kstartup_phase_core, "TlsAlloc", nullptr);
     if (_tls_index == TLS_OUT_OF_INDEXES) {
         __scrt_fastfail(FAST_FAIL_FATAL_APP_EXIT);
     }
 
-    if (!__scrt_initialize_crt(__scrt_module_type_sys)) {
+    __acrt_startup_trace_enter(&mark);
+    bool const crt_initialized = __scrt_initialize_crt(__scrt_module_type_sys);
+    __acrt_startup_trace_leave(&mark, kstartup_phase_crt, "__scrt_initialize_crt", nullptr);
+    if (!crt_initialized) {
         __scrt_fastfail(FAST_FAIL_FATAL_APP_EXIT);
     }
 
     __try {
-        if (_initterm_e(__xi_a, __xi_z) != 0) {
+        if (__acrt_startup_trace_initterm_e(__xi_a, __xi_z, kstartup_phase_xi) != 0) {
             (void)MusaCoreShutdown();
 
             return STATUS_DRIVER_INTERNAL_ERROR;
         }
 
-        _initterm(__xc_a, __xc_z);
+        __acrt_startup_trace_initterm(__xc_a, __xc_z, kstartup_phase_xc);
 
         // If this module has any dynamically initialized __declspec(thread)
         // variables, then we invoke their initialization for the primary thread
         // used to start the process:
         _tls_callback_type const* const tls_init_callback = __scrt_get_dyn_tls_init_callback();
         if (*tls_init_callback != nullptr && __scrt_is_nonwritable_in_current_image(tls_init_callback)) {
+            __acrt_startup_trace_enter(&mark);
             (*tls_init_callback)(nullptr, DLL_THREAD_ATTACH, nullptr);
+            __acrt_startup_trace_leave(&mark, kstartup_phase_tls, nullptr, reinterpret_cast<void const*>(*tls_init_callback));
         }
 
         // If this module has any thread-local destructors, register the
@@ -182,6 +208,9 @@ static __declspec(noinline) int __cdecl __scrt_common_main_seh(
         // Initialization is complete; invoke main...
         //
 
+        __acrt_startup_trace_end();
+        __scrt_start_parallel_initializers();
+
         auto const main_result = driver_main(driver_object, registry_path);
         if (NT_SUCCESS(main_result)) {
             if (driver_object) {
@@ -190,7 +219,9 @@ static __declspec(noinline) int __cdecl __scrt_common_main_seh(
             }
         }
         else {
+            __scrt_stop_parallel_initializers();
             _cexit();
+            __scrt_uninitialize_parallel_initializers();
 
             // We terminate the CRT:
             __scrt_uninitialize_crt(true, false);
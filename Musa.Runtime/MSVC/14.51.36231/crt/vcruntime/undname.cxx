@@ -56,6 +56,7 @@
 #endif
 
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 
 #ifndef _countof
@@ -67,6 +68,7 @@
 #include <Windows.h>
 #pragma warning(pop)
 #include "utf8.h"
+#include "kext/kundname.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -117,6 +119,13 @@ private:
 	Block *			tail;
 	size_t blockLeft;
 
+	// Musa: caller-provided scratch arena (see useArena)
+	char *			arenaCursor;
+	size_t			arenaLeft;
+	bool			arenaExhausted;
+
+	void *getMemoryFromArena(size_t sz);
+
 public:
 	_HeapManager(Alloc_t pAlloc, Free_t pFree)
 	{
@@ -125,8 +134,28 @@ public:
 		blockLeft = 0;
 		head = 0;
 		tail = 0;
+		arenaCursor = nullptr;
+		arenaLeft = 0;
+		arenaExhausted = false;
+	}
+
+	// Musa: Serve every allocation, including the result string, from
+	// [arena, arena + size).  Nothing is freed individually and nothing falls
+	// back to the heap:  running out of arena fails the undecoration.
+	void useArena(void *arena, size_t size)
+	{
+		size_t const skew = (PACK_SIZE - reinterpret_cast<uintptr_t>(arena) % PACK_SIZE) % PACK_SIZE;
+
+		pOpNew = nullptr;
+		pOpDelete = nullptr;
+		arenaCursor = static_cast<char *>(arena) + skew;
+		arenaLeft = size > skew ? size - skew : 0;
 	}
 
+	// The undecorator degrades gracefully when an allocation fails, so
+	// running out of arena has to be checked for explicitly.
+	bool arenaFailed() const { return arenaExhausted; }
+
 	// Avoid unintentional copy
 	
 	_HeapManager(const _HeapManager&) = delete;
@@ -866,6 +895,86 @@ pchar_t __UNDNAME_IMP __cdecl __UNDNAME_NAME_EX(
 
 }	// End of FUNCTION "unDName"
 
+
+
+// Musa: Arena-backed undecoration.
+//
+// Unlike __unDName, these never touch the pool and never take the global
+// undname lock:  each call builds its own UnDecorator whose working storage
+// comes from the caller's scratch arena, so any number of threads may
+// undecorate at once, each with its own arena.  See kext/kundname.h.
+
+extern "C" pchar_t __cdecl kundname(
+	_Out_writes_z_(maxStringLength) pchar_t outputString,
+	pcchar_t name,
+	int maxStringLength,
+	void * arena,
+	size_t arenaSize,
+	unsigned long disableFlags
+)
+{
+	if (!outputString || maxStringLength <= 0 || !name || !arena)
+		return nullptr;
+
+	UnDecorator unDecorate(name, nullptr, disableFlags, nullptr, nullptr);
+	unDecorate.getHeap().useArena(arena, arenaSize);
+
+	pchar_t const unDecoratedName = unDecorate.getUndecoratedName(outputString, maxStringLength);
+	if (unDecorate.getHeap().arenaFailed())
+		return nullptr;
+
+	return unDecoratedName;
+}
+
+
+
+extern "C" size_t __cdecl kundname_batch(
+	pcchar_t const * names,
+	pcchar_t * results,
+	size_t count,
+	_Out_writes_(outputSize) pchar_t output,
+	size_t outputSize,
+	void * arena,
+	size_t arenaSize,
+	unsigned long disableFlags
+)
+{
+	if (!names || !results || !output || !arena)
+		return 0;
+
+	size_t undecorated = 0;
+	for (size_t i = 0; i != count; ++i)
+	{
+		results[i] = nullptr;
+
+		int const room = outputSize > INT_MAX ? INT_MAX : static_cast<int>(outputSize);
+		if (room <= 1)
+			continue;
+
+		// Every name reuses the whole arena; its contents are dead once the
+		// previous result has been copied out.
+		pchar_t const result = kundname(output, names[i], room, arena, arenaSize, disableFlags);
+		if (!result)
+			continue;
+
+		// A result that fills all of the remaining output may have been
+		// truncated; treat the output as full from here on.
+		size_t const used = und_strlen(result) + 1;
+		if (used >= static_cast<size_t>(room))
+		{
+			outputSize = 0;
+			continue;
+		}
+
+		results[i] = result;
+		output += used;
+		outputSize -= used;
+		++undecorated;
+	}
+
+	return undecorated;
+}
+
 //	The 'UnDecorator' member functions
 
 inline UnDecorator::UnDecorator(
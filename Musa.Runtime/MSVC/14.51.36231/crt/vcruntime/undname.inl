@@ -162,11 +162,32 @@ inline void* operator new (size_t sz, _HeapManager& heap, int noBuffer)
         return heap.getMemoryWithBuffer(sz);
 }
 
+void* _HeapManager::getMemoryFromArena(size_t sz)
+{
+    // Musa: both sz and the cursor are PACK_SIZE aligned (see useArena).
+    if (sz == 0)
+        sz = PACK_SIZE;
+
+    if (arenaLeft < sz)
+    {
+        arenaExhausted = true;
+        return nullptr;
+    }
+
+    void* const memory = arenaCursor;
+    arenaCursor += sz;
+    arenaLeft   -= sz;
+    return memory;
+}
+
 void* _HeapManager::getMemoryWithoutBuffer(size_t sz)
 {
     // Align the allocation on an appropriate boundary
     sz = ((sz + PACK_SIZE - 1) & ~(PACK_SIZE - 1));
 
+    if (arenaCursor)
+        return getMemoryFromArena(sz);
+
     return (*pOpNew)(sz);
 }
 
@@ -180,6 +201,9 @@ void* _HeapManager::getMemoryWithBuffer(size_t sz)
     if (0 >= sz)
         sz = PACK_SIZE;
 
+    if (arenaCursor)
+        return getMemoryFromArena(sz);
+
     if (blockLeft < sz) {
         // Is the request greater than the largest buffer size ?
         if (sz > memBlockSize)
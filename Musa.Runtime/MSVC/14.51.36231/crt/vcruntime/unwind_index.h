@@ -0,0 +1,22 @@
+//
+// unwind_index.h
+//
+// Musa: Internal interface to the function table index of the image the
+// runtime is linked into.  See unwind_index.cpp.
+//
+#pragma once
+#include <vcruntime_internal.h>
+#include "kext/kunwind.h"
+
+extern "C" {
+
+// Builds the index.  Failure is not fatal:  lookups then fall back to the
+// kernel's own RtlLookupFunctionEntry and RtlPcToFileHeader.
+bool __cdecl __vcrt_initialize_unwind_index();
+void __cdecl __vcrt_uninitialize_unwind_index();
+
+// RtlPcToFileHeader, answered without a trip through the loaded module list
+// when the address lies in this image.
+PVOID __cdecl __vcrt_pc_to_file_header(_In_ PVOID pc, _Out_ PVOID* image_base);
+
+}
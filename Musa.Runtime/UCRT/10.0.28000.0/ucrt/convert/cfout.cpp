@@ -0,0 +1,440 @@
+//
+// cfout.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Floating point binary to decimal conversion routines
+//
+// Musa: The digits are generated with the Ryu-printf tables that the STL
+// already carries for std::to_chars (xcharconv_ryu_tables.cpp) instead of
+// the Burger-Dybvig big integer algorithm.  Each 64-bit multiplier triple
+// yields nine digits with three 64x64 multiplications, so the work is bounded
+// by the number of digits requested rather than by the magnitude of the value,
+// and no floating point operations are performed (the floating point state no
+// longer needs to be saved and restored around the conversion).  The output
+// (decimal exponent, truncated digits and trailing digit flag) is the same.
+//
+#include <corecrt_internal_fltintrn.h>
+#include <string.h>
+
+
+
+using namespace __crt_strtox;
+
+// Defined in the STL's xcharconv_ryu_tables.cpp, which is compiled into the
+// same library.  <xcharconv_ryu_tables.h> requires C++17, so the declarations
+// are repeated here.
+namespace std
+{
+    extern uint64_t const __POW10_SPLIT[1224][3];
+    extern uint64_t const __POW10_SPLIT_2[3133][3];
+}
+
+namespace
+{
+    // From Ryu's d2fixed_full_table.h; the same values as __POW10_OFFSET,
+    // __POW10_OFFSET_2 and __MIN_BLOCK_2 in <xcharconv_ryu_tables.h>.
+    constexpr uint16_t pow10_offset[64] =
+    {
+           0,    2,    5,    8,   12,   16,   21,   26,   32,   39,
+          46,   54,   62,   71,   80,   90,  100,  111,  122,  134,
+         146,  159,  173,  187,  202,  217,  233,  249,  266,  283,
+         301,  319,  338,  357,  377,  397,  418,  440,  462,  485,
+         508,  532,  556,  581,  606,  632,  658,  685,  712,  740,
+         769,  798,  828,  858,  889,  920,  952,  984, 1017, 1050,
+        1084, 1118, 1153, 1188
+    };
+
+    constexpr uint16_t pow10_offset_2[69] =
+    {
+           0,    2,    6,   12,   20,   29,   40,   52,   66,   80,
+          95,  112,  130,  150,  170,  192,  215,  240,  265,  292,
+         320,  350,  381,  413,  446,  480,  516,  552,  590,  629,
+         670,  712,  755,  799,  845,  892,  940,  989, 1040, 1092,
+        1145, 1199, 1254, 1311, 1369, 1428, 1488, 1550, 1613, 1678,
+        1743, 1810, 1878, 1947, 2017, 2088, 2161, 2235, 2311, 2387,
+        2465, 2544, 2625, 2706, 2789, 2873, 2959, 3046, 3133
+    };
+
+    constexpr uint8_t min_block_2[69] =
+    {
+         0,  0,  0,  0,  0,  0,  1,  1,  2,  3,
+         3,  4,  4,  5,  5,  6,  6,  7,  7,  8,
+         8,  9,  9, 10, 11, 11, 12, 12, 13, 13,
+        14, 14, 15, 15, 16, 16, 17, 17, 18, 19,
+        19, 20, 20, 21, 21, 22, 22, 23, 23, 24,
+        24, 25, 26, 26, 27, 27, 28, 28, 29, 29,
+        30, 30, 31, 31, 32, 32, 33, 34,  0
+    };
+
+    // Both tables are scaled by 2^120 beyond their index's power of two.
+    constexpr int32_t pow10_additional_bits = 120;
+
+    __forceinline uint64_t multiply_128(uint64_t const a, uint64_t const b, uint64_t& high) throw()
+    {
+    #if defined _M_X64
+        return _umul128(a, b, &high);
+    #else
+        high = __umulh(a, b);
+        return a * b;
+    #endif
+    }
+
+    // Returns floor(m * mul / 2^j) mod 10^9, where mul is a 192-bit multiplier
+    // (least significant word first) and j is in [128, 180].
+    __forceinline uint32_t multiply_shift_mod_1e9(uint64_t const m, uint64_t const* const mul, int32_t const j) throw()
+    {
+        uint64_t high0;
+        uint64_t high1;
+        uint64_t high2;
+        (void)multiply_128(m, mul[0], high0);
+        uint64_t const low1 = multiply_128(m, mul[1], high1);
+        uint64_t const low2 = multiply_128(m, mul[2], high2);
+
+        uint64_t const s0_high = low1 + high0;
+        uint32_t const c1      = s0_high < low1;
+        uint64_t const s1_low  = low2 + high1 + c1;
+        uint32_t const c2      = s1_low < low2;
+        uint64_t const s1_high = high2 + c2;
+
+        _ASSERTE(j >= 128 && j <= 180);
+        if (j < 160)
+        {
+            uint64_t const r0 = s1_high % 1000000000;
+            uint64_t const r1 = ((r0 << 32) | (s1_low >> 32)) % 1000000000;
+            uint64_t const r2 = (r1 << 32) | (s1_low & 0xffffffff);
+            return static_cast<uint32_t>((r2 >> (j - 128)) % 1000000000);
+        }
+        else
+        {
+            uint64_t const r0 = s1_high % 1000000000;
+            uint64_t const r1 = (r0 << 32) | (s1_low >> 32);
+            return static_cast<uint32_t>((r1 >> (j - 160)) % 1000000000);
+        }
+    }
+
+    __forceinline uint32_t decimal_length_9(uint32_t const v) throw()
+    {
+        _ASSERTE(v < 1000000000);
+        if (v >= 100000000) { return 9; }
+        if (v >= 10000000)  { return 8; }
+        if (v >= 1000000)   { return 7; }
+        if (v >= 100000)    { return 6; }
+        if (v >= 10000)     { return 5; }
+        if (v >= 1000)      { return 4; }
+        if (v >= 100)       { return 3; }
+        if (v >= 10)        { return 2; }
+        return 1;
+    }
+
+    // Returns true if m * 2^e, for e < 0, has a nonzero digit more than
+    // 'position' places after the decimal point.  The value times 10^position
+    // is m * 5^position * 2^(e + position), and 5^position is odd.
+    __forceinline bool has_fraction_digits_beyond(uint64_t const m, int32_t const e, uint32_t const position) throw()
+    {
+        if (e >= 0 || position >= static_cast<uint32_t>(-e))
+        {
+            return false;
+        }
+
+        unsigned long trailing_zero_bits;
+        _BitScanForward64(&trailing_zero_bits, m);
+        return trailing_zero_bits < static_cast<uint32_t>(-e) - position;
+    }
+
+    // Collects the generated digits into the mantissa buffer.  Digits are
+    // appended in blocks; those that do not fit are only examined, to tell
+    // whether the truncated result has trailing nonzero digits.
+    class mantissa_writer
+    {
+    public:
+
+        mantissa_writer(char* const first) throw()
+            : _first(first), _it(first), _last(nullptr), _trailing(false)
+        {
+        }
+
+        bool started()  const throw() { return _last != nullptr; }
+        bool full()     const throw() { return _it == _last; }
+        bool trailing() const throw() { return _trailing; }
+        void set_trailing() throw()   { _trailing = true; }
+
+        void start(char* const last) throw()
+        {
+            _last = last;
+        }
+
+        // Appends the 'width' low order decimal digits of 'block', most
+        // significant first.
+        void append(uint32_t block, uint32_t const width) throw()
+        {
+            uint32_t const room = static_cast<uint32_t>(_last - _it);
+            uint32_t const kept = width < room ? width : room;
+
+            for (uint32_t i = kept; i != width; ++i)
+            {
+                if (block % 10 != 0)
+                {
+                    _trailing = true;
+                }
+
+                block /= 10;
+            }
+
+            for (uint32_t i = kept; i != 0; --i)
+            {
+                _it[i - 1] = static_cast<char>('0' + block % 10);
+                block /= 10;
+            }
+
+            _it += kept;
+        }
+
+        // Drops trailing zeroes (the first digit is never zero) and terminates
+        // the string.
+        void finish() throw()
+        {
+            while (_it != _first && _it[-1] == '0')
+            {
+                --_it;
+            }
+
+            *_it = '\0';
+        }
+
+    private:
+
+        char* const _first;
+        char*       _it;
+        char*       _last;
+        bool        _trailing;
+    };
+}
+
+
+
+// This function converts a finite, positive, nonzero double into its decimal
+// representation.  The decimal mantissa and exponent are returned via the out
+// parameters, such that the value is 0.mmmm * 10^exponent, and the return
+// value affirms if there were nonzero digits beyond those written.  The digits
+// are truncated, not rounded; rounding is done by the caller.
+//
+// The mantissa is of the form m * 2^e.  Its integer part is generated from the
+// most significant 9-digit block down, and its fractional part from the most
+// significant block after the decimal point on, where block i is
+// floor(m * 2^e * 10^(9 * (i + 1))) mod 10^9.  Both are computed with one
+// multiply-shift against a precomputed multiplier (Ryu-printf; U. Adams,
+// "Ryu Revisited: Printf Floating Point Conversion", OOPSLA 2019).
+//
+// Digit generation stops when the first of the following conditions is true:
+// [1] the mantissa buffer is exhausted, [2] sufficient digits have been
+// generated for a %f specifier with the requested precision, or [3] all
+// remaining digits are known to be zero.
+__forceinline static __acrt_has_trailing_digits __cdecl convert_to_fos_high_precision(
+    double                 const value,
+    uint32_t               const precision,
+    __acrt_precision_style const precision_style,
+    int*                   const exponent,
+    char*                  const mantissa_buffer,
+    size_t                 const mantissa_buffer_count
+    ) throw()
+{
+    using floating_traits = __acrt_floating_type_traits<double>;
+    using components_type = floating_traits::components_type;
+
+    _ASSERTE(mantissa_buffer_count > 0);
+
+    components_type const& value_components = reinterpret_cast<components_type const&>(value);
+
+    // Denormal values have no implicit high order bit and the exponent of the
+    // smallest normal value.
+    bool const is_denormal = value_components._exponent == 0;
+
+    uint64_t const m = is_denormal
+        ? value_components._mantissa
+        : value_components._mantissa | (static_cast<uint64_t>(1) << (floating_traits::mantissa_bits - 1));
+
+    int32_t const e = (is_denormal ? 1 : static_cast<int32_t>(value_components._exponent)) -
+        floating_traits::exponent_bias -
+        (floating_traits::mantissa_bits - 1);
+
+    mantissa_writer writer(mantissa_buffer);
+    int32_t k = 0;
+
+    // The number of digits that are needed depends on k, which is known once
+    // the first nonzero block has been found.  convert_to_fos_high_precision()
+    // generates digits assuming we're formatting with %f; when %e is the format
+    // specifier, adding the exponent to the number of required digits is not
+    // needed.
+    auto const start = [&](int32_t const decimal_exponent)
+    {
+        k = decimal_exponent;
+
+        uint32_t const required_digits = k >= 0 && precision <= INT_MAX && precision_style == __acrt_precision_style::fixed
+            ? k + precision
+            : precision;
+
+        writer.start(mantissa_buffer + __min(mantissa_buffer_count - 1, required_digits));
+    };
+
+    // Integer part.  (m < 2^53, so there is none if e < -52.)
+    if (e >= -52)
+    {
+        uint32_t const index       = e < 0 ? 0 : (static_cast<uint32_t>(e) + 15) / 16;
+        int32_t  const shift       = static_cast<int32_t>(16 * index) + pow10_additional_bits - e;
+        uint32_t const log10_pow2  = (16 * index * 78913) >> 18;
+        uint32_t const block_count = (log10_pow2 + 1 + 16 + 8) / 9;
+
+        for (uint32_t i = block_count; i != 0; --i)
+        {
+            if (writer.full() && writer.trailing())
+            {
+                break;
+            }
+
+            uint32_t const block = multiply_shift_mod_1e9(
+                m << 8,
+                std::__POW10_SPLIT[pow10_offset[index] + i - 1],
+                shift + 8);
+
+            if (!writer.started())
+            {
+                if (block == 0)
+                {
+                    continue;
+                }
+
+                uint32_t const width = decimal_length_9(block);
+                start(static_cast<int32_t>(width + 9 * (i - 1)));
+                writer.append(block, width);
+            }
+            else if (writer.full())
+            {
+                if (block != 0)
+                {
+                    writer.set_trailing();
+                }
+            }
+            else
+            {
+                writer.append(block, 9);
+            }
+        }
+    }
+
+    // Fractional part.
+    if (writer.full())
+    {
+        if (!writer.trailing() && has_fraction_digits_beyond(m, e, 0))
+        {
+            writer.set_trailing();
+        }
+    }
+    else if (e < 0)
+    {
+        uint32_t const index = static_cast<uint32_t>(-e) / 16;
+        int32_t  const shift = pow10_additional_bits + (-e - static_cast<int32_t>(16 * index));
+
+        // The blocks before min_block_2[index] are zero.  Since the value has
+        // an integer part only if e >= -52, where there are none, they only
+        // ever add to the leading zeroes.
+        _ASSERTE(!writer.started() || min_block_2[index] == 0);
+
+        for (uint32_t i = min_block_2[index]; ; ++i)
+        {
+            uint32_t const p = pow10_offset_2[index] + i - min_block_2[index];
+            if (p >= pow10_offset_2[index + 1])
+            {
+                break; // All remaining digits are zero
+            }
+
+            uint32_t const block = multiply_shift_mod_1e9(m << 8, std::__POW10_SPLIT_2[p], shift + 8);
+
+            if (!writer.started())
+            {
+                if (block == 0)
+                {
+                    continue;
+                }
+
+                uint32_t const width = decimal_length_9(block);
+                start(-static_cast<int32_t>(9 * i + 9 - width));
+                writer.append(block, width);
+            }
+            else
+            {
+                writer.append(block, 9);
+            }
+
+            if (writer.full())
+            {
+                if (!writer.trailing() && has_fraction_digits_beyond(m, e, 9 * (i + 1)))
+                {
+                    writer.set_trailing();
+                }
+
+                break;
+            }
+        }
+    }
+
+    _ASSERTE(writer.started());
+
+    writer.finish();
+    *exponent = k;
+
+    return writer.trailing()
+        ? __acrt_has_trailing_digits::trailing
+        : __acrt_has_trailing_digits::no_trailing;
+}
+
+extern "C" __acrt_has_trailing_digits __cdecl __acrt_fltout(
+    _CRT_DOUBLE                  value,
+    unsigned               const precision,
+    __acrt_precision_style const precision_style,
+    STRFLT                 const flt,
+    char*                  const result,
+    size_t                 const result_count
+    )
+{
+    using floating_traits = __acrt_floating_type_traits<double>;
+    using components_type = floating_traits::components_type;
+
+    components_type& components = reinterpret_cast<components_type&>(value);
+
+    flt->sign     = components._sign == 1 ? '-' : ' ';
+    flt->mantissa = result;
+
+    unsigned int float_control;
+    _controlfp_s(&float_control, 0, 0);
+    bool const value_is_zero = components._exponent == 0 && (components._mantissa == 0 || float_control & _DN_FLUSH);
+    if (value_is_zero)
+    {
+        flt->decpt = 0;
+        _ERRCHECK(strcpy_s(result, result_count, "0"));
+        return __acrt_has_trailing_digits::no_trailing;
+    }
+
+    // Handle special cases:
+    __acrt_fp_class const classification = __acrt_fp_classify(value.x);
+    if (classification != __acrt_fp_class::finite)
+    {
+        flt->decpt = 1;
+    }
+
+    switch (classification)
+    {
+    case __acrt_fp_class::infinity:      _ERRCHECK(strcpy_s(result, result_count, "1#INF" )); return __acrt_has_trailing_digits::trailing;
+    case __acrt_fp_class::quiet_nan:     _ERRCHECK(strcpy_s(result, result_count, "1#QNAN")); return __acrt_has_trailing_digits::no_trailing;
+    case __acrt_fp_class::signaling_nan: _ERRCHECK(strcpy_s(result, result_count, "1#SNAN")); return __acrt_has_trailing_digits::no_trailing;
+    case __acrt_fp_class::indeterminate: _ERRCHECK(strcpy_s(result, result_count, "1#IND" )); return __acrt_has_trailing_digits::no_trailing;
+    }
+
+    // Make the number positive before we pass it to the digit generator:
+    components._sign = 0;
+
+    // The digit generator produces a truncated sequence of digits.  To allow
+    // our caller to correctly round the mantissa, we need to generate an extra
+    // digit.
+    return convert_to_fos_high_precision(value.x, precision + 1, precision_style, &flt->decpt, result, result_count);
+}
@@ -152,16 +152,20 @@ static char* __cdecl _fcvt_internal(
         return nullptr;
     }
 
-    char result_string[_CVTBUFSIZE + 1];
+    // Musa: Only the exponent (strflt.decpt) is consumed here, so the value is
+    // converted with precision 0, which generates a single digit; the buffer
+    // only needs to hold that digit or the inf, nan, or ind string.
+    size_t const restricted_count = 7; // "1#SNAN" + 1 null terminator
+    char result_string[restricted_count];
 
     _strflt strflt{};
     __acrt_fltout(
         reinterpret_cast<_CRT_DOUBLE const&>(value),
-        _countof(result_string),
-        __acrt_precision_style::fixed,
+        0,
+        __acrt_precision_style::scientific,
         &strflt,
         result_string,
-        _countof(result_string));
+        restricted_count);
 
     // Make sure we don't overflow the buffer.  If the user asks for more digits
     // than the buffer can handle, truncate it to the maximum size allowed in
@@ -0,0 +1,86 @@
+//
+// calloc_base.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Implementation of _calloc_base().  This is defined in a different source file
+// from the calloc() function to allow calloc() to be replaced by the user.
+//
+#include <corecrt_internal.h>
+#include <malloc.h>
+#include <new.h>
+#if defined NTOS_KERNEL_RUNTIME
+#include <corecrt_internal_startup_trace.h>
+#include <corecrt_internal_heap_profile.h>
+#endif
+
+// This function implements the logic of calloc().
+//
+// This function must be marked noinline, otherwise calloc and
+// _calloc_base will have identical COMDATs, and the linker will fold
+// them when calling one from the CRT. This is necessary because calloc
+// needs to support users patching in custom implementations.
+#if defined NTOS_KERNEL_RUNTIME
+//
+// Musa: The logic lives in __acrt_calloc_from, which reports caller as the call
+// site in the allocation telemetry (kext/kmemprof.h).  calloc calls it with its
+// own caller.
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl _calloc_base(
+    size_t const count,
+    size_t const size
+    )
+{
+    return __acrt_calloc_from(count, size, _ReturnAddress());
+}
+
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_calloc_from(
+    size_t      const count,
+    size_t      const size,
+    void const* const caller
+    )
+#else
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl _calloc_base(
+    size_t const count,
+    size_t const size
+    )
+#endif
+{
+    // Ensure that (count * size) does not overflow
+    _VALIDATE_RETURN_NOEXC(count == 0 || (_HEAP_MAXREQ / count) >= size, ENOMEM, nullptr);
+
+    // Ensure that we allocate a nonzero block size:
+    size_t const requested_block_size = count * size;
+    size_t const actual_block_size = requested_block_size == 0
+        ? 1
+        : requested_block_size;
+
+    for (;;)
+    {
+        void* const block = HeapAlloc(__acrt_heap, HEAP_ZERO_MEMORY, actual_block_size);
+
+        // If allocation succeeded, return the pointer to the new block:
+        if (block)
+        {
+            #if defined NTOS_KERNEL_RUNTIME
+            // Musa: Counted in the startup trace (kext/kstartup.h):
+            if (__acrt_startup_trace_armed)
+                __acrt_startup_trace_allocation(actual_block_size);
+
+            // Musa: Counted in the allocation telemetry (kext/kmemprof.h):
+            if (__acrt_heap_profile_armed)
+                __acrt_heap_profile_allocation(block, actual_block_size, KMEMPROF_TAG_CRT_HEAP, caller);
+            #endif
+            return block;
+        }
+
+        // Otherwise, see if we need to call the new handler, and if so call it.
+        // If the new handler fails, just return nullptr:
+        if (_query_new_mode() == 0 || !_callnewh(actual_block_size))
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        // The new handler was successful; try to allocate aagain...
+    }
+}
@@ -0,0 +1,602 @@
+//
+// heap_profile.cpp
+//
+// Musa: Allocation telemetry.  See kext/kmemprof.h.
+//
+// All tables live in one NonPagedPoolNx block allocated by the first
+// kmemprof_enable and freed when the AppCRT is uninitialized, so the hooks in
+// the allocators never see them go away while the driver runs.  Buckets and
+// live blocks are open-addressed tables claimed with compare-exchange; a key
+// that finds no slot within ProbeLimit probes goes to the overflow bucket (0)
+// or is not tracked.  Counters are per processor and are only summed by
+// kmemprof_query.
+//
+#include <corecrt_internal.h>
+#include <corecrt_internal_heap_profile.h>
+
+
+
+namespace
+{
+    constexpr ULONG HeapProfileTag   = 'PsuM';
+    constexpr ULONG ProbeLimit       = 32;
+    constexpr ULONG SizeClassCount   = 24;   // 16 bytes, 32 bytes, ... 64 MiB, then everything larger
+    constexpr ULONG MaximumCounterSets = 64; // processors beyond this share counters
+    constexpr ULONG CallSiteSearchFrames = 8;  // frames searched for the default call site
+    constexpr ULONG MaximumCallSiteSkip  = 16;
+
+    enum : long
+    {
+        BucketEmpty = 0,
+        BucketClaimed,
+        BucketReady,
+    };
+
+    struct HeapProfileBucket
+    {
+        void const*        call_site;
+        unsigned long      tag;
+        unsigned long      size_class;
+        long volatile      state;
+        long long volatile peak_live_bytes;
+    };
+
+    struct HeapProfileCounters // one per (processor, bucket)
+    {
+        long long volatile allocations;
+        long long volatile frees;
+        long long volatile allocated_bytes;
+        long long volatile freed_bytes;
+    };
+
+    struct alignas(SYSTEM_CACHE_ALIGNMENT_SIZE) HeapProfileProcessor
+    {
+        long volatile      sample_countdown;
+        long long volatile untracked_allocations;
+        long long volatile untracked_frees;
+    };
+
+    struct HeapProfileLiveBlock
+    {
+        void const* volatile block;     // nullptr if never used, TombstoneBlock once freed
+        unsigned long        bucket;
+        size_t               size;
+        unsigned long long   sample;    // sequence of the sample taken for the block, 0 if none
+    };
+
+    struct HeapProfileSample
+    {
+        unsigned long long volatile sequence; // 0 while being written
+        kmemprof_sample             sample;
+    };
+
+    struct HeapProfile
+    {
+        kmemprof_options      options;        // buckets and live_blocks are powers of two
+        ULONG                 counter_sets;
+        LARGE_INTEGER         frequency;
+        LARGE_INTEGER         start;
+        HeapProfileBucket*    buckets;        // [1 + options.buckets]; [0] is the overflow bucket
+        HeapProfileCounters*  counters;       // [counter_sets][1 + options.buckets]
+        HeapProfileProcessor* processors;     // [counter_sets]
+        HeapProfileLiveBlock* live;           // [options.live_blocks]
+        HeapProfileSample*    samples;        // [options.samples]
+        long long volatile    next_sample;
+    };
+
+    void const* const TombstoneBlock = reinterpret_cast<void const*>(~static_cast<uintptr_t>(0));
+}
+
+extern "C" long volatile __acrt_heap_profile_armed = 0;
+
+static void* volatile heap_profile      = nullptr; // HeapProfile*
+static long volatile  heap_profile_busy = 0;
+
+static HeapProfile* __cdecl active_heap_profile() noexcept
+{
+    return static_cast<HeapProfile*>(ReadPointerAcquire(&heap_profile));
+}
+
+
+
+static unsigned long long __cdecl mix(unsigned long long x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static unsigned long __cdecl size_class_of(size_t const size) noexcept
+{
+    if (size <= 16)
+        return 0;
+
+    unsigned long bit;
+    _BitScanReverse64(&bit, static_cast<unsigned long long>(size - 1));
+
+    unsigned long const size_class = bit + 1 - 4;
+    return size_class < SizeClassCount ? size_class : SizeClassCount - 1;
+}
+
+static unsigned long long __cdecl size_class_limit(unsigned long const size_class) noexcept
+{
+    return size_class == SizeClassCount - 1 ? ~0ull : 16ull << size_class;
+}
+
+static HeapProfileCounters* __cdecl current_counters(HeapProfile* const profile, unsigned long const bucket) noexcept
+{
+    ULONG const processor = KeGetCurrentProcessorNumberEx(nullptr) % profile->counter_sets;
+    return &profile->counters[static_cast<size_t>(processor) * (1 + profile->options.buckets) + bucket];
+}
+
+static HeapProfileProcessor* __cdecl current_processor(HeapProfile* const profile) noexcept
+{
+    return &profile->processors[KeGetCurrentProcessorNumberEx(nullptr) % profile->counter_sets];
+}
+
+
+
+static unsigned long __cdecl find_bucket(
+    HeapProfile*  const profile,
+    unsigned long const tag,
+    unsigned long const size_class,
+    void const*   const call_site
+    ) noexcept
+{
+    unsigned long long const hash = mix(
+        reinterpret_cast<uintptr_t>(call_site) ^ (static_cast<unsigned long long>(tag) << 8) ^ size_class);
+
+    unsigned long const mask = profile->options.buckets - 1;
+    for (ULONG probe = 0; probe != ProbeLimit; ++probe)
+    {
+        unsigned long const index  = 1 + static_cast<unsigned long>((hash + probe) & mask);
+        HeapProfileBucket&  bucket = profile->buckets[index];
+
+        long state = ReadAcquire(&bucket.state);
+        if (state == BucketEmpty)
+        {
+            state = InterlockedCompareExchange(&bucket.state, BucketClaimed, BucketEmpty);
+            if (state == BucketEmpty)
+            {
+                bucket.call_site  = call_site;
+                bucket.tag        = tag;
+                bucket.size_class = size_class;
+                WriteRelease(&bucket.state, BucketReady);
+                return index;
+            }
+        }
+
+        while (state == BucketClaimed)
+        {
+            YieldProcessor();
+            state = ReadAcquire(&bucket.state);
+        }
+
+        if (bucket.call_site == call_site && bucket.tag == tag && bucket.size_class == size_class)
+            return index;
+    }
+
+    return 0;
+}
+
+// The return address skip frames above caller on the current stack.  caller is
+// looked for among the innermost frames, which belong to the allocator; if it
+// is not there, or the stack is not that deep, caller itself is the call site.
+static __declspec(noinline) void const* __cdecl call_site_above(
+    void const*   const caller,
+    unsigned long const skip
+    ) noexcept
+{
+    void* frames[CallSiteSearchFrames + MaximumCallSiteSkip];
+    USHORT const count = RtlCaptureStackBackTrace(1, CallSiteSearchFrames + skip, frames, nullptr);
+    for (USHORT i = 0; i != count && i != CallSiteSearchFrames; ++i)
+    {
+        if (frames[i] == caller)
+            return i + skip < count ? frames[i + skip] : caller;
+    }
+
+    return caller;
+}
+
+static __declspec(noinline) unsigned long long __cdecl take_sample(
+    HeapProfile*  const profile,
+    void const*   const block,
+    size_t        const size,
+    unsigned long const tag
+    ) noexcept
+{
+    unsigned long long const sequence = static_cast<unsigned long long>(InterlockedIncrement64(&profile->next_sample));
+    HeapProfileSample& slot = profile->samples[(sequence - 1) % profile->options.samples];
+
+    WriteNoFence64(reinterpret_cast<long long volatile*>(&slot.sequence), 0);
+
+    slot.sample.sequence = sequence;
+    slot.sample.tag      = tag;
+    slot.sample.size     = size;
+    slot.sample.block    = block;
+    slot.sample.live     = true;
+    // Skip this function, __acrt_heap_profile_allocation and the allocator's
+    // innermost frame:
+    slot.sample.frames   = RtlCaptureStackBackTrace(3, KMEMPROF_SAMPLE_FRAMES, slot.sample.stack, nullptr);
+
+    WriteRelease64(reinterpret_cast<long long volatile*>(&slot.sequence), static_cast<long long>(sequence));
+    return sequence;
+}
+
+extern "C" __declspec(noinline) void __cdecl __acrt_heap_profile_allocation(
+    void const*   const block,
+    size_t        const size,
+    unsigned long const tag,
+    void const*         caller
+    )
+{
+    HeapProfile* const profile = active_heap_profile();
+    if (profile == nullptr || block == nullptr)
+        return;
+
+    if (profile->options.call_site_skip != 0)
+        caller = call_site_above(caller, profile->options.call_site_skip);
+
+    unsigned long const bucket = find_bucket(profile, tag, size_class_of(size), caller);
+
+    HeapProfileCounters* const counters = current_counters(profile, bucket);
+    InterlockedIncrement64(&counters->allocations);
+    InterlockedAdd64(&counters->allocated_bytes, static_cast<long long>(size));
+
+    HeapProfileProcessor* const processor = current_processor(profile);
+
+    unsigned long long sample = 0;
+    if (profile->options.sample_every != 0 && InterlockedDecrement(&processor->sample_countdown) <= 0)
+    {
+        InterlockedExchange(&processor->sample_countdown, static_cast<long>(profile->options.sample_every));
+        sample = take_sample(profile, block, size, tag);
+    }
+
+    unsigned long long const hash = mix(reinterpret_cast<uintptr_t>(block));
+    unsigned long      const mask = profile->options.live_blocks - 1;
+    for (ULONG probe = 0; probe != ProbeLimit; ++probe)
+    {
+        HeapProfileLiveBlock& live = profile->live[(hash + probe) & mask];
+
+        void const* const current = ReadPointerNoFence(const_cast<PVOID volatile*>(&live.block));
+        if (current != nullptr && current != TombstoneBlock)
+            continue;
+
+        if (InterlockedCompareExchangePointer(
+            const_cast<PVOID volatile*>(&live.block), const_cast<void*>(block), const_cast<void*>(current)) != current)
+            continue;
+
+        // Nobody else can look for this block until it has been returned:
+        live.bucket = bucket;
+        live.size   = size;
+        live.sample = sample;
+        return;
+    }
+
+    InterlockedIncrement64(&processor->untracked_allocations);
+}
+
+extern "C" __declspec(noinline) void __cdecl __acrt_heap_profile_free(void const* const block)
+{
+    HeapProfile* const profile = active_heap_profile();
+    if (profile == nullptr || block == nullptr)
+        return;
+
+    unsigned long long const hash = mix(reinterpret_cast<uintptr_t>(block));
+    unsigned long      const mask = profile->options.live_blocks - 1;
+    for (ULONG probe = 0; probe != ProbeLimit; ++probe)
+    {
+        HeapProfileLiveBlock& live = profile->live[(hash + probe) & mask];
+
+        void const* const current = ReadPointerNoFence(const_cast<PVOID volatile*>(&live.block));
+        if (current == nullptr)
+            break;
+
+        if (current != block)
+            continue;
+
+        unsigned long      const bucket = live.bucket;
+        size_t             const size   = live.size;
+        unsigned long long const sample = live.sample;
+        InterlockedExchangePointer(const_cast<PVOID volatile*>(&live.block), const_cast<void*>(TombstoneBlock));
+
+        HeapProfileCounters* const counters = current_counters(profile, bucket);
+        InterlockedIncrement64(&counters->frees);
+        InterlockedAdd64(&counters->freed_bytes, static_cast<long long>(size));
+
+        if (sample != 0)
+        {
+            HeapProfileSample& slot = profile->samples[(sample - 1) % profile->options.samples];
+            if (static_cast<unsigned long long>(ReadAcquire64(reinterpret_cast<long long volatile*>(&slot.sequence))) == sample)
+                slot.sample.live = false;
+        }
+
+        return;
+    }
+
+    InterlockedIncrement64(&current_processor(profile)->untracked_frees);
+}
+
+
+
+static unsigned long __cdecl round_up_to_power_of_two(unsigned long const value) noexcept
+{
+    if (value <= 1)
+        return 1;
+
+    unsigned long bit;
+    _BitScanReverse(&bit, value - 1);
+    return bit >= 31 ? 0x80000000ul : 1ul << (bit + 1);
+}
+
+static size_t __cdecl align_up(size_t const value) noexcept
+{
+    return (value + SYSTEM_CACHE_ALIGNMENT_SIZE - 1) & ~static_cast<size_t>(SYSTEM_CACHE_ALIGNMENT_SIZE - 1);
+}
+
+static HeapProfile* __cdecl create_heap_profile(kmemprof_options const& options) noexcept
+{
+    ULONG const processors   = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+    ULONG const counter_sets = processors < MaximumCounterSets ? processors : MaximumCounterSets;
+
+    size_t const bucket_slots = 1 + static_cast<size_t>(options.buckets);
+
+    size_t const profile_size    = align_up(sizeof(HeapProfile));
+    size_t const buckets_size    = align_up(bucket_slots * sizeof(HeapProfileBucket));
+    size_t const counters_size   = align_up(counter_sets * bucket_slots * sizeof(HeapProfileCounters));
+    size_t const processors_size = align_up(counter_sets * sizeof(HeapProfileProcessor));
+    size_t const live_size       = align_up(static_cast<size_t>(options.live_blocks) * sizeof(HeapProfileLiveBlock));
+    size_t const samples_size    = align_up(static_cast<size_t>(options.samples) * sizeof(HeapProfileSample));
+
+    size_t const total = profile_size + buckets_size + counters_size + processors_size + live_size + samples_size;
+
+    #pragma warning(suppress: 4996)
+    unsigned char* const block = static_cast<unsigned char*>(
+        ExAllocatePoolWithTag(NonPagedPoolNxCacheAligned, total, HeapProfileTag));
+    if (block == nullptr)
+        return nullptr;
+
+    memset(block, 0, profile_size);
+
+    unsigned char* it = block;
+    HeapProfile* const profile = reinterpret_cast<HeapProfile*>(it);               it += profile_size;
+    profile->buckets    = reinterpret_cast<HeapProfileBucket*>(it);                it += buckets_size;
+    profile->counters   = reinterpret_cast<HeapProfileCounters*>(it);              it += counters_size;
+    profile->processors = reinterpret_cast<HeapProfileProcessor*>(it);             it += processors_size;
+    profile->live       = reinterpret_cast<HeapProfileLiveBlock*>(it);             it += live_size;
+    profile->samples    = reinterpret_cast<HeapProfileSample*>(it);
+
+    profile->options      = options;
+    profile->counter_sets = counter_sets;
+    return profile;
+}
+
+static void __cdecl reset_heap_profile(HeapProfile* const profile) noexcept
+{
+    size_t const bucket_slots = 1 + static_cast<size_t>(profile->options.buckets);
+
+    memset(profile->buckets,    0, bucket_slots * sizeof(HeapProfileBucket));
+    memset(profile->counters,   0, profile->counter_sets * bucket_slots * sizeof(HeapProfileCounters));
+    memset(profile->processors, 0, profile->counter_sets * sizeof(HeapProfileProcessor));
+    memset(profile->live,       0, profile->options.live_blocks * sizeof(HeapProfileLiveBlock));
+    memset(profile->samples,    0, profile->options.samples * sizeof(HeapProfileSample));
+
+    for (ULONG i = 0; i != profile->counter_sets; ++i)
+    {
+        profile->processors[i].sample_countdown = static_cast<long>(profile->options.sample_every);
+    }
+
+    profile->next_sample = 0;
+    profile->start       = KeQueryPerformanceCounter(&profile->frequency);
+}
+
+extern "C" NTSTATUS __cdecl kmemprof_enable(kmemprof_options const* const options)
+{
+    if (InterlockedCompareExchange(&heap_profile_busy, 1, 0) != 0)
+        return STATUS_DEVICE_BUSY;
+
+    kmemprof_options requested{ 512, 65536, 0, 256, 0 };
+    if (options != nullptr)
+    {
+        if (options->buckets     != 0) requested.buckets     = options->buckets;
+        if (options->live_blocks != 0) requested.live_blocks = options->live_blocks;
+        if (options->samples     != 0) requested.samples     = options->samples;
+        requested.sample_every   = options->sample_every;
+        requested.call_site_skip = options->call_site_skip < MaximumCallSiteSkip
+            ? options->call_site_skip
+            : MaximumCallSiteSkip;
+    }
+
+    requested.buckets     = round_up_to_power_of_two(requested.buckets);
+    requested.live_blocks = round_up_to_power_of_two(requested.live_blocks);
+    requested.sample_every = requested.sample_every < 0x7FFFFFFFul ? requested.sample_every : 0x7FFFFFFFul;
+
+    InterlockedExchange(&__acrt_heap_profile_armed, 0);
+
+    // The hooks read heap_profile without a lock, so the tables are made once
+    // and only reset afterwards.  The table sizes of the first call stay.
+    HeapProfile* profile = static_cast<HeapProfile*>(heap_profile);
+    if (profile == nullptr)
+    {
+        profile = create_heap_profile(requested);
+        if (profile == nullptr)
+        {
+            InterlockedExchange(&heap_profile_busy, 0);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+    else
+    {
+        profile->options.sample_every   = requested.sample_every;
+        profile->options.call_site_skip = requested.call_site_skip;
+    }
+
+    reset_heap_profile(profile);
+
+    WritePointerRelease(&heap_profile, profile);
+    InterlockedExchange(&__acrt_heap_profile_armed, 1);
+    InterlockedExchange(&heap_profile_busy, 0);
+    return STATUS_SUCCESS;
+}
+
+extern "C" void __cdecl kmemprof_disable()
+{
+    InterlockedExchange(&__acrt_heap_profile_armed, 0);
+}
+
+extern "C" bool __cdecl __acrt_uninitialize_heap_profile(bool const /* terminating */)
+{
+    InterlockedExchange(&__acrt_heap_profile_armed, 0);
+
+    HeapProfile* const profile = static_cast<HeapProfile*>(InterlockedExchangePointer(&heap_profile, nullptr));
+    if (profile != nullptr)
+    {
+        ExFreePoolWithTag(profile, HeapProfileTag);
+    }
+
+    return true;
+}
+
+
+
+extern "C" size_t __cdecl kmemprof_query(
+    kmemprof_bucket*  const buckets,
+    size_t            const capacity,
+    kmemprof_summary* const summary
+    )
+{
+    HeapProfile* const profile = active_heap_profile();
+
+    size_t const limit = buckets != nullptr ? capacity : 0;
+    size_t copied = 0;
+    size_t used   = 0;
+
+    if (profile != nullptr)
+    {
+        size_t const bucket_slots = 1 + static_cast<size_t>(profile->options.buckets);
+        for (size_t index = 0; index != bucket_slots; ++index)
+        {
+            HeapProfileBucket& bucket = profile->buckets[index];
+            if (index != 0 && ReadAcquire(&bucket.state) != BucketReady)
+                continue;
+
+            kmemprof_bucket entry{};
+            long long freed_bytes = 0;
+            for (ULONG set = 0; set != profile->counter_sets; ++set)
+            {
+                HeapProfileCounters const& counters = profile->counters[set * bucket_slots + index];
+                entry.allocations     += static_cast<unsigned long long>(ReadNoFence64(&counters.allocations));
+                entry.frees           += static_cast<unsigned long long>(ReadNoFence64(&counters.frees));
+                entry.allocated_bytes += static_cast<unsigned long long>(ReadNoFence64(&counters.allocated_bytes));
+                freed_bytes           += ReadNoFence64(&counters.freed_bytes);
+            }
+
+            if (index == 0 && entry.allocations == 0 && entry.frees == 0)
+                continue;
+
+            ++used;
+
+            entry.tag        = index != 0 ? bucket.tag : 0;
+            entry.size_class = index != 0 ? size_class_limit(bucket.size_class) : 0;
+            entry.call_site  = index != 0 ? bucket.call_site : nullptr;
+            entry.live_bytes = static_cast<long long>(entry.allocated_bytes) - freed_bytes;
+
+            long long peak = ReadNoFence64(&bucket.peak_live_bytes);
+            while (entry.live_bytes > peak)
+            {
+                long long const previous = InterlockedCompareExchange64(&bucket.peak_live_bytes, entry.live_bytes, peak);
+                if (previous == peak)
+                {
+                    peak = entry.live_bytes;
+                    break;
+                }
+
+                peak = previous;
+            }
+            entry.peak_live_bytes = peak;
+
+            // Keep the limit busiest buckets, sorted by live bytes:
+            size_t position = copied;
+            if (copied == limit)
+            {
+                if (limit == 0 || buckets[limit - 1].live_bytes >= entry.live_bytes)
+                    continue;
+
+                position = limit - 1;
+            }
+            else
+            {
+                ++copied;
+            }
+
+            while (position != 0 && buckets[position - 1].live_bytes < entry.live_bytes)
+            {
+                buckets[position] = buckets[position - 1];
+                --position;
+            }
+
+            buckets[position] = entry;
+        }
+    }
+
+    if (summary != nullptr)
+    {
+        *summary = kmemprof_summary{};
+        if (profile != nullptr)
+        {
+            LARGE_INTEGER const now = KeQueryPerformanceCounter(nullptr);
+            summary->elapsed_us = static_cast<unsigned long long>(
+                (now.QuadPart - profile->start.QuadPart) * 1000000 / profile->frequency.QuadPart);
+            summary->buckets    = used;
+            summary->samples    = static_cast<unsigned long long>(ReadNoFence64(&profile->next_sample));
+
+            for (ULONG set = 0; set != profile->counter_sets; ++set)
+            {
+                summary->untracked_allocations += static_cast<unsigned long long>(
+                    ReadNoFence64(&profile->processors[set].untracked_allocations));
+                summary->untracked_frees += static_cast<unsigned long long>(
+                    ReadNoFence64(&profile->processors[set].untracked_frees));
+            }
+        }
+    }
+
+    return copied;
+}
+
+extern "C" size_t __cdecl kmemprof_query_samples(
+    kmemprof_sample* const samples,
+    size_t           const capacity
+    )
+{
+    HeapProfile* const profile = active_heap_profile();
+    if (profile == nullptr || samples == nullptr)
+        return 0;
+
+    unsigned long long const newest = static_cast<unsigned long long>(ReadAcquire64(&profile->next_sample));
+
+    size_t copied = 0;
+    for (unsigned long long sequence = newest;
+        sequence != 0 && copied != capacity && newest - sequence < profile->options.samples;
+        --sequence)
+    {
+        HeapProfileSample const& slot = profile->samples[(sequence - 1) % profile->options.samples];
+
+        auto const slot_sequence = reinterpret_cast<long long volatile const*>(&slot.sequence);
+        if (static_cast<unsigned long long>(ReadAcquire64(const_cast<long long volatile*>(slot_sequence))) != sequence)
+            continue;
+
+        samples[copied] = slot.sample;
+
+        // The slot may have been reused while it was copied:
+        MemoryBarrier();
+        if (static_cast<unsigned long long>(ReadNoFence64(const_cast<long long volatile*>(slot_sequence))) != sequence)
+            continue;
+
+        ++copied;
+    }
+
+    return copied;
+}
@@ -0,0 +1,79 @@
+//
+// malloc_base.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Implementation of _malloc_base().  This is defined in a different source file
+// from the malloc() function to allow malloc() to be replaced by the user.
+//
+#include <corecrt_internal.h>
+#include <malloc.h>
+#include <new.h>
+#if defined NTOS_KERNEL_RUNTIME
+#include <corecrt_internal_startup_trace.h>
+#include <corecrt_internal_heap_profile.h>
+#endif
+
+
+
+// This function implements the logic of malloc().  It is called directly by the
+// malloc() function in the Release CRT and is called by the debug heap in the
+// Debug CRT.
+//
+// This function must be marked noinline, otherwise malloc and
+// _malloc_base will have identical COMDATs, and the linker will fold
+// them when calling one from the CRT. This is necessary because malloc
+// needs to support users patching in custom implementations.
+#if defined NTOS_KERNEL_RUNTIME
+//
+// Musa: The logic lives in __acrt_malloc_from, which reports caller as the call
+// site in the allocation telemetry (kext/kmemprof.h).  malloc and operator new
+// call it with their own caller, so that the allocation is charged to the code
+// that asked for it rather than to them.
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl _malloc_base(size_t const size)
+{
+    return __acrt_malloc_from(size, _ReturnAddress());
+}
+
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_malloc_from(
+    size_t      const size,
+    void const* const caller
+    )
+#else
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl _malloc_base(size_t const size)
+#endif
+{
+    // Ensure that the requested size is not too large:
+    _VALIDATE_RETURN_NOEXC(_HEAP_MAXREQ >= size, ENOMEM, nullptr);
+
+    // Ensure we request an allocation of at least one byte:
+    size_t const actual_size = size == 0 ? 1 : size;
+
+    for (;;)
+    {
+        void* const block = HeapAlloc(__acrt_heap, 0, actual_size);
+        if (block)
+        {
+            #if defined NTOS_KERNEL_RUNTIME
+            // Musa: Counted in the startup trace (kext/kstartup.h):
+            if (__acrt_startup_trace_armed)
+                __acrt_startup_trace_allocation(actual_size);
+
+            // Musa: Counted in the allocation telemetry (kext/kmemprof.h):
+            if (__acrt_heap_profile_armed)
+                __acrt_heap_profile_allocation(block, actual_size, KMEMPROF_TAG_CRT_HEAP, caller);
+            #endif
+            return block;
+        }
+
+        // Otherwise, see if we need to call the new handler, and if so call it.
+        // If the new handler fails, just return nullptr:
+        if (_query_new_mode() == 0 || !_callnewh(actual_size))
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        // The new handler was successful; try to allocate again...
+    }
+}
@@ -0,0 +1,62 @@
+//
+// corecrt_internal_heap_profile.h
+//
+// Musa: Internal interface to the allocation telemetry.  See heap_profile.cpp
+// and kext/kmemprof.h.
+//
+#pragma once
+#include "kext/kmemprof.h"
+
+extern "C" {
+
+// Nonzero while kmemprof is enabled.  The allocators test it before reporting
+// an allocation or a free, so the cost while disabled is one predictable branch.
+extern long volatile __acrt_heap_profile_armed;
+
+// Reports a successful allocation of size bytes at block.  caller is the return
+// address into the code that called the allocation function.
+void __cdecl __acrt_heap_profile_allocation(
+    _In_     void const*   block,
+    _In_     size_t        size,
+    _In_     unsigned long tag,
+    _In_opt_ void const*   caller
+    );
+
+// Reports that block is about to be freed (or moved by a reallocation).  Must
+// be called before the block is returned to the allocator, so that its address
+// cannot be handed out again while it is still in the live table.
+void __cdecl __acrt_heap_profile_free(_In_ void const* block);
+
+// kmalloc, reporting caller as the call site.  operator new(size, pool, tag)
+// uses it so that allocations are charged to the caller of operator new.
+__declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_kmalloc_from(
+    _In_     size_t        size,
+    _In_     POOL_TYPE     pool,
+    _In_     unsigned long tag,
+    _In_opt_ void const*   caller
+    );
+
+// _malloc_base, _calloc_base and _realloc_base, reporting caller as the call
+// site.  malloc, calloc, realloc and operator new use them so that allocations
+// are charged to their callers; the _base functions report their own callers.
+__declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_malloc_from(
+    _In_     size_t      size,
+    _In_opt_ void const* caller
+    );
+
+__declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_calloc_from(
+    _In_     size_t      count,
+    _In_     size_t      size,
+    _In_opt_ void const* caller
+    );
+
+__declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_realloc_from(
+    _Pre_maybenull_ _Post_invalid_ void*       block,
+    _In_                           size_t      size,
+    _In_opt_                       void const* caller
+    );
+
+// Releases the tables.  Called when the AppCRT is uninitialized.
+bool __cdecl __acrt_uninitialize_heap_profile(bool terminating);
+
+}
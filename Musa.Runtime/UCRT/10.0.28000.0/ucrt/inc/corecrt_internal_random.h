@@ -0,0 +1,15 @@
+//
+// corecrt_internal_random.h
+//
+// Musa: Internal interface to the buffered random number generators.  See
+// rand_s.cpp and kext/krand.h.
+//
+#pragma once
+#include "kext/krand.h"
+
+extern "C" {
+
+// Releases the generators.  Called when the AppCRT is uninitialized.
+bool __cdecl __acrt_uninitialize_random_pool(bool terminating);
+
+}
@@ -0,0 +1,54 @@
+//
+// corecrt_internal_startup_trace.h
+//
+// Musa: Internal interface to the startup trace.  See startup_trace.cpp and
+// kext/kstartup.h.
+//
+#pragma once
+#include <corecrt_startup.h>
+#include "kext/kstartup.h"
+
+extern "C" {
+
+// Nonzero from __acrt_startup_trace_begin until __acrt_startup_trace_end.  The
+// allocators test it before reporting an allocation, so the only cost once the
+// driver is running is one predictable branch.
+extern long volatile __acrt_startup_trace_armed;
+
+struct __acrt_startup_trace_mark
+{
+    unsigned __int64 cycles;
+    long             allocations;
+    __int64          bytes;
+};
+
+void __cdecl __acrt_startup_trace_begin(void);
+void __cdecl __acrt_startup_trace_end(void);
+
+void __cdecl __acrt_startup_trace_enter(
+    _Out_ __acrt_startup_trace_mark* mark
+    );
+
+void __cdecl __acrt_startup_trace_leave(
+    _In_     __acrt_startup_trace_mark const* mark,
+    _In_     kstartup_phase                   phase,
+    _In_opt_ char const*                      name,
+    _In_opt_ void const*                      routine
+    );
+
+void __cdecl __acrt_startup_trace_allocation(_In_ size_t size);
+
+// Runs [first, last) like _initterm / _initterm_e, recording each initializer.
+void __cdecl __acrt_startup_trace_initterm(
+    _In_reads_(last - first) _PVFV const* first,
+    _In_                     _PVFV const* last,
+    _In_                     kstartup_phase phase
+    );
+
+int __cdecl __acrt_startup_trace_initterm_e(
+    _In_reads_(last - first) _PIFV const* first,
+    _In_                     _PIFV const* last,
+    _In_                     kstartup_phase phase
+    );
+
+}
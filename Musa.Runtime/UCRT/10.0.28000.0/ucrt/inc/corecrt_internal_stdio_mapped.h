@@ -0,0 +1,41 @@
+//
+// corecrt_internal_stdio_mapped.h
+//
+// Musa: Internal interface for memory-mapped stdio streams (fopen mode "rm").
+//
+// A mapped stream is a read-only binary stream whose buffer is a system-space
+// view of the whole file.  The view is installed as a user buffer that was not
+// set via setvbuf, a combination no other stdio path produces, so no new stream
+// flag is needed:
+//
+//   _base    the view
+//   _bufsiz  the file size (mapped streams are limited to INT_MAX bytes)
+//   _ptr     the current position within the view
+//   _cnt     the bytes remaining after _ptr
+//
+// While _cnt is nonzero the lowio file position is kept at the end of the file,
+// so that ftell and fseek compute positions exactly as they do for an ordinary
+// binary stream whose buffer was filled by a single read.
+//
+#pragma once
+#include <corecrt_internal_stdio.h>
+
+
+
+inline bool __acrt_stdio_is_mapped_stream(__crt_stdio_stream const stream) throw()
+{
+    return stream.has_user_buffer()
+        && !stream.has_any_of(_IOBUFFER_SETVBUF | _IOBUFFER_STBUF);
+}
+
+// Replaces the buffer of a freshly opened read-only stream with a view of the
+// file.  Returns false, leaving the stream an ordinary buffered stream, if the
+// file cannot be mapped (devices, pipes, empty or oversized files).
+extern "C" bool __cdecl __acrt_stdio_map_stream_nolock(FILE* public_stream);
+
+// Releases the view and moves the lowio file position to the stream position.
+extern "C" void __cdecl __acrt_stdio_unmap_stream_nolock(FILE* public_stream);
+
+// Points the stream at the view from the current lowio file position onwards.
+// Returns the number of bytes now available, 0 at end of file, or -1 on error.
+extern "C" int __cdecl __acrt_stdio_refill_mapped_nolock(FILE* public_stream);
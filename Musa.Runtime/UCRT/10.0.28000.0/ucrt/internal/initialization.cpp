@@ -12,6 +12,11 @@
 #include <corecrt_internal_stdio.h>
 #include <stdlib.h>
 #include <stdio.h>
+#if defined NTOS_KERNEL_RUNTIME
+#include <corecrt_internal_startup_trace.h>
+#include <corecrt_internal_heap_profile.h>
+#include <corecrt_internal_random.h>
+#endif
 
 extern "C" {
 
@@ -99,29 +104,11 @@ static bool __cdecl uninitialize_c(bool)
 
 #endif // CRTDLL
 
+#if !defined NTOS_KERNEL_RUNTIME
 // C4505: unreferenced local function
 #pragma warning( suppress: 4505 )
 static bool __cdecl initialize_environment()
 {
-#if defined NTOS_KERNEL_RUNTIME
-    // In kernel mode, GetEnvironmentStringsW may return null (no OS env).
-    // Try the standard path first; on failure, install an empty environment
-    // table so _putenv_s/getenv can operate on a CRT-managed env.
-    if (_initialize_narrow_environment() >= 0 && _get_initial_narrow_environment())
-    {
-        return true;
-    }
-
-    // Fallback: allocate a single null pointer as the empty environment array.
-    char** const empty_env = static_cast<char**>(_calloc_crt(1, sizeof(char*)));
-    if (empty_env == nullptr)
-    {
-        return true; // do not fail CRT init even on OOM here
-    }
-    empty_env[0] = nullptr;
-    *__p__environ() = empty_env;
-    return true;
-#else
     if (_initialize_narrow_environment() < 0)
     {
         return false;
@@ -133,8 +120,8 @@ static bool __cdecl initialize_environment()
     }
 
     return true;
-#endif
 }
+#endif
 
 // C4505: unreferenced local function
 #pragma warning( suppress: 4505 )
@@ -265,6 +252,13 @@ static __acrt_initializer const __acrt_initializers[] =
     { initialize_global_variables,             nullptr                                  },
 #endif
 
+#if defined NTOS_KERNEL_RUNTIME
+    // Musa: The allocation telemetry tables (kext/kmemprof.h) are released by
+    // the first entry, so that they are released after every other
+    // uninitializer and the frees those make are still charged.
+    { nullptr,                                 __acrt_uninitialize_heap_profile         },
+#endif
+
     // Global pointers are stored in encoded form; they must be dynamically
     // initialized to the encoded nullptr value before they are used by the CRT.
     { initialize_pointers,                     nullptr                                  },
@@ -285,6 +279,11 @@ static __acrt_initializer const __acrt_initializers[] =
     // takes place, as other initialization steps rely on the heap and locks:
     { __acrt_initialize_locks,                 __acrt_uninitialize_locks                },
     { __acrt_initialize_heap,                  __acrt_uninitialize_heap                 },
+#if defined NTOS_KERNEL_RUNTIME
+    // Musa: The random number generators (kext/krand.h) are released after
+    // the uninitializers that could still ask them for random bytes.
+    { nullptr,                                 __acrt_uninitialize_random_pool          },
+#endif
 
     // During uninitialization, before the heap is uninitialized, the AppCRT
     // needs to notify all VCRuntime instances in the process to allow them to
@@ -315,7 +314,11 @@ static __acrt_initializer const __acrt_initializers[] =
 #endif
     // Enclaves only require initializers for supported features.
 // Enclaves require environment init; kernel mode also needs it
-#if !defined _UCRT_ENCLAVE_BUILD || defined NTOS_KERNEL_RUNTIME
+#if defined NTOS_KERNEL_RUNTIME
+    // Musa: The kernel environment is read from the registry, and few drivers
+    // ever look at it, so it is built on first use (environment_initialization.cpp).
+    { nullptr,                                 uninitialize_environment                 },
+#elif !defined _UCRT_ENCLAVE_BUILD
     { initialize_environment,                  uninitialize_environment                 },
 #endif
     { initialize_c,                            uninitialize_c                           },
@@ -324,16 +327,62 @@ static __acrt_initializer const __acrt_initializers[] =
 
 
 
+#if defined NTOS_KERNEL_RUNTIME
+// Musa: __acrt_execute_initializers, recording each initializer in the startup
+// trace (see kext/kstartup.h).
+static bool __cdecl execute_initializers_traced(
+    __acrt_initializer const* const first,
+    __acrt_initializer const* const last
+    )
+{
+    __acrt_initializer const* it = first;
+    for (; it != last; ++it)
+    {
+        if (it->_initialize == nullptr)
+            continue;
+
+        __acrt_startup_trace_mark mark;
+        __acrt_startup_trace_enter(&mark);
+        bool const initialized = (it->_initialize)();
+        __acrt_startup_trace_leave(&mark, kstartup_phase_acrt, nullptr, reinterpret_cast<void const*>(it->_initialize));
+
+        if (!initialized)
+            break;
+    }
+
+    if (it == last)
+        return true;
+
+    // Roll back exactly as __acrt_execute_initializers does:
+    for (; it != first; --it)
+    {
+        if ((it - 1)->_initialize == nullptr || (it - 1)->_uninitialize == nullptr)
+            continue;
+
+        (it - 1)->_uninitialize(false);
+    }
+
+    return false;
+}
+#endif
+
 __crt_bool __cdecl __acrt_initialize()
 {
     #if defined CRTDLL
     __isa_available_init();
     #endif
 
+#if defined NTOS_KERNEL_RUNTIME
+    return execute_initializers_traced(
+        __acrt_initializers,
+        __acrt_initializers + _countof(__acrt_initializers)
+        );
+#else
     return __acrt_execute_initializers(
         __acrt_initializers,
         __acrt_initializers + _countof(__acrt_initializers)
         );
+#endif
 }
 
 __crt_bool __cdecl __acrt_uninitialize(__crt_bool const terminating)
@@ -0,0 +1,177 @@
+//
+// startup_trace.cpp
+//
+// Musa: Records what the runtime does between DriverEntry and DriverMain.
+//
+// The trace is a fixed table in the image rather than a pool allocation, so
+// recording it neither allocates nor fails.  Only the thread running
+// DriverEntry writes it; it is published for kstartup_trace_query once
+// DriverMain is entered and is never written again.
+//
+#include <corecrt_internal.h>
+#include <corecrt_internal_startup_trace.h>
+
+
+
+namespace
+{
+    constexpr size_t StartupTraceCapacity = 256;
+
+    struct StartupTrace
+    {
+        LARGE_INTEGER    frequency;
+        LARGE_INTEGER    entry_counter;
+        unsigned __int64 entry_cycles;
+        unsigned __int64 main_us;
+        unsigned __int64 main_cycles;
+        size_t           count;
+        size_t           dropped;
+        kstartup_record  records[StartupTraceCapacity];
+    };
+}
+
+extern "C" long volatile __acrt_startup_trace_armed = 0;
+
+static StartupTrace     startup_trace;
+static long volatile    startup_trace_published   = 0;
+static long volatile    startup_trace_allocations = 0;
+static __int64 volatile startup_trace_bytes       = 0;
+
+
+
+extern "C" void __cdecl __acrt_startup_trace_begin()
+{
+    startup_trace.entry_counter = KeQueryPerformanceCounter(&startup_trace.frequency);
+    startup_trace.entry_cycles  = ReadTimeStampCounter();
+    startup_trace.count         = 0;
+    startup_trace.dropped       = 0;
+
+    InterlockedExchange(&__acrt_startup_trace_armed, 1);
+}
+
+extern "C" void __cdecl __acrt_startup_trace_end()
+{
+    if (InterlockedExchange(&__acrt_startup_trace_armed, 0) == 0)
+        return;
+
+    unsigned __int64 const cycles  = ReadTimeStampCounter();
+    LARGE_INTEGER    const counter = KeQueryPerformanceCounter(nullptr);
+
+    startup_trace.main_cycles = cycles - startup_trace.entry_cycles;
+    startup_trace.main_us     = static_cast<unsigned __int64>(
+        (counter.QuadPart - startup_trace.entry_counter.QuadPart) * 1000000 / startup_trace.frequency.QuadPart);
+
+    InterlockedExchange(&startup_trace_published, 1);
+}
+
+extern "C" void __cdecl __acrt_startup_trace_allocation(size_t const size)
+{
+    InterlockedIncrement(&startup_trace_allocations);
+    InterlockedExchangeAdd64(&startup_trace_bytes, static_cast<__int64>(size));
+}
+
+extern "C" void __cdecl __acrt_startup_trace_enter(__acrt_startup_trace_mark* const mark)
+{
+    mark->allocations = ReadNoFence(&startup_trace_allocations);
+    mark->bytes       = ReadNoFence64(&startup_trace_bytes);
+    mark->cycles      = ReadTimeStampCounter();
+}
+
+extern "C" void __cdecl __acrt_startup_trace_leave(
+    __acrt_startup_trace_mark const* const mark,
+    kstartup_phase                   const phase,
+    char const*                      const name,
+    void const*                      const routine
+    )
+{
+    unsigned __int64 const cycles = ReadTimeStampCounter();
+
+    if (!__acrt_startup_trace_armed)
+        return;
+
+    if (startup_trace.count == StartupTraceCapacity)
+    {
+        ++startup_trace.dropped;
+        return;
+    }
+
+    kstartup_record& record = startup_trace.records[startup_trace.count++];
+    record.phase       = phase;
+    record.name        = name;
+    record.routine     = routine;
+    record.cycles      = cycles - mark->cycles;
+    record.allocations = static_cast<unsigned long>(ReadNoFence(&startup_trace_allocations) - mark->allocations);
+    record.bytes       = static_cast<unsigned long long>(ReadNoFence64(&startup_trace_bytes) - mark->bytes);
+}
+
+
+
+extern "C" void __cdecl __acrt_startup_trace_initterm(
+    _PVFV const* const first,
+    _PVFV const* const last,
+    kstartup_phase const phase
+    )
+{
+    for (_PVFV const* it = first; it != last; ++it)
+    {
+        if (*it == nullptr)
+            continue;
+
+        __acrt_startup_trace_mark mark;
+        __acrt_startup_trace_enter(&mark);
+        (**it)();
+        __acrt_startup_trace_leave(&mark, phase, nullptr, reinterpret_cast<void const*>(*it));
+    }
+}
+
+extern "C" int __cdecl __acrt_startup_trace_initterm_e(
+    _PIFV const* const first,
+    _PIFV const* const last,
+    kstartup_phase const phase
+    )
+{
+    for (_PIFV const* it = first; it != last; ++it)
+    {
+        if (*it == nullptr)
+            continue;
+
+        __acrt_startup_trace_mark mark;
+        __acrt_startup_trace_enter(&mark);
+        int const result = (**it)();
+        __acrt_startup_trace_leave(&mark, phase, nullptr, reinterpret_cast<void const*>(*it));
+
+        if (result != 0)
+            return result;
+    }
+
+    return 0;
+}
+
+
+
+extern "C" size_t __cdecl kstartup_trace_query(
+    kstartup_record*  const records,
+    size_t            const capacity,
+    kstartup_summary* const summary
+    )
+{
+    bool const published = ReadAcquire(&startup_trace_published) != 0;
+
+    size_t const available = published ? startup_trace.count : 0;
+    size_t const copied    = records == nullptr ? 0 : available < capacity ? available : capacity;
+
+    if (copied != 0)
+    {
+        memcpy(records, startup_trace.records, copied * sizeof(kstartup_record));
+    }
+
+    if (summary != nullptr)
+    {
+        summary->entry_to_main_us     = published ? startup_trace.main_us     : 0;
+        summary->entry_to_main_cycles = published ? startup_trace.main_cycles : 0;
+        summary->records              = available;
+        summary->dropped              = published ? startup_trace.dropped     : 0;
+    }
+
+    return copied;
+}
@@ -16,6 +16,7 @@
 #include <nturtl.h>
 #include <ntsecapi.h>
 #include <corecrt_internal.h>
+#include "kext/kclock.h"
 
 
 extern "C" DWORD WINAPI __acrt_FlsAlloc(PFLS_CALLBACK_FUNCTION const callback)
@@ -73,10 +74,13 @@ extern "C" BOOLEAN WINAPI __acrt_RtlGenRandom(
 
 // ---- UCRT delegates to kernel32 thunks (round 2) ----
 
-// __acrt_GetSystemTimePreciseAsFileTime -- delegate to GetSystemTimeAsFileTime
+// __acrt_GetSystemTimePreciseAsFileTime -- the CRT wall clock, precise unless
+// kclock_set_realtime_mode selected the coarse one
 extern "C" void __cdecl __acrt_GetSystemTimePreciseAsFileTime(LPFILETIME const lpTime)
 {
-    GetSystemTimeAsFileTime(lpTime);
+    long long const time = kclock_realtime();
+    lpTime->dwLowDateTime  = static_cast<DWORD>(time);
+    lpTime->dwHighDateTime = static_cast<DWORD>(time >> 32);
 }
 
 // __acrt_AreFileApisANSI -- always FALSE in kernel mode
@@ -10,20 +10,84 @@
 
 
 
-extern "C" __crt_lowio_handle_data* __cdecl __acrt_lowio_create_handle_array()
+// Musa: Allocation state kept alongside __pioinfo.  Each lowio handle array has
+// a 64-bit hint mask with one bit per slot that may be free, and a pair of masks
+// that track lazy initialization of the per-slot locks.  A summary mask records
+// which arrays have any hint bit set, so _alloc_osfhnd finds a candidate with two
+// bit scans instead of walking (and locking) every slot under the index lock.
+//
+// Hints are advisory: a slot is only ever claimed while holding its lock and
+// after re-checking FOPEN.  Paths that abandon a handle without going through
+// _free_osfhnd simply lose their hint; it is recovered by a rescan the next time
+// the hint masks run dry.
+static_assert(IOINFO_ARRAY_ELTS == 64, "lowio hint masks assume 64 slots per array");
+
+namespace
 {
-    __crt_unique_heap_ptr<__crt_lowio_handle_data> array(_calloc_crt_t(
-        __crt_lowio_handle_data,
-        IOINFO_ARRAY_ELTS));
+    struct __crt_lowio_array_state
+    {
+        __int64 volatile free_hint;    // slot may be free
+        __int64 volatile lock_claimed; // slot lock initialization has started
+        __int64 volatile lock_ready;   // slot lock is initialized
+    };
+}
 
-    if (!array)
-        return nullptr;
+static __crt_lowio_array_state __acrt_lowio_array_state[IOINFO_ARRAYS];
+static __int64 volatile        __acrt_lowio_free_arrays[IOINFO_ARRAYS / 64];
+
+static void __cdecl mark_fh_free(int const fh) throw()
+{
+    int const i = fh >> IOINFO_L2E;
+    int const j = fh & (IOINFO_ARRAY_ELTS - 1);
+
+    InterlockedBitTestAndSet64(&__acrt_lowio_array_state[i].free_hint, j);
+    InterlockedBitTestAndSet64(&__acrt_lowio_free_arrays[i / 64], i % 64);
+}
+
+static void __cdecl mark_array_free(int const i, __int64 const slots) throw()
+{
+    InterlockedOr64(&__acrt_lowio_array_state[i].free_hint, slots);
+    InterlockedBitTestAndSet64(&__acrt_lowio_free_arrays[i / 64], i % 64);
+}
+
+// Per-handle locks are initialized on first use rather than when the array is
+// created, so growing the table only costs the array allocation.  The first
+// thread to claim the slot initializes the lock; any others wait until it is
+// published as ready.
+static void __cdecl ensure_fh_lock(int const fh) throw()
+{
+    __crt_lowio_array_state& state = __acrt_lowio_array_state[fh >> IOINFO_L2E];
+    int const j = fh & (IOINFO_ARRAY_ELTS - 1);
+
+    if (_bittest64(const_cast<__int64 const*>(&state.lock_ready), j))
+        return;
+
+    if (!InterlockedBitTestAndSet64(&state.lock_claimed, j))
+    {
+        __acrt_InitializeCriticalSectionEx(&_pioinfo(fh)->lock, _CORECRT_SPINCOUNT, 0);
+        InterlockedBitTestAndSet64(&state.lock_ready, j);
+        return;
+    }
+
+    while (!_bittest64(const_cast<__int64 const*>(&state.lock_ready), j))
+    {
+        YieldProcessor();
+    }
+}
 
-    __crt_lowio_handle_data* const first = array.get();
-    __crt_lowio_handle_data* const last  = first + IOINFO_ARRAY_ELTS;
+#if defined NTOS_KERNEL_RUNTIME
+// The first handle array is part of the image rather than the heap, so the
+// lowio initialization that runs before DriverMain makes no allocation.  Most
+// drivers never open a CRT file handle beyond stdin, stdout and stderr.
+static __crt_lowio_handle_data __acrt_lowio_initial_handle_array[IOINFO_ARRAY_ELTS];
+#endif
+
+static void __cdecl initialize_handle_array(__crt_lowio_handle_data* const first) throw()
+{
+    __crt_lowio_handle_data* const last = first + IOINFO_ARRAY_ELTS;
     for (auto it = first; it != last; ++it)
     {
-        __acrt_InitializeCriticalSectionEx(&it->lock, _CORECRT_SPINCOUNT, 0);
+        // The lock is left zeroed; see ensure_fh_lock.
         it->osfhnd             = reinterpret_cast<intptr_t>(INVALID_HANDLE_VALUE);
         it->startpos           = 0;
         it->osfile             = 0;
@@ -39,7 +103,18 @@ extern "C" __crt_lowio_handle_data* __cdecl __acrt_lowio_create_handle_array()
             it->mbBuffer[i] = '\0';
         }
     }
+}
+
+extern "C" __crt_lowio_handle_data* __cdecl __acrt_lowio_create_handle_array()
+{
+    __crt_unique_heap_ptr<__crt_lowio_handle_data> array(_calloc_crt_t(
+        __crt_lowio_handle_data,
+        IOINFO_ARRAY_ELTS));
 
+    if (!array)
+        return nullptr;
+
+    initialize_handle_array(array.get());
     return array.detach();
 }
 
@@ -48,13 +123,40 @@ extern "C" void __cdecl __acrt_lowio_destroy_handle_array(__crt_lowio_handle_dat
     if (!array)
         return;
 
-    __crt_lowio_handle_data* const first = array;
-    __crt_lowio_handle_data* const last  = first + IOINFO_ARRAY_ELTS;
-    for (auto it = first; it != last; ++it)
+    // Only the locks that were lazily initialized need to be deleted.  Arrays
+    // that were never published in __pioinfo have no initialized locks.
+    __crt_lowio_array_state* state = nullptr;
+    for (int i = 0; i < IOINFO_ARRAYS; ++i)
     {
-        DeleteCriticalSection(&it->lock);
+        if (__pioinfo[i] == array)
+        {
+            state = &__acrt_lowio_array_state[i];
+            InterlockedBitTestAndReset64(&__acrt_lowio_free_arrays[i / 64], i % 64);
+            break;
+        }
+    }
+
+    if (state)
+    {
+        __int64 const ready = state->lock_ready;
+        for (int j = 0; j < IOINFO_ARRAY_ELTS; ++j)
+        {
+            if (_bittest64(&ready, j))
+            {
+                DeleteCriticalSection(&array[j].lock);
+            }
+        }
+
+        state->free_hint    = 0;
+        state->lock_claimed = 0;
+        state->lock_ready   = 0;
     }
 
+    #if defined NTOS_KERNEL_RUNTIME
+    if (array == __acrt_lowio_initial_handle_array)
+        return;
+    #endif
+
     _free_crt(array);
 }
 
@@ -79,7 +181,18 @@ extern "C" errno_t __cdecl __acrt_lowio_ensure_fh_exists(int const fh)
                 continue;
             }
 
-            __pioinfo[i] = __acrt_lowio_create_handle_array();
+            #if defined NTOS_KERNEL_RUNTIME
+            if (i == 0)
+            {
+                initialize_handle_array(__acrt_lowio_initial_handle_array);
+                __pioinfo[i] = __acrt_lowio_initial_handle_array;
+            }
+            else
+            #endif
+            {
+                __pioinfo[i] = __acrt_lowio_create_handle_array();
+            }
+
             if (!__pioinfo[i])
             {
                 status = ENOMEM;
@@ -87,6 +200,7 @@ extern "C" errno_t __cdecl __acrt_lowio_ensure_fh_exists(int const fh)
             }
 
             _nhandle += IOINFO_ARRAY_ELTS;
+            mark_array_free(static_cast<int>(i), -1);
         }
     }
     __finally
@@ -99,6 +213,57 @@ extern "C" errno_t __cdecl __acrt_lowio_ensure_fh_exists(int const fh)
 
 
 
+// Attempts to claim a free handle using the hint masks, without taking the
+// index lock.  Returns the locked CRT file handle, or -1 if no hinted slot was
+// actually free.
+static int __cdecl try_alloc_hinted_osfhnd() throw()
+{
+    for (int w = 0; w < IOINFO_ARRAYS / 64; ++w)
+    {
+        for (;;)
+        {
+            unsigned long i_bit;
+            if (!_BitScanForward64(&i_bit, static_cast<unsigned __int64>(__acrt_lowio_free_arrays[w])))
+                break;
+
+            int const i = w * 64 + static_cast<int>(i_bit);
+            __crt_lowio_array_state& state = __acrt_lowio_array_state[i];
+
+            unsigned long j;
+            if (!_BitScanForward64(&j, static_cast<unsigned __int64>(state.free_hint)))
+            {
+                // This array has run out of hints.  Clear its summary bit, then
+                // re-check in case a handle was freed concurrently:
+                InterlockedBitTestAndReset64(&__acrt_lowio_free_arrays[w], i_bit);
+                if (state.free_hint != 0)
+                    InterlockedBitTestAndSet64(&__acrt_lowio_free_arrays[w], i_bit);
+
+                continue;
+            }
+
+            // Only the thread that consumes the hint bit examines the slot:
+            if (!InterlockedBitTestAndReset64(&state.free_hint, j))
+                continue;
+
+            int const fh = i * IOINFO_ARRAY_ELTS + static_cast<int>(j);
+            __acrt_lowio_lock_fh(fh);
+            if ((_osfile(fh) & FOPEN) != 0)
+            {
+                __acrt_lowio_unlock_fh(fh);
+                continue;
+            }
+
+            _osfile(fh) = FOPEN;
+            _osfhnd(fh) = reinterpret_cast<intptr_t>(INVALID_HANDLE_VALUE);
+            return fh;
+        }
+    }
+
+    return -1;
+}
+
+
+
 // Allocates a CRT file handle.  This function finds the first free entry in
 // the arrays of file objects and returns the index of that entry (that index
 // is the CRT file handle) to the caller.  The FOPEN flag is set in the new
@@ -114,67 +279,67 @@ extern "C" errno_t __cdecl __acrt_lowio_ensure_fh_exists(int const fh)
 // the file handle, it must clear the FOPEN flag to free the handle.
 extern "C" int __cdecl _alloc_osfhnd()
 {
+    // Fast path: claim a slot recorded as free by _free_osfhnd or by array
+    // creation.  This does not touch the index lock.
+    int result = try_alloc_hinted_osfhnd();
+    if (result != -1)
+        return result;
+
     __acrt_lock(__acrt_lowio_index_lock);
-    int result = -1;
     __try
     {
-        // Search the arrays of file objects, in order, looking for the first
-        // free entry.  The compound index of this free entry is the return
-        // value.
-        //
-        // The compound index of the file object entry *(__pioinfo[i] + j) is
-        // k = i * IOINFO_ARRAY_ELTS + j.
-        for (int i = 0; i < IOINFO_ARRAYS; ++i)
+        // The hint masks are empty.  Handles abandoned without _free_osfhnd
+        // (e.g. on failed opens) are not recorded, so rebuild the hints from
+        // the handle data before growing the table:
+        bool found_free = false;
+        for (int i = 0; i < IOINFO_ARRAYS && __pioinfo[i]; ++i)
         {
-            // If this __crt_lowio_handle_data array does not yet exist, create a new one:
-            if (!__pioinfo[i])
+            __int64 slots = 0;
+            __crt_lowio_handle_data* const first = __pioinfo[i];
+            for (int j = 0; j != IOINFO_ARRAY_ELTS; ++j)
             {
-                __pioinfo[i] = __acrt_lowio_create_handle_array();
-                if (!__pioinfo[i])
-                    __leave;
-
-                _nhandle += IOINFO_ARRAY_ELTS;
+                if ((first[j].osfile & FOPEN) == 0)
+                    slots |= 1ll << j;
+            }
 
-                // The first element of the newly allocated array of handle data
-                // objects is our first free entry.  Note that since we hold the
-                // index lock, no one else can allocate this handle.
-                int const fh = i * IOINFO_ARRAY_ELTS;
+            if (slots != 0)
+            {
+                mark_array_free(i, slots);
+                found_free = true;
+            }
+        }
 
-                __acrt_lowio_lock_fh(fh);
-                _osfile(fh) = FOPEN;
-                result = fh;
+        if (found_free)
+        {
+            result = try_alloc_hinted_osfhnd();
+            if (result != -1)
                 __leave;
-            }
+        }
 
-            // Otherwise, this file object array already exists.  Search it looking
-            // for the first free entry:
-            __crt_lowio_handle_data* const first = __pioinfo[i];
-            __crt_lowio_handle_data* const last  = first + IOINFO_ARRAY_ELTS;
-            for (__crt_lowio_handle_data* pio = first; pio != last; ++pio)
-            {
-                if (pio->osfile & FOPEN)
-                    continue;
-
-                // Another thread may have grabbed this file handle out from
-                // under us while we waited for the lock.  If so, continue on
-                // searching through the array.
-                //
-                // CRT_REFACTOR TODO:  Resolve lowio synchronization issues.
-                EnterCriticalSection(&pio->lock);
-                if ((pio->osfile & FOPEN) != 0)
-                {
-                    LeaveCriticalSection(&pio->lock);
-                    continue;
-                }
-
-                // Otherwise, this entry is ours:  we hold the lock, so we can
-                // initialize it and return its handle:
-                int const fh = i * IOINFO_ARRAY_ELTS + static_cast<int>(pio - first);
-                _osfile(fh) = FOPEN;
-                _osfhnd(fh) = reinterpret_cast<intptr_t>(INVALID_HANDLE_VALUE);
-                result = fh;
+        // Every existing array is full; create the next one:
+        for (int i = 0; i < IOINFO_ARRAYS; ++i)
+        {
+            if (__pioinfo[i])
+                continue;
+
+            __pioinfo[i] = __acrt_lowio_create_handle_array();
+            if (!__pioinfo[i])
                 __leave;
-            }
+
+            _nhandle += IOINFO_ARRAY_ELTS;
+
+            // The first element of the newly allocated array of handle data
+            // objects is our first free entry.  Note that since we hold the
+            // index lock, no one else can allocate this handle.  The rest are
+            // published as free.
+            int const fh = i * IOINFO_ARRAY_ELTS;
+
+            __acrt_lowio_lock_fh(fh);
+            _osfile(fh) = FOPEN;
+            result = fh;
+
+            mark_array_free(i, ~1ll);
+            __leave;
         }
 
         // All entries are in use if we fall out of the loop.  return -1 in this case (which result is already set to)
@@ -244,6 +409,7 @@ extern "C" int __cdecl _free_osfhnd(int const fh)
 #endif
 
         _osfhnd(fh) = reinterpret_cast<intptr_t>(INVALID_HANDLE_VALUE);
+        mark_fh_free(fh);
         return 0;
     }
     else
@@ -328,6 +494,7 @@ extern "C" int __cdecl _open_osfhandle(intptr_t const osfhandle, int const sourc
         if (!success)
         {
             _osfile(fh) &= ~FOPEN;
+            mark_fh_free(fh);
         }
 
         __acrt_lowio_unlock_fh(fh);
@@ -340,6 +507,7 @@ extern "C" int __cdecl _open_osfhandle(intptr_t const osfhandle, int const sourc
 // Acquires the lock associated with the given file handle.
 extern "C" void __cdecl __acrt_lowio_lock_fh(int const fh)
 {
+    ensure_fh_lock(fh);
     EnterCriticalSection(&_pioinfo(fh)->lock);
 }
 
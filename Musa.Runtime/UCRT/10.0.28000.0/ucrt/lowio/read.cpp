@@ -6,6 +6,11 @@
 // Defines _read(), which reads bytes from a file.
 //
 #include <corecrt_internal_lowio.h>
+#include <string.h>
+
+#if defined _M_X64
+#include <emmintrin.h>
+#endif
 
 // Lookup table for UTF-8 lead bytes
 // Probably preferable to just ask if the bits are set than use an entire
@@ -94,6 +99,69 @@ static int __cdecl translate_utf16_from_console_nolock(
 
 
 
+// Musa: Returns a pointer to the first CR or Ctrl+Z in [first, last), or last
+// if there is none.  Text-mode translation only has work to do at those two
+// characters, so everything between them is moved as a block.
+static char* __cdecl find_cr_or_ctrlz(char* first, char* const last) throw()
+{
+#if defined _M_X64
+    __m128i const cr    = _mm_set1_epi8(CR);
+    __m128i const ctrlz = _mm_set1_epi8(CTRLZ);
+    for (; last - first >= 16; first += 16)
+    {
+        __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        int     const mask  = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(chunk, cr),
+            _mm_cmpeq_epi8(chunk, ctrlz)));
+        if (mask != 0)
+        {
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return first + index;
+        }
+    }
+#endif
+
+    for (; first != last; ++first)
+    {
+        if (*first == CR || *first == CTRLZ)
+            break;
+    }
+
+    return first;
+}
+
+static wchar_t* __cdecl find_cr_or_ctrlz(wchar_t* first, wchar_t* const last) throw()
+{
+#if defined _M_X64
+    __m128i const cr    = _mm_set1_epi16(CR);
+    __m128i const ctrlz = _mm_set1_epi16(CTRLZ);
+    for (; last - first >= 8; first += 8)
+    {
+        __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        int     const mask  = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi16(chunk, cr),
+            _mm_cmpeq_epi16(chunk, ctrlz)));
+        if (mask != 0)
+        {
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return first + index / sizeof(wchar_t);
+        }
+    }
+#endif
+
+    for (; first != last; ++first)
+    {
+        if (*first == CR || *first == CTRLZ)
+            break;
+    }
+
+    return first;
+}
+
+
+
 template <typename Character>
 static int __cdecl translate_text_mode_nolock(
     _In_                                                         int        const fh,
@@ -123,6 +191,26 @@ static int __cdecl translate_text_mode_nolock(
 
     while (source_it < buffer_end)
     {
+        // Move the run of ordinary characters up to the next CR or Ctrl+Z in
+        // one step.  Until the first CRLF has been compacted the run is
+        // already in place and nothing needs to be copied:
+        Character* const special_it = find_cr_or_ctrlz(source_it, buffer_end);
+        if (special_it != source_it)
+        {
+            size_t const run_length = static_cast<size_t>(special_it - source_it);
+            if (result_it != source_it)
+            {
+                memmove(result_it, source_it, run_length * sizeof(Character));
+            }
+
+            result_it += run_length;
+            source_it  = special_it;
+            if (source_it == buffer_end)
+            {
+                break;
+            }
+        }
+
         // If during translation we encounter a Ctrl+Z, we stop translating
         // immeidately.  For devices, we need to just set the Ctrl+Z flag;
         // for other files, we just copy the Ctrl+Z as a normal character
@@ -141,13 +229,6 @@ static int __cdecl translate_text_mode_nolock(
             break;
         }
 
-        // If the character is not a CR, then we can simply copy it:
-        if (*source_it != CR)
-        {
-            *result_it++ = *source_it++;
-            continue;
-        }
-
         // Otherwise, the character is a CR.  We need to look-ahead to see if
         // the next character is an LF, so that we can perform the CRLF => LF
         // translation.  First, handle the easy case where the CR does not
@@ -14,6 +14,9 @@
 #include <string.h>
 #include <wchar.h>
 
+#if defined _M_X64
+#include <emmintrin.h>
+#endif
 
 
 namespace
@@ -33,6 +36,14 @@ namespace
 // this size, but this is used as the base size.
 static size_t const BUF_SIZE = 5 * 1024;
 
+// Musa: Text-mode writes larger than BUF_SIZE are staged through a heap buffer
+// of this size, so that large writes are submitted in a handful of system calls
+// rather than one per 5K chunk.  Newline-free spans of at least
+// DIRECT_WRITE_THRESHOLD bytes are not copied at all; they are written straight
+// from the caller's buffer between the staged CRLF fragments.
+static size_t const STAGING_BUF_SIZE       = 64 * 1024;
+static size_t const DIRECT_WRITE_THRESHOLD = 16 * 1024;
+
 
 
 // Writes a buffer to a file.  The way in which the buffer is written depends on
@@ -410,125 +421,227 @@ static write_result __cdecl write_double_translated_unicode_nolock(
 
 
 
-static write_result __cdecl write_text_ansi_nolock(
-    int                                 const fh,
-    _In_reads_(buffer_size) char const* const buffer,
-    unsigned                            const buffer_size
-    ) throw()
+// Returns a pointer to the first LF in [first, last), or last if there is none.
+static char const* __cdecl find_lf(char const* first, char const* const last) throw()
 {
-    HANDLE      const os_handle  = reinterpret_cast<HANDLE>(_osfhnd(fh));
-    char const* const buffer_end = buffer + buffer_size;
+#if defined _M_X64
+    __m128i const lf = _mm_set1_epi8(LF);
+    for (; last - first >= 16; first += 16)
+    {
+        __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        int     const mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf));
+        if (mask != 0)
+        {
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return first + index;
+        }
+    }
+#endif
 
-    write_result result = { 0 };
+    char const* const it = static_cast<char const*>(memchr(first, LF, last - first));
+    return it ? it : last;
+}
 
-    for (char const* source_it = buffer; source_it < buffer_end; )
+static wchar_t const* __cdecl find_lf(wchar_t const* first, wchar_t const* const last) throw()
+{
+#if defined _M_X64
+    __m128i const lf = _mm_set1_epi16(LF);
+    for (; last - first >= 8; first += 8)
     {
-        char lfbuf[BUF_SIZE]; // The LF => CRLF translation buffer
+        __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        int     const mask  = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, lf));
+        if (mask != 0)
+        {
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return first + index / sizeof(wchar_t);
+        }
+    }
+#endif
 
-        // One-past-the-end of the translation buffer.  Note that we subtract
-        // one to account for the case where we're pointing to the last element
-        // in the buffer and we need to write both a CR and an LF.
-        char* const lfbuf_end = lfbuf + sizeof(lfbuf) - 1;
+    wchar_t const* const it = wmemchr(first, LF, last - first);
+    return it ? it : last;
+}
 
-        // Translate the source buffer into the translation buffer.  Note that
-        // both source_it and lfbuf_it are incremented in the loop.
-        char* lfbuf_it = lfbuf;
-        while (lfbuf_it < lfbuf_end && source_it < buffer_end)
+
+
+namespace
+{
+    // Accumulates LF => CRLF translated output and submits it to the OS in
+    // blocks as large as the staging buffer.  Every member returns false once
+    // the write must stop, either because of an OS error (recorded in the
+    // result) or because the OS wrote fewer bytes than requested.
+    template <typename Character>
+    class text_write_sink
+    {
+    public:
+
+        text_write_sink(
+            HANDLE        const os_handle,
+            Character*    const buffer,
+            size_t        const capacity,
+            write_result&       result
+            ) throw()
+            : _os_handle(os_handle),
+              _first(buffer),
+              _next(buffer),
+              _last(buffer + capacity),
+              _staged_lf_count(0),
+              _result(result)
         {
-            char const c = *source_it++;
+        }
 
-            if (c == LF)
+        bool append(Character const* source, size_t count) throw()
+        {
+            while (count != 0)
             {
-                ++result.lf_count;
-                *lfbuf_it++ = CR;
+                if (_next == _last && !flush())
+                    return false;
+
+                size_t const chunk = __min(count, static_cast<size_t>(_last - _next));
+                memcpy(_next, source, chunk * sizeof(Character));
+                _next  += chunk;
+                source += chunk;
+                count  -= chunk;
             }
 
-            *lfbuf_it++ = c;
+            return true;
         }
 
-        DWORD const lfbuf_length = static_cast<DWORD>(lfbuf_it - lfbuf);
+        bool append_crlf() throw()
+        {
+            if (_last - _next < 2 && !flush())
+                return false;
 
-        DWORD written;
-        if (!WriteFile(os_handle, lfbuf, lfbuf_length, &written, nullptr))
+            *_next++ = CR;
+            *_next++ = LF;
+            _staged_lf_count += sizeof(Character);
+            return true;
+        }
+
+        // Writes the span directly from the caller's buffer, after flushing
+        // whatever has been staged so far to keep the output in order:
+        bool write_direct(Character const* const source, size_t const count) throw()
         {
-            result.error_code = GetLastError();
-            return result;
+            return flush() && write(source, count * sizeof(Character));
         }
 
-        result.char_count += written;
-        if (written < lfbuf_length)
+        // As with the chunked writer this replaces, the translated LFs are
+        // accounted for as soon as their chunk is submitted:
+        bool flush() throw()
         {
-            return result; // The write succeeded but didn't write everything
+            size_t const length = static_cast<size_t>(_next - _first) * sizeof(Character);
+            _result.lf_count += _staged_lf_count;
+            _staged_lf_count  = 0;
+            _next             = _first;
+            return length == 0 || write(_first, length);
         }
-    }
 
-    return result;
+    private:
+
+        bool write(void const* const data, size_t const length) throw()
+        {
+            DWORD written;
+            if (!WriteFile(_os_handle, data, static_cast<DWORD>(length), &written, nullptr))
+            {
+                _result.error_code = GetLastError();
+                return false;
+            }
+
+            _result.char_count += written;
+            return written == length;
+        }
+
+        HANDLE        _os_handle;
+        Character*    _first;
+        Character*    _next;
+        Character*    _last;
+        DWORD         _staged_lf_count;
+        write_result& _result;
+    };
 }
 
 
 
-static write_result __cdecl write_text_utf16le_nolock(
+// Writes a text mode buffer in the ANSI or UTF-16LE text modes.  The buffer is
+// scanned for LFs; the spans between them are copied into the staging buffer
+// (or, if they are long enough, written directly), with a CRLF pair emitted in
+// place of each LF.
+template <typename Character>
+static write_result __cdecl write_text_translated_nolock(
     int                                 const fh,
     _In_reads_(buffer_size) char const* const buffer,
     unsigned                            const buffer_size
     ) throw()
 {
-    HANDLE         const os_handle  = reinterpret_cast<HANDLE>(_osfhnd(fh));
-    wchar_t const* const buffer_end = reinterpret_cast<wchar_t const*>(buffer + buffer_size);
+    HANDLE           const os_handle  = reinterpret_cast<HANDLE>(_osfhnd(fh));
+    Character const* const buffer_end = reinterpret_cast<Character const*>(buffer + buffer_size);
 
     write_result result = { 0 };
 
-    wchar_t const* source_it = reinterpret_cast<wchar_t const*>(buffer);
-    while (source_it < buffer_end)
+    // Small writes use the stack buffer.  Larger ones use a heap staging buffer
+    // if one can be obtained, and the stack buffer otherwise:
+    Character stack_buf[BUF_SIZE / sizeof(Character)];
+    __crt_unique_heap_ptr<Character> heap_buf;
+    if (buffer_size > BUF_SIZE)
     {
-        wchar_t lfbuf[BUF_SIZE / sizeof(wchar_t)]; // The translation buffer
+        heap_buf = _malloc_crt_t(Character, STAGING_BUF_SIZE / sizeof(Character));
+    }
 
-        // One-past-the-end of the translation buffer.  Note that we subtract
-        // one to account for the case where we're pointing to the last element
-        // in the buffer and we need to write both a CR and an LF.
-        wchar_t const* lfbuf_end = lfbuf + BUF_SIZE / sizeof(wchar_t) - 1;
+    text_write_sink<Character> sink = heap_buf
+        ? text_write_sink<Character>(os_handle, heap_buf.get(), STAGING_BUF_SIZE / sizeof(Character), result)
+        : text_write_sink<Character>(os_handle, stack_buf, _countof(stack_buf), result);
 
-        // Translate the source buffer into the translation buffer.  Note that
-        // both source_it and lfbuf_it are incremented in the loop.
-        wchar_t* lfbuf_it = lfbuf;
-        while (lfbuf_it < lfbuf_end && source_it < buffer_end)
-        {
-            wchar_t const c = *source_it++;
-
-            if (c == LF)
-            {
-                result.lf_count += 2;
-                *lfbuf_it++ = CR;
-            }
+    for (Character const* source_it = reinterpret_cast<Character const*>(buffer); source_it < buffer_end; )
+    {
+        Character const* const lf_it = find_lf(source_it, buffer_end);
 
-            *lfbuf_it++ = c;
-        }
+        size_t const span = static_cast<size_t>(lf_it - source_it);
+        bool const span_written = span * sizeof(Character) >= DIRECT_WRITE_THRESHOLD
+            ? sink.write_direct(source_it, span)
+            : sink.append(source_it, span);
 
-        // Note that this length is in bytes, not wchar_t elemnts, since we need
-        // to tell WriteFile how many bytes (not characters) to write:
-        DWORD const lfbuf_length = static_cast<DWORD>(lfbuf_it - lfbuf) * sizeof(wchar_t);
+        if (!span_written)
+            return result;
 
+        if (lf_it == buffer_end)
+            break;
 
-        // Attempt the write and return immediately if it fails:
-        DWORD written;
-        if (!WriteFile(os_handle, lfbuf, lfbuf_length, &written, nullptr))
-        {
-            result.error_code = GetLastError();
+        if (!sink.append_crlf())
             return result;
-        }
 
-        result.char_count += written;
-        if (written < lfbuf_length)
-        {
-            return result; // The write succeeded, but didn't write everything
-        }
+        source_it = lf_it + 1;
     }
 
+    sink.flush();
     return result;
 }
 
 
 
+static write_result __cdecl write_text_ansi_nolock(
+    int                                 const fh,
+    _In_reads_(buffer_size) char const* const buffer,
+    unsigned                            const buffer_size
+    ) throw()
+{
+    return write_text_translated_nolock<char>(fh, buffer, buffer_size);
+}
+
+
+
+static write_result __cdecl write_text_utf16le_nolock(
+    int                                 const fh,
+    _In_reads_(buffer_size) char const* const buffer,
+    unsigned                            const buffer_size
+    ) throw()
+{
+    return write_text_translated_nolock<wchar_t>(fh, buffer, buffer_size);
+}
+
+
+
 static write_result __cdecl write_text_utf8_nolock(
     int                                 const fh,
     _In_reads_(buffer_size) char const* const buffer,
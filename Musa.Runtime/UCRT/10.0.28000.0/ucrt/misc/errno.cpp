@@ -13,6 +13,7 @@
 #include <corecrt_internal.h>
 #include <corecrt_internal_ptd_propagation.h>
 #include <errno.h>
+#include "kext/kerror.h"
 
 
 
@@ -185,6 +186,189 @@ extern "C" int __cdecl __acrt_errno_from_os_error(unsigned long const oserrno)
 
 
 
+// Musa: NTSTATUS mapping.  Kernel failures arrive as NTSTATUS; mapping them
+// through RtlNtStatusToDosError and then errtable costs two searches and loses
+// information.  nt_status_table maps the common statuses directly to an errno
+// value and a description.  nt_status_index is a dense table, built at compile
+// time, from each status in the windows below to its entry in nt_status_table,
+// so a lookup is a range check and one load.
+namespace
+{
+    struct nt_status_entry
+    {
+        NTSTATUS    status;
+        int         errnocode;
+        char const* message;
+    };
+
+    struct nt_status_window
+    {
+        unsigned long first;
+        unsigned long count;
+    };
+}
+
+static constexpr nt_status_entry nt_status_table[]
+{
+    { STATUS_SUCCESS,                   0,            "success"                            },
+    { STATUS_ABANDONED,                 0,            "wait abandoned"                     },
+    { STATUS_USER_APC,                  0,            "user apc delivered"                 },
+    { STATUS_ALERTED,                   0,            "alerted"                            },
+    { STATUS_TIMEOUT,                   0,            "timeout"                            },
+    { STATUS_PENDING,                   0,            "operation pending"                  },
+    { STATUS_REPARSE,                   0,            "reparse"                            },
+    { STATUS_MORE_ENTRIES,              0,            "more entries"                       },
+
+    { STATUS_DATATYPE_MISALIGNMENT,     EFAULT,       "datatype misalignment"              },
+    { STATUS_BUFFER_OVERFLOW,           EOVERFLOW,    "buffer overflow"                    },
+    { STATUS_NO_MORE_FILES,             ENOENT,       "no more files"                      },
+    { STATUS_DEVICE_BUSY,               EBUSY,        "device busy"                        },
+    { STATUS_NO_MORE_ENTRIES,           ENOENT,       "no more entries"                    },
+
+    { STATUS_UNSUCCESSFUL,              EINVAL,       "unsuccessful"                       },
+    { STATUS_NOT_IMPLEMENTED,           ENOSYS,       "not implemented"                    },
+    { STATUS_INFO_LENGTH_MISMATCH,      EINVAL,       "information length mismatch"        },
+    { STATUS_ACCESS_VIOLATION,          EFAULT,       "access violation"                   },
+    { STATUS_INVALID_HANDLE,            EBADF,        "invalid handle"                     },
+    { STATUS_INVALID_PARAMETER,         EINVAL,       "invalid parameter"                  },
+    { STATUS_NO_SUCH_DEVICE,            ENODEV,       "no such device"                     },
+    { STATUS_NO_SUCH_FILE,              ENOENT,       "no such file"                       },
+    { STATUS_INVALID_DEVICE_REQUEST,    ENOTTY,       "invalid device request"             },
+    { STATUS_END_OF_FILE,               EIO,          "end of file"                        },
+    { STATUS_NO_MEMORY,                 ENOMEM,       "no memory"                          },
+    { STATUS_ACCESS_DENIED,             EACCES,       "access denied"                      },
+    { STATUS_BUFFER_TOO_SMALL,          ERANGE,       "buffer too small"                   },
+    { STATUS_OBJECT_TYPE_MISMATCH,      EINVAL,       "object type mismatch"               },
+    { STATUS_OBJECT_NAME_INVALID,       ENOENT,       "object name invalid"                },
+    { STATUS_OBJECT_NAME_NOT_FOUND,     ENOENT,       "object name not found"              },
+    { STATUS_OBJECT_NAME_COLLISION,     EEXIST,       "object name collision"              },
+    { STATUS_OBJECT_PATH_NOT_FOUND,     ENOENT,       "object path not found"              },
+    { STATUS_SHARING_VIOLATION,         EACCES,       "sharing violation"                  },
+    { STATUS_QUOTA_EXCEEDED,            ENOMEM,       "quota exceeded"                     },
+    { STATUS_FILE_LOCK_CONFLICT,        EACCES,       "file lock conflict"                 },
+    { STATUS_LOCK_NOT_GRANTED,          ENOLCK,       "lock not granted"                   },
+    { STATUS_DELETE_PENDING,            EACCES,       "delete pending"                     },
+    { STATUS_PRIVILEGE_NOT_HELD,        EPERM,        "privilege not held"                 },
+    { STATUS_INVALID_IMAGE_FORMAT,      ENOEXEC,      "invalid image format"               },
+    { STATUS_DISK_FULL,                 ENOSPC,       "disk full"                          },
+    { STATUS_INTEGER_OVERFLOW,          EOVERFLOW,    "integer overflow"                   },
+    { STATUS_INSUFFICIENT_RESOURCES,    ENOMEM,       "insufficient resources"             },
+    { STATUS_MEDIA_WRITE_PROTECTED,     EROFS,        "media write protected"              },
+    { STATUS_DEVICE_NOT_READY,          EAGAIN,       "device not ready"                   },
+    { STATUS_IO_TIMEOUT,                ETIMEDOUT,    "i/o timeout"                        },
+    { STATUS_FILE_IS_A_DIRECTORY,       EISDIR,       "file is a directory"                },
+    { STATUS_NOT_SUPPORTED,             ENOTSUP,      "not supported"                      },
+    { STATUS_DEVICE_DOES_NOT_EXIST,     ENODEV,       "device does not exist"              },
+    { STATUS_NOT_SAME_DEVICE,           EXDEV,        "not same device"                    },
+    { STATUS_DIRECTORY_NOT_EMPTY,       ENOTEMPTY,    "directory not empty"                },
+    { STATUS_NOT_A_DIRECTORY,           ENOTDIR,      "not a directory"                    },
+    { STATUS_NAME_TOO_LONG,             ENAMETOOLONG, "name too long"                      },
+    { STATUS_TOO_MANY_OPENED_FILES,     EMFILE,       "too many opened files"              },
+    { STATUS_CANCELLED,                 ECANCELED,    "cancelled"                          },
+    { STATUS_COMMITMENT_LIMIT,          ENOMEM,       "commitment limit"                   },
+    { STATUS_INVALID_ADDRESS,           EFAULT,       "invalid address"                    },
+    { STATUS_PIPE_BROKEN,               EPIPE,        "pipe broken"                        },
+    { STATUS_INVALID_DEVICE_STATE,      EBUSY,        "invalid device state"               },
+    { STATUS_INVALID_BUFFER_SIZE,       EINVAL,       "invalid buffer size"                },
+    { STATUS_CONNECTION_RESET,          ECONNRESET,   "connection reset"                   },
+    { STATUS_NOT_FOUND,                 ENOENT,       "not found"                          },
+    { STATUS_RETRY,                     EAGAIN,       "retry"                              },
+    { STATUS_CONNECTION_REFUSED,        ECONNREFUSED, "connection refused"                 },
+    { STATUS_NETWORK_UNREACHABLE,       ENETUNREACH,  "network unreachable"                },
+    { STATUS_HOST_UNREACHABLE,          EHOSTUNREACH, "host unreachable"                   },
+    { STATUS_CONNECTION_ABORTED,        ECONNABORTED, "connection aborted"                 },
+    { STATUS_TOO_MANY_LINKS,            EMLINK,       "too many links"                     },
+    { STATUS_NO_UNICODE_TRANSLATION,    EILSEQ,       "no unicode translation"             },
+};
+
+// Facility 0 success codes, warnings and errors; every status in
+// nt_status_table must fall into one of these.
+static constexpr nt_status_window nt_status_windows[]
+{
+    { 0x00000000ul, 0x200 },
+    { 0x80000000ul, 0x040 },
+    { 0xC0000000ul, 0x800 },
+};
+
+namespace
+{
+    struct nt_status_index_t
+    {
+        static constexpr size_t slot_count = 0x200 + 0x040 + 0x800;
+
+        unsigned char slots[slot_count]; // 1 + index into nt_status_table, 0 if absent
+        bool          complete;          // every entry was placed
+
+        constexpr nt_status_index_t() noexcept : slots{}, complete{true}
+        {
+            for (size_t entry = 0; entry != _countof(nt_status_table); ++entry)
+            {
+                size_t const slot = find_slot(static_cast<unsigned long>(nt_status_table[entry].status));
+                if (slot == slot_count || slots[slot] != 0)
+                {
+                    complete = false;
+                    continue;
+                }
+
+                slots[slot] = static_cast<unsigned char>(entry + 1);
+            }
+        }
+
+        static constexpr size_t find_slot(unsigned long const code) noexcept
+        {
+            size_t offset = 0;
+            for (nt_status_window const& window : nt_status_windows)
+            {
+                if (code - window.first < window.count)
+                    return offset + (code - window.first);
+
+                offset += window.count;
+            }
+
+            return slot_count;
+        }
+    };
+
+    constexpr nt_status_index_t nt_status_index;
+}
+
+static_assert(_countof(nt_status_table) < 0xFF, "nt_status_table does not fit the index");
+static_assert(nt_status_index.complete, "nt_status_table has a duplicate status or one outside nt_status_windows");
+
+static nt_status_entry const* __cdecl find_nt_status(NTSTATUS const status) noexcept
+{
+    size_t const slot = nt_status_index_t::find_slot(static_cast<unsigned long>(status));
+    if (slot == nt_status_index_t::slot_count)
+        return nullptr;
+
+    unsigned char const entry = nt_status_index.slots[slot];
+    return entry != 0 ? &nt_status_table[entry - 1] : nullptr;
+}
+
+extern "C" int __cdecl kerrno_from_ntstatus(NTSTATUS const status)
+{
+    nt_status_entry const* const entry = find_nt_status(status);
+    if (entry != nullptr)
+        return entry->errnocode;
+
+    if (NT_SUCCESS(status))
+        return 0;
+
+    // NTSTATUS_FROM_WIN32 wraps a Win32 error as 0xC007xxxx:
+    if (((static_cast<unsigned long>(status) >> 16) & 0xFFF) == FACILITY_NTWIN32)
+        return __acrt_errno_from_os_error(static_cast<unsigned long>(status) & 0xFFFF);
+
+    return EINVAL;
+}
+
+extern "C" char const* __cdecl kntstatus_message(NTSTATUS const status)
+{
+    nt_status_entry const* const entry = find_nt_status(status);
+    return entry != nullptr ? entry->message : nullptr;
+}
+
+
+
 // These safely set and get the value of the calling thread's errno
 extern "C" errno_t _set_errno(int const value)
 {
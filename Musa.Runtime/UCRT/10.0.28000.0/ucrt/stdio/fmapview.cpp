@@ -0,0 +1,175 @@
+//
+// fmapview.cpp -- Kernel-mode memory-mapped stdio streams
+//
+// A stream opened with the 'm' mode character ("rm", "rbm") is served from a
+// read-only system-space view of the file instead of a heap buffer refilled by
+// _read:  fread, fgets and friends copy straight out of the mapping, fseek only
+// moves a pointer, and _fmapview exposes the whole view for zero-copy parsing.
+// See corecrt_internal_stdio_mapped.h for how the view sits in the stream.
+//
+// Symbols provided by this overlay:
+//   __acrt_stdio_map_stream_nolock, __acrt_stdio_unmap_stream_nolock
+//   __acrt_stdio_refill_mapped_nolock
+//   _fmapview
+//
+#include <corecrt_internal_lowio.h>
+#include <corecrt_internal_stdio_mapped.h>
+#include <limits.h>
+
+
+
+static void* __cdecl map_file_view(HANDLE const os_handle) throw()
+{
+    OBJECT_ATTRIBUTES attributes;
+    InitializeObjectAttributes(&attributes, nullptr, OBJ_KERNEL_HANDLE, nullptr, nullptr);
+
+    HANDLE section_handle = nullptr;
+    NTSTATUS status = ZwCreateSection(
+        &section_handle,
+        SECTION_MAP_READ | SECTION_QUERY,
+        &attributes,
+        nullptr,
+        PAGE_READONLY,
+        SEC_COMMIT,
+        os_handle);
+    if (!NT_SUCCESS(status))
+        return nullptr;
+
+    void* section_object = nullptr;
+    status = ObReferenceObjectByHandle(
+        section_handle,
+        SECTION_MAP_READ,
+        nullptr,
+        KernelMode,
+        &section_object,
+        nullptr);
+    ZwClose(section_handle);
+    if (!NT_SUCCESS(status))
+        return nullptr;
+
+    // The view keeps the section's backing alive; the section object itself
+    // is not needed once the view exists:
+    void*  view      = nullptr;
+    SIZE_T view_size = 0;
+    status = MmMapViewInSystemSpace(section_object, &view, &view_size);
+    ObDereferenceObject(section_object);
+
+    return NT_SUCCESS(status) ? view : nullptr;
+}
+
+
+
+extern "C" bool __cdecl __acrt_stdio_map_stream_nolock(FILE* const public_stream)
+{
+    __crt_stdio_stream const stream(public_stream);
+
+    int const fh = _fileno(public_stream);
+    if (_osfile(fh) & (FDEV | FPIPE | FTEXT))
+        return false;
+
+    __int64 const file_size = _filelengthi64(fh);
+    if (file_size <= 0 || file_size > INT_MAX)
+        return false;
+
+    void* const view = map_file_view(reinterpret_cast<HANDLE>(_osfhnd(fh)));
+    if (view == nullptr)
+        return false;
+
+    // The whole file is "in the buffer", so the lowio position is at its end:
+    if (_lseeki64_nolock(fh, file_size, SEEK_SET) == -1)
+    {
+        MmUnmapViewInSystemSpace(view);
+        return false;
+    }
+
+    if (stream.has_crt_buffer())
+        __acrt_stdio_free_buffer_nolock(public_stream);
+
+    stream.unset_flags(_IOBUFFER_NONE);
+    stream.set_flags(_IOBUFFER_USER);
+    stream->_base   = static_cast<char*>(view);
+    stream->_ptr    = stream->_base;
+    stream->_cnt    = static_cast<int>(file_size);
+    stream->_bufsiz = static_cast<int>(file_size);
+    return true;
+}
+
+
+
+extern "C" void __cdecl __acrt_stdio_unmap_stream_nolock(FILE* const public_stream)
+{
+    __crt_stdio_stream const stream(public_stream);
+
+    // Leave the lowio position where the stream was, so that a stream which is
+    // re-buffered by setvbuf continues from the same place:
+    if (stream->_cnt > 0)
+    {
+        _lseeki64_nolock(_fileno(public_stream), stream->_ptr - stream->_base, SEEK_SET);
+    }
+
+    MmUnmapViewInSystemSpace(stream->_base);
+
+    stream.unset_flags(_IOBUFFER_USER);
+    stream->_base   = nullptr;
+    stream->_ptr    = nullptr;
+    stream->_cnt    = 0;
+    stream->_bufsiz = 0;
+}
+
+
+
+extern "C" int __cdecl __acrt_stdio_refill_mapped_nolock(FILE* const public_stream)
+{
+    __crt_stdio_stream const stream(public_stream);
+
+    int const fh = _fileno(public_stream);
+
+    __int64 const position = _lseeki64_nolock(fh, 0, SEEK_CUR);
+    if (position < 0)
+        return -1;
+
+    if (position >= stream->_bufsiz)
+    {
+        stream->_ptr = stream->_base;
+        return 0;
+    }
+
+    if (_lseeki64_nolock(fh, stream->_bufsiz, SEEK_SET) == -1)
+        return -1;
+
+    stream->_ptr = stream->_base + position;
+    return stream->_bufsiz - static_cast<int>(position);
+}
+
+
+
+// Returns the view backing a stream opened with the 'm' mode character.  The
+// view stays valid until the stream is closed, reopened or given a buffer with
+// setvbuf.  If the stream is not mapped (including when fopen fell back to an
+// ordinary buffered stream), *data and *size are cleared and EINVAL is
+// returned; the invalid parameter handler is not invoked for that case.
+extern "C" errno_t __cdecl _fmapview(
+    FILE*        const public_stream,
+    void const** const data,
+    size_t*      const size
+    )
+{
+    _VALIDATE_RETURN_ERRCODE(public_stream != nullptr, EINVAL);
+    _VALIDATE_RETURN_ERRCODE(data != nullptr,          EINVAL);
+    _VALIDATE_RETURN_ERRCODE(size != nullptr,          EINVAL);
+
+    *data = nullptr;
+    *size = 0;
+
+    __crt_stdio_stream const stream(public_stream);
+
+    return __acrt_lock_stream_and_call(public_stream, [&]() -> errno_t
+    {
+        if (!stream.is_in_use() || !__acrt_stdio_is_mapped_stream(stream))
+            return EINVAL;
+
+        *data = stream->_base;
+        *size = static_cast<size_t>(stream->_bufsiz);
+        return 0;
+    });
+}
@@ -8,7 +8,8 @@
 //   base SDK input.cpp:   __stdio_common_vsscanf (scanf engine)
 //   this overlay:         _vscprintf, _vscwprintf (→ _vsnprintf / _vsnwprintf)
 //                         _vsnprintf          (→ __stdio_common_vsprintf)
-//                         snprintf            (→ _vsnprintf)
+//                         vsnprintf, snprintf (→ fast path or __stdio_common_vsprintf)
+//                         vsprintf, sprintf   (→ fast path or __stdio_common_vsprintf)
 //                         sscanf              (→ __stdio_common_vsscanf)
 //   Self-contained -- no ntoskrnl dependency for printf/scanf.
 //
@@ -19,6 +20,233 @@
 #include <stdio.h>
 #include <wchar.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+namespace
+{
+    // Musa: Formats made only of %d %i %u %x %X %c %s %p and %% (the integer
+    // conversions optionally with an l, ll or z length modifier) are handled
+    // here without the __stdio_common_vsprintf state machine.  This covers the
+    // bulk of log lines.  Anything else -- flags, width, precision, floating
+    // point, %n, wide strings -- is left to the full engine.  The format is
+    // checked before any argument is consumed, so falling back is always safe.
+    enum class fast_length { none, l, ll, z };
+
+    bool is_fast_format(char const* it)
+    {
+        for (; *it != '\0'; ++it)
+        {
+            if (*it != '%')
+                continue;
+
+            ++it;
+            if (*it == '%')
+                continue;
+
+            if (*it == 'l')
+            {
+                ++it;
+                if (*it == 'l')
+                    ++it;
+            }
+            else if (*it == 'z')
+            {
+                ++it;
+            }
+            else if (*it == 's' || *it == 'p' || *it == 'c')
+            {
+                continue;
+            }
+
+            switch (*it)
+            {
+            case 'd': case 'i': case 'u': case 'x': case 'X':
+                continue;
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Writes up to the bound (keeping one character for the terminator) and
+    // keeps counting past it, so the required length comes out of one pass.
+    class bounded_output
+    {
+    public:
+        bounded_output(char* const buffer, size_t const count)
+            : _it(buffer), _room(count != 0 ? count - 1 : 0), _count(0)
+        {
+        }
+
+        void put(char const c)
+        {
+            if (_room != 0)
+            {
+                *_it++ = c;
+                --_room;
+            }
+
+            ++_count;
+        }
+
+        void put(char const* const string, size_t const length)
+        {
+            size_t const n = length < _room ? length : _room;
+            memcpy(_it, string, n);
+            _it    += n;
+            _room  -= n;
+            _count += length;
+        }
+
+        void terminate(bool const has_room)
+        {
+            if (has_room)
+                *_it = '\0';
+        }
+
+        size_t count() const { return _count; }
+
+    private:
+        char*  _it;
+        size_t _room;
+        size_t _count;
+    };
+
+    void put_unsigned(bounded_output& output, uint64_t value, unsigned const base, bool const upper, int const min_digits)
+    {
+        char const* const digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+        char  buffer[24];
+        char* const end = buffer + sizeof(buffer);
+        char* first = end;
+        do
+        {
+            *--first = digits[value % base];
+            value /= base;
+        }
+        while (value != 0);
+
+        while (end - first < min_digits)
+            *--first = '0';
+
+        output.put(first, static_cast<size_t>(end - first));
+    }
+
+    int format_fast(char* const buffer, size_t const count, char const* it, va_list args)
+    {
+        bounded_output output(buffer, count);
+
+        while (*it != '\0')
+        {
+            char const* const literal = it;
+            while (*it != '\0' && *it != '%')
+                ++it;
+
+            if (it != literal)
+                output.put(literal, static_cast<size_t>(it - literal));
+
+            if (*it == '\0')
+                break;
+
+            ++it; // '%'
+
+            fast_length length = fast_length::none;
+            if (*it == 'l')
+            {
+                ++it;
+                length = fast_length::l;
+                if (*it == 'l')
+                {
+                    ++it;
+                    length = fast_length::ll;
+                }
+            }
+            else if (*it == 'z')
+            {
+                ++it;
+                length = fast_length::z;
+            }
+
+            char const conversion = *it++;
+            switch (conversion)
+            {
+            case '%':
+                output.put('%');
+                break;
+
+            case 'c':
+                output.put(static_cast<char>(va_arg(args, int)));
+                break;
+
+            case 's':
+            {
+                char const* string = va_arg(args, char const*);
+                if (string == nullptr)
+                    string = "(null)";
+
+                output.put(string, strlen(string));
+                break;
+            }
+
+            case 'p':
+                put_unsigned(output, reinterpret_cast<uintptr_t>(va_arg(args, void*)), 16, true, 2 * sizeof(void*));
+                break;
+
+            case 'd':
+            case 'i':
+            {
+                int64_t value;
+                switch (length)
+                {
+                case fast_length::ll: value = va_arg(args, long long);                                    break;
+                case fast_length::z:  value = static_cast<int64_t>(static_cast<intptr_t>(va_arg(args, size_t))); break;
+                case fast_length::l:  value = va_arg(args, long);                                         break;
+                default:              value = va_arg(args, int);                                          break;
+                }
+
+                uint64_t magnitude = static_cast<uint64_t>(value);
+                if (value < 0)
+                {
+                    output.put('-');
+                    magnitude = 0 - magnitude;
+                }
+
+                put_unsigned(output, magnitude, 10, false, 1);
+                break;
+            }
+
+            default: // u, x, X
+            {
+                uint64_t value;
+                switch (length)
+                {
+                case fast_length::ll: value = va_arg(args, unsigned long long); break;
+                case fast_length::z:  value = va_arg(args, size_t);             break;
+                case fast_length::l:  value = va_arg(args, unsigned long);      break;
+                default:              value = va_arg(args, unsigned int);       break;
+                }
+
+                put_unsigned(output, value, conversion == 'u' ? 10 : 16, conversion == 'X', 1);
+                break;
+            }
+            }
+        }
+
+        output.terminate(count != 0);
+        return output.count() <= INT_MAX ? static_cast<int>(output.count()) : -1;
+    }
+
+    bool can_format_fast(char const* const buffer, size_t const count, char const* const format)
+    {
+        return (buffer != nullptr || count == 0)
+            && format != nullptr
+            && is_fast_format(format);
+    }
+}
 
 _CRT_BEGIN_C_HEADER
 
@@ -66,22 +294,26 @@ extern "C" int __cdecl sscanf(const char* buf, const char* fmt, ...)
     return r;
 }
 
+// ---- vsnprintf / snprintf -- C99 semantics in a single formatting pass ----
+
+extern "C" int __cdecl vsnprintf(char* buf, size_t n, const char* fmt, va_list args)
+{
+    if (can_format_fast(buf, n, fmt))
+        return format_fast(buf, n, fmt, args);
+
+    // C99: return count that *would* have been written, even on truncation.
+    // The standard snprintf behavior keeps counting once the buffer is full.
+    return __stdio_common_vsprintf(
+        _CRT_INTERNAL_LOCAL_PRINTF_OPTIONS | _CRT_INTERNAL_PRINTF_STANDARD_SNPRINTF_BEHAVIOR,
+        buf, n, fmt, nullptr, args);
+}
+
 extern "C" int __cdecl snprintf(char* buf, size_t n, const char* fmt, ...)
 {
     va_list args;
     __crt_va_start(args, fmt);
-    int const r = _vsnprintf(buf, n, fmt, args);
+    int const r = vsnprintf(buf, n, fmt, args);
     __crt_va_end(args);
-    // C99: return count that *would* have been written, even on truncation
-    // _vsnprintf returns -1 on truncation; call _vscprintf for true count
-    if (r < 0)
-    {
-        va_list args2;
-        __crt_va_start(args2, fmt);
-        int const needed = _vscprintf(fmt, args2);
-        __crt_va_end(args2);
-        return needed;
-    }
     return r;
 }
 
@@ -90,6 +322,9 @@ extern "C" int __cdecl snprintf(char* buf, size_t n, const char* fmt, ...)
 extern "C" int __cdecl vsprintf(char* buf, const char* fmt, va_list args)
 {
     // Use unbounded buffer size; caller responsible for buf size
+    if (can_format_fast(buf, static_cast<size_t>(-1), fmt))
+        return format_fast(buf, static_cast<size_t>(-1), fmt, args);
+
     return __stdio_common_vsprintf(
         _CRT_INTERNAL_LOCAL_PRINTF_OPTIONS | _CRT_INTERNAL_PRINTF_LEGACY_VSPRINTF_NULL_TERMINATION,
         buf, static_cast<size_t>(-1), fmt, nullptr, args);
@@ -0,0 +1,756 @@
+//
+// qsort.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Defines qsort(), a routine for sorting arrays.
+//
+// Musa: The median-of-three quicksort is replaced by pattern-defeating
+// quicksort (Orson Peters, "Pattern-defeating Quicksort", 2021): median of
+// three (ninther above 128 elements) pivots, insertion sort below 24 elements,
+// detection of already partitioned ranges, shuffling after a badly unbalanced
+// partition and a heapsort once there have been log2(num) of those, so the
+// worst case is O(num log num).  Elements of 4, 8 and 16 bytes are swapped as
+// whole words and partitioned with the branchless block partition; other
+// widths use the plain partition and a chunked swap.  qsort_u32 and qsort_u64
+// (kext/ksort.h) sort integer keys with an LSD radix sort instead.
+//
+// The comparator is never called with the same pointer for both arguments.
+//
+#include <corecrt_internal.h>
+#include <search.h>
+#include <cfguard.h>
+#include <string.h>
+#include "kext/ksort.h"
+
+
+/* Temporarily define optimization macros (to be removed by the build team: RsmqblCompiler alias) */
+#if !defined(BEGIN_PRAGMA_OPTIMIZE_DISABLE)
+#define BEGIN_PRAGMA_OPTIMIZE_DISABLE(flags, bug, reason) \
+    __pragma(optimize(flags, off))
+#define BEGIN_PRAGMA_OPTIMIZE_ENABLE(flags, bug, reason) \
+    __pragma(optimize(flags, on))
+#define END_PRAGMA_OPTIMIZE() \
+    __pragma(optimize("", on))
+#endif
+
+
+// Always compile this module for speed, not size
+BEGIN_PRAGMA_OPTIMIZE_ENABLE("t", MSFT:4499497, "This file is performance-critical and should always be optimized for speed")
+
+
+
+#ifdef _M_CEE
+    #define __fileDECL __clrcall
+#else
+    #define __fileDECL __cdecl
+#endif
+
+
+
+// Used when building x64 versions of a function for use in Arm64 (to avoid Arm64EC transitions)
+#if !defined(_CRT_ARM64X_X64_BUILD)
+#define CRT_ARM64X_X64_NAME(name) name
+#else
+#define CRT_ARM64X_X64_NAME(name) name##_x64
+#endif
+
+
+
+#ifndef _QSORT_PDQSORT_DEFINED
+#define _QSORT_PDQSORT_DEFINED
+namespace __crt_pdqsort
+{
+    constexpr size_t insertion_sort_threshold     = 24;
+    constexpr size_t ninther_threshold            = 128;
+    constexpr size_t partial_insertion_sort_limit = 8;
+    constexpr size_t block_size                   = 64;
+
+    // Elements whose width is known at compile time; swapped through a
+    // temporary so the compiler can use whole registers.
+    template <size_t Width>
+    struct fixed_width
+    {
+        size_t width() const noexcept { return Width; }
+
+        void swap(char* const a, char* const b) const noexcept
+        {
+            unsigned char tmp[Width];
+            memcpy(tmp, a, Width);
+            memcpy(a, b, Width);
+            memcpy(b, tmp, Width);
+        }
+    };
+
+    struct any_width
+    {
+        size_t _width;
+
+        size_t width() const noexcept { return _width; }
+
+        void swap(char* a, char* b) const noexcept
+        {
+            size_t n = _width;
+            for (; n >= sizeof(uint64_t); n -= sizeof(uint64_t), a += sizeof(uint64_t), b += sizeof(uint64_t))
+            {
+                uint64_t tmp;
+                memcpy(&tmp, a, sizeof(tmp));
+                memcpy(a, b, sizeof(tmp));
+                memcpy(b, &tmp, sizeof(tmp));
+            }
+
+            while (n--)
+            {
+                char const tmp = *a;
+                *a++ = *b;
+                *b++ = tmp;
+            }
+        }
+    };
+
+    // Element is fixed_width or any_width; Less(a, b) is true if *a orders
+    // before *b.  Ranges are [begin, end) as char pointers.
+    //
+    // The partition scans stop at an element the pivot selection put in their
+    // way, which only works if Less is a strict weak ordering.  A caller's
+    // comparator need not be one (one that never returns 0, or is given NaNs),
+    // so unless Unguarded, which is for the comparisons qsort defines itself,
+    // each scan also stops at the ends of the range and every insertion sort
+    // checks for the beginning of the range.
+    template <typename Element, typename Less, bool Branchless, bool Unguarded = false>
+    class sorter
+    {
+    public:
+        sorter(Element const element, Less const& less) noexcept
+            : _element(element), _less(less), _w(element.width())
+        {
+        }
+
+        void sort(char* const begin, size_t const num) noexcept
+        {
+            int bad_allowed = 0;
+            for (size_t n = num; n > 1; n >>= 1)
+            {
+                ++bad_allowed;
+            }
+
+            sort_loop(begin, begin + num * _w, bad_allowed, true);
+        }
+
+    private:
+        Element     _element;
+        Less const& _less;
+        size_t      _w;
+
+        bool less(char const* const a, char const* const b) const noexcept { return _less(a, b); }
+        void swap(char* const a, char* const b) const noexcept { _element.swap(a, b); }
+        size_t count(char const* const first, char const* const last) const noexcept { return static_cast<size_t>(last - first) / _w; }
+
+        bool below(char const* const p, char const* const limit) const noexcept { return Unguarded || p < limit; }
+        bool above(char const* const p, char const* const limit) const noexcept { return Unguarded || p > limit; }
+
+        void insertion_sort(char* const begin, char* const end) const noexcept
+        {
+            if (begin == end)
+                return;
+
+            for (char* cur = begin + _w; cur != end; cur += _w)
+            {
+                for (char* sift = cur; sift != begin && less(sift, sift - _w); sift -= _w)
+                {
+                    swap(sift - _w, sift);
+                }
+            }
+        }
+
+        // The element before begin orders before or with every element in
+        // the range, so it stops each sift.  Unguarded only.
+        void unguarded_insertion_sort(char* const begin, char* const end) const noexcept
+        {
+            if (begin == end)
+                return;
+
+            for (char* cur = begin + _w; cur != end; cur += _w)
+            {
+                for (char* sift = cur; less(sift, sift - _w); sift -= _w)
+                {
+                    swap(sift - _w, sift);
+                }
+            }
+        }
+
+        // Insertion sort that gives up after partial_insertion_sort_limit
+        // moves; returns whether the range was sorted.
+        bool partial_insertion_sort(char* const begin, char* const end) const noexcept
+        {
+            if (begin == end)
+                return true;
+
+            size_t moves = 0;
+            for (char* cur = begin + _w; cur != end; cur += _w)
+            {
+                for (char* sift = cur; sift != begin && less(sift, sift - _w); sift -= _w)
+                {
+                    swap(sift - _w, sift);
+                    ++moves;
+                }
+
+                if (moves > partial_insertion_sort_limit)
+                    return false;
+            }
+
+            return true;
+        }
+
+        void sort2(char* const a, char* const b) const noexcept
+        {
+            if (less(b, a))
+                swap(a, b);
+        }
+
+        void sort3(char* const a, char* const b, char* const c) const noexcept
+        {
+            sort2(a, b);
+            sort2(b, c);
+            sort2(a, b);
+        }
+
+        void sift_down(char* const begin, size_t root, size_t const num) const noexcept
+        {
+            for (;;)
+            {
+                size_t child = 2 * root + 1;
+                if (child >= num)
+                    return;
+
+                if (child + 1 < num && less(begin + child * _w, begin + (child + 1) * _w))
+                    ++child;
+
+                if (!less(begin + root * _w, begin + child * _w))
+                    return;
+
+                swap(begin + root * _w, begin + child * _w);
+                root = child;
+            }
+        }
+
+        void heap_sort(char* const begin, char* const end) const noexcept
+        {
+            size_t const num = count(begin, end);
+            for (size_t i = num / 2; i-- != 0; )
+            {
+                sift_down(begin, i, num);
+            }
+
+            for (size_t n = num; n > 1; --n)
+            {
+                swap(begin, begin + (n - 1) * _w);
+                sift_down(begin, 0, n - 1);
+            }
+        }
+
+        // Partitions [begin, end) around the pivot at begin.  Elements equal to
+        // the pivot go to the right.  Returns the final position of the pivot
+        // and stores whether the range was already partitioned.  Relies on an
+        // element that does not order before the pivot after it (the median of
+        // three leaves one at end - 1).
+        char* partition_right(char* const begin, char* const end, bool& already_partitioned) const noexcept
+        {
+            char const* const pivot = begin;
+            char* const limit = end - _w;
+            char* first = begin;
+            char* last  = end;
+
+            do first += _w; while (below(first, limit) && less(first, pivot));
+
+            if (first - _w == begin)
+            {
+                while (first < last)
+                {
+                    last -= _w;
+                    if (less(last, pivot))
+                        break;
+                }
+            }
+            else
+            {
+                do last -= _w; while (above(last, begin) && !less(last, pivot));
+            }
+
+            already_partitioned = first >= last;
+
+            while (first < last)
+            {
+                swap(first, last);
+                do first += _w; while (below(first, limit) && less(first, pivot));
+                do last -= _w; while (above(last, begin) && !less(last, pivot));
+            }
+
+            char* const pivot_position = first - _w;
+            swap(begin, pivot_position);
+            return pivot_position;
+        }
+
+        // partition_right with the comparisons for a block of elements done
+        // up front into offset arrays, so the outcome of a comparison is never
+        // branched on.
+        char* partition_right_branchless(char* const begin, char* const end, bool& already_partitioned) const noexcept
+        {
+            char const* const pivot = begin;
+            char* const limit = end - _w;
+            char* first = begin;
+            char* last  = end;
+
+            do first += _w; while (below(first, limit) && less(first, pivot));
+
+            if (first - _w == begin)
+            {
+                while (first < last)
+                {
+                    last -= _w;
+                    if (less(last, pivot))
+                        break;
+                }
+            }
+            else
+            {
+                do last -= _w; while (above(last, begin) && !less(last, pivot));
+            }
+
+            already_partitioned = first >= last;
+            if (!already_partitioned)
+            {
+                swap(first, last);
+                first += _w;
+            }
+
+            unsigned char offsets_l[block_size];
+            unsigned char offsets_r[block_size];
+            char*  offsets_l_base = first;
+            char*  offsets_r_base = last;
+            size_t num_l   = 0;
+            size_t num_r   = 0;
+            size_t start_l = 0;
+            size_t start_r = 0;
+
+            while (first < last)
+            {
+                // Fill the offset blocks with elements on the wrong side,
+                // splitting what is left between the empty blocks.
+                size_t const num_unknown = count(first, last);
+                size_t const left_split  = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+                size_t const right_split = num_r == 0 ? num_unknown - left_split : 0;
+
+                size_t const left_count = left_split < block_size ? left_split : block_size;
+                for (size_t i = 0; i < left_count; ++i)
+                {
+                    offsets_l[num_l] = static_cast<unsigned char>(i);
+                    num_l += !less(first, pivot);
+                    first += _w;
+                }
+
+                size_t const right_count = right_split < block_size ? right_split : block_size;
+                for (size_t i = 0; i < right_count; )
+                {
+                    offsets_r[num_r] = static_cast<unsigned char>(++i);
+                    last -= _w;
+                    num_r += less(last, pivot);
+                }
+
+                size_t const num = num_l < num_r ? num_l : num_r;
+                for (size_t i = 0; i < num; ++i)
+                {
+                    swap(offsets_l_base + offsets_l[start_l + i] * _w, offsets_r_base - offsets_r[start_r + i] * _w);
+                }
+
+                num_l   -= num;
+                num_r   -= num;
+                start_l += num;
+                start_r += num;
+
+                if (num_l == 0)
+                {
+                    start_l = 0;
+                    offsets_l_base = first;
+                }
+
+                if (num_r == 0)
+                {
+                    start_r = 0;
+                    offsets_r_base = last;
+                }
+            }
+
+            // Move whatever is left in one block to the middle.
+            if (num_l != 0)
+            {
+                while (num_l--)
+                {
+                    last -= _w;
+                    swap(offsets_l_base + offsets_l[start_l + num_l] * _w, last);
+                }
+                first = last;
+            }
+
+            if (num_r != 0)
+            {
+                while (num_r--)
+                {
+                    swap(offsets_r_base - offsets_r[start_r + num_r] * _w, first);
+                    first += _w;
+                }
+                last = first;
+            }
+
+            char* const pivot_position = first - _w;
+            swap(begin, pivot_position);
+            return pivot_position;
+        }
+
+        // Partitions [begin, end) around the pivot at begin with the elements
+        // equal to it on the left.  Used when the element before begin equals
+        // the pivot, so that no element in the range orders before it and the
+        // whole left part is done.
+        char* partition_left(char* const begin, char* const end) const noexcept
+        {
+            char const* const pivot = begin;
+            char* const limit = end - _w;
+            char* first = begin;
+            char* last  = end;
+
+            do last -= _w; while (above(last, begin) && less(pivot, last));
+
+            if (last + _w == end)
+            {
+                while (first < last)
+                {
+                    first += _w;
+                    if (less(pivot, first))
+                        break;
+                }
+            }
+            else
+            {
+                do first += _w; while (below(first, limit) && !less(pivot, first));
+            }
+
+            while (first < last)
+            {
+                swap(first, last);
+                do last -= _w; while (above(last, begin) && less(pivot, last));
+                do first += _w; while (below(first, limit) && !less(pivot, first));
+            }
+
+            swap(begin, last);
+            return last;
+        }
+
+        // Sorts the smaller side of each partition recursively and loops on
+        // the larger one, so the recursion is at most log2(num) deep.
+        void sort_loop(char* begin, char* end, int bad_allowed, bool leftmost) const noexcept
+        {
+            for (;;)
+            {
+                size_t const size = count(begin, end);
+                if (size < insertion_sort_threshold)
+                {
+                    if (leftmost || !Unguarded)
+                        insertion_sort(begin, end);
+                    else
+                        unguarded_insertion_sort(begin, end);
+                    return;
+                }
+
+                size_t const s2 = size / 2;
+                if (size > ninther_threshold)
+                {
+                    sort3(begin,                 begin + s2 * _w,       end - _w);
+                    sort3(begin + _w,            begin + (s2 - 1) * _w, end - 2 * _w);
+                    sort3(begin + 2 * _w,        begin + (s2 + 1) * _w, end - 3 * _w);
+                    sort3(begin + (s2 - 1) * _w, begin + s2 * _w,       begin + (s2 + 1) * _w);
+                    swap(begin, begin + s2 * _w);
+                }
+                else
+                {
+                    sort3(begin + s2 * _w, begin, end - _w);
+                }
+
+                // A pivot equal to the element before the range (the pivot of
+                // an earlier partition) means many equal elements: put them
+                // all on the left, where they are done.
+                if (!leftmost && !less(begin - _w, begin))
+                {
+                    begin = partition_left(begin, end) + _w;
+                    continue;
+                }
+
+                bool already_partitioned;
+                char* const pivot_position = Branchless
+                    ? partition_right_branchless(begin, end, already_partitioned)
+                    : partition_right(begin, end, already_partitioned);
+
+                size_t const l_size = count(begin, pivot_position);
+                size_t const r_size = count(pivot_position + _w, end);
+
+                if (l_size < size / 8 || r_size < size / 8)
+                {
+                    if (--bad_allowed == 0)
+                    {
+                        heap_sort(begin, end);
+                        return;
+                    }
+
+                    // Break up the pattern that produced the bad partition.
+                    if (l_size >= insertion_sort_threshold)
+                    {
+                        swap(begin,                 begin + (l_size / 4) * _w);
+                        swap(pivot_position - _w,   pivot_position - (l_size / 4) * _w);
+
+                        if (l_size > ninther_threshold)
+                        {
+                            swap(begin + _w,              begin + (l_size / 4 + 1) * _w);
+                            swap(begin + 2 * _w,          begin + (l_size / 4 + 2) * _w);
+                            swap(pivot_position - 2 * _w, pivot_position - (l_size / 4 + 1) * _w);
+                            swap(pivot_position - 3 * _w, pivot_position - (l_size / 4 + 2) * _w);
+                        }
+                    }
+
+                    if (r_size >= insertion_sort_threshold)
+                    {
+                        swap(pivot_position + _w, pivot_position + (1 + r_size / 4) * _w);
+                        swap(end - _w,            end - (r_size / 4) * _w);
+
+                        if (r_size > ninther_threshold)
+                        {
+                            swap(pivot_position + 2 * _w, pivot_position + (2 + r_size / 4) * _w);
+                            swap(pivot_position + 3 * _w, pivot_position + (3 + r_size / 4) * _w);
+                            swap(end - 2 * _w,            end - (1 + r_size / 4) * _w);
+                            swap(end - 3 * _w,            end - (2 + r_size / 4) * _w);
+                        }
+                    }
+                }
+                else if (already_partitioned &&
+                    partial_insertion_sort(begin, pivot_position) &&
+                    partial_insertion_sort(pivot_position + _w, end))
+                {
+                    return;
+                }
+
+                if (l_size < r_size)
+                {
+                    sort_loop(begin, pivot_position, bad_allowed, leftmost);
+                    begin    = pivot_position + _w;
+                    leftmost = false;
+                }
+                else
+                {
+                    sort_loop(pivot_position + _w, end, bad_allowed, false);
+                    end = pivot_position;
+                }
+            }
+        }
+    };
+
+    template <typename Less>
+    void sort(char* const base, size_t const num, size_t const width, Less const& less) noexcept
+    {
+        switch (width)
+        {
+        case 4:  sorter<fixed_width<4>,  Less, true >(fixed_width<4>{},  less).sort(base, num); break;
+        case 8:  sorter<fixed_width<8>,  Less, true >(fixed_width<8>{},  less).sort(base, num); break;
+        case 16: sorter<fixed_width<16>, Less, true >(fixed_width<16>{}, less).sort(base, num); break;
+        default: sorter<any_width,       Less, false>(any_width{width},  less).sort(base, num); break;
+        }
+    }
+}
+#endif // _QSORT_PDQSORT_DEFINED
+
+
+
+extern "C"
+#ifdef __USE_CONTEXT
+void __fileDECL qsort_s_x64(
+    void* const base, size_t const num, size_t const width, int(__fileDECL* const comp)(void*, void const*, void const*), void* const context);
+#else
+    void __fileDECL qsort_x64(void* const base, size_t const num, size_t const width, int (__fileDECL* const comp)(void const*, void const*));
+#endif
+
+// QuickSort function for sorting arrays.  The array is sorted in place.
+// Parameters:
+//  * base:  Pointer to the initial element of the array
+//  * num:   Number of elements in the array
+//  * width: Width of each element in the array, in bytes
+//  * comp:  Pointer to a function returning analog of strcmp for strings, but
+//           supplied by the caller for comparing the array elements.  It
+//           accepts two pointers to elements; returns negative if 1 < 2;
+//           zero if 1 == 2, and positive if 1 > 2.
+#ifndef _M_CEE
+extern "C"
+DECLSPEC_GUARDNOCF
+#endif
+_CRT_SECURITYSAFECRITICAL_ATTRIBUTE
+#ifdef __USE_CONTEXT
+void __fileDECL CRT_ARM64X_X64_NAME(qsort_s) (
+    void*  const base,
+    size_t const num,
+    size_t const width,
+    int (__fileDECL* const comp)(void*, void const*, void const*),
+    void*  const context
+    )
+#else // __USE_CONTEXT
+void __fileDECL CRT_ARM64X_X64_NAME(qsort) (
+    void*  const base,
+    size_t const num,
+    size_t const width,
+    int (__fileDECL* const comp)(void const*, void const*)
+    )
+#endif // __USE_CONTEXT
+{
+#if defined(_M_ARM64EC) && _UCRT_DLL
+    // When ucrtbase.dll is Arm64EC and the caller is passing an x64 compare
+    // function, making an Arm64EC->x64 transition for each comparison incurs
+    // non-trivial overhead.  It is much more efficient to just call the pure
+    // x64 implementation instead.
+
+    if (!RtlIsEcCode((ULONG_PTR)comp))
+    {
+#ifdef __USE_CONTEXT
+        return qsort_s_x64(base, num, width, comp, context);
+#else
+        return qsort_x64(base, num, width, comp);
+#endif
+    }
+#endif // defined(_M_ARM64EC) && _UCRT_DLL
+
+    _VALIDATE_RETURN_VOID(base != nullptr || num == 0, EINVAL);
+    _VALIDATE_RETURN_VOID(width > 0, EINVAL);
+    _VALIDATE_RETURN_VOID(comp != nullptr, EINVAL);
+
+    _GUARD_CHECK_ICALL(comp);
+
+    if (num < 2)
+        return; // Nothing to do:
+
+    // Reentrancy diligence: Save (and unset) global-state mode to the stack before making callout to 'compare'
+    __crt_state_management::scoped_global_state_reset saved_state;
+
+#ifdef __USE_CONTEXT
+    auto const less = [comp, context](char const* const a, char const* const b)
+    {
+        return comp(context, a, b) < 0;
+    };
+#else
+    auto const less = [comp](char const* const a, char const* const b)
+    {
+        return comp(a, b) < 0;
+    };
+#endif
+
+    __crt_pdqsort::sort(static_cast<char*>(base), num, width, less);
+}
+
+
+
+#if !defined __USE_CONTEXT && !defined _CRT_ARM64X_X64_BUILD
+
+// Below this many keys the counting passes cost more than they save.
+#define RADIX_SORT_CUTOFF 512
+
+// LSD radix sort, a byte per pass.  A pass whose byte is the same in every key
+// is skipped.  Falls back to pdqsort for short arrays and when the scratch
+// buffer cannot be allocated.
+template <typename Key>
+static void __cdecl radix_sort(Key* const keys, size_t const num) noexcept
+{
+    auto const less = [](char const* const a, char const* const b)
+    {
+        Key x;
+        Key y;
+        memcpy(&x, a, sizeof(Key));
+        memcpy(&y, b, sizeof(Key));
+        return x < y;
+    };
+
+    if (num < RADIX_SORT_CUTOFF)
+    {
+        __crt_pdqsort::sorter<__crt_pdqsort::fixed_width<sizeof(Key)>, decltype(less), true, true>(
+            __crt_pdqsort::fixed_width<sizeof(Key)>{}, less).sort(reinterpret_cast<char*>(keys), num);
+        return;
+    }
+
+    size_t const counts_size = sizeof(Key) * 256 * sizeof(size_t);
+    __crt_unique_heap_ptr<unsigned char> const scratch(_malloc_crt_t(unsigned char, counts_size + num * sizeof(Key)));
+    if (!scratch)
+    {
+        __crt_pdqsort::sorter<__crt_pdqsort::fixed_width<sizeof(Key)>, decltype(less), true, true>(
+            __crt_pdqsort::fixed_width<sizeof(Key)>{}, less).sort(reinterpret_cast<char*>(keys), num);
+        return;
+    }
+
+    size_t* const counts = reinterpret_cast<size_t*>(scratch.get());
+    memset(counts, 0, counts_size);
+
+    for (size_t i = 0; i < num; ++i)
+    {
+        Key const key = keys[i];
+        for (size_t digit = 0; digit < sizeof(Key); ++digit)
+        {
+            ++counts[digit * 256 + static_cast<unsigned char>(key >> (digit * 8))];
+        }
+    }
+
+    Key* source      = keys;
+    Key* destination = reinterpret_cast<Key*>(scratch.get() + counts_size);
+    for (size_t digit = 0; digit < sizeof(Key); ++digit)
+    {
+        size_t* const digit_counts = counts + digit * 256;
+        unsigned const shift = static_cast<unsigned>(digit * 8);
+        if (digit_counts[static_cast<unsigned char>(source[0] >> shift)] == num)
+            continue;
+
+        size_t offset = 0;
+        for (size_t value = 0; value < 256; ++value)
+        {
+            size_t const n = digit_counts[value];
+            digit_counts[value] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < num; ++i)
+        {
+            Key const key = source[i];
+            destination[digit_counts[static_cast<unsigned char>(key >> shift)]++] = key;
+        }
+
+        Key* const sorted = destination;
+        destination = source;
+        source      = sorted;
+    }
+
+    if (source != keys)
+    {
+        memcpy(keys, source, num * sizeof(Key));
+    }
+}
+
+extern "C" void __cdecl qsort_u32(unsigned int* const base, size_t const num)
+{
+    _VALIDATE_RETURN_VOID(base != nullptr || num == 0, EINVAL);
+    if (num < 2)
+        return;
+
+    radix_sort(base, num);
+}
+
+extern "C" void __cdecl qsort_u64(unsigned long long* const base, size_t const num)
+{
+    _VALIDATE_RETURN_VOID(base != nullptr || num == 0, EINVAL);
+    if (num < 2)
+        return;
+
+    radix_sort(base, num);
+}
+
+#endif // !__USE_CONTEXT && !_CRT_ARM64X_X64_BUILD
+
+END_PRAGMA_OPTIMIZE()
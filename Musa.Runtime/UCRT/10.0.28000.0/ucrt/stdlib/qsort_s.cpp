@@ -0,0 +1,13 @@
+//
+// qsort_s.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Defines _qsort_s(), a routine for sorting arrays.
+//
+#ifdef __USE_CONTEXT
+    #error __USE_CONTEXT should be undefined
+#endif
+
+#define __USE_CONTEXT
+#include "qsort.cpp"
@@ -0,0 +1,336 @@
+//
+// rand_s.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// The implementation of the rand_s() function, which generates random numbers.
+//
+// Musa: rand_s and rand_s_bytes draw from a ChaCha20 generator per processor,
+// keyed and periodically reseeded from the system RNG.  See kext/krand.h.
+//
+// A request raises to DISPATCH_LEVEL, so that it has the current processor's
+// generator to itself, takes at most ChunkSize bytes into a stack buffer, and
+// lowers again before copying them out.  When the generator needs fresh seed
+// material the request lowers, reads the system RNG at the caller's IRQL and
+// starts over; the seed is mixed into whichever generator it lands on.
+//
+#include <corecrt_internal.h>
+#include <corecrt_internal_random.h>
+#include <stdlib.h>
+
+
+
+namespace
+{
+    constexpr ULONG  RandomPoolTag = 'RsuM';
+    constexpr size_t BlockSize     = 64;
+    constexpr size_t KeySize       = 32;
+    constexpr size_t BufferSize    = 16 * BlockSize;
+    constexpr size_t ChunkSize     = 256;
+
+    struct alignas(SYSTEM_CACHE_ALIGNMENT_SIZE) RandomGenerator
+    {
+        unsigned char buffer[BufferSize]; // keystream; the last 'available' bytes are unused
+        uint32_t      key[KeySize / sizeof(uint32_t)];
+        size_t        available;
+        size_t        output_since_reseed;
+        long          generation;         // of the last reseed; 0 if never seeded
+    };
+
+    struct RandomPool
+    {
+        ULONG           processors;
+        RandomGenerator generators[1];    // [processors]
+    };
+}
+
+static void* volatile  random_pool            = nullptr; // RandomPool*
+static long volatile   random_pool_generation = 1;
+static size_t volatile random_reseed_interval = KRAND_DEFAULT_RESEED_INTERVAL;
+
+
+
+static __forceinline void quarter_round(uint32_t (&x)[16], int const a, int const b, int const c, int const d) noexcept
+{
+    x[a] += x[b]; x[d] = _rotl(x[d] ^ x[a], 16);
+    x[c] += x[d]; x[b] = _rotl(x[b] ^ x[c], 12);
+    x[a] += x[b]; x[d] = _rotl(x[d] ^ x[a],  8);
+    x[c] += x[d]; x[b] = _rotl(x[b] ^ x[c],  7);
+}
+
+// One ChaCha20 block: key, a 64-bit block counter and a zero nonce.  Every key
+// is used for a single refill, so the nonce never has to change.
+static void __cdecl chacha20_block(
+    uint32_t const (&key)[8],
+    uint64_t const   counter,
+    unsigned char*   output
+    ) noexcept
+{
+    uint32_t const input[16] = {
+        0x61707865, 0x3320646E, 0x79622D32, 0x6B206574, // "expand 32-byte k"
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0, 0,
+    };
+
+    uint32_t x[16];
+    memcpy(x, input, sizeof(x));
+
+    for (int round = 0; round < 20; round += 2)
+    {
+        quarter_round(x, 0, 4,  8, 12);
+        quarter_round(x, 1, 5,  9, 13);
+        quarter_round(x, 2, 6, 10, 14);
+        quarter_round(x, 3, 7, 11, 15);
+        quarter_round(x, 0, 5, 10, 15);
+        quarter_round(x, 1, 6, 11, 12);
+        quarter_round(x, 2, 7,  8, 13);
+        quarter_round(x, 3, 4,  9, 14);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        x[i] += input[i]; // little endian on every supported target
+    }
+
+    memcpy(output, x, BlockSize);
+    RtlSecureZeroMemory(x, sizeof(x));
+}
+
+// Fills the buffer with keystream and takes the next key from its start.
+static void __cdecl refill(RandomGenerator& generator) noexcept
+{
+    for (size_t block = 0; block < BufferSize / BlockSize; ++block)
+    {
+        chacha20_block(generator.key, block, generator.buffer + block * BlockSize);
+    }
+
+    memcpy(generator.key, generator.buffer, KeySize);
+    RtlSecureZeroMemory(generator.buffer, KeySize);
+    generator.available = BufferSize - KeySize;
+}
+
+static void __cdecl reseed(RandomGenerator& generator, unsigned char const (&seed)[KeySize], long const generation) noexcept
+{
+    unsigned char const* const bytes = seed;
+    for (size_t i = 0; i < _countof(generator.key); ++i)
+    {
+        uint32_t word;
+        memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+        generator.key[i] ^= word;
+    }
+
+    refill(generator);
+    generator.output_since_reseed = 0;
+    generator.generation          = generation;
+}
+
+static void __cdecl take(RandomGenerator& generator, unsigned char* const output, size_t const count) noexcept
+{
+    size_t done = 0;
+    while (done != count)
+    {
+        if (generator.available == 0)
+        {
+            refill(generator);
+        }
+
+        size_t const n = generator.available < count - done ? generator.available : count - done;
+        unsigned char* const source = generator.buffer + BufferSize - generator.available;
+        memcpy(output + done, source, n);
+        RtlSecureZeroMemory(source, n);
+
+        generator.available -= n;
+        done                += n;
+    }
+
+    generator.output_since_reseed += count;
+}
+
+
+
+static bool __cdecl system_random(void* const buffer, size_t const count) noexcept
+{
+    unsigned char* it        = static_cast<unsigned char*>(buffer);
+    size_t         remaining = count;
+    while (remaining != 0)
+    {
+        ULONG const n = remaining < MAXULONG ? static_cast<ULONG>(remaining) : MAXULONG;
+        if (!__acrt_RtlGenRandom(it, n))
+        {
+            return false;
+        }
+
+        it        += n;
+        remaining -= n;
+    }
+
+    return true;
+}
+
+static RandomPool* __cdecl get_random_pool() noexcept
+{
+    RandomPool* pool = static_cast<RandomPool*>(ReadPointerAcquire(&random_pool));
+    if (pool != nullptr)
+    {
+        return pool;
+    }
+
+    ULONG const processors = KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+    size_t const size = FIELD_OFFSET(RandomPool, generators) + processors * sizeof(RandomGenerator);
+
+    #pragma warning(suppress: 4996)
+    pool = static_cast<RandomPool*>(ExAllocatePoolWithTag(NonPagedPoolNxCacheAligned, size, RandomPoolTag));
+    if (pool == nullptr)
+    {
+        return nullptr;
+    }
+
+    memset(pool, 0, size);
+    pool->processors = processors;
+
+    void* const existing = InterlockedCompareExchangePointer(&random_pool, pool, nullptr);
+    if (existing != nullptr)
+    {
+        ExFreePoolWithTag(pool, RandomPoolTag);
+        return static_cast<RandomPool*>(existing);
+    }
+
+    return pool;
+}
+
+// Produces count <= ChunkSize bytes into output, which must be resident.
+static bool __cdecl generate(unsigned char* const output, size_t const count) noexcept
+{
+    size_t const interval = random_reseed_interval;
+    RandomPool* const pool = interval != 0 ? get_random_pool() : nullptr;
+    if (pool == nullptr)
+    {
+        return system_random(output, count);
+    }
+
+    unsigned char seed[KeySize];
+    bool seeded = false;
+    for (;;)
+    {
+        KIRQL previous_irql;
+        KeRaiseIrql(DISPATCH_LEVEL, &previous_irql);
+
+        ULONG const processor = KeGetCurrentProcessorNumberEx(nullptr);
+        if (processor >= pool->processors)
+        {
+            KeLowerIrql(previous_irql);
+            return system_random(output, count);
+        }
+
+        RandomGenerator& generator = pool->generators[processor];
+        long const generation = ReadAcquire(&random_pool_generation);
+        bool const stale = generator.generation != generation || generator.output_since_reseed >= interval;
+        if (stale && !seeded)
+        {
+            KeLowerIrql(previous_irql);
+            if (!system_random(seed, sizeof(seed)))
+            {
+                return false;
+            }
+
+            seeded = true;
+            continue;
+        }
+
+        if (seeded)
+        {
+            reseed(generator, seed, generation);
+        }
+
+        take(generator, output, count);
+        KeLowerIrql(previous_irql);
+
+        if (seeded)
+        {
+            RtlSecureZeroMemory(seed, sizeof(seed));
+        }
+        return true;
+    }
+}
+
+
+
+extern "C" errno_t __cdecl rand_s_bytes(void* const buffer, size_t const count)
+{
+    _VALIDATE_RETURN_ERRCODE(buffer != nullptr || count == 0, EINVAL);
+
+    // Musa: Neither the generators nor the system RNG can be used above
+    // DISPATCH_LEVEL.
+    if (KeGetCurrentIrql() > DISPATCH_LEVEL)
+        return EINVAL;
+
+    unsigned char* it        = static_cast<unsigned char*>(buffer);
+    size_t         remaining = count;
+
+    unsigned char chunk[ChunkSize];
+    while (remaining != 0)
+    {
+        size_t const n = remaining < ChunkSize ? remaining : ChunkSize;
+        if (!generate(chunk, n))
+        {
+            RtlSecureZeroMemory(buffer, count);
+            errno = ENOMEM;
+            return errno;
+        }
+
+        memcpy(it, chunk, n);
+        it        += n;
+        remaining -= n;
+    }
+
+    RtlSecureZeroMemory(chunk, sizeof(chunk));
+    return 0;
+}
+
+extern "C" errno_t __cdecl rand_s(unsigned int* const result)
+{
+    _VALIDATE_RETURN_ERRCODE(result != nullptr, EINVAL);
+    *result = 0;
+
+    if (KeGetCurrentIrql() > DISPATCH_LEVEL)
+        return EINVAL;
+
+    // Musa: From the buffered generator rather than one system RNG call per
+    // value.
+    unsigned char bytes[sizeof(*result)];
+    if (!generate(bytes, sizeof(bytes)))
+    {
+        errno = ENOMEM;
+        return errno;
+    }
+
+    memcpy(result, bytes, sizeof(*result));
+    RtlSecureZeroMemory(bytes, sizeof(bytes));
+    return 0;
+}
+
+extern "C" size_t __cdecl krand_set_reseed_interval(size_t const bytes)
+{
+    return static_cast<size_t>(InterlockedExchangeSizeT(&random_reseed_interval, bytes));
+}
+
+extern "C" void __cdecl krand_reseed()
+{
+    if (InterlockedIncrement(&random_pool_generation) == 0)
+    {
+        // 0 marks a generator that has never been seeded.
+        InterlockedIncrement(&random_pool_generation);
+    }
+}
+
+extern "C" bool __cdecl __acrt_uninitialize_random_pool(bool const /* terminating */)
+{
+    RandomPool* const pool = static_cast<RandomPool*>(InterlockedExchangePointer(&random_pool, nullptr));
+    if (pool != nullptr)
+    {
+        RtlSecureZeroMemory(pool, FIELD_OFFSET(RandomPool, generators) + pool->processors * sizeof(RandomGenerator));
+        ExFreePoolWithTag(pool, RandomPoolTag);
+    }
+
+    return true;
+}
@@ -0,0 +1,411 @@
+//
+// static_search.cpp
+//
+// Musa: Static search tables.  See kext/ksearch.h.
+//
+// The S+ trees follow "Static B-Trees" (Sergey Slotin, Algorithms for Modern
+// Hardware): layers of B-key nodes stored bottom up, the lowest layer being
+// the sorted keys padded to whole nodes, and each key of a higher layer the
+// smallest key of the subtree to its right.  A lookup counts the keys of a
+// node that are less than the key, which picks the child, and the count in
+// the last node is added to the leaf's position to give the rank.  Keys are
+// stored with the sign bit flipped so that the signed SIMD compares order them
+// as unsigned; padding is the largest key, which is never less than a key.
+//
+// The Eytzinger table stores the elements in the order of a breadth-first walk
+// of the balanced binary search tree over them: the children of element k are
+// 2k and 2k + 1 (k from 1).  A lookup descends by k = 2k + (key > element) and
+// recovers the lower bound by dropping the trailing right turns.
+//
+#include <corecrt_internal.h>
+#include <search.h>
+#include <cfguard.h>
+#include <string.h>
+#include "kext/ksearch.h"
+
+#if defined _M_X64
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined _M_ARM64
+#include <arm_neon.h>
+#endif
+
+
+
+namespace __crt_static_search
+{
+    constexpr size_t NodeSize      = 64;
+    constexpr size_t MaximumHeight = 32;
+
+    template <typename Key>
+    struct stree
+    {
+        static constexpr size_t B = NodeSize / sizeof(Key);
+
+        size_t num;
+        size_t height;
+        size_t offsets[MaximumHeight];  // of each layer, in keys; [height] is the total
+        Key*   keys;                    // NodeSize-aligned, biased
+    };
+
+    template <typename Key>
+    constexpr Key bias(Key const key) noexcept
+    {
+        return key ^ (static_cast<Key>(1) << (sizeof(Key) * 8 - 1));
+    }
+
+    inline unsigned long trailing_zeroes(unsigned long long const value) noexcept
+    {
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return index;
+    }
+
+    // The number of keys in a node that are less than the (biased) key.  The
+    // keys of a node are sorted, so the lanes that compare less form a prefix.
+    inline size_t node_rank(unsigned int const* const node, unsigned int const key) noexcept
+    {
+    #if defined _M_X64
+        __m128i const x  = _mm_set1_epi32(static_cast<int>(key));
+        __m128i const m0 = _mm_cmpgt_epi32(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 0));
+        __m128i const m1 = _mm_cmpgt_epi32(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 1));
+        __m128i const m2 = _mm_cmpgt_epi32(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 2));
+        __m128i const m3 = _mm_cmpgt_epi32(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 3));
+        unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_packs_epi16(_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m3))));
+        return trailing_zeroes(~static_cast<unsigned long long>(mask));
+    #elif defined _M_ARM64
+        int32x4_t const x = vdupq_n_s32(static_cast<int32_t>(key));
+        int32_t const* const n = reinterpret_cast<int32_t const*>(node);
+        int32x4_t const sum = vaddq_s32(
+            vaddq_s32(vreinterpretq_s32_u32(vcltq_s32(vld1q_s32(n + 0), x)), vreinterpretq_s32_u32(vcltq_s32(vld1q_s32(n + 4), x))),
+            vaddq_s32(vreinterpretq_s32_u32(vcltq_s32(vld1q_s32(n + 8), x)), vreinterpretq_s32_u32(vcltq_s32(vld1q_s32(n + 12), x))));
+        return static_cast<size_t>(-vaddvq_s32(sum));
+    #else
+        size_t rank = 0;
+        for (size_t i = 0; i < stree<unsigned int>::B; ++i)
+        {
+            rank += static_cast<int>(node[i]) < static_cast<int>(key);
+        }
+        return rank;
+    #endif
+    }
+
+#if defined _M_X64
+    long sse42_state = -1; // -1 until checked, then 0 or 1
+
+    bool sse42_available() noexcept
+    {
+        long state = ReadNoFence(&sse42_state);
+        if (state < 0)
+        {
+            int registers[4];
+            __cpuid(registers, 1);
+            state = (registers[2] & (1 << 20)) != 0;
+            WriteNoFence(&sse42_state, state);
+        }
+        return state != 0;
+    }
+#endif
+
+    inline size_t node_rank(unsigned long long const* const node, unsigned long long const key) noexcept
+    {
+    #if defined _M_ARM64
+        int64x2_t const x = vdupq_n_s64(static_cast<int64_t>(key));
+        int64_t const* const n = reinterpret_cast<int64_t const*>(node);
+        int64x2_t const sum = vaddq_s64(
+            vaddq_s64(vreinterpretq_s64_u64(vcltq_s64(vld1q_s64(n + 0), x)), vreinterpretq_s64_u64(vcltq_s64(vld1q_s64(n + 2), x))),
+            vaddq_s64(vreinterpretq_s64_u64(vcltq_s64(vld1q_s64(n + 4), x)), vreinterpretq_s64_u64(vcltq_s64(vld1q_s64(n + 6), x))));
+        return static_cast<size_t>(-vaddvq_s64(sum));
+    #else
+    #if defined _M_X64
+        if (sse42_available())
+        {
+            __m128i const x  = _mm_set1_epi64x(static_cast<long long>(key));
+            __m128i const m0 = _mm_cmpgt_epi64(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 0));
+            __m128i const m1 = _mm_cmpgt_epi64(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 1));
+            __m128i const m2 = _mm_cmpgt_epi64(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 2));
+            __m128i const m3 = _mm_cmpgt_epi64(x, _mm_load_si128(reinterpret_cast<__m128i const*>(node) + 3));
+            unsigned const mask =
+                static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m0)))       |
+                static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m1))) << 2  |
+                static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m2))) << 4  |
+                static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m3))) << 6;
+            return trailing_zeroes(~static_cast<unsigned long long>(mask));
+        }
+    #endif
+        size_t rank = 0;
+        for (size_t i = 0; i < stree<unsigned long long>::B; ++i)
+        {
+            rank += static_cast<long long>(node[i]) < static_cast<long long>(key);
+        }
+        return rank;
+    #endif
+    }
+
+    template <typename Key>
+    size_t lower_bound(stree<Key> const& tree, Key const key) noexcept
+    {
+        constexpr size_t B = stree<Key>::B;
+        Key const biased = bias(key);
+
+        size_t k = 0; // first key of the current node
+        for (size_t h = tree.height - 1; h != 0; --h)
+        {
+            size_t const i = node_rank(tree.keys + tree.offsets[h] + k, biased);
+            k = k * (B + 1) + i * B;
+        }
+
+        size_t const rank = k + node_rank(tree.keys + k, biased);
+        return rank < tree.num ? rank : tree.num;
+    }
+
+    // Allocates a T followed by a NodeSize-aligned array of count Elements.
+    template <typename T, typename Element>
+    T* allocate_with_array(size_t const count, Element*& array) noexcept
+    {
+        size_t const header_size = (sizeof(T) + NodeSize - 1) & ~(NodeSize - 1);
+        if (count > (_HEAP_MAXREQ - header_size - NodeSize) / sizeof(Element))
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        unsigned char* const block = static_cast<unsigned char*>(_malloc_crt(header_size + NodeSize + count * sizeof(Element)));
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+
+        uintptr_t const start = (reinterpret_cast<uintptr_t>(block) + header_size + NodeSize - 1) & ~static_cast<uintptr_t>(NodeSize - 1);
+        array = reinterpret_cast<Element*>(start);
+        return reinterpret_cast<T*>(block);
+    }
+
+    template <typename Tree, typename Key>
+    Tree* build(Key const* const sorted, size_t const num) noexcept
+    {
+        using tree_type = stree<Key>;
+        constexpr size_t B = tree_type::B;
+        Key const infinity = bias(static_cast<Key>(~static_cast<Key>(0)));
+
+        // Layer sizes, bottom up: each layer has a key for every node of the
+        // layer below but the first, rounded up to whole nodes.
+        size_t offsets[MaximumHeight + 1];
+        size_t height = 0;
+        size_t layer  = num == 0 ? 1 : num;
+        offsets[0] = 0;
+        for (;;)
+        {
+            size_t const nodes = (layer + B - 1) / B;
+            offsets[height + 1] = offsets[height] + nodes * B;
+            ++height;
+            if (layer <= B)
+                break;
+
+            layer = (nodes + B) / (B + 1) * B;
+        }
+
+        Key* keys;
+        Tree* const table = allocate_with_array<Tree>(offsets[height], keys);
+        if (table == nullptr)
+        {
+            return nullptr;
+        }
+
+        tree_type& tree = table->tree;
+        tree.num    = num;
+        tree.height = height;
+        tree.keys   = keys;
+        memcpy(tree.offsets, offsets, sizeof(tree.offsets));
+
+        for (size_t i = 0; i < num; ++i)
+        {
+            keys[i] = bias(sorted[i]);
+        }
+
+        for (size_t i = num; i < offsets[1]; ++i)
+        {
+            keys[i] = infinity;
+        }
+
+        for (size_t h = 1; h < height; ++h)
+        {
+            for (size_t i = 0; i < offsets[h + 1] - offsets[h]; ++i)
+            {
+                // The leftmost leaf of the subtree right of key i.
+                size_t k = i / B;
+                k = k * (B + 1) + (i - k * B) + 1;
+                for (size_t l = 1; l < h; ++l)
+                {
+                    k *= B + 1;
+                }
+
+                keys[offsets[h] + i] = k * B < num ? keys[k * B] : infinity;
+            }
+        }
+
+        return table;
+    }
+}
+
+struct ksearch_u32
+{
+    __crt_static_search::stree<unsigned int> tree;
+};
+
+struct ksearch_u64
+{
+    __crt_static_search::stree<unsigned long long> tree;
+};
+
+struct ksearch_table
+{
+    size_t         num;
+    size_t         width;
+    unsigned char* elements; // element k (1 to num) at elements + k * width
+};
+
+
+
+extern "C" ksearch_u32* __cdecl ksearch_u32_build(unsigned int const* const sorted, size_t const num)
+{
+    _VALIDATE_RETURN(sorted != nullptr || num == 0, EINVAL, nullptr);
+    return __crt_static_search::build<ksearch_u32>(sorted, num);
+}
+
+extern "C" size_t __cdecl ksearch_u32_lower_bound(ksearch_u32 const* const table, unsigned int const key)
+{
+    return __crt_static_search::lower_bound(table->tree, key);
+}
+
+extern "C" void __cdecl ksearch_u32_free(ksearch_u32* const table)
+{
+    _free_crt(table);
+}
+
+extern "C" ksearch_u64* __cdecl ksearch_u64_build(unsigned long long const* const sorted, size_t const num)
+{
+    _VALIDATE_RETURN(sorted != nullptr || num == 0, EINVAL, nullptr);
+    return __crt_static_search::build<ksearch_u64>(sorted, num);
+}
+
+extern "C" size_t __cdecl ksearch_u64_lower_bound(ksearch_u64 const* const table, unsigned long long const key)
+{
+    return __crt_static_search::lower_bound(table->tree, key);
+}
+
+extern "C" void __cdecl ksearch_u64_free(ksearch_u64* const table)
+{
+    _free_crt(table);
+}
+
+
+
+// Copies the sorted elements into the subtree rooted at k, in order; returns
+// the index of the next element to place.
+static size_t __cdecl fill_eytzinger(
+    ksearch_table&       table,
+    unsigned char const* sorted,
+    size_t               next,
+    size_t const         k
+    ) noexcept
+{
+    if (k <= table.num)
+    {
+        next = fill_eytzinger(table, sorted, next, 2 * k);
+        memcpy(table.elements + k * table.width, sorted + next * table.width, table.width);
+        next = fill_eytzinger(table, sorted, next + 1, 2 * k + 1);
+    }
+
+    return next;
+}
+
+extern "C" ksearch_table* __cdecl ksearch_table_build(void const* const sorted, size_t const num, size_t const width)
+{
+    _VALIDATE_RETURN(sorted != nullptr || num == 0, EINVAL, nullptr);
+    _VALIDATE_RETURN(width > 0, EINVAL, nullptr);
+
+    if (num >= _HEAP_MAXREQ / width)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    unsigned char* elements;
+    ksearch_table* const table = __crt_static_search::allocate_with_array<ksearch_table>((num + 1) * width, elements);
+    if (table == nullptr)
+    {
+        return nullptr;
+    }
+
+    table->num      = num;
+    table->width    = width;
+    table->elements = elements;
+    fill_eytzinger(*table, static_cast<unsigned char const*>(sorted), 0, 1);
+    return table;
+}
+
+extern "C"
+DECLSPEC_GUARDNOCF
+void const* __cdecl ksearch_table_lower_bound(
+    ksearch_table const* const table,
+    void const*          const key,
+    int (__cdecl*        const compare)(void const*, void const*)
+    )
+{
+    _VALIDATE_RETURN(compare != nullptr, EINVAL, nullptr);
+
+    _GUARD_CHECK_ICALL(compare);
+
+    __crt_state_management::scoped_global_state_reset saved_state;
+
+    size_t const num = table->num;
+    size_t const width = table->width;
+    unsigned char const* const elements = table->elements;
+
+    size_t k = 1;
+    while (k <= num)
+    {
+        // The sixteen descendants four levels down are adjacent.
+        if (16 * k <= num)
+        {
+        #if defined _M_X64
+            _mm_prefetch(reinterpret_cast<char const*>(elements + 16 * k * width), _MM_HINT_T0);
+        #elif defined _M_ARM64
+            __prefetch(elements + 16 * k * width);
+        #endif
+        }
+
+        k = 2 * k + (compare(key, elements + k * width) > 0);
+    }
+
+    // Undo the right turns taken after the last left turn, then that turn.
+    k >>= __crt_static_search::trailing_zeroes(~static_cast<unsigned long long>(k)) + 1;
+    return k != 0 ? elements + k * width : nullptr;
+}
+
+extern "C"
+DECLSPEC_GUARDNOCF
+void const* __cdecl ksearch_table_find(
+    ksearch_table const* const table,
+    void const*          const key,
+    int (__cdecl*        const compare)(void const*, void const*)
+    )
+{
+    void const* const element = ksearch_table_lower_bound(table, key, compare);
+    if (element == nullptr)
+    {
+        return nullptr;
+    }
+
+    _GUARD_CHECK_ICALL(compare);
+
+    __crt_state_management::scoped_global_state_reset saved_state;
+    return compare(key, element) == 0 ? element : nullptr;
+}
+
+extern "C" void __cdecl ksearch_table_free(ksearch_table* const table)
+{
+    _free_crt(table);
+}
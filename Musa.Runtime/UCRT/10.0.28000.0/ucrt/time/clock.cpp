@@ -0,0 +1,56 @@
+//
+// clock.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// The clock() function, which calculates the amount of elapsed time since the
+// process started execution.
+//
+// Musa: Measured with kclock_monotonic.  See kext/kclock.h.
+//
+#include <corecrt_internal_time.h>
+#include <sys\timeb.h>
+#include <sys\types.h>
+#include "kext/kclock.h"
+
+
+
+// The monotonic clock at process startup, in nanoseconds.
+static long long start_count;
+
+
+
+// This function initializes the global start_count variable when the CRT is
+// initialized.  This initializer always runs in the CRT DLL; it only runs in
+// the static CRT if this object file is linked into the module, which will only
+// happen if some user code calls clock().
+extern "C" int __cdecl __acrt_initialize_clock()
+{
+    start_count = kclock_monotonic();
+    return 0;
+}
+
+_CRT_LINKER_FORCE_INCLUDE(__acrt_clock_initializer);
+
+// Calculates and returns the amount of elapsed time since the process started
+// execution.  During CRT initialization, the 'start_count' global variable is
+// initialized to the current tick count; subsequent calls to clock() get the
+// new tick count and subtract the 'start_count' from it.
+//
+// The return value is the number of CLK_TCKs that have elapsed (milliseconds).
+// On failure, -1 is returned.
+extern "C" clock_t __cdecl clock()
+{
+    long long const result = kclock_monotonic() - start_count;
+    if (result < 0)
+        return -1;
+
+    long long const scaled_result = result / (1000 * 1000 * 1000 / CLOCKS_PER_SEC);
+
+    // Per C11 7.27.2.1 ("The clock function")/3, "If the processor time used...
+    // cannot be represented, the function returns the value (clock_t)(-1)."
+    if (scaled_result > LONG_MAX)
+        return -1;
+
+    return static_cast<clock_t>(scaled_result);
+}
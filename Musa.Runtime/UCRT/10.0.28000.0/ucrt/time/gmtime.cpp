@@ -0,0 +1,173 @@
+//
+// gmtime.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// The gmtime() family of functions, which converts a time_t value into a tm
+// structure in UTC.
+//
+// Musa: The date is computed arithmetically, without loops over years or
+// months.
+//
+#include <corecrt_internal_time.h>
+
+
+
+// Musa: Converts a count of days since 1970-01-01 into a civil date, without
+// loops or tables (the days_from_civil inverse of H. Hinnant's "chrono-
+// Compatible Low-Level Date Algorithms").  Years are counted from March, so
+// that the leap day falls at the end of the year; days must be at least
+// -719468 (0000-03-01).
+namespace
+{
+    struct civil_date
+    {
+        int year;  // years since 1900
+        int yday;  // days since January 1 (0 - 365)
+        int mon;   // months since January (0 - 11)
+        int mday;  // day of the month (1 - 31)
+    };
+}
+
+static civil_date __cdecl civil_from_days(long long const days) throw()
+{
+    unsigned long long const z   = static_cast<unsigned long long>(days + 719468);
+    unsigned const           era = static_cast<unsigned>(z / 146097);
+    unsigned const           doe = static_cast<unsigned>(z - era * 146097ull);          // [0, 146096]
+    unsigned const           yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+    unsigned const           doy = doe - (365 * yoe + yoe / 4 - yoe / 100);           // [0, 365], from March 1
+    unsigned const           mp  = (5 * doy + 2) / 153;                               // [0, 11], from March
+
+    civil_date date;
+    date.mday = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    date.mon  = static_cast<int>(mp < 10 ? mp + 2 : mp - 10);
+    date.year = static_cast<int>(yoe + era * 400 + (mp >= 10)) - 1900;
+
+    // January and February end the March-based year; March through December
+    // follow the January and February of the civil year:
+    date.yday = mp >= 10
+        ? static_cast<int>(doy) - 306
+        : static_cast<int>(doy) + 59 + (__crt_time_is_leap_year(date.year) ? 1 : 0);
+
+    return date;
+}
+
+
+
+// Converts a time_t value into a tm structure in UTC.  Stores the tm structure
+// into the '*ptm' buffer. Returns zero on success; returns an error code on
+// failure
+template <typename TimeType>
+static errno_t __cdecl common_gmtime_s(tm* const ptm, TimeType const* const timp) throw()
+{
+    typedef __crt_time_time_t_traits<__time64_t> time_traits;
+
+    _VALIDATE_RETURN_ERRCODE(ptm != nullptr, EINVAL)
+    memset(ptm, 0xff, sizeof(tm));
+
+    _VALIDATE_RETURN_ERRCODE(timp != nullptr, EINVAL);
+    TimeType const caltim = *timp;
+
+    _VALIDATE_RETURN_ERRCODE_NOEXC(caltim >= _MIN_LOCAL_TIME, EINVAL)
+
+    // Upper bound check only necessary for _gmtime64_s (it's > LONG_MAX).
+    // For _gmtime32_s, any positive number is within range (<= LONG_MAX).
+    _VALIDATE_RETURN_ERRCODE_NOEXC(caltim <= time_traits::max_time_t + _MAX_LOCAL_TIME, EINVAL)
+
+    // Musa: Split the time into days and seconds of the day, rounding toward
+    // negative infinity, and convert the days directly:
+    __time64_t const time = caltim;
+    __time64_t days = time / _DAY_SEC;
+    int seconds = static_cast<int>(time - days * _DAY_SEC);
+    if (seconds < 0)
+    {
+        seconds += _DAY_SEC;
+        --days;
+    }
+
+    civil_date const date = civil_from_days(days);
+    ptm->tm_year = date.year;
+    ptm->tm_yday = date.yday;
+    ptm->tm_mon  = date.mon;
+    ptm->tm_mday = date.mday;
+
+    // Determine days since Sunday (0 - 6)
+    ptm->tm_wday = static_cast<int>((days + _BASE_DOW + 7) % 7);
+
+    // Determine hours since midnight (0 - 23), minutes after the hour
+    // (0 - 59), and seconds after the minute (0 - 59).
+    ptm->tm_hour = seconds / 3600;
+    seconds -= ptm->tm_hour * 3600;
+
+    ptm->tm_min = seconds / 60;
+    ptm->tm_sec = seconds - ptm->tm_min * 60;
+
+    ptm->tm_isdst = 0;
+    return 0;
+}
+
+extern "C" errno_t __cdecl _gmtime32_s(tm* const result, __time32_t const* const time_value)
+{
+    return common_gmtime_s(result, time_value);
+}
+
+extern "C" errno_t __cdecl _gmtime64_s(tm* const result, __time64_t const* const time_value)
+{
+    return common_gmtime_s(result, time_value);
+}
+
+
+
+// Gets the thread-local buffer to be used by gmtime.  Returns a pointer to the
+// buffer on success; returns null and sets errno on failure.
+extern "C" tm* __cdecl __getgmtimebuf()
+{
+    __acrt_ptd* const ptd = __acrt_getptd_noexit();
+    if (ptd == nullptr)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    if (ptd->_gmtime_buffer != nullptr)
+    {
+        return ptd->_gmtime_buffer;
+    }
+
+    ptd->_gmtime_buffer = _malloc_crt_t(tm, 1).detach();
+    if (ptd->_gmtime_buffer == nullptr)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    return ptd->_gmtime_buffer;
+}
+
+
+// Converts a time_t value into a tm structure in UTC.  Returns a pointer to a
+// thread-local buffer containing the tm structure on success; returns null on
+// failure.
+template <typename TimeType>
+_Success_(return != 0)
+static tm* __cdecl common_gmtime(TimeType const* const time_value) throw()
+{
+    tm* const ptm = __getgmtimebuf();
+    if (ptm == nullptr)
+        return nullptr;
+
+    if (common_gmtime_s(ptm, time_value) != 0)
+        return nullptr;
+
+    return ptm;
+}
+
+extern "C" tm* __cdecl _gmtime32(__time32_t const* const time_value)
+{
+    return common_gmtime(time_value);
+}
+
+extern "C" tm* __cdecl _gmtime64(__time64_t const* const time_value)
+{
+    return common_gmtime(time_value);
+}
@@ -0,0 +1,350 @@
+//
+// strftime.cpp
+//
+//      Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// The strftime family of functions, which format time data into a string, and
+// related functionality.
+//
+// Musa: Numeric ISO 8601 and RFC 3339 style formats are expanded directly into
+// the caller's buffer, without the wide character round trip.
+//
+#include <corecrt_internal_time.h>
+#include <locale.h>
+
+//-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// Day and Month Name and Time Locale Information Fetching Functions
+//
+//-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+extern "C" char* __cdecl _Getdays_l(_locale_t const locale)
+{
+    _LocaleUpdate locale_update(locale);
+    __crt_lc_time_data const* const time_data = locale_update.GetLocaleT()->locinfo->lc_time_curr;
+
+    size_t length = 0;
+    for (size_t n = 0; n < 7; ++n)
+    {
+        length += strlen(time_data->wday_abbr[n]) + strlen(time_data->wday[n]) + 2;
+    }
+
+    __crt_unique_heap_ptr<char> buffer(_malloc_crt_t(char, length + 1));
+    if (buffer.get() == nullptr)
+        return nullptr;
+
+
+    char* it = buffer.get();
+    for (size_t n = 0; n < 7; ++n)
+    {
+        *it++ = ':';
+        _ERRCHECK(strcpy_s(it, (length + 1) - (it - buffer.get()), time_data->wday_abbr[n]));
+        it += strlen(it);
+        *it++ = ':';
+        _ERRCHECK(strcpy_s(it, (length + 1) - (it - buffer.get()), time_data->wday[n]));
+        it += strlen(it);
+    }
+    *it++ = '\0';
+
+    return buffer.detach();
+}
+
+extern "C" char* __cdecl _Getdays()
+{
+    return _Getdays_l(nullptr);
+}
+
+
+
+extern "C" char* __cdecl _Getmonths_l(_locale_t const locale)
+{
+    _LocaleUpdate locale_update(locale);
+    __crt_lc_time_data const* time_data = locale_update.GetLocaleT()->locinfo->lc_time_curr;
+
+    size_t length = 0;
+    for (size_t n = 0; n < 12; ++n)
+    {
+        length += strlen(time_data->month_abbr[n]) + strlen(time_data->month[n]) + 2;
+    }
+
+    __crt_unique_heap_ptr<char> buffer(_malloc_crt_t(char, length + 1));
+    if (buffer.get() == nullptr)
+        return nullptr;
+
+    char* it = buffer.get();
+    for (size_t n = 0; n < 12; ++n)
+    {
+        *it++ = ':';
+        _ERRCHECK(strcpy_s(it, (length + 1) - (it - buffer.get()), time_data->month_abbr[n]));
+        it += strlen(it);
+        *it++ = ':';
+        _ERRCHECK(strcpy_s(it, (length + 1) - (it - buffer.get()), time_data->month[n]));
+        it += strlen(it);
+    }
+    *it++ = '\0';
+
+    return buffer.detach();
+}
+
+
+
+extern "C" char* __cdecl _Getmonths()
+{
+    return _Getmonths_l(nullptr);
+}
+
+extern "C" void* __cdecl _W_Gettnames();
+
+extern "C" void* __cdecl _Gettnames()
+{
+    return _W_Gettnames();
+}
+
+
+
+//-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// The strftime family of functions
+//
+//-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// Musa: Formats made up only of the %Y, %m, %d, %H, %M, %S, %F, %T, %z and %%
+// directives and of ASCII text are expanded by try_strftime_numeric, directly
+// into the caller's buffer.  None of these directives depends on the locale,
+// and ASCII text is the same in every code page, so the result is the one the
+// wide path would produce.  Anything else, a field out of the range that the
+// wide path accepts, or a buffer too small for the result is left to the wide
+// path, which reports it.
+static bool __cdecl store_digits(
+    char*&       out,
+    char const*  last,
+    int          value,
+    int    const digits
+    ) throw()
+{
+    if (last - out < digits)
+        return false;
+
+    for (int i = digits - 1; i >= 0; --i)
+    {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+
+    out += digits;
+    return true;
+}
+
+static bool __cdecl store_char(char*& out, char const* const last, char const c) throw()
+{
+    if (out == last)
+        return false;
+
+    *out++ = c;
+    return true;
+}
+
+static bool __cdecl expand_numeric(
+    char*&            out,
+    char const* const last,
+    char        const specifier,
+    tm const*   const timeptr
+    ) throw()
+{
+    switch (specifier)
+    {
+    case 'Y':
+        return timeptr->tm_year >= -1900 && timeptr->tm_year <= 8099
+            && store_digits(out, last, timeptr->tm_year + 1900, 4);
+
+    case 'm':
+        return timeptr->tm_mon >= 0 && timeptr->tm_mon <= 11
+            && store_digits(out, last, timeptr->tm_mon + 1, 2);
+
+    case 'd':
+        return timeptr->tm_mday >= 1 && timeptr->tm_mday <= 31
+            && store_digits(out, last, timeptr->tm_mday, 2);
+
+    case 'H':
+        return timeptr->tm_hour >= 0 && timeptr->tm_hour <= 23
+            && store_digits(out, last, timeptr->tm_hour, 2);
+
+    case 'M':
+        return timeptr->tm_min >= 0 && timeptr->tm_min <= 59
+            && store_digits(out, last, timeptr->tm_min, 2);
+
+    case 'S':
+        return timeptr->tm_sec >= 0 && timeptr->tm_sec <= 60
+            && store_digits(out, last, timeptr->tm_sec, 2);
+
+    case 'F': // "%Y-%m-%d"
+        return expand_numeric(out, last, 'Y', timeptr) && store_char(out, last, '-')
+            && expand_numeric(out, last, 'm', timeptr) && store_char(out, last, '-')
+            && expand_numeric(out, last, 'd', timeptr);
+
+    case 'T': // "%H:%M:%S"
+        return expand_numeric(out, last, 'H', timeptr) && store_char(out, last, ':')
+            && expand_numeric(out, last, 'M', timeptr) && store_char(out, last, ':')
+            && expand_numeric(out, last, 'S', timeptr);
+
+    case 'z': // "-0430"; the sign is that of the local time relative to UTC
+    {
+        __tzset();
+
+        long offset = 0;
+        _ERRCHECK(_get_timezone(&offset));
+        if (timeptr->tm_isdst)
+        {
+            long dst_bias = 0;
+            _ERRCHECK(_get_dstbias(&dst_bias));
+            offset += dst_bias;
+        }
+
+        long const positive_offset = offset < 0 ? -offset : offset;
+        return store_char(out, last, offset <= 0 ? '+' : '-')
+            && store_digits(out, last, static_cast<int>((positive_offset / 60) / 60), 2)
+            && store_digits(out, last, static_cast<int>((positive_offset / 60) % 60), 2);
+    }
+
+    case '%':
+        return store_char(out, last, '%');
+
+    default:
+        return false;
+    }
+}
+
+// Returns true and stores the length of the result if the format was expanded;
+// returns false, with the buffer contents unspecified, otherwise.
+static bool __cdecl try_strftime_numeric(
+    char*       const string,
+    size_t      const maxsize,
+    char const* const format,
+    tm const*   const timeptr,
+    size_t&           length
+    ) throw()
+{
+    char*             out  = string;
+    char const* const last = string + (maxsize - 1); // Leave room for null terminator
+
+    for (char const* it = format; *it != '\0'; ++it)
+    {
+        if (*it == '%')
+        {
+            if (!expand_numeric(out, last, *++it, timeptr))
+                return false;
+        }
+        else if (static_cast<unsigned char>(*it) >= 0x80 || !store_char(out, last, *it))
+        {
+            return false;
+        }
+    }
+
+    *out = '\0';
+    length = static_cast<size_t>(out - string);
+    return true;
+}
+
+
+
+// These functions format a time as a string using a given locale.  They place
+// characters into the user's output buffer, expanding time format directives as
+// described in the provided control string.  The lc_time_arg and locale are
+// used for locale data.
+//
+// If the total number of characters that need to be written (including the null
+// terminator) is less than the max_size, then the number of characters written
+// (not including the null terminator) is returned.  Otherwise, zero is returned.
+//
+// These functions simply delegate to the corresponding wide string functions
+// (e.g. _wcsftime).
+_Success_(return > 0)
+extern "C" size_t __cdecl _Strftime_l (
+    _Out_writes_z_(maxsize) char * const string,
+    _In_ size_t                    const maxsize,
+    _In_z_ const char *            const format,
+    _In_ const tm *                const timeptr,
+    _In_ void *                    const lc_time_arg,
+    _In_opt_ _locale_t             const locale
+    )
+{
+    _VALIDATE_RETURN(string != nullptr, EINVAL, 0)
+    _VALIDATE_RETURN(maxsize != 0,      EINVAL, 0)
+    *string = '\0';
+
+    _VALIDATE_RETURN(format != nullptr,  EINVAL, 0)
+    _VALIDATE_RETURN(timeptr != nullptr, EINVAL, 0)
+
+    // Musa: Numeric formats need neither the locale nor the wide path.
+    size_t numeric_length = 0;
+    if (try_strftime_numeric(string, maxsize, format, timeptr, numeric_length))
+    {
+        return numeric_length;
+    }
+
+    *string = '\0';
+
+    _LocaleUpdate locale_update(locale);
+    unsigned int const lc_time_cp = locale_update.GetLocaleT()->locinfo->lc_time_cp;
+
+    __crt_internal_win32_buffer<wchar_t> wformat;
+
+    errno_t const cvt1 = __acrt_mbs_to_wcs_cp(format, wformat, lc_time_cp);
+
+    if (cvt1 != 0) {
+        return 0;
+    }
+
+    // Allocate a new wide-char output string with the same size as the char*
+    // string one passed in as argument
+    __crt_unique_heap_ptr<wchar_t> const wstring(_malloc_crt_t(wchar_t, maxsize));
+    if (wstring.get() == nullptr)
+    {
+        // malloc should set the errno, if any
+        return 0;
+    }
+
+    size_t const wcsftime_result = _Wcsftime_l(wstring.get(), maxsize, wformat.data(), timeptr, lc_time_arg, locale);
+    if (wcsftime_result == 0)
+    {
+        return 0;
+    }
+
+    __crt_no_alloc_win32_buffer<char> copy_back(string, maxsize);
+    errno_t const cvt2 = __acrt_wcs_to_mbs_cp(wstring.get(), copy_back, lc_time_cp);
+
+    if (cvt2 != 0) {
+        return 0;
+    }
+
+    return copy_back.size();
+}
+
+extern "C" size_t __cdecl _Strftime(
+    char*       const string,
+    size_t      const max_size,
+    char const* const format,
+    tm const*   const timeptr,
+    void*       const lc_time_arg
+    )
+{
+    return _Strftime_l(string, max_size, format, timeptr, lc_time_arg, nullptr);
+}
+
+extern "C" size_t __cdecl _strftime_l(
+    char*       const string,
+    size_t      const max_size,
+    char const* const format,
+    tm const*   const timeptr,
+    _locale_t   const locale
+    )
+{
+    return _Strftime_l(string, max_size, format, timeptr, nullptr, locale);
+}
+extern "C" size_t __cdecl strftime(
+    char*       const string,
+    size_t      const max_size,
+    char const* const format,
+    tm const*   const timeptr
+    )
+{
+    return _Strftime_l(string, max_size, format, timeptr, nullptr, nullptr);
+}
@@ -0,0 +1,289 @@
+#include <corecrt_internal.h>
+#include "kclock.h"
+
+#if defined _M_X64
+#include <intrin.h>
+#endif
+
+
+// The monotonic clock is the interrupt time, in nanoseconds.  On x64 it is
+// read from the time stamp counter once that has been calibrated: the first
+// reading anchors the counter to the precise interrupt time (the origin), a
+// reading KCLOCK_CALIBRATION_MS later derives the counter's period from the
+// two, and from then on a reading is one RDTSC and a 64x64 multiply.  The
+// period is refined against the origin each time the time since the last
+// refinement doubles.  A refinement continues from the current reading, so the
+// clock never jumps, and slews the period by whatever the reading is off the
+// interrupt time, so that the two meet again at the next refinement.  A reading
+// more than a second ahead of, or a millisecond behind, the coarse interrupt
+// time means that the counter was reset or stopped (hibernation) and the
+// calibration starts over.
+//
+// The calibration is guarded by a sequence count.  The writer runs at
+// HIGH_LEVEL while the count is odd and takes the counter value at which the
+// new calibration starts only after making it odd; readers wait out an odd
+// count and read again if it changed under them.  So a reading made with the
+// old calibration is of a counter value before the new one starts, where the
+// two agree, and the clock never goes back across an update.  Before the
+// counter is calibrated the precise interrupt time is read within the same
+// sequence, for the same reason.
+
+namespace
+{
+    constexpr long long NanosecondsPerTick  = 100; // of the system and interrupt times
+    constexpr long long NanosecondsPerMs    = 1000 * 1000;
+    constexpr long long CalibrationInterval = KCLOCK_CALIBRATION_MS * NanosecondsPerMs;
+    constexpr int       MaximumSlewShift    = 11; // slew the period by at most 1/2048 of itself
+
+    long volatile realtime_mode = KCLOCK_PRECISE;
+
+    long long coarse_interrupt_time() noexcept
+    {
+        return static_cast<long long>(KeQueryInterruptTime()) * NanosecondsPerTick;
+    }
+
+    long long precise_interrupt_time() noexcept
+    {
+        ULONG64 performance_counter;
+        return static_cast<long long>(KeQueryInterruptTimePrecise(&performance_counter)) * NanosecondsPerTick;
+    }
+
+#if defined _M_X64
+    // Guarded by a sequence count: odd while being written, 0 before the
+    // origin is taken.
+    struct TscCalibration
+    {
+        unsigned long long origin_tsc;
+        long long          origin_ns;
+        unsigned long long base_tsc;
+        long long          base_ns;
+        unsigned long long period;     // ns per count, 32.32 fixed point; 0 until calibrated
+        unsigned long long refine_tsc; // refine the period when the counter passes this
+    };
+
+    TscCalibration volatile tsc_calibration;
+    long volatile           tsc_sequence = 0;
+    long volatile           tsc_state    = -1; // -1 until checked, 0 if unusable, 1 if usable
+
+    bool tsc_usable() noexcept
+    {
+        long state = ReadNoFence(&tsc_state);
+        if (state < 0)
+        {
+            int registers[4];
+            __cpuid(registers, 1);
+            bool const hypervisor = (static_cast<unsigned>(registers[2]) & 0x80000000u) != 0;
+
+            __cpuid(registers, 0x80000000);
+            bool invariant = false;
+            if (static_cast<unsigned>(registers[0]) >= 0x80000007)
+            {
+                __cpuid(registers, 0x80000007);
+                invariant = (registers[3] & (1 << 8)) != 0;
+            }
+
+            state = invariant && !hypervisor;
+            WriteNoFence(&tsc_state, state);
+        }
+        return state != 0;
+    }
+
+    inline long long scale(unsigned long long const counts, unsigned long long const period) noexcept
+    {
+        unsigned long long high;
+        unsigned long long const low = _umul128(counts, period, &high);
+        return static_cast<long long>((high << 32) | (low >> 32));
+    }
+
+    // The counter at the moment of the precise interrupt time stored in ns.
+    // Neither is read before the instructions that precede the call.
+    unsigned long long read_tsc_and_interrupt_time(long long& ns) noexcept
+    {
+        _mm_lfence();
+        unsigned long long const before = __rdtsc();
+        ns = precise_interrupt_time();
+        unsigned long long const after = __rdtsc();
+        return before + (after - before) / 2;
+    }
+
+    // Takes the origin, calibrates, refines or resets, as the state requires.
+    // Only the caller that moves the sequence from even to odd does anything.
+    void update_calibration(long const sequence, bool const reset) noexcept
+    {
+        if ((sequence & 1) != 0)
+        {
+            return;
+        }
+
+        // Nothing on this processor may wait for the sequence while it is odd.
+        KIRQL irql;
+        KeRaiseIrql(HIGH_LEVEL, &irql);
+        if (InterlockedCompareExchange(&tsc_sequence, sequence + 1, sequence) != sequence)
+        {
+            KeLowerIrql(irql);
+            return;
+        }
+
+        TscCalibration volatile& c = tsc_calibration;
+
+        long long ns;
+        unsigned long long const tsc = read_tsc_and_interrupt_time(ns);
+        if (reset || sequence == 0)
+        {
+            c.origin_tsc = tsc;
+            c.origin_ns  = ns;
+            c.period     = 0;
+        }
+        else if (tsc > c.origin_tsc && ns - c.origin_ns >= CalibrationInterval)
+        {
+            // period = elapsed ns * 2^32 / elapsed counts
+            unsigned long long const elapsed_ns = static_cast<unsigned long long>(ns - c.origin_ns);
+            unsigned long long const elapsed_tsc = tsc - c.origin_tsc;
+            unsigned long long remainder;
+            unsigned long long const period = _udiv128(elapsed_ns >> 32, elapsed_ns << 32, elapsed_tsc, &remainder);
+
+            if (period == 0 || period > 10ull << 32) // slower than 100 MHz
+            {
+                WriteNoFence(&tsc_state, 0);
+            }
+            else
+            {
+                // Continue from the current reading, if there is one, and
+                // take out its offset from ns over the next elapsed_tsc counts:
+                // slew = offset * 2^32 / elapsed counts.
+                long long base_ns = ns;
+                unsigned long long slewed = period;
+                if (c.period != 0)
+                {
+                    base_ns = c.base_ns + scale(tsc - c.base_tsc, c.period);
+
+                    long long const offset = base_ns - ns;
+                    unsigned long long const magnitude = static_cast<unsigned long long>(offset < 0 ? -offset : offset);
+                    unsigned long long const limit = period >> MaximumSlewShift;
+                    unsigned long long slew = limit;
+                    if (magnitude < 1ull << 31)
+                    {
+                        slew = (magnitude << 32) / elapsed_tsc;
+                        slew = slew < limit ? slew : limit;
+                    }
+                    slewed = offset < 0 ? period + slew : period - slew;
+                }
+
+                c.base_tsc   = tsc;
+                c.base_ns    = base_ns;
+                c.period     = slewed;
+                c.refine_tsc = tsc + elapsed_tsc;
+            }
+        }
+
+        InterlockedExchange(&tsc_sequence, sequence + 2);
+        KeLowerIrql(irql);
+    }
+
+    long long read_tsc_clock() noexcept
+    {
+        for (;;)
+        {
+            long const sequence = ReadAcquire(&tsc_sequence);
+            if ((sequence & 1) != 0)
+            {
+                YieldProcessor();
+                continue;
+            }
+
+            TscCalibration volatile const& c = tsc_calibration;
+            unsigned long long const period     = c.period;
+            unsigned long long const base_tsc   = c.base_tsc;
+            long long const          base_ns    = c.base_ns;
+            unsigned long long const refine_tsc = c.refine_tsc;
+            long long const          origin_ns  = c.origin_ns;
+            long long const          coarse     = coarse_interrupt_time(); // before the counter, so never later
+            unsigned long long const tsc        = __rdtsc();
+            long long const          precise    = period == 0 ? precise_interrupt_time() : 0;
+            _mm_lfence();
+            if (ReadAcquire(&tsc_sequence) != sequence)
+            {
+                continue;
+            }
+
+            if (period == 0)
+            {
+                if (sequence == 0 || precise - origin_ns >= CalibrationInterval)
+                {
+                    update_calibration(sequence, false);
+                }
+                return precise;
+            }
+
+            // The counters of two processors may differ by a few counts.
+            long long const ns = base_ns + (tsc > base_tsc ? scale(tsc - base_tsc, period) : 0);
+            if (ns < coarse - NanosecondsPerMs || ns > coarse + 1000 * NanosecondsPerMs)
+            {
+                update_calibration(sequence, true);
+                continue;
+            }
+
+            if (tsc >= refine_tsc)
+            {
+                update_calibration(sequence, false);
+            }
+            return ns;
+        }
+    }
+#endif
+}
+
+
+
+extern "C" long long __cdecl kclock_realtime_precise()
+{
+    LARGE_INTEGER time;
+    KeQuerySystemTimePrecise(&time);
+    return time.QuadPart;
+}
+
+extern "C" long long __cdecl kclock_realtime_coarse()
+{
+    LARGE_INTEGER time;
+    KeQuerySystemTime(&time);
+    return time.QuadPart;
+}
+
+extern "C" long long __cdecl kclock_realtime()
+{
+    return ReadNoFence(&realtime_mode) == KCLOCK_COARSE
+        ? kclock_realtime_coarse()
+        : kclock_realtime_precise();
+}
+
+extern "C" long long __cdecl kclock_monotonic()
+{
+#if defined _M_X64
+    if (tsc_usable())
+    {
+        return read_tsc_clock();
+    }
+#endif
+
+    return precise_interrupt_time();
+}
+
+extern "C" long long __cdecl kclock_monotonic_coarse()
+{
+    return coarse_interrupt_time();
+}
+
+extern "C" void __cdecl kclock_refine()
+{
+#if defined _M_X64
+    if (tsc_usable() && tsc_calibration.period != 0)
+    {
+        update_calibration(ReadAcquire(&tsc_sequence), false);
+    }
+#endif
+}
+
+extern "C" kclock_mode __cdecl kclock_set_realtime_mode(kclock_mode const mode)
+{
+    return static_cast<kclock_mode>(InterlockedExchange(&realtime_mode, mode == KCLOCK_COARSE ? KCLOCK_COARSE : KCLOCK_PRECISE));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <corecrt.h>
+
+
+// Clock sources.
+//
+// Wall clock readings are in 100-nanosecond units since 1601-01-01 UTC (the
+// FILETIME scale); monotonic readings are the interrupt time, in nanoseconds
+// since boot, time spent in sleep and hibernation included.  Every reading
+// takes no locks and may be made at any IRQL.
+//
+//     kclock_realtime_precise     KeQuerySystemTimePrecise: the system time
+//                                 interpolated with the performance counter
+//     kclock_realtime_coarse      KeQuerySystemTime: the system time as of the
+//                                 last clock interrupt; one shared memory read
+//     kclock_monotonic            the time stamp counter, scaled, where it is
+//                                 usable; KeQueryInterruptTimePrecise otherwise
+//     kclock_monotonic_coarse     KeQueryInterruptTime: the interrupt time as
+//                                 of the last clock interrupt
+//
+// The time stamp counter is used on x64 processors that report an invariant
+// TSC and no hypervisor, once it has been calibrated against the precise
+// interrupt time over KCLOCK_CALIBRATION_MS milliseconds from the first
+// kclock_monotonic call; until then, and on every other system, the precise
+// interrupt time is read instead.  The two agree at the switch, and each
+// refinement of the calibration slews the counter's period toward the
+// interrupt time, so they stay within a few microseconds of each other.
+// kclock_monotonic never goes back, on one processor or across processors,
+// through the switch and every refinement.
+//
+// kclock_realtime is the CRT's wall clock, read by timespec_get, _ftime,
+// std::chrono::system_clock and file_clock, and by timed waits on std::mutex
+// and std::condition_variable.  It is precise unless the mode is set to
+// KCLOCK_COARSE, which trades resolution (the clock interrupt period, 0.5 to
+// 15.6 ms) for the cost of a memory read; use it where timestamps are taken at
+// high rate and need not be finer than a tick.  std::chrono::steady_clock and
+// clock are based on kclock_monotonic.
+
+#define KCLOCK_CALIBRATION_MS 1000
+
+typedef enum kclock_mode
+{
+    KCLOCK_PRECISE,
+    KCLOCK_COARSE,
+} kclock_mode;
+
+extern "C" long long __cdecl kclock_realtime();
+
+extern "C" long long __cdecl kclock_realtime_precise();
+
+extern "C" long long __cdecl kclock_realtime_coarse();
+
+extern "C" long long __cdecl kclock_monotonic();
+
+extern "C" long long __cdecl kclock_monotonic_coarse();
+
+// Refines the time stamp counter calibration now rather than when it is due,
+// if the counter is in use and calibrated.  kclock_monotonic continues from
+// its current reading.
+extern "C" void __cdecl kclock_refine();
+
+// Selects the clock behind kclock_realtime and returns the previous mode.
+extern "C" kclock_mode __cdecl kclock_set_realtime_mode(_In_ kclock_mode mode);
@@ -0,0 +1,50 @@
+#pragma once
+
+
+// NTSTATUS errors.
+//
+// Kernel failures arrive as NTSTATUS.  kerrno_from_ntstatus maps a status
+// straight to an errno value without going through a Win32 error code, and
+// kntstatus_message returns a short built-in description.  Both are a single
+// lookup in a dense table built at compile time; neither allocates, takes a
+// lock, or touches the thread's errno, so they can be used at any IRQL.
+//
+// Success and informational codes map to 0.  Errors that are not in the table
+// map to EINVAL, except FACILITY_NTWIN32 codes, which carry a Win32 error and
+// are mapped as such.
+
+extern "C" int __cdecl kerrno_from_ntstatus(_In_ NTSTATUS status);
+
+// Returns a static, lowercase description ("access denied"), or nullptr if the
+// status is not in the table.
+extern "C" char const* __cdecl kntstatus_message(_In_ NTSTATUS status);
+
+
+#if defined __cplusplus && !defined _CORECRT_BUILD
+#include <system_error>
+
+_STD_BEGIN
+
+#ifndef _EXPORT_STD
+#define _EXPORT_STD
+#endif
+
+// The "ntstatus" error category.  error_code values are NTSTATUS.  The
+// category object is constant-initialized and never destroyed, like
+// system_category(), so constructing an error_code is two stores.  message()
+// copies the built-in description (or "unknown NTSTATUS 0x........") and
+// default_error_condition() maps to generic_category() through
+// kerrno_from_ntstatus, so
+//
+//     make_nt_error_code(STATUS_ACCESS_DENIED) == errc::permission_denied
+//
+// holds.  Use kntstatus_message when the message must not allocate.
+_EXPORT_STD _NODISCARD const error_category& nt_category() noexcept;
+
+_EXPORT_STD _NODISCARD inline error_code make_nt_error_code(const NTSTATUS _Status) noexcept {
+    return error_code(static_cast<int>(_Status), _STD nt_category());
+}
+
+_STD_END
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+
+// exception_ptr block pool.
+//
+// std::current_exception and std::make_exception_ptr copy the exception into a
+// reference-counted block.  Blocks of up to 256 bytes (the record plus an
+// exception object of about 80 bytes) come from a per-processor pool of
+// NonPagedPoolNx slots filled at startup, then from the heap, and only when
+// the heap fails from a small emergency reserve.  Larger exceptions always use
+// the heap.  The counters below are cumulative since startup.
+
+struct kexception_pool_stats
+{
+    long long pooled;   // blocks taken from a per-processor list
+    long long heap;     // blocks taken from the heap
+    long long reserve;  // blocks taken from the emergency reserve
+    long long failed;   // captures that degraded to std::bad_alloc
+    unsigned long capacity; // per-processor slots in total, 0 if the pool could not be allocated
+};
+
+extern "C" void __cdecl kexception_pool_query(_Out_ kexception_pool_stats* stats) noexcept;
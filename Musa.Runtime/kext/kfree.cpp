@@ -1,5 +1,6 @@
 #include <corecrt_internal.h>
 #include "kmalloc.h"
+#include <corecrt_internal_heap_profile.h>
 
 
 extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) void __cdecl kfree(
@@ -8,6 +9,8 @@ extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) void __cdecl kfree(
 )
 {
     if (block) {
+        if (__acrt_heap_profile_armed)
+            __acrt_heap_profile_free(block);
         ExFreePoolWithTag(block, tag);
     }
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+
+// Deferred and parallel static initialization.
+//
+// Ordinary global constructors (.CRT$XC) all run on the DriverEntry thread
+// before DriverMain.  An object declared with KINIT_OBJECT is built instead
+//
+//  * KINIT_DEFERRED:  the first time it is accessed, or
+//  * KINIT_PARALLEL:  on a pool of system threads started just before
+//                     DriverMain, or the first time it is accessed, whichever
+//                     comes first.
+//
+// Accessing an object (get(), ->, *) that is still being built blocks until it
+// is complete, so accessors must run at IRQL < DISPATCH_LEVEL.  An object's
+// dependencies, given as a nullptr-terminated array of entries, are built
+// before it is; a constructor may also simply access other KINIT objects.
+// Dependencies must not form a cycle.  Constructors must not throw.
+//
+// Built objects are destroyed when the driver unloads, in reverse order of
+// completion and interleaved with ordinary global destructors as if each had
+// been an ordinary global constructed at that moment, so an object built from
+// a global constructor is destroyed after that global.  Unload first waits for
+// the parallel pool to finish.  entry.cycles records how long each constructor
+// ran (ReadTimeStampCounter() ticks).
+//
+//     static void build_words(void* storage) { ::new (storage) Trie(load_words()); }
+//     KINIT_OBJECT(Trie, words, KINIT_PARALLEL, build_words, nullptr);
+//
+//     static kinit_entry* const grammar_dependencies[] = { &words.entry, nullptr };
+//     static void build_grammar(void* storage) { ::new (storage) Grammar(*words); }
+//     KINIT_OBJECT(Grammar, grammar, KINIT_DEFERRED, build_grammar, grammar_dependencies);
+//
+//     grammar->match(...);   // builds words (if the pool has not yet) and grammar
+
+#define KINIT_DEFERRED 0x0ul
+#define KINIT_PARALLEL 0x1ul
+
+struct kinit_entry
+{
+    void (__cdecl*       construct)(void* object);
+    void (__cdecl*       destroy)(void* object);    // optional
+    void*                object;
+    kinit_entry* const*  dependencies;              // nullptr-terminated, optional
+    unsigned long        flags;
+    char const*          name;
+
+    // Owned by the runtime; zero-initialized.
+    long volatile        state;
+    void* volatile       owner;
+    kinit_entry*         next_completed;
+    unsigned long long   cycles;
+    KEVENT               completed;
+};
+
+// Builds entry (and its dependencies) if it has not been built, or waits for
+// the thread that is building it.
+extern "C" void __cdecl kinit_ensure(_Inout_ kinit_entry* entry);
+
+
+template <typename T>
+class kinit_object final
+{
+public:
+    constexpr kinit_object(
+        void (__cdecl* const construct)(void* object),
+        unsigned long const flags,
+        kinit_entry* const* const dependencies,
+        char const* const name
+    ) noexcept
+        : entry{ construct, &_Destroy, _Storage, dependencies, flags, name }
+        , _Storage{}
+    {
+    }
+
+    kinit_object(const kinit_object&) = delete;
+    kinit_object& operator=(const kinit_object&) = delete;
+
+    T& get() noexcept
+    {
+        kinit_ensure(&entry);
+        return *reinterpret_cast<T*>(_Storage);
+    }
+
+    T* operator->() noexcept { return &get(); }
+    T& operator*()  noexcept { return get(); }
+
+    kinit_entry entry;
+
+private:
+    static void __cdecl _Destroy(void* const object) noexcept
+    {
+        static_cast<T*>(object)->~T();
+    }
+
+    alignas(T) unsigned char _Storage[sizeof(T)];
+};
+
+// Registration is a pointer in .CRT$XKM, between the runtime's .CRT$XKA and
+// .CRT$XKZ markers.  The object itself is constant-initialized, so it can be
+// accessed from ordinary global constructors as well.  Use at namespace scope.
+#pragma section(".CRT$XKM", long, read)
+
+#define KINIT_OBJECT(type, name, flags, construct, dependencies)                   \
+    kinit_object<type> name{ construct, flags, dependencies, #name };                \
+    extern "C" __declspec(allocate(".CRT$XKM")) kinit_entry* const name##_kinit_entry = &name.entry
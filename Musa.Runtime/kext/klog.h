@@ -0,0 +1,100 @@
+#pragma once
+#include <corecrt.h>
+
+#if _HAS_CXX20
+#include <format>
+#include <utility>
+#endif
+
+
+// Kernel log.
+//
+// std::print and std::println to stdout or stderr, klog_print and klog_write
+// do not write to the debugger as they are called.  Each line is appended to
+// a buffer of the processor it is written on, without taking a lock, and a
+// worker thread running at low priority passes the lines, oldest first, to
+// the sink in batches:
+//
+//     debugger    DbgPrintEx, as many lines per call as fit in 512 bytes
+//                 (the default, with DPFLTR_DEFAULT_ID)
+//     file        _write on a CRT file descriptor
+//     trace       EtwWriteString, one event per line, on a provider
+//                 registered with EtwRegister
+//
+// The worker starts at the first line written at PASSIVE_LEVEL.  It wakes when
+// a line follows a quiet period and then drains every KLOG_FLUSH_INTERVAL_MS
+// milliseconds, or as soon as a buffer is half full, until the buffers stay
+// empty.  A line that does not fit in its processor's buffer is dropped and
+// counted rather than waited for.  Lines still buffered when the CRT is
+// uninitialized are written out before the driver unloads.
+//
+// Levels are the ETW ones.  stdout lines are KLOG_INFO and stderr lines
+// KLOG_ERROR; the debugger sink maps KLOG_INFO and KLOG_VERBOSE to
+// DPFLTR_TRACE_LEVEL and DPFLTR_INFO_LEVEL, which the default debug filter
+// hides.  Text printed without a newline is held until the line is complete
+// or klog_flush is called, and a line longer than KLOG_MAX_LINE bytes is
+// split.
+//
+// std::print takes the stream lock and must be called below DISPATCH_LEVEL;
+// klog_print and klog_write may be called at DISPATCH_LEVEL.  std::print only
+// goes through here when the ordinary literal encoding is UTF-8 (/utf-8);
+// otherwise it writes to the stream with fwrite, and a driver's stdout has no
+// file behind it.
+
+#define KLOG_MAX_LINE           512
+#define KLOG_BUFFER_SIZE        (32 * 1024)     // per processor
+#define KLOG_FLUSH_INTERVAL_MS  50
+
+typedef enum klog_level
+{
+    KLOG_ERROR   = 2,
+    KLOG_WARNING = 3,
+    KLOG_INFO    = 4,
+    KLOG_VERBOSE = 5,
+} klog_level;
+
+struct klog_stats
+{
+    long long lines;    // lines buffered
+    long long dropped;  // lines dropped because a buffer was full
+    long long written;  // lines passed to a sink
+    long long batches;  // sink calls (DbgPrintEx, _write or EtwWriteString)
+};
+
+// Each sink setter first writes out the lines already buffered, to the
+// previous sink.  'component_id' is a DPFLTR_TYPE.
+extern "C" errno_t __cdecl klog_set_debugger_sink(_In_ unsigned long component_id);
+
+// 'fd' must stay open until another sink is set.  Each line ends in "\n".
+extern "C" errno_t __cdecl klog_set_file_sink(_In_ int fd);
+
+// The provider is unregistered when another sink is set.
+extern "C" errno_t __cdecl klog_set_trace_sink(_In_ struct _GUID const* provider);
+
+// Appends 'text' as one line, without a newline; text longer than
+// KLOG_MAX_LINE is cut.  Returns ENOSPC if the line was dropped, EINVAL if
+// 'level' is not one of the above.
+extern "C" errno_t __cdecl klog_write(
+    _In_                klog_level  level,
+    _In_reads_(size)    char const* text,
+    _In_                size_t      size
+);
+
+// Writes out every buffered line, text printed to stdout and stderr without a
+// newline included, and returns when the sink has them.  PASSIVE_LEVEL only.
+extern "C" void __cdecl klog_flush();
+
+extern "C" void __cdecl klog_query(_Out_ klog_stats* stats);
+
+#if _HAS_CXX20
+// Formats a line on the stack, cut at KLOG_MAX_LINE bytes, and appends it:
+//
+//     klog_print(KLOG_INFO, "irp {} completed with {:#x}", irp_id, status);
+template <class... Args>
+errno_t klog_print(klog_level const level, std::format_string<Args...> const format, Args&&... args)
+{
+    char line[KLOG_MAX_LINE];
+    auto const result = std::format_to_n(line, KLOG_MAX_LINE, format, std::forward<Args>(args)...);
+    return klog_write(level, line, static_cast<size_t>(result.out - line));
+}
+#endif
@@ -2,6 +2,8 @@
 #include <new.h>
 #include "kmalloc.h"
 #include "knew.h"
+#include <corecrt_internal_startup_trace.h>
+#include <corecrt_internal_heap_profile.h>
 
 
 extern"C" __declspec(noinline) void* __cdecl ExReallocatePoolWithTag(
@@ -29,10 +31,11 @@ extern"C" __declspec(noinline) void* __cdecl ExReallocatePoolWithTag(
     return nullptr;
 }
 
-extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl kmalloc(
+extern "C" __declspec(noinline) _CRTRESTRICT void* __cdecl __acrt_kmalloc_from(
     size_t const  size,
     pool_t        pool,
-    unsigned long tag
+    unsigned long tag,
+    void const*   caller
 )
 {
     // Ensure that the requested size is not too large:
@@ -44,8 +47,13 @@ extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl
     for (;;) {
         #pragma warning(suppress: 4996)
         void* const block = ExAllocatePoolWithTag(pool, actual_size, tag);
-        if (block)
+        if (block) {
+            if (__acrt_startup_trace_armed)
+                __acrt_startup_trace_allocation(actual_size);
+            if (__acrt_heap_profile_armed)
+                __acrt_heap_profile_allocation(block, actual_size, tag, caller);
             return block;
+        }
 
         // Otherwise, see if we need to call the new handler, and if so call it.
         // If the new handler fails, just return nullptr:
@@ -58,6 +66,15 @@ extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl
     }
 }
 
+extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl kmalloc(
+    size_t const  size,
+    pool_t        pool,
+    unsigned long tag
+)
+{
+    return __acrt_kmalloc_from(size, pool, tag, _ReturnAddress());
+}
+
 extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl kcalloc(
     size_t const  count,
     size_t const  size,
@@ -73,7 +90,7 @@ extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl
     size_t const actual_block_size    = requested_block_size == 0 ? 1 : requested_block_size;
 
     for (;;) {
-        void* const block = kmalloc(actual_block_size, pool, tag);
+        void* const block = __acrt_kmalloc_from(actual_block_size, pool, tag, _ReturnAddress());
 
         // If allocation succeeded, return the pointer to the new block:
         if (block) {
@@ -102,7 +119,7 @@ extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl
 {
     // If the block is a nullptr, just call malloc:
     if (block == nullptr)
-        return kmalloc(new_size, pool, tag);
+        return __acrt_kmalloc_from(new_size, pool, tag, _ReturnAddress());
 
     // If the new size is 0, just call free and return nullptr:
     if (new_size == 0) {
@@ -113,9 +130,16 @@ extern "C" _CRT_HYBRIDPATCHABLE __declspec(noinline) _CRTRESTRICT void* __cdecl
     // Ensure that the requested size is not too large:
     _VALIDATE_RETURN_NOEXC(_HEAP_MAXREQ >= new_size, ENOMEM, nullptr);
 
+    // Musa: The block leaves the allocation telemetry before it can be freed
+    // by the reallocation.  If the reallocation fails, it stays untracked.
+    if (__acrt_heap_profile_armed)
+        __acrt_heap_profile_free(block);
+
     for (;;) {
         void* const new_block = ExReallocatePoolWithTag(old_size, new_size, block, pool, tag);
         if (new_block) {
+            if (__acrt_heap_profile_armed)
+                __acrt_heap_profile_allocation(new_block, new_size, tag, _ReturnAddress());
             return new_block;
         }
 
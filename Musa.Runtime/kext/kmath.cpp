@@ -0,0 +1,596 @@
+#include <corecrt_internal.h>
+#include <math.h>
+#include <string.h>
+#include "kmath.h"
+
+#if defined _M_X64
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined _M_ARM64
+#include <arm_neon.h>
+#endif
+
+
+// The kernels are written once against a small set of lane-wise operations
+// and instantiated for each register width.  Masks are vectors with every bit
+// of a lane set or clear.  mul_add may or may not be fused.
+
+namespace
+{
+    inline uint64_t as_bits(double const value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline double from_bits(uint64_t const bits)
+    {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // One lane; used where no vector unit is available.
+    struct scalar_lanes
+    {
+        using vector = double;
+        static constexpr size_t lanes = 1;
+
+        static vector load(double const* const p)          { return *p; }
+        static void   store(double* const p, vector const v) { *p = v; }
+        static vector set(double const v)                  { return v; }
+        static vector set_bits(uint64_t const v)           { return from_bits(v); }
+
+        static vector add(vector const a, vector const b)  { return a + b; }
+        static vector sub(vector const a, vector const b)  { return a - b; }
+        static vector mul(vector const a, vector const b)  { return a * b; }
+        static vector div(vector const a, vector const b)  { return a / b; }
+        static vector mul_add(vector const a, vector const b, vector const c) { return a * b + c; }
+        static vector sqrt(vector const a)                 { return ::sqrt(a); }
+
+        static vector bit_and(vector const a, vector const b)     { return from_bits(as_bits(a) & as_bits(b)); }
+        static vector bit_or(vector const a, vector const b)      { return from_bits(as_bits(a) | as_bits(b)); }
+        static vector bit_xor(vector const a, vector const b)     { return from_bits(as_bits(a) ^ as_bits(b)); }
+        static vector bit_and_not(vector const a, vector const b) { return from_bits(as_bits(a) & ~as_bits(b)); }
+        static vector int_add(vector const a, vector const b)     { return from_bits(as_bits(a) + as_bits(b)); }
+        static vector int_sub(vector const a, vector const b)     { return from_bits(as_bits(a) - as_bits(b)); }
+        template <int N> static vector shift_left(vector const a)  { return from_bits(as_bits(a) << N); }
+        template <int N> static vector shift_right(vector const a) { return from_bits(as_bits(a) >> N); }
+
+        static vector less_equal(vector const a, vector const b) { return from_bits(a <= b ? ~0ull : 0); }
+        static vector greater(vector const a, vector const b)    { return from_bits(a > b ? ~0ull : 0); }
+        static vector select(vector const m, vector const a, vector const b) { return as_bits(m) ? a : b; }
+        static unsigned mask_bits(vector const m)                { return as_bits(m) ? 1u : 0u; }
+    };
+
+#if defined _M_X64
+    struct sse2_lanes
+    {
+        using vector = __m128d;
+        static constexpr size_t lanes = 2;
+
+        static vector load(double const* const p)          { return _mm_loadu_pd(p); }
+        static void   store(double* const p, vector const v) { _mm_storeu_pd(p, v); }
+        static vector set(double const v)                  { return _mm_set1_pd(v); }
+        static vector set_bits(uint64_t const v)           { return _mm_castsi128_pd(_mm_set1_epi64x(static_cast<long long>(v))); }
+
+        static vector add(vector const a, vector const b)  { return _mm_add_pd(a, b); }
+        static vector sub(vector const a, vector const b)  { return _mm_sub_pd(a, b); }
+        static vector mul(vector const a, vector const b)  { return _mm_mul_pd(a, b); }
+        static vector div(vector const a, vector const b)  { return _mm_div_pd(a, b); }
+        static vector mul_add(vector const a, vector const b, vector const c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+        static vector sqrt(vector const a)                 { return _mm_sqrt_pd(a); }
+
+        static vector bit_and(vector const a, vector const b)     { return _mm_and_pd(a, b); }
+        static vector bit_or(vector const a, vector const b)      { return _mm_or_pd(a, b); }
+        static vector bit_xor(vector const a, vector const b)     { return _mm_xor_pd(a, b); }
+        static vector bit_and_not(vector const a, vector const b) { return _mm_andnot_pd(b, a); }
+        static vector int_add(vector const a, vector const b)     { return _mm_castsi128_pd(_mm_add_epi64(_mm_castpd_si128(a), _mm_castpd_si128(b))); }
+        static vector int_sub(vector const a, vector const b)     { return _mm_castsi128_pd(_mm_sub_epi64(_mm_castpd_si128(a), _mm_castpd_si128(b))); }
+        template <int N> static vector shift_left(vector const a)  { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a), N)); }
+        template <int N> static vector shift_right(vector const a) { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a), N)); }
+
+        static vector less_equal(vector const a, vector const b) { return _mm_cmple_pd(a, b); }
+        static vector greater(vector const a, vector const b)    { return _mm_cmpgt_pd(a, b); }
+        static vector select(vector const m, vector const a, vector const b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+        static unsigned mask_bits(vector const m)                { return static_cast<unsigned>(_mm_movemask_pd(m)); }
+    };
+
+    struct avx2_lanes
+    {
+        using vector = __m256d;
+        static constexpr size_t lanes = 4;
+
+        static vector load(double const* const p)          { return _mm256_loadu_pd(p); }
+        static void   store(double* const p, vector const v) { _mm256_storeu_pd(p, v); }
+        static vector set(double const v)                  { return _mm256_set1_pd(v); }
+        static vector set_bits(uint64_t const v)           { return _mm256_castsi256_pd(_mm256_set1_epi64x(static_cast<long long>(v))); }
+
+        static vector add(vector const a, vector const b)  { return _mm256_add_pd(a, b); }
+        static vector sub(vector const a, vector const b)  { return _mm256_sub_pd(a, b); }
+        static vector mul(vector const a, vector const b)  { return _mm256_mul_pd(a, b); }
+        static vector div(vector const a, vector const b)  { return _mm256_div_pd(a, b); }
+        static vector mul_add(vector const a, vector const b, vector const c) { return _mm256_fmadd_pd(a, b, c); }
+        static vector sqrt(vector const a)                 { return _mm256_sqrt_pd(a); }
+
+        static vector bit_and(vector const a, vector const b)     { return _mm256_and_pd(a, b); }
+        static vector bit_or(vector const a, vector const b)      { return _mm256_or_pd(a, b); }
+        static vector bit_xor(vector const a, vector const b)     { return _mm256_xor_pd(a, b); }
+        static vector bit_and_not(vector const a, vector const b) { return _mm256_andnot_pd(b, a); }
+        static vector int_add(vector const a, vector const b)     { return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(a), _mm256_castpd_si256(b))); }
+        static vector int_sub(vector const a, vector const b)     { return _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_castpd_si256(a), _mm256_castpd_si256(b))); }
+        template <int N> static vector shift_left(vector const a)  { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a), N)); }
+        template <int N> static vector shift_right(vector const a) { return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a), N)); }
+
+        static vector less_equal(vector const a, vector const b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+        static vector greater(vector const a, vector const b)    { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        static vector select(vector const m, vector const a, vector const b) { return _mm256_blendv_pd(b, a, m); }
+        static unsigned mask_bits(vector const m)                { return static_cast<unsigned>(_mm256_movemask_pd(m)); }
+    };
+#elif defined _M_ARM64
+    struct neon_lanes
+    {
+        using vector = float64x2_t;
+        static constexpr size_t lanes = 2;
+
+        static vector load(double const* const p)          { return vld1q_f64(p); }
+        static void   store(double* const p, vector const v) { vst1q_f64(p, v); }
+        static vector set(double const v)                  { return vdupq_n_f64(v); }
+        static vector set_bits(uint64_t const v)           { return vreinterpretq_f64_u64(vdupq_n_u64(v)); }
+
+        static vector add(vector const a, vector const b)  { return vaddq_f64(a, b); }
+        static vector sub(vector const a, vector const b)  { return vsubq_f64(a, b); }
+        static vector mul(vector const a, vector const b)  { return vmulq_f64(a, b); }
+        static vector div(vector const a, vector const b)  { return vdivq_f64(a, b); }
+        static vector mul_add(vector const a, vector const b, vector const c) { return vfmaq_f64(c, a, b); }
+        static vector sqrt(vector const a)                 { return vsqrtq_f64(a); }
+
+        static uint64x2_t u(vector const a)                { return vreinterpretq_u64_f64(a); }
+        static vector     f(uint64x2_t const a)            { return vreinterpretq_f64_u64(a); }
+
+        static vector bit_and(vector const a, vector const b)     { return f(vandq_u64(u(a), u(b))); }
+        static vector bit_or(vector const a, vector const b)      { return f(vorrq_u64(u(a), u(b))); }
+        static vector bit_xor(vector const a, vector const b)     { return f(veorq_u64(u(a), u(b))); }
+        static vector bit_and_not(vector const a, vector const b) { return f(vbicq_u64(u(a), u(b))); }
+        static vector int_add(vector const a, vector const b)     { return f(vaddq_u64(u(a), u(b))); }
+        static vector int_sub(vector const a, vector const b)     { return f(vsubq_u64(u(a), u(b))); }
+        template <int N> static vector shift_left(vector const a)  { return f(vshlq_n_u64(u(a), N)); }
+        template <int N> static vector shift_right(vector const a) { return f(vshrq_n_u64(u(a), N)); }
+
+        static vector less_equal(vector const a, vector const b) { return f(vcleq_f64(a, b)); }
+        static vector greater(vector const a, vector const b)    { return f(vcgtq_f64(a, b)); }
+        static vector select(vector const m, vector const a, vector const b) { return vbslq_f64(u(m), a, b); }
+        static unsigned mask_bits(vector const m)
+        {
+            return static_cast<unsigned>(vgetq_lane_u64(u(m), 0) & 1) | static_cast<unsigned>((vgetq_lane_u64(u(m), 1) & 1) << 1);
+        }
+    };
+#endif
+
+    constexpr double round_shifter = 0x1.8p52; // adding and subtracting rounds to an integer
+    constexpr double inverse_ln2   = 1.44269504088896338700e+00;
+    constexpr double ln2_hi        = 6.93147180369123816490e-01; // 32 bits; n * ln2_hi is exact
+    constexpr double ln2_lo        = 1.90821492927058770002e-10;
+    constexpr uint64_t sign_bit    = 0x8000000000000000ull;
+
+    template <class V>
+    __forceinline unsigned outside(typename V::vector const in_domain)
+    {
+        return ~V::mask_bits(in_domain) & ((1u << V::lanes) - 1);
+    }
+
+    // 2^n, for t = n + round_shifter and n + 1023 in [1, 2046].
+    template <class V>
+    __forceinline typename V::vector power_of_two(typename V::vector const t)
+    {
+        return V::template shift_left<52>(V::int_add(t, V::set_bits(1023)));
+    }
+
+    // exp (fdlibm e_exp.c):  x = n ln2 + r, exp(r) = 1 + r + r c / (2 - c)
+    // where c = r - r^2 P(r^2).
+    struct exp_function
+    {
+        static double scalar(double const x) { return exp(x); }
+
+        template <class V>
+        __forceinline static typename V::vector vector(typename V::vector const x, unsigned& fallback)
+        {
+            using vector = typename V::vector;
+
+            fallback = outside<V>(V::less_equal(V::bit_and_not(x, V::set_bits(sign_bit)), V::set(708.0)));
+
+            vector const t  = V::mul_add(x, V::set(inverse_ln2), V::set(round_shifter));
+            vector const n  = V::sub(t, V::set(round_shifter));
+            vector const hi = V::sub(x, V::mul(n, V::set(ln2_hi)));
+            vector const lo = V::mul(n, V::set(ln2_lo));
+            vector const r  = V::sub(hi, lo);
+            vector const rr = V::mul(r, r);
+
+            vector p = V::set(4.13813679705723846039e-08);
+            p = V::mul_add(p, rr, V::set(-1.65339022054652515390e-06));
+            p = V::mul_add(p, rr, V::set( 6.61375632143793436117e-05));
+            p = V::mul_add(p, rr, V::set(-2.77777777770155933842e-03));
+            p = V::mul_add(p, rr, V::set( 1.66666666666666019037e-01));
+            vector const c = V::sub(r, V::mul(rr, p));
+
+            vector const q = V::div(V::mul(r, c), V::sub(V::set(2.0), c));
+            vector const y = V::sub(V::set(1.0), V::sub(V::sub(lo, q), hi));
+            return V::mul(y, power_of_two<V>(t));
+        }
+    };
+
+    // log (fdlibm e_log.c):  x = 2^k m with m in [sqrt(2)/2, sqrt(2)),
+    // f = m - 1, s = f / (2 + f), log(1 + f) = f - f^2/2 + s (f^2/2 + R(s^2)).
+    struct log_function
+    {
+        static double scalar(double const x) { return log(x); }
+
+        template <class V>
+        __forceinline static typename V::vector vector(typename V::vector const x, unsigned& fallback)
+        {
+            using vector = typename V::vector;
+
+            fallback = outside<V>(V::bit_and(
+                V::less_equal(V::set(0x1p-1022), x),
+                V::less_equal(x, V::set(0x1.fffffffffffffp1023))));
+
+            vector const u = V::int_add(x, V::set_bits(0x00095f6200000000ull)); // + (1.0 - sqrt(2)/2) in the high word
+            vector const k = V::sub(
+                V::bit_or(V::template shift_right<52>(u), V::set(0x1p52)),
+                V::set(0x1p52 + 1023));
+            vector const m = V::int_add(
+                V::bit_and(u, V::set_bits(0x000fffffffffffffull)),
+                V::set_bits(0x3fe6a09e00000000ull));
+
+            vector const f    = V::sub(m, V::set(1.0));
+            vector const hfsq = V::mul(V::mul(V::set(0.5), f), f);
+            vector const s    = V::div(f, V::add(V::set(2.0), f));
+            vector const z    = V::mul(s, s);
+            vector const w    = V::mul(z, z);
+
+            vector t1 = V::set(1.531383769920937332e-01);
+            t1 = V::mul_add(t1, w, V::set(2.222219843214978396e-01));
+            t1 = V::mul_add(t1, w, V::set(3.999999999940941908e-01));
+            t1 = V::mul(t1, w);
+
+            vector t2 = V::set(1.479819860511658591e-01);
+            t2 = V::mul_add(t2, w, V::set(1.818357216161805012e-01));
+            t2 = V::mul_add(t2, w, V::set(2.857142874366239149e-01));
+            t2 = V::mul_add(t2, w, V::set(6.666666666666735130e-01));
+            t2 = V::mul(t2, z);
+
+            vector const r = V::add(t2, t1);
+
+            vector result = V::mul(s, V::add(hfsq, r));
+            result = V::add(result, V::mul(k, V::set(ln2_lo)));
+            result = V::sub(result, hfsq);
+            result = V::add(result, f);
+            return V::add(result, V::mul(k, V::set(ln2_hi)));
+        }
+    };
+
+    // expm1 for |a| <= 41:  a = n ln2 + r + c, where c is the rounding error
+    // of r, and expm1(a) = 2^n (e^(r + c) - 1) + (2^n - 1).
+    template <class V>
+    __forceinline typename V::vector expm1_kernel(typename V::vector const a)
+    {
+        using vector = typename V::vector;
+
+        vector const t  = V::mul_add(a, V::set(inverse_ln2), V::set(round_shifter));
+        vector const n  = V::sub(t, V::set(round_shifter));
+        vector const hi = V::sub(a, V::mul(n, V::set(ln2_hi)));
+        vector const lo = V::mul(n, V::set(ln2_lo));
+        vector const r  = V::sub(hi, lo);
+        vector const c  = V::sub(V::sub(hi, r), lo);
+
+        // e^r - 1 = r + r^2 (1/2! + r/3! + ... + r^11/13!); the first omitted
+        // term is below 2^-56 r for |r| <= ln2/2.
+        vector p = V::set(1.0 / 6227020800.0);
+        p = V::mul_add(p, r, V::set(1.0 / 479001600.0));
+        p = V::mul_add(p, r, V::set(1.0 / 39916800.0));
+        p = V::mul_add(p, r, V::set(1.0 / 3628800.0));
+        p = V::mul_add(p, r, V::set(1.0 / 362880.0));
+        p = V::mul_add(p, r, V::set(1.0 / 40320.0));
+        p = V::mul_add(p, r, V::set(1.0 / 5040.0));
+        p = V::mul_add(p, r, V::set(1.0 / 720.0));
+        p = V::mul_add(p, r, V::set(1.0 / 120.0));
+        p = V::mul_add(p, r, V::set(1.0 / 24.0));
+        p = V::mul_add(p, r, V::set(1.0 / 6.0));
+        p = V::mul_add(p, r, V::set(0.5));
+        p = V::mul_add(V::mul(r, r), p, r);
+        p = V::mul_add(c, V::add(V::set(1.0), p), p);
+
+        vector const scale = power_of_two<V>(t);
+        return V::mul_add(scale, p, V::sub(scale, V::set(1.0)));
+    }
+
+    // tanh (as musl):  with w = |x| and t = expm1(+-2w),
+    //     w > log(3)/2:        1 - 2 / (t + 2)
+    //     w > log(5/3)/2:      t / (t + 2)
+    //     otherwise:          -t / (t + 2), t = expm1(-2w)
+    // and 1 for w > 20.
+    struct tanh_function
+    {
+        static double scalar(double const x) { return tanh(x); }
+
+        template <class V>
+        __forceinline static typename V::vector vector(typename V::vector const x, unsigned& fallback)
+        {
+            using vector = typename V::vector;
+
+            vector const sign = V::bit_and(x, V::set_bits(sign_bit));
+            vector const w    = V::bit_xor(x, sign);
+            vector const one  = V::set(1.0);
+            vector const two  = V::set(2.0);
+
+            fallback = outside<V>(V::less_equal(w, V::set(HUGE_VAL))); // NaN
+
+            vector const saturated = V::greater(w, V::set(20.0));
+            vector const large     = V::greater(w, V::set(0.54930614433405489));
+            vector const medium    = V::greater(w, V::set(0.25541281188299536));
+
+            vector const w2 = V::mul(V::select(saturated, V::set(20.0), w), two);
+            vector const t  = expm1_kernel<V>(V::select(medium, w2, V::bit_xor(w2, V::set_bits(sign_bit))));
+
+            vector const q      = V::div(t, V::add(t, two));
+            vector const result = V::select(large,
+                V::sub(one, V::div(two, V::add(t, two))),
+                V::select(medium, q, V::bit_xor(q, V::set_bits(sign_bit))));
+
+            return V::bit_or(V::bit_and_not(V::select(saturated, one, result), V::set_bits(sign_bit)), sign);
+        }
+    };
+
+    // sin and cos (fdlibm e_rem_pio2.c, k_sin.c and k_cos.c):  x = n pi/2 +
+    // y0 + y1, reduced with pi/2 split into parts whose products with n are
+    // exact, so the reduction is good to about 150 bits for |x| < 2^19 pi/2.
+    // fdlibm only takes the second and third steps when the first one cancels,
+    // and then the second is exact.  Here all three are always taken, so the
+    // rounding errors of both are carried into y1.
+    template <class V>
+    struct pio2_reduction
+    {
+        typename V::vector n;   // n + round_shifter
+        typename V::vector y0;
+        typename V::vector y1;
+    };
+
+    template <class V>
+    __forceinline pio2_reduction<V> reduce_pio2(typename V::vector const x)
+    {
+        using vector = typename V::vector;
+
+        vector const t = V::mul_add(x, V::set(6.36619772367581382433e-01), V::set(round_shifter));
+        vector const n = V::sub(t, V::set(round_shifter));
+
+        vector const r1 = V::sub(x, V::mul(n, V::set(1.57079632673412561417e+00)));
+
+        vector const w2 = V::mul(n, V::set(6.07710050630396597660e-11));
+        vector const r2 = V::sub(r1, w2);
+        vector const e2 = V::sub(V::sub(r1, r2), w2);
+
+        vector const w3 = V::mul(n, V::set(2.02226624871116645580e-21));
+        vector const r3 = V::sub(r2, w3);
+        vector const e3 = V::sub(V::sub(r2, r3), w3);
+
+        vector const w  = V::sub(V::mul(n, V::set(8.47842766036889956997e-32)), V::add(e2, e3));
+        vector const y0 = V::sub(r3, w);
+        return { t, y0, V::sub(V::sub(r3, y0), w) };
+    }
+
+    // sin(y0 + y1) for |y0 + y1| <= pi/4
+    template <class V>
+    __forceinline typename V::vector sin_kernel(typename V::vector const x, typename V::vector const y)
+    {
+        using vector = typename V::vector;
+
+        vector const z = V::mul(x, x);
+        vector const w = V::mul(z, z);
+        vector const v = V::mul(z, x);
+
+        vector r = V::mul_add(z, V::set(2.75573137070700676789e-06), V::set(-1.98412698298579493134e-04));
+        r = V::mul_add(z, r, V::set(8.33333333332248946124e-03));
+        r = V::mul_add(V::mul(z, w), V::mul_add(z, V::set(1.58969099521155010221e-10), V::set(-2.50507602534068634195e-08)), r);
+
+        vector const a = V::sub(V::mul(z, V::sub(V::mul(V::set(0.5), y), V::mul(v, r))), y);
+        return V::sub(x, V::sub(a, V::mul(v, V::set(-1.66666666666666324348e-01))));
+    }
+
+    // cos(y0 + y1) for |y0 + y1| <= pi/4
+    template <class V>
+    __forceinline typename V::vector cos_kernel(typename V::vector const x, typename V::vector const y)
+    {
+        using vector = typename V::vector;
+
+        vector const z = V::mul(x, x);
+        vector const w = V::mul(z, z);
+
+        vector r = V::mul_add(z, V::set(2.48015872894767294178e-05), V::set(-1.38888888888741095749e-03));
+        r = V::mul(z, V::mul_add(z, r, V::set(4.16666666666666019037e-02)));
+        vector s = V::mul_add(z, V::set(-1.13596475577881948265e-11), V::set(2.08757232129817482790e-09));
+        s = V::mul_add(z, s, V::set(-2.75573143513906633035e-07));
+        r = V::mul_add(V::mul(w, w), s, r);
+
+        vector const hz = V::mul(V::set(0.5), z);
+        vector const v  = V::sub(V::set(1.0), hz);
+        vector const e  = V::add(V::sub(V::sub(V::set(1.0), v), hz), V::sub(V::mul(z, r), V::mul(x, y)));
+        return V::add(v, e);
+    }
+
+    constexpr double sincos_limit = 0x1p19 * 1.57079632679489661923;
+
+    // The quadrant n selects sin or cos of the reduced argument (odd n) and
+    // the sign (n & 2); cos is sin shifted by one quadrant.
+    template <class V, int Quadrant>
+    __forceinline typename V::vector sincos(typename V::vector const x, unsigned& fallback)
+    {
+        using vector = typename V::vector;
+
+        fallback = outside<V>(V::less_equal(V::bit_and_not(x, V::set_bits(sign_bit)), V::set(sincos_limit)));
+
+        pio2_reduction<V> const reduced = reduce_pio2<V>(x);
+        vector const n    = V::int_add(reduced.n, V::set_bits(Quadrant));
+        vector const odd  = V::int_sub(V::set_bits(0), V::bit_and(n, V::set_bits(1)));
+        vector const sign = V::template shift_left<62>(V::bit_and(n, V::set_bits(2)));
+
+        vector const s = sin_kernel<V>(reduced.y0, reduced.y1);
+        vector const c = cos_kernel<V>(reduced.y0, reduced.y1);
+        return V::bit_xor(V::select(odd, c, s), sign);
+    }
+
+    struct sin_function
+    {
+        static double scalar(double const x) { return sin(x); }
+
+        template <class V>
+        __forceinline static typename V::vector vector(typename V::vector const x, unsigned& fallback)
+        {
+            return sincos<V, 0>(x, fallback);
+        }
+    };
+
+    struct cos_function
+    {
+        static double scalar(double const x) { return cos(x); }
+
+        template <class V>
+        __forceinline static typename V::vector vector(typename V::vector const x, unsigned& fallback)
+        {
+            return sincos<V, 1>(x, fallback);
+        }
+    };
+
+    struct sqrt_function
+    {
+        static double scalar(double const x) { return sqrt(x); }
+
+        template <class V>
+        __forceinline static typename V::vector vector(typename V::vector const x, unsigned& fallback)
+        {
+            fallback = 0;
+            return V::sqrt(x);
+        }
+    };
+
+    // Runs F over the array, V::lanes elements at a time.  The last partial
+    // group is padded with ones, which every kernel accepts, so it is computed
+    // exactly as a full one.
+    template <class V, class F>
+    __forceinline void apply(double const* const x, double* const y, size_t const count)
+    {
+        double in[V::lanes];
+        double out[V::lanes];
+
+        for (size_t i = 0; i < count; i += V::lanes) {
+            size_t const used = count - i < V::lanes ? count - i : V::lanes;
+
+            typename V::vector argument;
+            if (used == V::lanes) {
+                argument = V::load(x + i);
+            } else {
+                for (size_t k = 0; k < V::lanes; ++k) {
+                    in[k] = k < used ? x[i + k] : 1.0;
+                }
+                argument = V::load(in);
+            }
+
+            unsigned fallback = 0;
+            typename V::vector const result = F::template vector<V>(argument, fallback);
+
+            if (used == V::lanes && fallback == 0) {
+                V::store(y + i, result);
+                continue;
+            }
+
+            // x and y may be the same array, so the arguments are kept until
+            // the fallbacks have been computed.
+            V::store(in, argument);
+            V::store(out, result);
+            for (size_t k = 0; k < used; ++k) {
+                y[i + k] = (fallback >> k) & 1 ? F::scalar(in[k]) : out[k];
+            }
+        }
+    }
+
+#if defined _M_X64
+    // -1 until the first call; then 1 if AVX2 and FMA are present and the
+    // operating system has enabled the AVX state, 0 otherwise.
+    long avx2_state = -1;
+
+    bool avx2_available()
+    {
+        long state = avx2_state;
+        if (state < 0) {
+            int info[4];
+            __cpuid(info, 1);
+            bool const fma = (info[2] & (1 << 12)) != 0;
+            __cpuidex(info, 7, 0);
+            bool const avx2 = (info[1] & (1 << 5)) != 0;
+
+            state = fma && avx2 && (RtlGetEnabledExtendedFeatures(XSTATE_MASK_AVX) & XSTATE_MASK_AVX) != 0;
+            avx2_state = state;
+        }
+        return state != 0;
+    }
+
+    template <class F>
+    __declspec(noinline) void apply_avx2(double const* const x, double* const y, size_t const count)
+    {
+        apply<avx2_lanes, F>(x, y, count);
+        _mm256_zeroupper();
+    }
+#endif
+
+    template <class F>
+    __forceinline void apply_best(double const* const x, double* const y, size_t const count)
+    {
+#if defined _M_X64
+        if (count >= KVMATH_AVX2_MINIMUM_COUNT && KeGetCurrentIrql() <= DISPATCH_LEVEL && avx2_available()) {
+            XSTATE_SAVE state;
+            if (NT_SUCCESS(KeSaveExtendedProcessorState(XSTATE_MASK_AVX, &state))) {
+                apply_avx2<F>(x, y, count);
+                KeRestoreExtendedProcessorState(&state);
+                return;
+            }
+        }
+        apply<sse2_lanes, F>(x, y, count);
+#elif defined _M_ARM64
+        apply<neon_lanes, F>(x, y, count);
+#else
+        apply<scalar_lanes, F>(x, y, count);
+#endif
+    }
+}
+
+
+
+extern "C" void __cdecl kvexp(double const* const x, double* const y, size_t const count)
+{
+    apply_best<exp_function>(x, y, count);
+}
+
+extern "C" void __cdecl kvlog(double const* const x, double* const y, size_t const count)
+{
+    apply_best<log_function>(x, y, count);
+}
+
+extern "C" void __cdecl kvtanh(double const* const x, double* const y, size_t const count)
+{
+    apply_best<tanh_function>(x, y, count);
+}
+
+extern "C" void __cdecl kvsin(double const* const x, double* const y, size_t const count)
+{
+    apply_best<sin_function>(x, y, count);
+}
+
+extern "C" void __cdecl kvcos(double const* const x, double* const y, size_t const count)
+{
+    apply_best<cos_function>(x, y, count);
+}
+
+extern "C" void __cdecl kvsqrt(double const* const x, double* const y, size_t const count)
+{
+    apply_best<sqrt_function>(x, y, count);
+}
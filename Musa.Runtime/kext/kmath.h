@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>
+
+
+// Batch math.
+//
+// Each function computes y[i] = f(x[i]) for i in [0, count).  x and y may be
+// the same array; otherwise they must not overlap.  The work is done two
+// (SSE2, NEON) or four (AVX2 with FMA, for at least KVMATH_AVX2_MINIMUM_COUNT
+// elements) lanes at a time with polynomial kernels that touch neither the
+// floating point control word nor errno.  Elements outside a kernel's domain
+// (listed below; NaNs are outside every domain) are passed to the scalar CRT
+// function, so their results, including any errno, are the CRT's.
+//
+// The 256-bit kernels need the upper halves of the YMM registers, which the
+// kernel does not preserve for drivers:  they run between
+// KeSaveExtendedProcessorState and KeRestoreExtendedProcessorState, and the
+// 128-bit kernels are used instead when that fails or the caller is above
+// DISPATCH_LEVEL.  The 128-bit kernels use only XMM (NEON) registers, which
+// drivers may use without saving them.  The functions may be called at IRQL
+// <= DISPATCH_LEVEL (at higher IRQL only if no element can fall back).
+//
+// Maximum errors (the bounds below; the largest error seen in parentheses),
+// measured against a long double reference over 2 * 10^7 arguments per
+// function for the one-lane, SSE2 and AVX2 kernels.  The NEON kernels are the
+// same code, with fused mul-add as in AVX2.  Results are not correctly rounded
+// and may differ in the last place between kernel widths.
+//
+//     kvexp    |x| <= 708                  1 ulp    (0.88)
+//     kvlog    DBL_MIN <= x <= DBL_MAX     1 ulp    (0.84)
+//     kvtanh   any non-NaN x               3 ulp    (2.52)
+//     kvsin    |x| <= 2^19 pi/2            1 ulp    (0.78)
+//     kvcos    |x| <= 2^19 pi/2            1 ulp    (0.77)
+//     kvsqrt   any x; correctly rounded, NaN for x < 0 without setting errno
+
+#define KVMATH_AVX2_MINIMUM_COUNT 64
+
+extern "C" void __cdecl kvexp(
+    _In_reads_(count)   double const* x,
+    _Out_writes_(count) double*       y,
+    _In_                size_t        count
+);
+
+extern "C" void __cdecl kvlog(
+    _In_reads_(count)   double const* x,
+    _Out_writes_(count) double*       y,
+    _In_                size_t        count
+);
+
+extern "C" void __cdecl kvtanh(
+    _In_reads_(count)   double const* x,
+    _Out_writes_(count) double*       y,
+    _In_                size_t        count
+);
+
+extern "C" void __cdecl kvsin(
+    _In_reads_(count)   double const* x,
+    _Out_writes_(count) double*       y,
+    _In_                size_t        count
+);
+
+extern "C" void __cdecl kvcos(
+    _In_reads_(count)   double const* x,
+    _Out_writes_(count) double*       y,
+    _In_                size_t        count
+);
+
+extern "C" void __cdecl kvsqrt(
+    _In_reads_(count)   double const* x,
+    _Out_writes_(count) double*       y,
+    _In_                size_t        count
+);
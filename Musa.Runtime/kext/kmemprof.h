@@ -0,0 +1,104 @@
+#pragma once
+#include <stddef.h>
+
+
+// Allocation telemetry.
+//
+// Off by default.  Once kmemprof_enable has been called, every allocation made
+// through kmalloc, kcalloc, krealloc, operator new(size, pool, tag) and the
+// CRT heap (malloc, calloc, realloc, operator new) is counted in a bucket keyed
+// by (pool tag, size class, call site).  CRT heap blocks have no pool tag of
+// their own and are counted under KMEMPROF_TAG_CRT_HEAP.  Counters are kept
+// per processor and summed by kmemprof_query, so recording an allocation is a
+// bucket lookup, two interlocked additions on the current processor's counters
+// and one entry in a table of live blocks, from which a free finds the bucket
+// and size it has to be charged to.  While disabled, the cost is one branch.
+//
+// In addition, 1 in sample_every allocations (per processor) records its call
+// stack, from the allocator outwards, in a ring of the most recent
+// samples; kmemprof_query_samples reports which of them are still live.
+//
+// The call site is the return address into the caller of the allocation
+// function: kmalloc, kcalloc, krealloc, malloc, calloc, realloc or operator new
+// (operator new[] and the nothrow forms call operator new, as the standard
+// requires, and are charged to that call).  For allocations made through
+// wrappers of these (std::allocator, a driver's own allocator) set
+// call_site_skip to take the call site that many frames further up the stack
+// instead, up to 16; this captures a short stack trace per allocation and
+// costs accordingly.
+//
+// Tables are allocated from NonPagedPoolNx on the first kmemprof_enable, with
+// the sizes it asks for, and live until the driver unloads.  The counters take
+// 32 bytes per bucket per processor (up to 64 processors; more share them).
+// Enabling again resets every counter and sample.  Neither enabling nor
+// disabling waits for allocations in flight on other processors, so counts can
+// be off by those.
+// Blocks allocated while disabled, and blocks that did not fit the live table,
+// are counted as untracked when they are freed.
+
+#define KMEMPROF_TAG_CRT_HEAP 0ul
+#define KMEMPROF_SAMPLE_FRAMES 16
+
+struct kmemprof_options
+{
+    unsigned long buckets;          // distinct (tag, size class, call site) keys;  default 512
+    unsigned long live_blocks;      // live allocations that can be tracked;         default 65536
+    unsigned long sample_every;     // sample 1 in N allocations, 0 to disable;     default 0
+    unsigned long samples;          // samples kept (the most recent);              default 256
+    unsigned long call_site_skip;   // extra frames to skip for the call site;      default 0
+};
+
+struct kmemprof_bucket
+{
+    unsigned long      tag;
+    unsigned long long size_class;      // allocations of at most this many bytes (and more than the previous class)
+    void const*        call_site;       // nullptr for allocations that did not fit the bucket table
+    unsigned long long allocations;
+    unsigned long long frees;
+    unsigned long long allocated_bytes;
+    long long          live_bytes;
+    long long          peak_live_bytes; // highest live_bytes seen by kmemprof_query
+};
+
+struct kmemprof_summary
+{
+    unsigned long long elapsed_us;      // since kmemprof_enable, for allocation rates
+    size_t             buckets;         // buckets in use
+    unsigned long long untracked_frees;
+    unsigned long long untracked_allocations; // did not fit the live table
+    unsigned long long samples;         // samples taken since kmemprof_enable
+};
+
+struct kmemprof_sample
+{
+    unsigned long long sequence;        // 1 for the first sample since kmemprof_enable
+    unsigned long      tag;
+    size_t             size;
+    void const*        block;
+    bool               live;
+    unsigned long      frames;
+    void*              stack[KMEMPROF_SAMPLE_FRAMES];
+};
+
+// Starts (or restarts) recording.  options may be null for the defaults.  Must
+// be called at PASSIVE_LEVEL.  Returns STATUS_INSUFFICIENT_RESOURCES if the
+// tables cannot be allocated, and STATUS_DEVICE_BUSY, changing nothing, if
+// another kmemprof_enable call is in progress.
+extern "C" NTSTATUS __cdecl kmemprof_enable(_In_opt_ kmemprof_options const* options);
+
+extern "C" void __cdecl kmemprof_disable();
+
+// Copies up to capacity buckets, busiest (most live bytes) first, and fills
+// summary if it is not null.  Returns the number copied.
+extern "C" size_t __cdecl kmemprof_query(
+    _Out_writes_opt_(capacity) kmemprof_bucket*  buckets,
+    _In_                       size_t            capacity,
+    _Out_opt_                  kmemprof_summary* summary
+);
+
+// Copies up to capacity of the most recent samples, newest first.  Returns the
+// number copied.
+extern "C" size_t __cdecl kmemprof_query_samples(
+    _Out_writes_opt_(capacity) kmemprof_sample* samples,
+    _In_                       size_t           capacity
+);
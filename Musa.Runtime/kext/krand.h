@@ -0,0 +1,44 @@
+#pragma once
+#include <corecrt.h>
+
+
+// Buffered random numbers.
+//
+// rand_s, rand_s_bytes and std::random_device draw from a ChaCha20 generator
+// per processor instead of calling the system RNG for every request.  Each
+// generator is keyed from the system RNG on first use and refills a 1 KiB
+// keystream buffer at a time; the first 32 bytes of every refill become the
+// next key and are erased, and bytes are erased from the buffer as they are
+// handed out, so the state of a generator does not reveal earlier output.
+//
+// A generator is reseeded (fresh system RNG bytes are mixed into its key)
+// after it has produced the reseed interval's worth of bytes, and on its next
+// use after krand_reseed.  Call krand_reseed when earlier output may have been
+// duplicated elsewhere: after resuming from hibernation or being restored from
+// a virtual machine snapshot, the kernel counterparts of fork.  Neither waits
+// for requests in flight on other processors.
+//
+// The generators live in one NonPagedPoolNx block allocated on first use and
+// freed when the AppCRT is uninitialized.  Requests run at DISPATCH_LEVEL on
+// the current processor's generator, 256 bytes at a time, and are copied to
+// the caller's buffer at the caller's IRQL, so the buffer may be pageable if
+// the caller runs below DISPATCH_LEVEL.  Requests made while the interval is 0
+// go to the system RNG directly.
+
+#define KRAND_DEFAULT_RESEED_INTERVAL (1024 * 1024)
+
+// Fills buffer with count random bytes.  Returns 0, EINVAL if buffer is null
+// and count is not 0 or if called above DISPATCH_LEVEL, or ENOMEM (also stored
+// in errno) if the system RNG fails, in which case the buffer is zeroed.
+// rand_s fails the same ways.  Callable at IRQL <= DISPATCH_LEVEL.
+extern "C" errno_t __cdecl rand_s_bytes(
+    _Out_writes_bytes_all_(count) void*  buffer,
+    _In_                          size_t count
+);
+
+// Sets the number of bytes a generator produces between reseeds and returns
+// the previous value.  0 bypasses the generators.
+extern "C" size_t __cdecl krand_set_reseed_interval(_In_ size_t bytes);
+
+// Makes every generator reseed before it produces more output.
+extern "C" void __cdecl krand_reseed();
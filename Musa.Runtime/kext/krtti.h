@@ -0,0 +1,14 @@
+#pragma once
+
+
+// Opt-in dynamic_cast result cache.
+//
+// When enabled, __RTDynamicCast remembers the outcome of each distinct cast
+// (per most-derived type, source type, target type and source sub-object) in a
+// small lock-free per-processor table, so repeated casts in hot paths skip the
+// class hierarchy walk.  The tables are allocated from NonPagedPoolNx on first
+// enable and released when the runtime shuts down.
+//
+// Returns the previous state.  Enabling fails silently (and the cache stays
+// off) if the tables cannot be allocated.
+extern "C" bool __cdecl krtti_set_cast_cache(_In_ bool enable);
@@ -0,0 +1,80 @@
+#pragma once
+#include <corecrt.h>
+
+
+// Static search tables.
+//
+// Read-mostly sorted tables searched far more often than they change are
+// better served by a layout built for search than by bsearch over the sorted
+// array, whose probes jump across the whole array and mispredict half the
+// time.  A table is built once from sorted input into a copy and is read-only
+// from then on: lookups take no locks, do not allocate and may run
+// concurrently.  To change the contents, build a new table.
+//
+// ksearch_u32 and ksearch_u64 are S+ trees (static B+ trees) of 64-byte nodes
+// holding 16 or 8 keys.  Each level costs one cache line; the keys in a node
+// are compared at once with SSE2 (u32), SSE4.2 when the processor has it (u64)
+// or NEON, without a branch on the outcome.  lower_bound returns the index
+// into the sorted input of the first key not less than key, or num if there is
+// none, so the table can index a parallel array of values.  The tree takes
+// about 1 + 1/16 (u32) or 1 + 1/8 (u64) times the size of the keys.
+//
+// ksearch_table holds elements of any width in Eytzinger (breadth-first)
+// order, compared with a bsearch-style comparator; the lookup loop does not
+// branch on the comparison and prefetches four levels ahead.  find returns the
+// element equal to key, like bsearch; lower_bound the first element not less
+// than key.  Either returns nullptr if there is none.  The pointers are into
+// the table's copy of the elements.
+//
+// The build functions return nullptr and set errno to ENOMEM if the CRT heap
+// cannot hold the table, or to EINVAL for a null input with num != 0.  The
+// input must be sorted in ascending order (by compare, for ksearch_table);
+// duplicates are allowed.
+
+typedef struct ksearch_u32   ksearch_u32;
+typedef struct ksearch_u64   ksearch_u64;
+typedef struct ksearch_table ksearch_table;
+
+extern "C" ksearch_u32* __cdecl ksearch_u32_build(
+    _In_reads_(num) unsigned int const* sorted,
+    _In_            size_t              num
+);
+
+extern "C" size_t __cdecl ksearch_u32_lower_bound(
+    _In_ ksearch_u32 const* table,
+    _In_ unsigned int       key
+);
+
+extern "C" void __cdecl ksearch_u32_free(_In_opt_ ksearch_u32* table);
+
+extern "C" ksearch_u64* __cdecl ksearch_u64_build(
+    _In_reads_(num) unsigned long long const* sorted,
+    _In_            size_t                    num
+);
+
+extern "C" size_t __cdecl ksearch_u64_lower_bound(
+    _In_ ksearch_u64 const* table,
+    _In_ unsigned long long key
+);
+
+extern "C" void __cdecl ksearch_u64_free(_In_opt_ ksearch_u64* table);
+
+extern "C" ksearch_table* __cdecl ksearch_table_build(
+    _In_reads_bytes_(num * width) void const* sorted,
+    _In_                          size_t      num,
+    _In_                          size_t      width
+);
+
+extern "C" void const* __cdecl ksearch_table_find(
+    _In_ ksearch_table const* table,
+    _In_ void const*          key,
+    _In_ int (__cdecl*        compare)(void const* key, void const* element)
+);
+
+extern "C" void const* __cdecl ksearch_table_lower_bound(
+    _In_ ksearch_table const* table,
+    _In_ void const*          key,
+    _In_ int (__cdecl*        compare)(void const* key, void const* element)
+);
+
+extern "C" void __cdecl ksearch_table_free(_In_opt_ ksearch_table* table);
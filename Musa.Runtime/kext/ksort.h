@@ -0,0 +1,25 @@
+#pragma once
+#include <corecrt.h>
+
+
+// Integer sorts.
+//
+// qsort_u32 and qsort_u64 sort arrays of unsigned keys into ascending order
+// with an LSD radix sort: one counting pass over the keys, then one scatter
+// pass per byte in which the keys differ.  The scatter needs a scratch copy of
+// the array from the CRT heap; arrays of fewer than 512 keys, or that cannot
+// get one, are sorted in place by the same pattern-defeating quicksort as
+// qsort.
+//
+// Like qsort, both may be called at IRQL <= DISPATCH_LEVEL if the array is
+// in nonpaged memory.
+
+extern "C" void __cdecl qsort_u32(
+    _Inout_updates_(num) unsigned int* base,
+    _In_                 size_t        num
+);
+
+extern "C" void __cdecl qsort_u64(
+    _Inout_updates_(num) unsigned long long* base,
+    _In_                 size_t              num
+);
@@ -0,0 +1,53 @@
+#pragma once
+#include <stddef.h>
+
+
+// Startup trace.
+//
+// The DriverEntry provided by the runtime records every step it takes before
+// calling DriverMain:  Musa.Core startup, each entry of the AppCRT initializer
+// table, each .CRT$XI and .CRT$XC initializer, and the thread-local callbacks.
+// Each record carries the elapsed time-stamp counter ticks and the number and
+// size of heap allocations (malloc, calloc, operator new, kmalloc) made while
+// the step ran.  Recording stops when DriverMain is entered; the trace stays
+// queryable for the life of the driver.
+//
+// Subsystems that kernel drivers rarely touch (the environment) are set up on
+// first use and do not appear in the trace.
+
+enum kstartup_phase : unsigned long
+{
+    kstartup_phase_core = 0,   // Musa.Core and TLS index setup
+    kstartup_phase_crt,        // VCRuntime and AppCRT initialization as a whole
+    kstartup_phase_acrt,       // one entry of the AppCRT initializer table (within crt)
+    kstartup_phase_xi,         // one .CRT$XI (C) initializer
+    kstartup_phase_xc,         // one .CRT$XC (C++) initializer
+    kstartup_phase_tls,        // dynamic thread-local initialization
+};
+
+struct kstartup_record
+{
+    kstartup_phase     phase;
+    char const*        name;        // fixed steps only, otherwise nullptr
+    void const*        routine;     // the initializer, for symbol lookup
+    unsigned long long cycles;      // ReadTimeStampCounter() ticks
+    unsigned long      allocations;
+    unsigned long long bytes;
+};
+
+struct kstartup_summary
+{
+    unsigned long long entry_to_main_us;     // DriverEntry to DriverMain
+    unsigned long long entry_to_main_cycles;
+    size_t             records;              // records available
+    size_t             dropped;              // steps that did not fit the trace
+};
+
+// Copies up to capacity records into records (which may be null when capacity
+// is 0) and fills summary if it is not null.  Returns the number copied.
+// Returns 0 with summary->records == 0 until DriverMain has been entered.
+extern "C" size_t __cdecl kstartup_trace_query(
+    _Out_writes_opt_(capacity) kstartup_record*  records,
+    _In_                       size_t            capacity,
+    _Out_opt_                  kstartup_summary* summary
+);
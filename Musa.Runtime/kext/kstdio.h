@@ -0,0 +1,41 @@
+#pragma once
+#include <stdio.h>
+#include <cstddef>
+
+#if _HAS_CXX20
+#include <span>
+#endif
+
+
+// Memory-mapped stdio streams.
+//
+// fopen(name, "rm") (or "rbm") opens a read-only binary stream backed by a
+// system-space view of the whole file.  fread/fgets/fseek/ftell work as usual
+// but are served from the view; _fmapview returns the view itself so a parser
+// can walk the file without copying it.  The view stays valid until the stream
+// is closed, reopened or given a buffer with setvbuf.
+//
+// If the file cannot be mapped (empty, larger than INT_MAX bytes, a device or
+// a pipe) fopen still succeeds with an ordinary buffered stream and _fmapview
+// returns EINVAL.  Touching the view may raise STATUS_IN_PAGE_ERROR if the
+// backing read fails, and must happen below DISPATCH_LEVEL.
+
+extern "C" errno_t __cdecl _fmapview(
+    _In_                                FILE*        stream,
+    _Outptr_result_bytebuffer_(*size)   void const** data,
+    _Out_                               size_t*      size
+);
+
+#if _HAS_CXX20
+// Returns the view backing 'stream', or an empty span if it is not mapped.
+inline std::span<const std::byte> kfmapview(FILE* const stream) noexcept
+{
+    void const* data = nullptr;
+    size_t      size = 0;
+    if (_fmapview(stream, &data, &size) != 0) {
+        return {};
+    }
+
+    return { static_cast<const std::byte*>(data), size };
+}
+#endif
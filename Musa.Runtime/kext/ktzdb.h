@@ -0,0 +1,66 @@
+#pragma once
+#include <corecrt.h>
+
+
+// Time zone database.
+//
+// std::chrono::get_tzdb, locate_zone, current_zone and zoned_time read the
+// IANA time zone database through the __std_tzdb_* entry points, which in
+// user mode call ICU.  Here they are served from a compact database that the
+// driver loads, either from its own image (a resource or a const array) with
+// ktzdb_load, or from a file with ktzdb_load_file, which maps the file rather
+// than reading it.  A zone's data is parsed the first time the zone is used;
+// a lookup is a binary search over its transitions, and times after the last
+// transition follow the zone's POSIX TZ rule.
+//
+// The database is little endian:
+//
+//     offset  0   char     magic[4]          "TZDB"
+//             4   uint32   format            1
+//             8   uint32   count             number of entries
+//            12   uint32   default_zone      entry index, or 0xFFFFFFFF
+//            16   char     version[16]       tzdata version, e.g. "2025b"
+//            32   entry    entries[count]    sorted by name, bytewise
+//
+//     entry:      uint32   name              offset of the NUL-terminated name
+//                 uint32   target            for a link, the entry index of
+//                                            its zone; 0xFFFFFFFF for a zone
+//                 uint32   data, size        for a zone, the offset and size
+//                                            of its TZif data (RFC 8536,
+//                                            version 2 or later), as compiled
+//                                            by zic; 0 for a link
+//
+// Build.TimeZoneDatabase.py builds one from a zoneinfo directory.
+//
+// The standard library reads the list of zones once, at the first get_tzdb
+// call, so load the database before that; reload_tzdb does not read the list
+// again.  A database loaded later answers every lookup from then on, and one
+// that lacks a zone on the list makes lookups in that zone throw.  Databases
+// that are replaced are kept until the CRT is uninitialized, so a lookup in
+// progress never dangles.  A mapped database is paged, so zone lookups must
+// happen below DISPATCH_LEVEL.
+//
+// current_zone is the zone set with ktzdb_set_current_zone, else the
+// database's default zone, else "UTC".  Leap seconds are the ones built into
+// <chrono>.
+
+// Uses 'database', which must stay valid and unchanged while the driver runs.
+// Returns EINVAL if it is not a well-formed database.
+extern "C" errno_t __cdecl ktzdb_load(
+    _In_reads_bytes_(size) void const* database,
+    _In_                   size_t      size
+);
+
+// Checks 'database' as ktzdb_load does, without loading it or allocating.
+extern "C" errno_t __cdecl ktzdb_validate(
+    _In_reads_bytes_(size) void const* database,
+    _In_                   size_t      size
+);
+
+// Opens 'path' with fopen and maps it; the file stays open.
+extern "C" errno_t __cdecl ktzdb_load_file(_In_z_ char const* path);
+
+// Sets the zone returned by current_zone; nullptr restores the default.
+// Returns EINVAL if the loaded database has no such zone or link, or if no
+// database is loaded.
+extern "C" errno_t __cdecl ktzdb_set_current_zone(_In_opt_z_ char const* name);
@@ -0,0 +1,39 @@
+#pragma once
+#include <stddef.h>
+
+
+// Arena-backed C++ name undecoration.
+//
+// kundname undecorates one MSVC-decorated name (the same flags as
+// UnDecorateSymbolName / __unDName) into a caller-supplied buffer, taking all
+// of its working storage from a caller-supplied scratch arena:  no pool
+// allocations and no global lock, so calls may run concurrently as long as
+// each caller uses its own arena (a stack buffer or a per-CPU buffer).  A few
+// KB of arena covers ordinary symbols; deeply nested templates may need 16-64
+// KB.  The result is truncated to outputSize - 1 characters.  Names that are
+// not decorated are copied through unchanged.
+//
+// Returns output, or nullptr if the arena ran out or the name is malformed.
+extern "C" char* __cdecl kundname(
+    _Out_writes_z_(outputSize) char*       output,
+    _In_z_                     char const* name,
+    _In_                       int         outputSize,
+    _Inout_updates_bytes_(arenaSize) void* arena,
+    _In_                       size_t      arenaSize,
+    _In_                       unsigned long flags
+);
+
+// Undecorates names[0..count) one after another, reusing the whole arena for
+// each, and packs the NUL-terminated results back to back into output.
+// results[i] receives a pointer into output, or nullptr if names[i] failed
+// or output was already full.  Returns the number of names undecorated.
+extern "C" size_t __cdecl kundname_batch(
+    _In_reads_(count)          char const* const* names,
+    _Out_writes_(count)        char const**       results,
+    _In_                       size_t             count,
+    _Out_writes_(outputSize)   char*              output,
+    _In_                       size_t             outputSize,
+    _Inout_updates_bytes_(arenaSize) void*        arena,
+    _In_                       size_t             arenaSize,
+    _In_                       unsigned long      flags
+);
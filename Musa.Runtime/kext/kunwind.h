@@ -0,0 +1,17 @@
+#pragma once
+
+
+// Function table lookup for exception dispatch and stack walking.
+//
+// A drop-in for RtlLookupFunctionEntry.  Program counters inside the image the
+// runtime is linked into are resolved against a sorted, cache-aligned copy of
+// the image's .pdata begin addresses, behind a per-processor last-hit entry,
+// so repeated lookups for the same function (a throw site, a frame handler, a
+// hot loop being sampled) cost one comparison.  Every other address is handed
+// to RtlLookupFunctionEntry unchanged.  The runtime uses it for its own
+// catch-funclet lookups; use it in RtlVirtualUnwind loops as well.
+extern "C" PRUNTIME_FUNCTION __cdecl kunwind_lookup_function_entry(
+    _In_      ULONG64               control_pc,
+    _Out_     PULONG64              image_base,
+    _Inout_opt_ PUNWIND_HISTORY_TABLE history_table
+);
@@ -1,6 +1,7 @@
 #include <vcstartup_internal.h>
 #include "kmalloc.h"
 #include "knew.h"
+#include <corecrt_internal_heap_profile.h>
 
 
 // Enable the compiler to elide null checks during LTCG
@@ -29,7 +30,8 @@ operator new(
 )
 {
     for (;;) {
-        void* const block = kmalloc(size, pool_type, tag);
+        // Charged to the caller of operator new in the allocation telemetry:
+        void* const block = __acrt_kmalloc_from(size, pool_type, tag, _ReturnAddress());
         if (block) {
             return block;
         }